@@ -13,6 +13,7 @@
  */
 
 #include "all_fractal_definitions.h"
+#include "scalar_fractal_formulas.hpp"
 
 cFractalMandelbox::cFractalMandelbox() : cAbstractFractal()
 {
@@ -62,45 +63,12 @@ void cFractalMandelbox::FormulaCode(CVector4 &z, const sFractal *fractal, sExten
 	}
 	else
 	{
-		if (fabs(z.x) > fractal->mandelbox.foldingLimit)
-		{
-			z.x = sign(z.x) * fractal->mandelbox.foldingValue - z.x;
-			aux.color += fractal->mandelbox.color.factor.x;
-		}
-		if (fabs(z.y) > fractal->mandelbox.foldingLimit)
-		{
-			z.y = sign(z.y) * fractal->mandelbox.foldingValue - z.y;
-			aux.color += fractal->mandelbox.color.factor.y;
-		}
-		if (fabs(z.z) > fractal->mandelbox.foldingLimit)
-		{
-			z.z = sign(z.z) * fractal->mandelbox.foldingValue - z.z;
-			aux.color += fractal->mandelbox.color.factor.z;
-		}
-	}
-
-	const double r2 = z.Dot(z);
-
-	z += fractal->mandelbox.offset;
-
-	if (r2 < fractal->mandelbox.mR2)
-	{
-		z *= fractal->mandelbox.mboxFactor1;
-		aux.DE *= fractal->mandelbox.mboxFactor1;
-		aux.color += fractal->mandelbox.color.factorSp1;
-	}
-	else if (r2 < fractal->mandelbox.fR2)
-	{
-		const double tglad_factor2 = fractal->mandelbox.fR2 / r2;
-		z *= tglad_factor2;
-		aux.DE *= tglad_factor2;
-		aux.color += fractal->mandelbox.color.factorSp2;
+		MandelboxBoxFold(z, aux.color, fractal);
 	}
 
-	z -= fractal->mandelbox.offset;
+	MandelboxSphericalFold(z, aux.DE, aux.color, fractal);
 
 	if (fractal->mandelbox.mainRotationEnabled) z = fractal->mandelbox.mainRot.RotateVector(z);
 
-	z = z * fractal->mandelbox.scale;
-	aux.DE = aux.DE * fabs(fractal->mandelbox.scale) + 1.0;
+	MandelboxScale(z, aux.DE, fractal);
 }
@@ -0,0 +1,111 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator  _%}}i*<.         ______
+ * Copyright (C) 2026 Mandelbulber Team   _>]|=||i=i<,      / ____/ __    __
+ *                                        \><||i|=>>%)     / /   __/ /___/ /_
+ * This file is part of Mandelbulber.     )<=i=]=|=i<>    / /__ /_  __/_  __/
+ * The project is licensed under GPLv3,   -<>>=|><|||`    \____/ /_/   /_/
+ * see also COPYING file in this folder.    ~+{i%+++
+ *
+ * Iteration code of Mandelbulb and Mandelbox templated on the vector and scalar type.
+ * Used by formula classes in double precision and by ComputeScalar() in single precision.
+ * The vector type needs only x, y, z and w members.
+ */
+
+#ifndef MANDELBULBER2_FORMULA_DEFINITION_SCALAR_FRACTAL_FORMULAS_HPP_
+#define MANDELBULBER2_FORMULA_DEFINITION_SCALAR_FRACTAL_FORMULAS_HPP_
+
+#include <cmath>
+
+#include "src/common_math.h"
+#include "src/fractal.h"
+
+template <typename TVector, typename T>
+inline void MandelbulbIteration(TVector &z, T r, T &DE, const sFractal *fractal)
+{
+	const T power = T(fractal->bulb.power);
+	const T th0 = std::asin(z.z / r) + T(fractal->bulb.betaAngleOffset);
+	const T ph0 = std::atan2(z.y, z.x) + T(fractal->bulb.alphaAngleOffset);
+	T rp = std::pow(r, power - T(1.0));
+	const T th = th0 * power;
+	const T ph = ph0 * power;
+	const T cth = std::cos(th);
+	DE = (rp * DE) * power + T(1.0);
+	rp *= r;
+	z.x = cth * std::cos(ph) * rp;
+	z.y = cth * std::sin(ph) * rp;
+	z.z = std::sin(th) * rp;
+}
+
+// box folding of Mandelbox without rotations
+template <typename TVector, typename T>
+inline void MandelboxBoxFold(TVector &z, T &color, const sFractal *fractal)
+{
+	const T foldingLimit = T(fractal->mandelbox.foldingLimit);
+	const T foldingValue = T(fractal->mandelbox.foldingValue);
+	if (std::fabs(z.x) > foldingLimit)
+	{
+		z.x = T(sign(z.x)) * foldingValue - z.x;
+		color += T(fractal->mandelbox.color.factor.x);
+	}
+	if (std::fabs(z.y) > foldingLimit)
+	{
+		z.y = T(sign(z.y)) * foldingValue - z.y;
+		color += T(fractal->mandelbox.color.factor.y);
+	}
+	if (std::fabs(z.z) > foldingLimit)
+	{
+		z.z = T(sign(z.z)) * foldingValue - z.z;
+		color += T(fractal->mandelbox.color.factor.z);
+	}
+}
+
+// spherical folding of Mandelbox around its offset
+template <typename TVector, typename T>
+inline void MandelboxSphericalFold(TVector &z, T &DE, T &color, const sFractal *fractal)
+{
+	const T r2 = z.x * z.x + z.y * z.y + z.z * z.z + z.w * z.w;
+
+	const T offsetX = T(fractal->mandelbox.offset.x);
+	const T offsetY = T(fractal->mandelbox.offset.y);
+	const T offsetZ = T(fractal->mandelbox.offset.z);
+	const T offsetW = T(fractal->mandelbox.offset.w);
+	z.x += offsetX;
+	z.y += offsetY;
+	z.z += offsetZ;
+	z.w += offsetW;
+
+	T factor = T(1.0);
+	if (r2 < T(fractal->mandelbox.mR2))
+	{
+		factor = T(fractal->mandelbox.mboxFactor1);
+		color += T(fractal->mandelbox.color.factorSp1);
+	}
+	else if (r2 < T(fractal->mandelbox.fR2))
+	{
+		factor = T(fractal->mandelbox.fR2) / r2;
+		color += T(fractal->mandelbox.color.factorSp2);
+	}
+	z.x *= factor;
+	z.y *= factor;
+	z.z *= factor;
+	z.w *= factor;
+	DE *= factor;
+
+	z.x -= offsetX;
+	z.y -= offsetY;
+	z.z -= offsetZ;
+	z.w -= offsetW;
+}
+
+template <typename TVector, typename T>
+inline void MandelboxScale(TVector &z, T &DE, const sFractal *fractal)
+{
+	const T scale = T(fractal->mandelbox.scale);
+	z.x *= scale;
+	z.y *= scale;
+	z.z *= scale;
+	z.w *= scale;
+	DE = DE * std::fabs(scale) + T(1.0);
+}
+
+#endif /* MANDELBULBER2_FORMULA_DEFINITION_SCALAR_FRACTAL_FORMULAS_HPP_ */
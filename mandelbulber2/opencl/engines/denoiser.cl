@@ -0,0 +1,102 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * one iteration of edge-aware a-trous wavelet denoiser (the same as cPostEffectDenoiser)
+ * colours, albedo, normals and world positions are stored as 3 floats per pixel
+ */
+
+float3 LoadFloat3(__global float *buffer, int index)
+{
+	return (float3){buffer[index * 3], buffer[index * 3 + 1], buffer[index * 3 + 2]};
+}
+
+//------------------ MAIN RENDER FUNCTION --------------------
+kernel void Denoiser(__global float *colorIn, __global float *zBuffer, __global float *albedo,
+	__global float *normals, __global float *world, __global float *out, sParamsDenoiser p)
+{
+	const int i = get_global_id(0);
+	const int2 scr = (int2){i % p.width, i / p.width};
+
+	// B3 spline kernel
+	const float kernelWeights[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+	const float3 lumaFactors = (float3){0.299f, 0.587f, 0.114f};
+
+	float3 pixel = LoadFloat3(colorIn, i);
+	float luminance = dot(pixel, lumaFactors);
+	float z = zBuffer[i];
+	float3 a = LoadFloat3(albedo, i);
+	float3 n = p.useNormals ? LoadFloat3(normals, i) : (float3){0.0f, 0.0f, 0.0f};
+	float3 w = p.useWorld ? LoadFloat3(world, i) : (float3){0.0f, 0.0f, 0.0f};
+
+	float3 sum = (float3){0.0f, 0.0f, 0.0f};
+	float weightSum = 0.0f;
+
+	for (int dy = -2; dy <= 2; dy++)
+	{
+		int yy = scr.y + dy * p.step;
+		if (yy < 0 || yy >= p.height) continue;
+		for (int dx = -2; dx <= 2; dx++)
+		{
+			int xx = scr.x + dx * p.step;
+			if (xx < 0 || xx >= p.width) continue;
+
+			int i2 = xx + yy * p.width;
+			float3 pixel2 = LoadFloat3(colorIn, i2);
+			float luminance2 = dot(pixel2, lumaFactors);
+
+			float dist = fabs(zBuffer[i2] - z);
+			if (p.useWorld) dist = max(dist, length(LoadFloat3(world, i2) - w));
+			float dz = dist / (z * p.sigmaDepth * p.step + 1e-6f);
+
+			float3 da3 = LoadFloat3(albedo, i2) - a;
+			float da = dot(da3, da3) / p.sigmaAlbedo;
+
+			float dl = fabs(luminance2 - luminance)
+								 / (p.sigmaLuminance * sqrt(max(luminance, luminance2)) + 1e-4f);
+
+			float weight = kernelWeights[abs(dx)] * kernelWeights[abs(dy)] * exp(-dz - da - dl);
+
+			if (p.useNormals)
+			{
+				float3 n2 = LoadFloat3(normals, i2);
+				weight *= pow(max(0.0f, dot(n, n2)), p.normalPower);
+			}
+
+			sum += pixel2 * weight;
+			weightSum += weight;
+		}
+	}
+
+	float3 result = sum / weightSum;
+	out[i * 3] = result.x;
+	out[i * 3 + 1] = result.y;
+	out[i * 3 + 2] = result.z;
+}
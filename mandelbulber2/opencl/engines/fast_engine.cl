@@ -76,6 +76,19 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff,
 	__global sPrimitiveCl *__attribute__((aligned(16))) primitives =
 		(__global sPrimitiveCl *)&inBuff[primitivesOffset];
 
+	//--- Cone-marching pre-pass
+
+#ifdef CONE_MARCH_PREPASS
+	int coneMarchMainOffset = GetInteger(5 * sizeof(int), inBuff);
+	int coneMarchTileSize = GetInteger(coneMarchMainOffset, inBuff);
+	int coneMarchTilesX = GetInteger(coneMarchMainOffset + 1 * sizeof(int), inBuff);
+	int coneMarchArrayOffset = GetInteger(coneMarchMainOffset + 3 * sizeof(int), inBuff);
+
+	__global float *coneMarchDepths = (__global float *)&inBuff[coneMarchArrayOffset];
+	float coneMarchStartDistance =
+		coneMarchDepths[imageX / coneMarchTileSize + (imageY / coneMarchTileSize) * coneMarchTilesX];
+#endif
+
 	//--------- end of data file ----------------------------------
 
 	sClPixel pixel;
@@ -199,6 +212,10 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff,
 		float scan, distThresh, distance;
 
 		scan = 1e-10f;
+#ifdef CONE_MARCH_PREPASS
+		// view vector is not normalized
+		scan = max(scan, coneMarchStartDistance / length(viewVector));
+#endif
 
 		sClCalcParams calcParam;
 		calcParam.N = consts->params.N;
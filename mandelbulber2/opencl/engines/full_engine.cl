@@ -198,6 +198,19 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff, __global ch
 	__global sObjectDataCl *__attribute__((aligned(16))) objectsData =
 		(__global sObjectDataCl *)&inBuff[objectsOffset];
 
+	//--- Cone-marching pre-pass
+
+#ifdef CONE_MARCH_PREPASS
+	int coneMarchMainOffset = GetInteger(5 * sizeof(int), inBuff);
+	int coneMarchTileSize = GetInteger(coneMarchMainOffset, inBuff);
+	int coneMarchTilesX = GetInteger(coneMarchMainOffset + 1 * sizeof(int), inBuff);
+	int coneMarchArrayOffset = GetInteger(coneMarchMainOffset + 3 * sizeof(int), inBuff);
+
+	__global float *coneMarchDepths = (__global float *)&inBuff[coneMarchArrayOffset];
+	float coneMarchStartDistance =
+		coneMarchDepths[imageX / coneMarchTileSize + (imageY / coneMarchTileSize) * coneMarchTilesX];
+#endif
+
 	//--------- end of data file ----------------------------------
 
 	sClPixel pixel;
@@ -358,7 +371,7 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff, __global ch
 		float opacityOut;
 		float3 surfaceColor = 0.0f;
 
-		float3 point;
+		float3 point = 0.0f;
 		float depth = 0.0f;
 
 		int reflectionsMax = consts->params.reflectionsMax;
@@ -420,7 +433,7 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff, __global ch
 
 		float4 resultShader = 0.0f;
 		float3 objectColour = 0.0f;
-		float3 normal;
+		float3 normal = 0.0f;
 		float opacity = 0.0f;
 
 #ifdef PERSP_FISH_EYE_CUT
@@ -434,7 +447,11 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff, __global ch
 			rayMarchingIn.binaryEnable = true;
 			rayMarchingIn.direction = normalize(viewVector);
 			rayMarchingIn.maxScan = consts->params.viewDistanceMax;
+#ifdef CONE_MARCH_PREPASS
+			rayMarchingIn.minScan = coneMarchStartDistance;
+#else
 			rayMarchingIn.minScan = 0.0f;
+#endif
 			rayMarchingIn.start = start;
 			rayMarchingIn.invertMode = false;
 			recursionIn.rayMarchingIn = rayMarchingIn;
@@ -451,6 +468,7 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff, __global ch
 			if (!recursionOut.found) depth = 1e20f;
 			opacity = recursionOut.fogOpacity;
 			normal = recursionOut.normal;
+			point = recursionOut.point;
 
 #ifdef PERSP_FISH_EYE_CUT
 		}
@@ -482,6 +500,12 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff, __global ch
 			pixel.G = pixelLeftColor.s1;
 			pixel.B = pixelLeftColor.s2;
 			pixel.zBuffer = depth;
+			pixel.normalX = normal.x;
+			pixel.normalY = normal.y;
+			pixel.normalZ = normal.z;
+			pixel.worldX = point.x;
+			pixel.worldY = point.y;
+			pixel.worldZ = point.z;
 			pixel.colR = objectColour.s0 * 256.0f;
 			pixel.colG = objectColour.s1 * 256.0f;
 			pixel.colB = objectColour.s2 * 256.0f;
@@ -505,6 +529,12 @@ kernel void fractal3D(__global sClPixel *out, __global char *inBuff, __global ch
 #endif
 
 	pixel.zBuffer = depth;
+	pixel.normalX = normal.x;
+	pixel.normalY = normal.y;
+	pixel.normalZ = normal.z;
+	pixel.worldX = point.x;
+	pixel.worldY = point.y;
+	pixel.worldZ = point.z;
 	pixel.colR = objectColour.s0 * 256.0f;
 	pixel.colG = objectColour.s1 * 256.0f;
 	pixel.colB = objectColour.s2 * 256.0f;
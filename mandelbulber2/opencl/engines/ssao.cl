@@ -32,14 +32,100 @@
  * SSAO shader function optimized for opencl
  */
 
+// horizon based SSAO on min-max depth pyramid (the same as cSSAOWorker::DoWorkHierarchical())
+float SSAOHierarchical(int2 scr, float z, __global float *sineCosineBuffer,
+	__global float2 *depthPyramid, __global int4 *pyramidLevels, __global float2 *ssaoSteps,
+	sParamsSSAO *p, int randomSeed)
+{
+	float aspectRatio = (float)p->width / p->height;
+	float2 plane = (float2){((float)scr.x / p->width - 0.5f) * aspectRatio,
+									 (float)scr.y / p->height - 0.5f}
+								 * p->fov;
+	float2 position = plane * z;
+
+	// random mode rotates all directions and scales all steps of the pixel
+	float rRandom = 1.0f;
+	float2 rotation = (float2){1.0f, 0.0f};
+	if (p->random_mode)
+	{
+		for (int k = 0; k < 3; k++)
+			randomSeed = RandomInt(&randomSeed);
+		rRandom = 0.5f + Random(65536, &randomSeed) / 65536.0f;
+		float angle = Random(62831 / p->quality, &randomSeed) / 10000.0f;
+		rotation = (float2){cos(angle), sin(angle)};
+	}
+
+	float ambient = 0.0f;
+	int rayCount = 0;
+	for (int d = 0; d < p->quality; d++)
+	{
+		float2 dirBase = (float2){sineCosineBuffer[d + p->quality], sineCosineBuffer[d]};
+		float2 dir = (float2){dirBase.x * rotation.x - dirBase.y * rotation.y,
+			dirBase.y * rotation.x + dirBase.x * rotation.y};
+
+		float maxDiff = -1e30f;
+		bool wasRay = false;
+		for (int s = 0; s < p->numberOfSteps; s++)
+		{
+			// x - radius, y - pyramid level
+			float2 step = ssaoSteps[s];
+			float2 v = convert_float2(scr) + 0.5f + step.x * rRandom * dir;
+
+			// steps are sorted by radius, so next ones are outside the image too
+			if (v.x < 0.0f || v.x >= p->width || v.y < 0.0f || v.y >= p->height) break;
+			int2 iv = convert_int2(v);
+			if (iv.x == scr.x && iv.y == scr.y) continue;
+
+			float2 samplePlane = (float2){((float)iv.x / p->width - 0.5f) * aspectRatio,
+														 (float)iv.y / p->height - 0.5f}
+													 * p->fov;
+			float planeDistance = distance(samplePlane, plane) * z;
+
+			// cells which contain depth discontinuities are checked on finer levels
+			int level = (int)step.y;
+			int4 l = pyramidLevels[level];
+			float2 zMinMax = depthPyramid[l.z + (iv.y >> level) * l.x + (iv.x >> level)];
+			while (level > 0 && zMinMax.y - zMinMax.x > p->maxDepthRangeRatio * planeDistance)
+			{
+				level--;
+				l = pyramidLevels[level];
+				zMinMax = depthPyramid[l.z + (iv.y >> level) * l.x + (iv.x >> level)];
+			}
+
+			wasRay = true;
+
+			float diff = (z - zMinMax.x) / distance(samplePlane * zMinMax.x, position);
+			maxDiff = max(maxDiff, diff);
+		}
+
+		if (wasRay)
+		{
+			ambient += -atan(maxDiff) / M_PI_F + 0.5f;
+			rayCount++;
+		}
+	}
+
+	return (rayCount > 0) ? max(ambient / rayCount, 0.0f) : 0.0f;
+}
+
 //------------------ MAIN RENDER FUNCTION --------------------
-kernel void SSAO(
-	__global float *zBuffer, __global float *sineCosineBuffer, __global float *out, sParamsSSAO p)
+kernel void SSAO(__global float *zBuffer, __global float *sineCosineBuffer,
+	__global float2 *depthPyramid, __global int4 *pyramidLevels, __global float2 *ssaoSteps,
+	__global float *out, sParamsSSAO p)
 {
 	const unsigned int i = get_global_id(0);
 	const int2 scr = (int2){i % p.width, i / p.width};
 	const float2 scr_f = convert_float2(scr);
 
+	if (p.hierarchical)
+	{
+		float z = zBuffer[i];
+		out[i] = (z < 1.0e5f) ? SSAOHierarchical(scr, z, sineCosineBuffer, depthPyramid,
+															pyramidLevels, ssaoSteps, &p, i)
+													: 0.0f;
+		return;
+	}
+
 	float scaleFactor = (float)p.width / (p.quality * p.quality) / 2.0f;
 	float aspectRatio = (float)p.width / p.height;
 
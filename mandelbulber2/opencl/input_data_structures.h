@@ -47,6 +47,13 @@ typedef struct
 	cl_float G;
 	cl_float B;
 	cl_float zBuffer;
+	// world normal and position, filled only by full engine (guides for denoiser)
+	cl_float normalX;
+	cl_float normalY;
+	cl_float normalZ;
+	cl_float worldX;
+	cl_float worldY;
+	cl_float worldZ;
 	cl_ushort opacity;
 	cl_ushort alpha;
 	cl_uchar colR;
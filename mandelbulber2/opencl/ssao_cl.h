@@ -42,6 +42,9 @@ typedef struct
 	cl_int quality;
 	cl_float fov;
 	cl_int random_mode;
+	cl_int hierarchical;
+	cl_int numberOfSteps;
+	cl_float maxDepthRangeRatio;
 } sParamsSSAO;
 
 #endif /* MANDELBULBER2_OPENCL_SSAO_CL_H_ */
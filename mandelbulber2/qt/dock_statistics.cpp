@@ -75,6 +75,12 @@ void cDockStatistics::slotUpdateStatistics(cStatistics stat) const
 		QString::number(stat.GetNumberOfIterationsPerSecond()));
 	ui->tableWidget_statistics->item(3, 0)->setText(stat.GetDETypeString());
 	ui->tableWidget_statistics->item(4, 0)->setText(QString::number(stat.GetMissedDEPercentage()));
+	ui->tableWidget_statistics->item(6, 0)->setText(
+		QString::number(stat.GetConeMarchingSavedStepsPerPixel()));
+	ui->tableWidget_statistics->item(7, 0)->setText(
+		QString::number(stat.GetDistanceEvaluationsPerRay()));
+	ui->tableWidget_statistics->item(8, 0)->setText(
+		QString::number(stat.GetBackgroundRaysPercentage()));
 	gMainInterface->mainWindow->GetWidgetDockRenderingEngine()->UpdateLabelWrongDEPercentage(
 		tr("Percentage of wrong distance estimations: %1").arg(stat.GetMissedDEPercentage()));
 	gMainInterface->mainWindow->GetWidgetDockRenderingEngine()->UpdateLabelUsedDistanceEstimation(
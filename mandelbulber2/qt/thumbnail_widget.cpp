@@ -44,6 +44,7 @@
 
 #include "src/cimage.hpp"
 #include "src/common_math.h"
+#include "src/fractal_enums.h"
 #include "src/global_data.hpp"
 #include "src/interface.hpp"
 #include "src/opencl_engine_render_fractal.h"
@@ -53,6 +54,7 @@
 #include "src/stereo.h"
 #include "src/system_data.hpp"
 #include "src/system_directories.hpp"
+#include "src/thumbnail_render_service.hpp"
 #include "src/wait.hpp"
 
 cThumbnailWidget::cThumbnailWidget(QWidget *parent) : QWidget(parent)
@@ -81,7 +83,8 @@ void cThumbnailWidget::Init(QWidget *parent)
 	hasParameters = false;
 	disableTimer = false;
 	disableThumbnailCache = false;
-	connect(this, SIGNAL(renderRequest()), this, SLOT(slotRender()));
+	renderJobCounter = 0;
+	connect(this, SIGNAL(renderRequest()), this, SLOT(slotRenderOnPaint()));
 	params.reset(new cParameterContainer);
 	fractal.reset(new cFractalContainer);
 	useOneCPUCore = false;
@@ -120,6 +123,7 @@ cThumbnailWidget::~cThumbnailWidget()
 		image.reset();
 		// qDebug() << "cThumbnailWidget image deleted" << instanceIndex;
 	}
+	if (gThumbnailRenderService) gThumbnailRenderService->Cancel(this);
 
 	instanceCount--;
 	// qDebug() << "cThumbnailWidget destructed" << instanceIndex;
@@ -209,6 +213,7 @@ void cThumbnailWidget::AssignParameters(std::shared_ptr<const cParameterContaine
 			{
 				// just wait and pray
 			}
+			if (gThumbnailRenderService) gThumbnailRenderService->Cancel(this);
 
 			emit settingsChanged();
 
@@ -229,28 +234,7 @@ void cThumbnailWidget::AssignParameters(std::shared_ptr<const cParameterContaine
 				QPixmap pixmap;
 				pixmap.load(thumbnailFileName);
 				pixmap = pixmap.scaled(tWidth, tHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-				QImage qImage = pixmap.toImage();
-				qImage = qImage.convertToFormat(QImage::Format_RGB888);
-
-				std::vector<sRGB8> &preview = image->GetPreviewPrimary();
-				std::vector<sRGB8> &preview2 = image->GetPreview();
-
-				int bWidth = qImage.width();
-				int bHeight = qImage.height();
-
-				if (!qImage.isNull())
-				{
-					for (int y = 0; y < bHeight; y++)
-					{
-						sRGB8 *line = reinterpret_cast<sRGB8 *>(qImage.scanLine(y));
-						for (int x = 0; x < bWidth; x++)
-						{
-							sRGB8 pixel(quint8(line[x].R), quint8(line[x].G), quint8(line[x].B));
-							preview[x + y * bWidth] = pixel;
-							preview2[x + y * bWidth] = pixel;
-						}
-					}
-				}
+				LoadPreview(pixmap.toImage());
 
 				params.reset();
 				fractal.reset();
@@ -275,7 +259,42 @@ void cThumbnailWidget::AssignParameters(std::shared_ptr<const cParameterContaine
 	}
 }
 
+void cThumbnailWidget::LoadPreview(QImage qImage)
+{
+	qImage = qImage.convertToFormat(QImage::Format_RGB888);
+
+	std::vector<sRGB8> &preview = image->GetPreviewPrimary();
+	std::vector<sRGB8> &preview2 = image->GetPreview();
+
+	int bWidth = qImage.width();
+	int bHeight = qImage.height();
+
+	if (!qImage.isNull())
+	{
+		for (int y = 0; y < bHeight; y++)
+		{
+			sRGB8 *line = reinterpret_cast<sRGB8 *>(qImage.scanLine(y));
+			for (int x = 0; x < bWidth; x++)
+			{
+				sRGB8 pixel(quint8(line[x].R), quint8(line[x].G), quint8(line[x].B));
+				preview[x + y * bWidth] = pixel;
+				preview2[x + y * bWidth] = pixel;
+			}
+		}
+	}
+}
+
 void cThumbnailWidget::slotRender()
+{
+	RequestRender(false);
+}
+
+void cThumbnailWidget::slotRenderOnPaint()
+{
+	RequestRender(true);
+}
+
+void cThumbnailWidget::RequestRender(bool cancellable)
 {
 	// qDebug() << "slotRender";
 	if (image && params)
@@ -287,54 +306,101 @@ void cThumbnailWidget::slotRender()
 			Wait(100);
 		}
 
-		// random wait to not generate to many events at exactly the same time
-		Wait(Random(100) + 50);
+		// render service exists only with GUI, otherwise the thumbnail is rendered immediately
+		if (gThumbnailRenderService)
+			gThumbnailRenderService->Request(this, cancellable);
+		else
+			StartRenderJob(useOneCPUCore);
+	}
+	else
+	{
+		qCritical() << "Parameters or image not yet allocated!";
+	}
+}
 
-		if (!disableTimer && cRenderJob::GetRunningJobCount() > systemData.numberOfThreads)
-		{
-			// try again after some random time
-			timer->start(Random(5000) + 1);
-			return;
-		}
+int cThumbnailWidget::StartRenderJob(bool oneCPUCore)
+{
+	if (!image || !params) return -1;
+
+	stopRequest = false;
+
+	cRenderJob *renderJob =
+		new cRenderJob(params, fractal, image, &stopRequest, static_cast<QWidget *>(this));
+	connect(renderJob, SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)),
+		this, SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
+	connect(renderJob, SIGNAL(updateImage()), this, SLOT(update()));
+	connect(renderJob, &cRenderJob::signalTotalRenderTime, this,
+		&cThumbnailWidget::signalTotalRenderTime);
 
-		stopRequest = false;
+	renderingTimeTimer.start();
+	renderJob->UseSizeFromImage(true);
 
-		cRenderJob *renderJob =
-			new cRenderJob(params, fractal, image, &stopRequest, static_cast<QWidget *>(this));
-		connect(renderJob, SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)),
-			this, SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
-		connect(renderJob, SIGNAL(updateImage()), this, SLOT(update()));
-		connect(renderJob, &cRenderJob::signalTotalRenderTime, this,
-			&cThumbnailWidget::signalTotalRenderTime);
+	cRenderingConfiguration config;
+	if (useOneCPUCore || oneCPUCore) config.DisableMultiThread();
+	config.EnableIgnoreErrors();
+	config.DisableNetRender();
 
-		renderingTimeTimer.start();
-		renderJob->UseSizeFromImage(true);
+	renderJob->Init(cRenderJob::still, config);
 
-		cRenderingConfiguration config;
-		if (useOneCPUCore) config.DisableMultiThread();
-		config.EnableIgnoreErrors();
-		config.DisableNetRender();
+	QThread *thread = new QThread;
+	renderJob->moveToThread(thread);
+	QObject::connect(thread, SIGNAL(started()), renderJob, SLOT(slotExecute()));
 
-		renderJob->Init(cRenderJob::still, config);
+	thread->setObjectName("ThumbnailWorker");
+	thread->start();
 
-		QThread *thread = new QThread;
-		renderJob->moveToThread(thread);
-		QObject::connect(thread, SIGNAL(started()), renderJob, SLOT(slotExecute()));
+	int jobId = ++renderJobCounter;
 
-		thread->setObjectName("ThumbnailWorker");
-		thread->start();
+	QObject::connect(renderJob, SIGNAL(finished()), renderJob, SLOT(deleteLater()));
+	QObject::connect(renderJob, SIGNAL(finished()), thread, SLOT(quit()));
+	QObject::connect(renderJob, SIGNAL(fullyRendered(const QString &, const QString &)), this,
+		SLOT(slotFullyRendered()));
+	QObject::connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+	connect(thread, &QThread::finished, this, &cThumbnailWidget::signalFinished);
+	connect(thread, &QThread::finished, this, [this, jobId]() { emit renderJobFinished(jobId); });
 
-		QObject::connect(renderJob, SIGNAL(finished()), renderJob, SLOT(deleteLater()));
-		QObject::connect(renderJob, SIGNAL(finished()), thread, SLOT(quit()));
-		QObject::connect(renderJob, SIGNAL(fullyRendered(const QString &, const QString &)), this,
-			SLOT(slotFullyRendered()));
-		QObject::connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
-		connect(thread, &QThread::finished, this, &cThumbnailWidget::signalFinished);
+	return jobId;
+}
+
+void cThumbnailWidget::CancelRender()
+{
+	stopRequest = true;
+	isRendered = false; // will be requested again when painted
+
+	if (!disableTimer && hasParameters)
+	{
+		timer->start(Random(1000000) * 10 + 60000);
 	}
-	else
+}
+
+void cThumbnailWidget::CopyRenderedThumbnail(const cThumbnailWidget *source)
+{
+	QImage qImage(static_cast<const uchar *>(source->image->ConvertTo8bitChar()),
+		int(source->image->GetWidth()), int(source->image->GetHeight()),
+		int(source->image->GetWidth() * sizeof(sRGB8)), QImage::Format_RGB888);
+	LoadPreview(qImage.scaled(tWidth, tHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+
+	isRendered = true;
+	isFullyRendered = true;
+	params.reset();
+	fractal.reset();
+	update();
+	emit thumbnailRendered();
+	emit signalFinished();
+}
+
+QString cThumbnailWidget::GetOpenClProgramKey() const
+{
+	if (!params || !params->Get<bool>("opencl_enabled") || params->Get<int>("opencl_mode") == 0)
+		return QString();
+
+	// thumbnails with the same formulas and engine use the same OpenCL program
+	QString key = QString::number(params->Get<int>("opencl_mode"));
+	for (int i = 1; i <= NUMBER_OF_FRACTALS; i++)
 	{
-		qCritical() << "Parameters or image not yet allocated!";
+		key += QString(",%1").arg(params->Get<int>("formula", i));
 	}
+	return key;
 }
 
 void cThumbnailWidget::slotFullyRendered()
@@ -360,18 +426,11 @@ void cThumbnailWidget::slotFullyRendered()
 
 void cThumbnailWidget::slotRandomRender()
 {
-	if (cRenderJob::GetRunningJobCount() > systemData.numberOfThreads)
+	// render service decides when the thumbnail will be rendered
+	if (!disableTimer && image && params)
 	{
-		// if it's to busy, render later
-		timer->start(Random(1000) * 10 + 1);
-	}
-	else
-	{
-		if (!disableTimer)
-		{
-			isRendered = true;
-			slotRender();
-		}
+		isRendered = true;
+		RequestRender(true);
 	}
 }
 
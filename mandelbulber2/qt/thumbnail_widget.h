@@ -35,6 +35,7 @@
  * The class then asynchronously renders the fractal as a thumbnail and displays it.
  * The fractal thumbnails can also be cached in filesystem for faster loading.
  * Signals for progress and render finish can be connected, see also usage in PreviewFileDialog.
+ * Render jobs are started by cThumbnailRenderService, which orders requests of all widgets.
  */
 
 #ifndef MANDELBULBER2_QT_THUMBNAIL_WIDGET_H_
@@ -45,6 +46,7 @@
 #include <memory>
 
 #include <QElapsedTimer>
+#include <QImage>
 #include <QWidget>
 
 // forward declarations
@@ -72,15 +74,27 @@ public:
 	QString GetThumbnailFileName() const;
 	void StopRequest() { stopRequest = true; }
 
+	// interface for cThumbnailRenderService
+	QString GetHash() const { return hash; }
+	bool IsThumbnailCacheDisabled() const { return disableThumbnailCache; }
+	QString GetOpenClProgramKey() const;
+	bool IsVisibleOnScreen() const { return isVisible() && !visibleRegion().isEmpty(); }
+	int StartRenderJob(bool oneCPUCore);
+	void CancelRender();
+	void CopyRenderedThumbnail(const cThumbnailWidget *source);
+
 	static int instanceCount;
 	int instanceIndex;
 
 private:
 	void paintEvent(QPaintEvent *event) override;
+	void RequestRender(bool cancellable);
+	void LoadPreview(QImage qImage);
 
 private slots:
 	void slotFullyRendered();
 	void slotRandomRender();
+	void slotRenderOnPaint();
 
 public slots:
 	void slotSetMinimumSize(int width, int height);
@@ -104,6 +118,7 @@ private:
 	bool disableTimer;
 	bool disableRenderOnPaint = false;
 	bool disableThumbnailCache;
+	int renderJobCounter;
 	// timer for random trigger for rendering (renders thumbnail even when is not visible)
 	QTimer *timer;
 	QElapsedTimer renderingTimeTimer;
@@ -119,6 +134,7 @@ signals:
 	void signalZeroDistance();
 	void signalTotalRenderTime(double seconds);
 	void signalFinished();
+	void renderJobFinished(int jobId);
 };
 
 #endif /* MANDELBULBER2_QT_THUMBNAIL_WIDGET_H_ */
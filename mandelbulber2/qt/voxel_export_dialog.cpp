@@ -86,14 +86,17 @@ void cVoxelExportDialog::on_pushButton_start_render_layers_clicked()
 		int samplesY = gPar->Get<int>("voxel_samples_y");
 		int samplesZ = gPar->Get<int>("voxel_samples_z");
 		bool greyscale = gPar->Get<bool>("voxel_greyscale_iterations");
+		cVoxelExport::enumVoxelFormat voxelFormat = gPar->Get<bool>("voxel_sparse_volume")
+																									? cVoxelExport::voxelFormatSparseVolume
+																									: cVoxelExport::voxelFormatSlice;
 
 		QDir folder(folderString);
 		if (folder.exists())
 		{
 			slicerBusy = true;
 			// voxelExport deleted by deleteLater()
-			voxelExport = new cVoxelExport(
-				samplesX, samplesY, samplesZ, limitMin, limitMax, folder, maxIter, greyscale);
+			voxelExport = new cVoxelExport(samplesX, samplesY, samplesZ, limitMin, limitMax, folder,
+				maxIter, greyscale, voxelFormat);
 			QObject::connect(voxelExport,
 				SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
 				SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)));
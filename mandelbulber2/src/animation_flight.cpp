@@ -46,6 +46,7 @@
 
 #include "ui_dock_animation.h"
 
+#include "animation_frame_batch.hpp"
 #include "animation_frames.hpp"
 #include "cimage.hpp"
 #include "common_math.h"
@@ -61,6 +62,7 @@
 #include "render_window.hpp"
 #include "rendered_image_widget.hpp"
 #include "rendering_configuration.hpp"
+#include "reprojection_cache.hpp"
 #include "settings.hpp"
 #include "system_data.hpp"
 #include "system_directories.hpp"
@@ -985,6 +987,38 @@ void cFlightAnimation::ConfirmAndSendRenderedFrames(
 	}
 }
 
+std::unique_ptr<cAnimationFrameBatch> cFlightAnimation::PrepareFrameBatch() const
+{
+	// frames have to be rendered one by one when they are distributed by NetRender or rendered
+	// with OpenCL, or when depth of previous frame is reused
+	if (gNetRender->IsClient() || gNetRender->IsServer() || params->Get<bool>("opencl_enabled")
+			|| params->Get<bool>("flight_reprojection_cache"))
+		return nullptr;
+
+	const int parallelFrames = cAnimationFrameBatch::NumberOfParallelFrames(
+		params->Get<int>("flight_parallel_frames"), systemData.numberOfThreads);
+	if (parallelFrames < 2) return nullptr;
+
+	return std::unique_ptr<cAnimationFrameBatch>(
+		new cAnimationFrameBatch(parallelFrames, cRenderJob::flightAnim));
+}
+
+void cFlightAnimation::RenderFrameBatch(cAnimationFrameBatch *frameBatch, bool *stopRequest)
+{
+	const ImageFileSave::enumImageFileType fileType =
+		ImageFileSave::enumImageFileType(params->Get<int>("flight_animation_image_type"));
+	const bool result = frameBatch->Render(fileType, stopRequest);
+
+	// frames which were finished are marked also when rendering was interrupted
+	for (int frameIndex : frameBatch->GetRenderedFrames())
+	{
+		renderedFramesCount++;
+		alreadyRenderedFrames[frameIndex] = true;
+	}
+
+	if (!result) throw false;
+}
+
 bool cFlightAnimation::RenderFlight(bool *stopRequest)
 {
 	mainInterface->DisablePeriodicRefresh();
@@ -1008,6 +1042,11 @@ bool cFlightAnimation::RenderFlight(bool *stopRequest)
 
 	std::shared_ptr<cRenderJob> renderJob = PrepareRenderJob(stopRequest);
 
+	if (params->Get<bool>("flight_reprojection_cache"))
+	{
+		renderJob->SetReprojectionCache(std::make_shared<cReprojectionCache>());
+	}
+
 	cRenderingConfiguration config;
 
 	if (systemData.noGui)
@@ -1068,6 +1107,9 @@ bool cFlightAnimation::RenderFlight(bool *stopRequest)
 			InitJobsForClients(frameRanges);
 		}
 
+		// optional rendering of several frames at the same time
+		std::unique_ptr<cAnimationFrameBatch> frameBatch = PrepareFrameBatch();
+
 		for (int index = 0; index < frames->GetNumberOfFrames(); ++index)
 		{
 			// skip already rendered frame
@@ -1104,6 +1146,13 @@ bool cFlightAnimation::RenderFlight(bool *stopRequest)
 
 			params->Set("frame_no", index);
 
+			if (frameBatch)
+			{
+				frameBatch->AddFrame(index, GetFlightFilename(index, false), params, fractalParams);
+				if (frameBatch->IsFull()) RenderFrameBatch(frameBatch.get(), stopRequest);
+				continue;
+			}
+
 			// render frame
 			renderJob->UpdateParameters(params, fractalParams);
 			const int result = renderJob->Execute();
@@ -1129,6 +1178,8 @@ bool cFlightAnimation::RenderFlight(bool *stopRequest)
 			gApplication->processEvents();
 		}
 
+		if (frameBatch && !frameBatch->IsEmpty()) RenderFrameBatch(frameBatch.get(), stopRequest);
+
 		emit updateProgressAndStatus(QObject::tr("Animation finished"), progressText.getText(1.0), 1.0,
 			cProgressText::progress_IMAGE);
 		emit notifyRenderFlightRenderStatus(
@@ -54,6 +54,7 @@
 #include "statistics.h"
 
 // forward declarations
+class cAnimationFrameBatch;
 class cImage;
 class cInterface;
 class cFractalContainer;
@@ -145,6 +146,8 @@ private:
 		const sFrameRanges &frameRanges, cProgressText *progressText, int index);
 	void UpdateCameraAndTarget();
 	void ConfirmAndSendRenderedFrames(const int frameIndex, const QStringList &listOfSavedFiles);
+	std::unique_ptr<cAnimationFrameBatch> PrepareFrameBatch() const;
+	void RenderFrameBatch(cAnimationFrameBatch *frameBatch, bool *stopRequest);
 
 	cInterface *mainInterface;
 	Ui::cDockAnimation *ui;
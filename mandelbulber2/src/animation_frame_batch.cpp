@@ -0,0 +1,205 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cAnimationFrameBatch - renders several animation frames at the same time, each frame with
+ * its own image, render job and part of CPU threads
+ */
+
+#include "animation_frame_batch.hpp"
+
+#include <QThread>
+
+#include "cimage.hpp"
+#include "files.h"
+#include "fractal_container.hpp"
+#include "global_data.hpp"
+#include "parameters.hpp"
+#include "render_trace.hpp"
+#include "rendering_configuration.hpp"
+#include "system_data.hpp"
+#include "write_log.hpp"
+
+cAnimationFrameWorker::cAnimationFrameWorker(std::shared_ptr<cRenderJob> _renderJob,
+	std::shared_ptr<cImage> _image, const QString &_filename,
+	ImageFileSave::enumImageFileType _fileType)
+		: QObject()
+{
+	renderJob = _renderJob;
+	image = _image;
+	filename = _filename;
+	fileType = _fileType;
+	finishedFlag = false;
+	result = false;
+}
+
+cAnimationFrameWorker::~cAnimationFrameWorker()
+{
+	// nothing to delete
+}
+
+void cAnimationFrameWorker::doWork()
+{
+	result = renderJob->Execute();
+	if (result)
+	{
+		cTraceSpan traceSpan("save frame", "animation");
+		listOfSavedFiles = SaveImage(filename, fileType, image, nullptr);
+	}
+	finishedFlag = true;
+	emit finished();
+}
+
+cAnimationFrameBatch::cAnimationFrameBatch(int _numberOfSlots, cRenderJob::enumMode _mode)
+		: QObject()
+{
+	frameSlots.resize(size_t(_numberOfSlots));
+	usedSlots = 0;
+	mode = _mode;
+	threadsPerFrame = qMax(1, systemData.numberOfThreads / _numberOfSlots);
+}
+
+cAnimationFrameBatch::~cAnimationFrameBatch()
+{
+	// nothing to delete
+}
+
+int cAnimationFrameBatch::NumberOfParallelFrames(int requested, int totalNumberOfThreads)
+{
+	return qBound(1, requested, qMax(1, totalNumberOfThreads / 2));
+}
+
+void cAnimationFrameBatch::AddFrame(int frameIndex, const QString &filename,
+	const std::shared_ptr<cParameterContainer> params,
+	const std::shared_ptr<cFractalContainer> fractalParams)
+{
+	sSlot &slot = frameSlots[size_t(usedSlots)];
+	if (!slot.params)
+	{
+		slot.params.reset(new cParameterContainer());
+		slot.fractalParams.reset(new cFractalContainer());
+	}
+	*slot.params = *params;
+	*slot.fractalParams = *fractalParams;
+	slot.frameIndex = frameIndex;
+	slot.filename = filename;
+	usedSlots++;
+}
+
+bool cAnimationFrameBatch::InitSlot(sSlot *slot) const
+{
+	slot->image.reset(
+		new cImage(slot->params->Get<int>("image_width"), slot->params->Get<int>("image_height")));
+	slot->renderJob.reset(
+		new cRenderJob(slot->params, slot->fractalParams, slot->image, &slot->stopRequest));
+
+	cRenderingConfiguration config;
+	config.DisableRefresh();
+	config.DisableProgressiveRender();
+	config.SetNumberOfThreads(threadsPerFrame);
+
+	return slot->renderJob->Init(mode, config);
+}
+
+bool cAnimationFrameBatch::Render(
+	ImageFileSave::enumImageFileType fileType, const bool *stopRequest)
+{
+	WriteLogInt("cAnimationFrameBatch::Render() frames", usedSlots, 2);
+
+	renderedFrames.clear();
+	listsOfSavedFiles.clear();
+
+	std::vector<std::shared_ptr<cAnimationFrameWorker>> workers;
+	std::vector<std::shared_ptr<QThread>> threads;
+
+	bool initFailed = false;
+	for (int i = 0; i < usedSlots; i++)
+	{
+		sSlot &slot = frameSlots[size_t(i)];
+		slot.stopRequest = false;
+		if (!slot.renderJob)
+		{
+			// render jobs are reused for next batches like in serial rendering of animation
+			if (!InitSlot(&slot))
+			{
+				slot.renderJob.reset();
+				initFailed = true;
+				break;
+			}
+		}
+		else
+		{
+			slot.renderJob->UpdateParameters(slot.params, slot.fractalParams);
+		}
+
+		std::shared_ptr<cAnimationFrameWorker> worker(
+			new cAnimationFrameWorker(slot.renderJob, slot.image, slot.filename, fileType));
+		std::shared_ptr<QThread> thread(new QThread);
+		worker->moveToThread(thread.get());
+		connect(thread.get(), SIGNAL(started()), worker.get(), SLOT(doWork()));
+		connect(worker.get(), SIGNAL(finished()), thread.get(), SLOT(quit()));
+		thread->setObjectName("AnimationFrame");
+		thread->start();
+
+		workers.push_back(worker);
+		threads.push_back(thread);
+	}
+
+	// wait for all frames, keeping user interface responsive and passing stop requests
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		while (!threads[i]->wait(10))
+		{
+			if (*stopRequest || systemData.globalStopRequest || initFailed)
+			{
+				for (int s = 0; s < usedSlots; s++)
+					frameSlots[size_t(s)].stopRequest = true;
+			}
+			gApplication->processEvents();
+		}
+	}
+
+	bool result = !initFailed;
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		if (workers[i]->GetResult())
+		{
+			renderedFrames.append(frameSlots[i].frameIndex);
+			listsOfSavedFiles.append(workers[i]->GetListOfSavedFiles());
+		}
+		else
+		{
+			result = false;
+		}
+	}
+
+	usedSlots = 0;
+	return result;
+}
@@ -0,0 +1,129 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cAnimationFrameBatch - renders several animation frames at the same time, each frame with
+ * its own image, render job and part of CPU threads
+ */
+
+#ifndef MANDELBULBER2_SRC_ANIMATION_FRAME_BATCH_HPP_
+#define MANDELBULBER2_SRC_ANIMATION_FRAME_BATCH_HPP_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include "file_image.hpp"
+#include "render_job.hpp"
+
+class cImage;
+class cParameterContainer;
+class cFractalContainer;
+
+// executes render job of one frame in worker thread and saves the image
+class cAnimationFrameWorker : public QObject
+{
+	Q_OBJECT
+public:
+	cAnimationFrameWorker(std::shared_ptr<cRenderJob> _renderJob, std::shared_ptr<cImage> _image,
+		const QString &_filename, ImageFileSave::enumImageFileType _fileType);
+	~cAnimationFrameWorker() override;
+
+	bool IsFinished() const { return finishedFlag; }
+	bool GetResult() const { return result; }
+	const QStringList &GetListOfSavedFiles() const { return listOfSavedFiles; }
+
+public slots:
+	void doWork();
+
+signals:
+	void finished();
+
+private:
+	std::shared_ptr<cRenderJob> renderJob;
+	std::shared_ptr<cImage> image;
+	QString filename;
+	ImageFileSave::enumImageFileType fileType;
+	QStringList listOfSavedFiles;
+	std::atomic<bool> finishedFlag;
+	bool result;
+};
+
+class cAnimationFrameBatch : public QObject
+{
+	Q_OBJECT
+public:
+	cAnimationFrameBatch(int _numberOfSlots, cRenderJob::enumMode _mode);
+	~cAnimationFrameBatch() override;
+
+	// number of frames worth to render at the same time. Every frame needs at least two threads
+	static int NumberOfParallelFrames(int requested, int totalNumberOfThreads);
+
+	bool IsFull() const { return usedSlots >= int(frameSlots.size()); }
+	bool IsEmpty() const { return usedSlots == 0; }
+
+	// takes copy of parameters of interpolated frame
+	void AddFrame(int frameIndex, const QString &filename,
+		const std::shared_ptr<cParameterContainer> params,
+		const std::shared_ptr<cFractalContainer> fractalParams);
+
+	// renders and saves all added frames. Frames which were finished are listed in order of adding
+	// (also when false is returned because of stop request or error)
+	bool Render(ImageFileSave::enumImageFileType fileType, const bool *stopRequest);
+	const QVector<int> &GetRenderedFrames() const { return renderedFrames; }
+	const QVector<QStringList> &GetListsOfSavedFiles() const { return listsOfSavedFiles; }
+
+private:
+	struct sSlot
+	{
+		std::shared_ptr<cImage> image;
+		std::shared_ptr<cRenderJob> renderJob;
+		std::shared_ptr<cParameterContainer> params;
+		std::shared_ptr<cFractalContainer> fractalParams;
+		bool stopRequest = false;
+		int frameIndex = -1;
+		QString filename;
+	};
+
+	bool InitSlot(sSlot *slot) const;
+
+	std::vector<sSlot> frameSlots; // never resized, render jobs keep pointers to stop flags
+	int usedSlots;
+	int threadsPerFrame;
+	cRenderJob::enumMode mode;
+	QVector<int> renderedFrames;
+	QVector<QStringList> listsOfSavedFiles;
+};
+
+#endif /* MANDELBULBER2_SRC_ANIMATION_FRAME_BATCH_HPP_ */
@@ -44,6 +44,7 @@
 
 #include "ui_dock_animation.h"
 
+#include "animation_frame_batch.hpp"
 #include "animation_path_data.hpp"
 #include "cimage.hpp"
 #include "common_math.h"
@@ -837,6 +838,37 @@ void cKeyframeAnimation::UpadeProgressInformation(
 		percentDoneFrame, cProgressText::progress_ANIMATION);
 }
 
+std::unique_ptr<cAnimationFrameBatch> cKeyframeAnimation::PrepareFrameBatch() const
+{
+	// frames have to be rendered one by one when they are distributed by NetRender or rendered
+	// with OpenCL
+	if (gNetRender->IsClient() || gNetRender->IsServer() || params->Get<bool>("opencl_enabled"))
+		return nullptr;
+
+	const int parallelFrames = cAnimationFrameBatch::NumberOfParallelFrames(
+		params->Get<int>("keyframe_parallel_frames"), systemData.numberOfThreads);
+	if (parallelFrames < 2) return nullptr;
+
+	return std::unique_ptr<cAnimationFrameBatch>(
+		new cAnimationFrameBatch(parallelFrames, cRenderJob::keyframeAnim));
+}
+
+void cKeyframeAnimation::RenderFrameBatch(cAnimationFrameBatch *frameBatch, bool *stopRequest)
+{
+	const ImageFileSave::enumImageFileType fileType =
+		ImageFileSave::enumImageFileType(params->Get<int>("keyframe_animation_image_type"));
+	const bool result = frameBatch->Render(fileType, stopRequest);
+
+	// frames which were finished are marked also when rendering was interrupted
+	for (int frameIndex : frameBatch->GetRenderedFrames())
+	{
+		renderedFramesCount++;
+		alreadyRenderedFrames[frameIndex] = true;
+	}
+
+	if (!result) throw false;
+}
+
 bool cKeyframeAnimation::RenderKeyframes(bool *stopRequest)
 {
 	mainInterface->DisablePeriodicRefresh();
@@ -926,6 +958,10 @@ bool cKeyframeAnimation::RenderKeyframes(bool *stopRequest)
 
 		// main loop for rendering of frames
 		renderedFramesCount = 0;
+
+		// optional rendering of several frames at the same time
+		std::unique_ptr<cAnimationFrameBatch> frameBatch = PrepareFrameBatch();
+
 		for (int index = 0; index < keyframes->GetNumberOfFrames() - 1; ++index)
 		{
 			//-------------- rendering of interpolated keyframes ----------------
@@ -972,8 +1008,17 @@ bool cKeyframeAnimation::RenderKeyframes(bool *stopRequest)
 				// recalculation of camera rotation and distance (just for display purposes)
 				UpdateCameraAndTarget();
 
-				// render frame
 				params->Set("frame_no", frameIndex);
+
+				if (frameBatch)
+				{
+					frameBatch->AddFrame(
+						frameIndex, GetKeyframeFilename(index, subIndex, false), params, fractalParams);
+					if (frameBatch->IsFull()) RenderFrameBatch(frameBatch.get(), stopRequest);
+					continue;
+				}
+
+				// render frame
 				renderJob->UpdateParameters(params, fractalParams);
 				result = renderJob->Execute();
 				if (!result) throw false;
@@ -1000,6 +1045,8 @@ bool cKeyframeAnimation::RenderKeyframes(bool *stopRequest)
 			//--------------------------------------------------------------------
 		}
 
+		if (frameBatch && !frameBatch->IsEmpty()) RenderFrameBatch(frameBatch.get(), stopRequest);
+
 		emit updateProgressAndStatus(QObject::tr("Animation finished"), progressText.getText(1.0), 1.0,
 			cProgressText::progress_IMAGE);
 		emit updateProgressHide();
@@ -53,6 +53,7 @@
 #include "statistics.h"
 
 // forward declarations
+class cAnimationFrameBatch;
 class cImage;
 class cInterface;
 class cFractalContainer;
@@ -153,6 +154,8 @@ private:
 	void InitJobsForClients(const sFrameRanges &frameRanges);
 	void UpdateCameraAndTarget();
 	void ConfirmAndSendRenderedFrames(const int frameIndex, const QStringList &listOfSavedFiles);
+	std::unique_ptr<cAnimationFrameBatch> PrepareFrameBatch() const;
+	void RenderFrameBatch(cAnimationFrameBatch *frameBatch, bool *stopRequest);
 	void UpadeProgressInformation(
 		const sFrameRanges &frameRanges, cProgressText *progressText, const int frameIndex, int index);
 
@@ -0,0 +1,486 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cAutoBounds - automatic estimation of bounding boxes of objects on the scene
+ */
+
+#include "auto_bounds.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <QCryptographicHash>
+#include <QStringList>
+
+#include "calculate_distance.hpp"
+#include "fractal.h"
+#include "fractal_container.hpp"
+#include "fractparams.hpp"
+#include "lights.hpp"
+#include "material.h"
+#include "nine_fractals.hpp"
+#include "parameters.hpp"
+#include "primitives.h"
+#include "render_data.hpp"
+#include "system_data.hpp"
+
+QMutex cAutoBounds::cacheMutex;
+QByteArray cAutoBounds::cachedHash;
+std::shared_ptr<const cAutoBounds> cAutoBounds::cachedBounds;
+
+namespace
+{
+bool IsRepeated(const CVector3 &repeat)
+{
+	// CVector3::mod() repeats only along axes with positive period
+	return repeat.x > 0.0 || repeat.y > 0.0 || repeat.z > 0.0;
+}
+} // namespace
+
+void sBoundingBox::Add(const CVector3 &point)
+{
+	if (empty)
+	{
+		min = point;
+		max = point;
+		empty = false;
+		return;
+	}
+	min.x = std::min(min.x, point.x);
+	min.y = std::min(min.y, point.y);
+	min.z = std::min(min.z, point.z);
+	max.x = std::max(max.x, point.x);
+	max.y = std::max(max.y, point.y);
+	max.z = std::max(max.z, point.z);
+}
+
+void sBoundingBox::Add(const sBoundingBox &box)
+{
+	if (box.unbounded) unbounded = true;
+	if (box.empty) return;
+	Add(box.min);
+	Add(box.max);
+}
+
+void sBoundingBox::Expand(double margin)
+{
+	if (empty) return;
+	min -= CVector3(margin, margin, margin);
+	max += CVector3(margin, margin, margin);
+}
+
+bool sBoundingBox::Contains(const CVector3 &cellMin, const CVector3 &cellMax) const
+{
+	return !empty && cellMin.x >= min.x && cellMin.y >= min.y && cellMin.z >= min.z
+				 && cellMax.x <= max.x && cellMax.y <= max.y && cellMax.z <= max.z;
+}
+
+double sBoundingBox::Distance(const CVector3 &point) const
+{
+	if (unbounded) return 0.0;
+	if (empty) return std::numeric_limits<double>::max();
+
+	CVector3 outside(std::max(std::max(min.x - point.x, point.x - max.x), 0.0),
+		std::max(std::max(min.y - point.y, point.y - max.y), 0.0),
+		std::max(std::max(min.z - point.z, point.z - max.z), 0.0));
+	return outside.Length();
+}
+
+bool sBoundingBox::Intersect(
+	const CVector3 &start, const CVector3 &direction, double *tNear, double *tFar) const
+{
+	*tNear = -std::numeric_limits<double>::max();
+	*tFar = std::numeric_limits<double>::max();
+	if (unbounded) return true;
+	if (empty) return false;
+
+	const double startAxis[3] = {start.x, start.y, start.z};
+	const double directionAxis[3] = {direction.x, direction.y, direction.z};
+	const double minAxis[3] = {min.x, min.y, min.z};
+	const double maxAxis[3] = {max.x, max.y, max.z};
+
+	// slab method
+	for (int i = 0; i < 3; i++)
+	{
+		if (directionAxis[i] == 0.0)
+		{
+			if (startAxis[i] < minAxis[i] || startAxis[i] > maxAxis[i]) return false;
+			continue;
+		}
+		double t1 = (minAxis[i] - startAxis[i]) / directionAxis[i];
+		double t2 = (maxAxis[i] - startAxis[i]) / directionAxis[i];
+		if (t1 > t2) std::swap(t1, t2);
+		*tNear = std::max(*tNear, t1);
+		*tFar = std::min(*tFar, t2);
+		if (*tNear > *tFar) return false;
+	}
+	return *tFar >= 0.0;
+}
+
+cAutoBounds::cAutoBounds()
+{
+	// nothing to initialize
+}
+
+cAutoBounds::~cAutoBounds()
+{
+	// nothing to delete
+}
+
+bool cAutoBounds::IsApplicable(const sParamRender &params, const sRenderData &data)
+{
+	// effects which integrate along the whole ray need also steps in empty space
+	if (params.glowEnabled || params.fogEnabled || params.volFogEnabled || params.iterFogEnabled
+			|| params.cloudsEnable || params.fakeLightsEnabled)
+		return false;
+
+	for (int i = 0; i < data.lights.GetNumberOfLights(); i++)
+	{
+		const cLight *light = data.lights.GetLight(i);
+		if (light->enabled && light->volumetric) return false;
+		if (light->IsVisibleAlongRays()) return false;
+	}
+
+	return true;
+}
+
+QByteArray cAutoBounds::CalculateBoundsHash(
+	const cParameterContainer &params, const cFractalContainer &fractals)
+{
+	// camera can fly around the same objects during animation
+	static const QStringList viewParameters = {"camera", "target", "camera_top", "camera_rotation",
+		"camera_distance_to_target", "fov", "perspective_type", "sweet_spot_horizontal_angle",
+		"sweet_spot_vertical_angle", "image_width", "image_height", "frame_no", "view_distance_max",
+		"view_distance_min"};
+
+	QCryptographicHash hashCrypt(QCryptographicHash::Md4);
+
+	for (const QString &parameterName : params.GetListOfParameters())
+	{
+		enumParameterType parameterType = params.GetParameterType(parameterName);
+		if (parameterType == paramApp) continue;
+		if (viewParameters.contains(parameterName) || parameterName.startsWith("stereo_")) continue;
+		hashCrypt.addData((parameterName + "=" + params.Get<QString>(parameterName) + ";").toUtf8());
+	}
+
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		const std::shared_ptr<cParameterContainer> fractal = fractals.at(i);
+		for (const QString &parameterName : fractal->GetListOfParameters())
+		{
+			hashCrypt.addData(
+				(parameterName + "=" + fractal->Get<QString>(parameterName) + ";").toUtf8());
+		}
+	}
+
+	return hashCrypt.result();
+}
+
+std::shared_ptr<const cAutoBounds> cAutoBounds::GetCached(const QByteArray &hash)
+{
+	QMutexLocker lock(&cacheMutex);
+	if (cachedBounds && hash == cachedHash) return cachedBounds;
+	return nullptr;
+}
+
+void cAutoBounds::StoreInCache(const QByteArray &hash, std::shared_ptr<const cAutoBounds> bounds)
+{
+	QMutexLocker lock(&cacheMutex);
+	cachedHash = hash;
+	cachedBounds = bounds;
+}
+
+bool cAutoBounds::Calculate(const sParamRender &params, const cNineFractals &fractals,
+	sRenderData *data, double outerBounding)
+{
+	// distance estimation can be too big, what is compensated by user with smaller step factor
+	double safetyFactor = 0.5 * std::min(params.DEFactor, 1.0);
+
+	// cube of outerBounding size can be rotated by fractal rotation
+	double halfSize = outerBounding * sqrt(3.0);
+	bool repeated = IsRepeated(params.common.repeat);
+
+	int numberOfComponents = params.booleanOperatorsEnabled ? NUMBER_OF_FRACTALS : 1;
+	for (int i = 0; i < numberOfComponents; i++)
+	{
+		sBoundingBox &box = componentBox[i];
+		box = sBoundingBox();
+
+		if (*data->stopRequest || systemData.globalStopRequest) return false;
+
+		if (params.booleanOperatorsEnabled && i > 0 && fractals.GetFractal(i)->formula == fractal::none)
+			continue;
+
+		if (repeated || (params.booleanOperatorsEnabled && IsRepeated(params.formulaRepeat[i])))
+		{
+			box.unbounded = true;
+			continue;
+		}
+
+		int formulaIndex = params.booleanOperatorsEnabled ? i : -1;
+		tDistanceFunction distanceFunction = [&params, &fractals, formulaIndex](
+																					 const CVector3 &point, double detailSize) {
+			sDistanceIn in(point, detailSize, false);
+			sDistanceOut out;
+			out.totalIters = 0;
+			return CalculateDistanceSimple(params, fractals, in, &out, formulaIndex);
+		};
+
+		// coordinates of the component are the same as for CalculateDistanceSimple()
+		sBoundingBox localBox = EstimateBox(
+			distanceFunction, params.common.fractalPosition, halfSize, safetyFactor, data);
+		if (*data->stopRequest || systemData.globalStopRequest) return false;
+
+		if (localBox.empty || localBox.unbounded || !params.booleanOperatorsEnabled)
+		{
+			box = localBox;
+		}
+		else
+		{
+			// boolean component is moved, rotated and scaled before calculation of distance
+			CRotationMatrix mRotInverse = params.mRotFormulaRotation[i].Transpose();
+			for (int c = 0; c < 8; c++)
+			{
+				CVector3 corner((c & 1) ? localBox.max.x : localBox.min.x,
+					(c & 2) ? localBox.max.y : localBox.min.y, (c & 4) ? localBox.max.z : localBox.min.z);
+				box.Add(mRotInverse.RotateVector(corner / params.formulaScale[i])
+								+ params.formulaPosition[i]);
+			}
+		}
+		box.Expand(DisplacementHeight(i, data));
+	}
+
+	primitivesBox = PrimitivesBox(params, data);
+
+	totalBox = primitivesBox;
+	for (int i = 0; i < numberOfComponents; i++)
+		totalBox.Add(componentBox[i]);
+
+	return true;
+}
+
+bool cAutoBounds::ClipRay(
+	const CVector3 &start, const CVector3 &direction, double *minScan, double *maxScan) const
+{
+	double tNear, tFar;
+	if (!totalBox.Intersect(start, direction, &tNear, &tFar))
+	{
+		*maxScan = *minScan - 1.0;
+		return false;
+	}
+	*minScan = std::max(*minScan, tNear);
+	*maxScan = std::min(*maxScan, tFar);
+	return *minScan <= *maxScan;
+}
+
+sBoundingBox cAutoBounds::EstimateBox(const tDistanceFunction &distanceFunction,
+	const CVector3 &center, double halfSize, double safetyFactor, sRenderData *data) const
+{
+	// domain is divided into gridSize^3 cells which are subdivided in parallel
+	const int gridSize = 4;
+	const int numberOfCells = gridSize * gridSize * gridSize;
+
+	CVector3 domainMin = center - CVector3(halfSize, halfSize, halfSize);
+	CVector3 domainMax = center + CVector3(halfSize, halfSize, halfSize);
+	sBoundingBox box;
+	CVector3 leafSize;
+
+	for (int pass = 0; pass < numberOfPasses; pass++)
+	{
+		if (*data->stopRequest || systemData.globalStopRequest) return box;
+
+		CVector3 cellSize = (domainMax - domainMin) / gridSize;
+		leafSize = cellSize / double(1 << numberOfLevels);
+
+		sBoundingBox passBox;
+
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < numberOfCells; i++)
+		{
+			int x = i % gridSize;
+			int y = (i / gridSize) % gridSize;
+			int z = i / (gridSize * gridSize);
+			CVector3 cellMin = domainMin + CVector3(cellSize.x * x, cellSize.y * y, cellSize.z * z);
+			sBoundingBox cellBox;
+			SubdivideCell(
+				distanceFunction, cellMin, cellMin + cellSize, numberOfLevels, safetyFactor, &cellBox);
+#pragma omp critical(autoBoundsMerge)
+			passBox.Add(cellBox);
+		}
+
+		// every cell of the finer grid was proven to be empty
+		if (passBox.empty) return passBox;
+
+		// object which touches the border of the first domain can continue outside
+		if (pass == 0)
+		{
+			CVector3 tolerance = leafSize * 0.5;
+			if (passBox.min.x < domainMin.x + tolerance.x || passBox.min.y < domainMin.y + tolerance.y
+					|| passBox.min.z < domainMin.z + tolerance.z
+					|| passBox.max.x > domainMax.x - tolerance.x
+					|| passBox.max.y > domainMax.y - tolerance.y
+					|| passBox.max.z > domainMax.z - tolerance.z)
+			{
+				passBox.unbounded = true;
+				return passBox;
+			}
+		}
+
+		// space outside of found box is already proven empty, so next pass checks only the box
+		box = passBox;
+		domainMin = box.min;
+		domainMax = box.max;
+	}
+
+	// margin for surfaces crossing the border of the last cells
+	box.Expand(leafSize.Length());
+	return box;
+}
+
+void cAutoBounds::SubdivideCell(const tDistanceFunction &distanceFunction, const CVector3 &cellMin,
+	const CVector3 &cellMax, int level, double safetyFactor, sBoundingBox *box)
+{
+	// cells inside already found box can't make it bigger
+	if (box->Contains(cellMin, cellMax)) return;
+
+	CVector3 cellCenter = (cellMin + cellMax) * 0.5;
+	double halfDiagonal = (cellMax - cellMin).Length() * 0.5;
+
+	double distance = distanceFunction(cellCenter, halfDiagonal * 0.1);
+	// unbounding sphere contains the whole cell
+	if (distance * safetyFactor > halfDiagonal) return;
+
+	if (level == 0)
+	{
+		box->Add(cellMin);
+		box->Add(cellMax);
+		return;
+	}
+
+	CVector3 halfSize = (cellMax - cellMin) * 0.5;
+	for (int i = 0; i < 8; i++)
+	{
+		CVector3 childMin(cellMin.x + ((i & 1) ? halfSize.x : 0.0),
+			cellMin.y + ((i & 2) ? halfSize.y : 0.0), cellMin.z + ((i & 4) ? halfSize.z : 0.0));
+		SubdivideCell(
+			distanceFunction, childMin, childMin + halfSize, level - 1, safetyFactor, box);
+	}
+}
+
+sBoundingBox cAutoBounds::PrimitivesBox(const sParamRender &params, const sRenderData *data)
+{
+	sBoundingBox box;
+	const cPrimitives &primitives = params.primitives;
+	CRotationMatrix mRotInverse = primitives.mRotAllPrimitivesRotation.Transpose();
+
+	for (const sPrimitiveBasic *primitive : *primitives.GetListOfPrimitives())
+	{
+		if (!primitive->enable) continue;
+
+		double radius = PrimitiveBoundingRadius(primitive);
+		if (radius < 0.0)
+		{
+			box.unbounded = true;
+			continue;
+		}
+		radius += DisplacementHeight(primitive->objectId, data);
+
+		// all primitives are moved and rotated together before calculation of distance
+		CVector3 center =
+			mRotInverse.RotateVector(primitive->position) + primitives.allPrimitivesPosition;
+		box.Add(center - CVector3(radius, radius, radius));
+		box.Add(center + CVector3(radius, radius, radius));
+	}
+	return box;
+}
+
+double cAutoBounds::PrimitiveBoundingRadius(const sPrimitiveBasic *primitive)
+{
+	using namespace fractal;
+
+	// negative radius means infinite primitive
+	if (IsRepeated(primitive->repeat)) return -1.0;
+
+	switch (primitive->objectType)
+	{
+		case objBox:
+		{
+			const auto *box = static_cast<const sPrimitiveBox *>(primitive);
+			if (IsRepeated(box->repeat)) return -1.0;
+			return primitive->size.Length() * 0.5 + std::max(box->rounding, 0.0);
+		}
+		case objSphere:
+		{
+			const auto *sphere = static_cast<const sPrimitiveSphere *>(primitive);
+			if (IsRepeated(sphere->repeat)) return -1.0;
+			return sphere->radius;
+		}
+		case objCone:
+		{
+			const auto *cone = static_cast<const sPrimitiveCone *>(primitive);
+			if (IsRepeated(cone->repeat)) return -1.0;
+			return sqrt(cone->radius * cone->radius + cone->height * cone->height);
+		}
+		case objCylinder:
+		{
+			const auto *cylinder = static_cast<const sPrimitiveCylinder *>(primitive);
+			if (IsRepeated(cylinder->repeat)) return -1.0;
+			return sqrt(cylinder->radius * cylinder->radius + cylinder->height * cylinder->height);
+		}
+		case objTorus:
+		{
+			const auto *torus = static_cast<const sPrimitiveTorus *>(primitive);
+			if (IsRepeated(torus->repeat)) return -1.0;
+			// L-pow norms can reach corners of the cube
+			return (torus->radius + torus->tubeRadius) * sqrt(3.0);
+		}
+		case objCircle:
+		{
+			return static_cast<const sPrimitiveCircle *>(primitive)->radius;
+		}
+		case objRectangle:
+		{
+			const auto *rectangle = static_cast<const sPrimitiveRectangle *>(primitive);
+			return 0.5
+						 * sqrt(rectangle->width * rectangle->width + rectangle->height * rectangle->height);
+		}
+		default: return -1.0; // planes and water
+	}
+}
+
+double cAutoBounds::DisplacementHeight(int objectId, const sRenderData *data)
+{
+	if (!data || !data->materialTable.IsCompiled() || objectId >= data->objectData.size()) return 0.0;
+
+	const sCompiledMaterial &compiled = data->materialTable.GetMaterial(objectId);
+	if (!compiled.Has(sCompiledMaterial::flagDisplacementTexture)) return 0.0;
+	return fabs(compiled.material->displacementTextureHeight);
+}
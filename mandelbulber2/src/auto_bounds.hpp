@@ -0,0 +1,135 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cAutoBounds - automatic estimation of bounding boxes of objects on the scene
+ *
+ * Space around each fractal component is divided recursively into cells. A cell is empty when
+ * the unbounding sphere found by distance estimation in its centre contains the whole cell.
+ * Cells which couldn't be proven empty define the bounding box of the component. Primitives
+ * are bounded by spheres calculated from their dimensions. Rays are clipped to the sum of
+ * all boxes, so empty space in front of and behind the objects is not ray-marched.
+ */
+
+#ifndef MANDELBULBER2_SRC_AUTO_BOUNDS_HPP_
+#define MANDELBULBER2_SRC_AUTO_BOUNDS_HPP_
+
+#include <functional>
+#include <memory>
+
+#include <QByteArray>
+#include <QMutex>
+
+#include "algebra.hpp"
+#include "fractal_enums.h"
+
+// forward declarations
+class cFractalContainer;
+class cNineFractals;
+class cParameterContainer;
+struct sParamRender;
+struct sPrimitiveBasic;
+struct sRenderData;
+
+struct sBoundingBox
+{
+	CVector3 min;
+	CVector3 max;
+	bool empty = true;			// there is no object inside
+	bool unbounded = false; // object is infinite or repeated
+
+	void Add(const CVector3 &point);
+	void Add(const sBoundingBox &box);
+	void Expand(double margin);
+	bool Contains(const CVector3 &cellMin, const CVector3 &cellMax) const;
+
+	// lower bound of distance from the point to the object (0 inside the box)
+	double Distance(const CVector3 &point) const;
+
+	// returns false if the ray doesn't cross the box
+	bool Intersect(
+		const CVector3 &start, const CVector3 &direction, double *tNear, double *tFar) const;
+};
+
+class cAutoBounds
+{
+public:
+	cAutoBounds();
+	~cAutoBounds();
+
+	// rays can be clipped only when no effect integrates along the whole ray
+	static bool IsApplicable(const sParamRender &params, const sRenderData &data);
+
+	// hash of parameters which can change the shape of objects (camera is not included)
+	static QByteArray CalculateBoundsHash(
+		const cParameterContainer &params, const cFractalContainer &fractals);
+
+	// returns bounds calculated for the same hash before or nullptr
+	static std::shared_ptr<const cAutoBounds> GetCached(const QByteArray &hash);
+	static void StoreInCache(const QByteArray &hash, std::shared_ptr<const cAutoBounds> bounds);
+
+	// estimates bounds of all objects. outerBounding is assumed maximum size of fractals.
+	// Returns false when calculation was stopped
+	bool Calculate(const sParamRender &params, const cNineFractals &fractals, sRenderData *data,
+		double outerBounding);
+
+	// limits range of the ray to the sum of bounding boxes. Returns false if the ray misses all
+	bool ClipRay(
+		const CVector3 &start, const CVector3 &direction, double *minScan, double *maxScan) const;
+
+	const sBoundingBox &GetTotalBox() const { return totalBox; }
+	const sBoundingBox &GetPrimitivesBox() const { return primitivesBox; }
+	// box of fractal in boolean slot, or of the whole fractal when boolean mode is disabled
+	const sBoundingBox &GetComponentBox(int index) const { return componentBox[index]; }
+
+private:
+	typedef std::function<double(const CVector3 &point, double detailSize)> tDistanceFunction;
+
+	sBoundingBox EstimateBox(const tDistanceFunction &distanceFunction, const CVector3 &center,
+		double halfSize, double safetyFactor, sRenderData *data) const;
+	static void SubdivideCell(const tDistanceFunction &distanceFunction, const CVector3 &cellMin,
+		const CVector3 &cellMax, int level, double safetyFactor, sBoundingBox *box);
+	static sBoundingBox PrimitivesBox(const sParamRender &params, const sRenderData *data);
+	static double PrimitiveBoundingRadius(const sPrimitiveBasic *primitive);
+	static double DisplacementHeight(int objectId, const sRenderData *data);
+
+	static const int numberOfLevels = 5; // depth of cell subdivision in one pass
+	static const int numberOfPasses = 3; // each pass subdivides the box found by previous one
+
+	sBoundingBox componentBox[NUMBER_OF_FRACTALS];
+	sBoundingBox primitivesBox;
+	sBoundingBox totalBox;
+
+	static QMutex cacheMutex;
+	static QByteArray cachedHash;
+	static std::shared_ptr<const cAutoBounds> cachedBounds;
+};
+
+#endif /* MANDELBULBER2_SRC_AUTO_BOUNDS_HPP_ */
@@ -40,6 +40,7 @@
 
 #include <QVector>
 
+#include "auto_bounds.hpp"
 #include "compute_fractal.hpp"
 #include "displacement_map.hpp"
 #include "fractal.h"
@@ -53,6 +54,32 @@
 
 using namespace std;
 
+namespace
+{
+// lower bound of distance from the point to the boolean component given by user defined
+// bounding sphere and by automatically estimated bounding box
+double ComponentBoundDistance(
+	const sParamRender &params, const sRenderData *data, int index, const CVector3 &point)
+{
+	// bounds are given for a single copy of the component, not for its repetitions
+	if (params.formulaRepeat[index].Length() > 0.0) return 0.0;
+
+	double boundDistance = 0.0;
+	if (params.formulaBoundingRadius[index] > 0.0)
+	{
+		boundDistance = (point - params.formulaPosition[index]).Length()
+										- params.formulaBoundingRadius[index];
+	}
+	if (data && data->autoBounds)
+	{
+		boundDistance =
+			max(boundDistance, data->autoBounds->GetComponentBox(index).Distance(point));
+	}
+	// empty component has infinite distance
+	return min(boundDistance, params.viewDistanceMax);
+}
+} // namespace
+
 double CalculateDistance(const sParamRender &params, const cNineFractals &fractals,
 	const sDistanceIn &in, sDistanceOut *out, sRenderData *data)
 {
@@ -105,6 +132,27 @@ double CalculateDistance(const sParamRender &params, const cNineFractals &fracta
 		{
 			if (fractals.GetFractal(i + 1)->formula != fractal::none)
 			{
+				const params::enumBooleanOperator boolOperator = params.booleanOperator[i];
+				const double boundDistance = ComponentBoundDistance(params, data, i + 1, in.point);
+
+				// components which can't change the result are not calculated. Subtraction changes
+				// only points inside 1st object and closer than detailSize * limit * 1.5 to 2nd one
+				if (boolOperator == params::booleanOperatorOR && boundDistance > 0.0
+						&& boundDistance >= distance)
+					continue;
+				if (boolOperator == params::booleanOperatorSUB
+						&& (distance >= in.detailSize || boundDistance >= in.detailSize * 2.25))
+					continue;
+				if (boolOperator == params::booleanOperatorAND
+						&& boundDistance > max(distance, in.detailSize * 2.0))
+				{
+					// intersection is at least as far as the bound of the component. Close to the bound
+					// the component is calculated, otherwise the bound would be found as a surface
+					distance = boundDistance;
+					out->objectId = 1 + i;
+					continue;
+				}
+
 				sDistanceOut outTemp = *out;
 
 				point = in.point - params.formulaPosition[i + 1];
@@ -123,8 +171,6 @@ double CalculateDistance(const sParamRender &params, const cNineFractals &fracta
 
 				distTemp = DisplacementMap(distTemp, pointFractalized, i + 1, data);
 
-				const params::enumBooleanOperator boolOperator = params.booleanOperator[i];
-
 				switch (boolOperator)
 				{
 					case params::booleanOperatorOR:
@@ -37,6 +37,9 @@
 #include <qpainter.h>
 
 #include "common_math.h"
+#include "geometry_buffer.hpp"
+#include "render_trace.hpp"
+
 cImage::cImage(int w, int h, bool _allocLater)
 {
 	isAllocated = false;
@@ -202,6 +205,8 @@ void cImage::FreeImage()
 	diffuseFloat.clear();
 	worldFloat.clear();
 
+	geometryBuffer.reset();
+
 	gammaTable.clear();
 	gammaTablePrepared = false;
 }
@@ -277,6 +282,7 @@ void cImage::CalculateGammaTable()
 
 void cImage::CompileImage(QList<int> *list)
 {
+	cTraceSpan traceSpan("CompileImage", "image");
 	int listIndex = 0;
 	for (quint64 y = 0; y < height; y++)
 	{
@@ -298,6 +304,7 @@ void cImage::CompileImage(QList<int> *list)
 
 void cImage::CompileImage(const QList<QRect> *list)
 {
+	cTraceSpan traceSpan("CompileImage", "image");
 	if (!imageFloat.empty() && !postImageFloat.empty())
 	{
 		for (auto rect : *list)
@@ -316,6 +323,12 @@ void cImage::CompileImage(const QList<QRect> *list)
 	}
 }
 
+std::shared_ptr<cGeometryBuffer> cImage::GetGeometryBuffer()
+{
+	if (!geometryBuffer) geometryBuffer.reset(new cGeometryBuffer());
+	return geometryBuffer;
+}
+
 int cImage::GetUsedMB() const
 {
 	quint64 mb;
@@ -339,8 +352,11 @@ int cImage::GetUsedMB() const
 	optionalSize +=
 		optionalChannels * width * height * (sizeof(sRGBFloat) + sizeof(sRGB16) + sizeof(sRGB8));
 
+	quint64 geometrySize = 0;
+	if (geometryBuffer) geometrySize = width * height * sizeof(sGeometrySample);
+
 	mb = (zBufferSize + alphaSize16 + alphaSize8 + image16Size + image8Size + imageFloatSize * 2
-				 + colorSize + opacitySize + optionalSize)
+				 + colorSize + opacitySize + optionalSize + geometrySize)
 			 / 1024 / 1024;
 
 	return int(mb);
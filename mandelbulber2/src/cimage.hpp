@@ -49,6 +49,8 @@
 #include "color_structures.hpp"
 #include "image_adjustments.h"
 
+class cGeometryBuffer;
+
 struct sImageOptional
 {
 	sImageOptional() {}
@@ -269,6 +271,8 @@ public:
 	std::vector<sRGB8> &GetColor() { return colourBuffer; }
 	std::vector<quint16> &GetOpacity() { return opacityBuffer; }
 	size_t GetZBufferSize() const { return sizeof(float) * quint64(height) * quint64(width); }
+	std::shared_ptr<cGeometryBuffer> GetGeometryBuffer();
+	void FreeGeometryBuffer() { geometryBuffer.reset(); }
 	QWidget *GetImageWidget() { return imageWidget; }
 	std::vector<sRGB8> &GetPreview() { return preview2; }
 	std::vector<sRGB8> &GetPreviewPrimary() { return preview; }
@@ -353,6 +357,9 @@ private:
 	std::vector<sRGBFloat> diffuseFloat;
 	std::vector<sRGBFloat> worldFloat;
 
+	// primary ray hits for incremental re-shading (allocated on demand)
+	std::shared_ptr<cGeometryBuffer> geometryBuffer;
+
 	std::vector<sRGB8> preview;
 	std::vector<sRGB8> preview2;
 	QWidget *imageWidget;
@@ -37,11 +37,13 @@
 
 #include <ctime>
 
+#include <QFile>
 #include <QList>
 
 #include "animation_frames.hpp"
 #include "error_message.hpp"
 #include "file_image.hpp"
+#include "formula_benchmark.hpp"
 #include "fractal_container.hpp"
 #include "global_data.hpp"
 #include "headless.h"
@@ -52,7 +54,10 @@
 #include "old_settings.hpp"
 #include "opencl_global.h"
 #include "opencl_hardware.h"
+#include "progress_metrics.hpp"
 #include "queue.hpp"
+#include "render_daemon.hpp"
+#include "render_trace.hpp"
 #include "settings.hpp"
 #include "system_data.hpp"
 #include "system_directories.hpp"
@@ -155,6 +160,11 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *_qApplication)
 	const QCommandLineOption queueOption(QStringList({"q", "queue"}),
 		QCoreApplication::translate("main", "Renders all images from common queue."));
 
+	const QCommandLineOption daemonOption(QStringList({"daemon"}),
+		QCoreApplication::translate("main",
+			"Runs as a render daemon which takes jobs (still image, voxel, animation) with settings\n"
+			"text over a local socket. Socket name is set by daemon_socket_name parameter."));
+
 	const QCommandLineOption testOption(QStringList({"t", "test"}),
 		QCoreApplication::translate("main", "Runs testcases on the mandelbulber instance"));
 
@@ -164,6 +174,24 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *_qApplication)
 			" parameter difficulty (1 -> very easy, > 20 -> very hard, 10 -> default)."
 			" When [output] option is set to a folder, the example-test images will be stored there."));
 
+	const QCommandLineOption formulaBenchmarkOption(QStringList({"formula-benchmark"}),
+		QCoreApplication::translate("main",
+			"Runs microbenchmark of every fractal formula (formula iterations per second, analytic and"
+			" delta DE samples per second on CPU and on OpenCL CPU device if available), specify"
+			" optional parameter difficulty (10 -> default). Results are written in JSON format to"
+			" [output] file or to stdout."));
+
+	const QCommandLineOption benchmarkBaselineOption(QStringList({"benchmark-baseline"}),
+		QCoreApplication::translate("main",
+			"Compares formula benchmark results with JSON file from previous run and exits with error"
+			" when any value is slower than the baseline by more than the tolerance."),
+		QCoreApplication::translate("main", "FILE"));
+
+	const QCommandLineOption benchmarkToleranceOption(QStringList({"benchmark-tolerance"}),
+		QCoreApplication::translate(
+			"main", "Allowed slowdown in percent when comparing with baseline (default 10)."),
+		QCoreApplication::translate("main", "N"));
+
 	const QCommandLineOption gpuOption(QStringList({"g", "gpu"}),
 		QCoreApplication::translate(
 			"main", "Runs the program in opencl mode and selects first available gpu device."));
@@ -179,10 +207,29 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *_qApplication)
 	const QCommandLineOption voxelOption(QStringList({"V", "voxel"}),
 		QCoreApplication::translate("main",
 			"Renders the voxel volume. Output formats are:\n"
-			"  slice - stack of PNG images into one folder (default)\n"
-			"  ply   - Polygon File Format (single 3d file)\n"),
+			"  slice  - stack of PNG images into one folder (default)\n"
+			"  ply    - Polygon File Format (single 3d file)\n"
+			"  volume - sparse compressed volume with distance and iteration channels\n"
+			"           (single .mbsv file in voxel_image_path)\n"),
 		QCoreApplication::translate("main", "FORMAT"));
 
+	const QCommandLineOption traceOption(QStringList({"trace"}),
+		QCoreApplication::translate("main",
+			"Records timeline of rendering stages (render job, textures, lines, tiles, SSAO, DOF,"
+			" image saving, OpenCL, netrender) and saves it at exit to FILE in Chrome trace format."),
+		QCoreApplication::translate("main", "FILE"));
+
+	const QCommandLineOption progressJsonOption(QStringList({"progress-json"}),
+		QCoreApplication::translate("main",
+			"Prints progress and statistics as JSON lines (percent done, ETA, rays/s, iterations/s,"
+			" missed DE, memory, OpenCL devices throughput, netrender state) instead of progress bars."));
+
+	const QCommandLineOption prometheusOption(QStringList({"prometheus"}),
+		QCoreApplication::translate("main",
+			"Writes progress and statistics metrics to FILE in Prometheus textfile format"
+			" (updated once per second)."),
+		QCoreApplication::translate("main", "FILE"));
+
 	const QCommandLineOption statsOption(QStringList({"stats"}),
 		QCoreApplication::translate("main", "Shows statistics while rendering in CLI mode."));
 
@@ -217,12 +264,19 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *_qApplication)
 	parser.addOption(portOption);
 	parser.addOption(noColorOption);
 	parser.addOption(queueOption);
+	parser.addOption(daemonOption);
 	parser.addOption(testOption);
 	parser.addOption(benchmarkOption);
+	parser.addOption(formulaBenchmarkOption);
+	parser.addOption(benchmarkBaselineOption);
+	parser.addOption(benchmarkToleranceOption);
 	parser.addOption(touchOption);
 	parser.addOption(voxelOption);
 	parser.addOption(overrideOption);
 	parser.addOption(statsOption);
+	parser.addOption(traceOption);
+	parser.addOption(progressJsonOption);
+	parser.addOption(prometheusOption);
 	parser.addOption(gpuOption);
 	parser.addOption(gpuAllOption);
 	parser.addOption(helpInputOption);
@@ -255,12 +309,17 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *_qApplication)
 	cliData.portText = parser.value(portOption);
 	cliData.outputText = parser.value(outputOption);
 	cliData.logFilepathText = parser.value(logFilepathOption);
+	cliData.traceFileText = parser.value(traceOption);
 	cliData.listParameters = parser.isSet(listOption);
 	cliData.queue = parser.isSet(queueOption);
+	cliData.daemon = parser.isSet(daemonOption);
 	cliData.voxel = parser.isSet(voxelOption);
 	cliData.voxelFormat = parser.value(voxelOption);
 	cliData.test = parser.isSet(testOption);
 	cliData.benchmark = parser.isSet(benchmarkOption);
+	cliData.formulaBenchmark = parser.isSet(formulaBenchmarkOption);
+	cliData.benchmarkBaseline = parser.value(benchmarkBaselineOption);
+	cliData.benchmarkToleranceText = parser.value(benchmarkToleranceOption);
 	cliData.touch = parser.isSet(touchOption);
 	cliData.gpu = parser.isSet(gpuOption);
 	cliData.gpuAll = parser.isSet(gpuAllOption);
@@ -269,6 +328,9 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *_qApplication)
 	cliData.showOpenCLHelp = parser.isSet(helpOpenClOption);
 
 	systemData.statsOnCLI = parser.isSet(statsOption);
+	if (parser.isSet(progressJsonOption)) cProgressMetrics::EnableJsonLines();
+	if (parser.isSet(prometheusOption))
+		cProgressMetrics::EnablePrometheusFile(parser.value(prometheusOption));
 
 #ifdef _WIN32 /* WINDOWS */
 	systemData.useColor = false;
@@ -278,8 +340,10 @@ cCommandLineInterface::cCommandLineInterface(QCoreApplication *_qApplication)
 
 	if (cliData.listParameters) cliData.nogui = true;
 	if (cliData.queue) cliData.nogui = true;
+	if (cliData.daemon) cliData.nogui = true;
 	if (cliData.test) cliData.nogui = true;
 	if (cliData.benchmark) cliData.nogui = true;
+	if (cliData.formulaBenchmark) cliData.nogui = true;
 	cliOperationalMode = modeBootOnly;
 }
 
@@ -302,10 +366,15 @@ void cCommandLineInterface::ReadCLI()
 		systemData.SetLogfileName(cliData.logFilepathText);
 	}
 
+	// timeline of rendering stages
+	if (cliData.traceFileText != "") cRenderTrace::Enable(cliData.traceFileText);
+
 	// run test cases
 	if (cliData.test) runTestCasesAndExit();
 	// run benchmarks
 	if (cliData.benchmark) runBenchmarksAndExit();
+	// run formula microbenchmarks
+	if (cliData.formulaBenchmark) runFormulaBenchmarksAndExit();
 
 	// check netrender server / client
 	if (cliData.server)
@@ -316,7 +385,9 @@ void cCommandLineInterface::ReadCLI()
 		return;
 	}
 
-	if (cliData.queue)
+	if (cliData.daemon)
+		handleDaemon();
+	else if (cliData.queue)
 		handleQueue();
 	else
 		handleArgs();
@@ -382,7 +453,8 @@ void cCommandLineInterface::ReadCLI()
 	}
 
 	if (cliData.nogui && cliOperationalMode != modeKeyframe && cliOperationalMode != modeFlight
-			&& cliOperationalMode != modeQueue && cliOperationalMode != modeVoxel)
+			&& cliOperationalMode != modeQueue && cliOperationalMode != modeVoxel
+			&& cliOperationalMode != modeDaemon)
 	{
 		// creating output filename if it's not specified
 		if (cliData.outputText == "")
@@ -436,6 +508,18 @@ void cCommandLineInterface::ProcessCLI() const
 			gMainInterface->headless->RenderVoxel(cliData.voxelFormat);
 			break;
 		}
+		case modeDaemon:
+		{
+			gMainInterface->headless = new cHeadless(gMainInterface);
+			gRenderDaemon = new cRenderDaemon(gMainInterface->headless, gMainInterface);
+			if (gRenderDaemon->Listen(gPar->Get<QString>("daemon_socket_name")))
+			{
+				QObject::connect(
+					gRenderDaemon, &cRenderDaemon::finished, gApplication, &QApplication::quit);
+				gApplication->exec();
+			}
+			break;
+		}
 		case modeBootOnly:
 		{
 			// nothing to be done
@@ -503,6 +587,28 @@ void cCommandLineInterface::printExampleHelpAndExit()
 		"(will not work under Windows)")
 			<< "\n\n";
 
+	out << cHeadless::colorize(QObject::tr("Render daemon"), cHeadless::ansiBlue) << "\n";
+	out << cHeadless::colorize(
+		"mandelbulber2 --daemon -O daemon_socket_name=mbjobs", cHeadless::ansiYellow)
+			<< "\n";
+	out << QObject::tr(
+		"Runs the mandelbulber instance as a render daemon listening on local socket 'mbjobs'.\n"
+		"Jobs are sent as a line 'JOB <type> <format> <length> [<output>]' followed by\n"
+		"<length> bytes of settings text (type: still, voxel, flight, keyframe).\n"
+		"Progress, results and errors are sent back as text lines.\n"
+		"Initialized parameters, OpenCL kernels and textures stay loaded between jobs.")
+			<< "\n\n";
+
+	out << cHeadless::colorize(QObject::tr("Formula benchmark"), cHeadless::ansiBlue) << "\n";
+	out << cHeadless::colorize(
+		"mandelbulber2 --formula-benchmark -o new.json --benchmark-baseline old.json 10",
+		cHeadless::ansiYellow)
+			<< "\n";
+	out << QObject::tr(
+		"Measures speed of every fractal formula with difficulty 10, saves results to new.json\n"
+		"and exits with error when any formula is more than 10% slower than in old.json.")
+			<< "\n\n";
+
 	out.flush();
 	exit(0);
 }
@@ -558,7 +664,7 @@ void cCommandLineInterface::printOpenCLHelpAndExit()
 	out << " * opencl_precision    - "
 			<< QObject::tr(
 					 "Floating point precision of Render (single is faster, but "
-					 "less accurate)")
+					 "less accurate, auto uses double only when needed for deep zoom)")
 			<< QString("\n  `- %1\n")
 					 .arg(QObject::tr("possible values: [%1]")
 									.arg(gPar->GetAsOneParameter("opencl_precision").GetEnumLookup().join(", ")));
@@ -756,6 +862,106 @@ void cCommandLineInterface::runBenchmarksAndExit()
 	exit(status);
 }
 
+void cCommandLineInterface::runFormulaBenchmarksAndExit()
+{
+	systemData.noGui = true;
+	int difficulty = 10;
+	double tolerance = 10.0;
+
+	if (args.size() > 0)
+	{
+		bool checkParse = false;
+		const int difficultyTemp = args[0].toInt(&checkParse);
+		if (checkParse && difficultyTemp > 0) difficulty = difficultyTemp;
+	}
+
+	if (cliData.benchmarkToleranceText != "")
+	{
+		bool checkParse = false;
+		const double toleranceTemp = cliData.benchmarkToleranceText.toDouble(&checkParse);
+		if (checkParse && toleranceTemp >= 0.0) tolerance = toleranceTemp;
+	}
+
+	QByteArray baselineJson;
+	if (cliData.benchmarkBaseline != "")
+	{
+		QFile baselineFile(cliData.benchmarkBaseline);
+		if (!baselineFile.open(QIODevice::ReadOnly))
+		{
+			cErrorMessage::showMessage(
+				QObject::tr("Cannot open benchmark baseline file\n"), cErrorMessage::errorMessage);
+			parser.showHelp(cliErrorBenchmarkBaselineInvalid);
+		}
+		baselineJson = baselineFile.readAll();
+	}
+
+	// when JSON report is written to stdout, messages go to stderr to keep the report valid
+	const bool jsonToStdout = cliData.outputText == "";
+	auto writeMessage = [jsonToStdout](const QString &text) {
+		if (jsonToStdout)
+		{
+			QTextStream outErr(stderr);
+			outErr << text;
+			WriteLog(text, 1);
+		}
+		else
+		{
+			WriteLogCout(text, 1);
+		}
+	};
+
+	writeMessage(QString("Starting formula benchmark with difficulty [%1]").arg(difficulty) + "\n");
+
+	cFormulaBenchmark benchmark(difficulty);
+	benchmark.Run();
+	const QByteArray json = benchmark.ToJson();
+
+	if (!jsonToStdout)
+	{
+		QFile outputFile(cliData.outputText);
+		if (outputFile.open(QIODevice::WriteOnly))
+		{
+			outputFile.write(json);
+			WriteLogCout("Formula benchmark results saved to " + cliData.outputText + "\n", 1);
+		}
+		else
+		{
+			cErrorMessage::showMessage(
+				QObject::tr("Cannot write benchmark results to ") + cliData.outputText,
+				cErrorMessage::errorMessage);
+		}
+	}
+	else
+	{
+		QTextStream out(stdout);
+		out << json;
+		out.flush();
+	}
+
+	int status = 0;
+	if (cliData.benchmarkBaseline != "")
+	{
+		bool parseOk = false;
+		const QStringList regressions =
+			benchmark.CompareWithBaseline(baselineJson, tolerance, &parseOk);
+		if (!parseOk)
+		{
+			cErrorMessage::showMessage(
+				QObject::tr("Benchmark baseline file is not valid JSON\n"), cErrorMessage::errorMessage);
+			exit(cliErrorBenchmarkBaselineInvalid);
+		}
+
+		for (const QString &regression : regressions)
+		{
+			writeMessage("Regression: " + regression + "\n");
+		}
+		writeMessage(
+			QString("%1 regressions found (tolerance %2%)\n").arg(regressions.size()).arg(tolerance));
+		if (!regressions.isEmpty()) status = cliErrorBenchmarkRegression;
+	}
+	exit(status);
+}
+
 void cCommandLineInterface::handleServer()
 {
 	QTextStream out(stdout);
@@ -828,6 +1034,15 @@ void cCommandLineInterface::handleQueue()
 	}
 }
 
+void cCommandLineInterface::handleDaemon()
+{
+	// settings are received with each job
+	cliOperationalMode = modeDaemon;
+	settingsSpecified = true;
+	cliData.nogui = true;
+	systemData.noGui = true;
+}
+
 void cCommandLineInterface::handleArgs()
 {
 	if (args.size() > 0)
@@ -1156,7 +1371,7 @@ void cCommandLineInterface::handleEndFrame()
 
 void cCommandLineInterface::handleVoxel()
 {
-	QStringList allowedVoxelFormat({"ply", "slice"});
+	QStringList allowedVoxelFormat({"ply", "slice", "volume"});
 	WriteLogString(
 		"CommandLineInterface::handleVoxel(): cliData.voxelFormat", cliData.voxelFormat, 3);
 	if (!allowedVoxelFormat.contains(cliData.voxelFormat))
@@ -54,7 +54,8 @@ public:
 		modeFlight,
 		modeStill,
 		modeQueue,
-		modeVoxel
+		modeVoxel,
+		modeDaemon
 	};
 	enum cliErrors
 	{
@@ -81,6 +82,8 @@ public:
 		cliErrorVoxelOutputFormatInvalid = -51,
 
 		cliErrorBenchmarkOutputFolderInvalid = -60,
+		cliErrorBenchmarkBaselineInvalid = -61,
+		cliErrorBenchmarkRegression = -62,
 
 		cliErrorOpenClNotCompiled = -70,
 		cliErrorOpenClNoPlatform = -71,
@@ -100,11 +103,13 @@ private:
 	[[noreturn]] static void printParametersAndExit();
 	[[noreturn]] static void runTestCasesAndExit();
 	[[noreturn]] void runBenchmarksAndExit();
+	[[noreturn]] void runFormulaBenchmarksAndExit();
 
 	// argument handling methods
 	void handleServer();
 	void handleClient();
 	void handleQueue();
+	void handleDaemon();
 	void handleArgs();
 	void handleOverrideParameters() const;
 	void handleResolution();
@@ -130,9 +135,11 @@ private:
 		bool flight;
 		bool silent;
 		bool queue;
+		bool daemon;
 		bool voxel;
 		bool test;
 		bool benchmark;
+		bool formulaBenchmark;
 		bool touch;
 		bool gpu;
 		bool gpuAll;
@@ -147,6 +154,9 @@ private:
 		QString outputText;
 		QString voxelFormat;
 		QString logFilepathText;
+		QString benchmarkBaseline;
+		QString benchmarkToleranceText;
+		QString traceFileText;
 	} cliData;
 
 	QCommandLineParser parser;
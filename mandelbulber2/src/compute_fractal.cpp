@@ -35,6 +35,7 @@
 #include "compute_fractal.hpp"
 
 #include "common_math.h"
+#include "compute_fractal_scalar.hpp"
 #include "fractal.h"
 #include "material.h"
 #include "nine_fractals.hpp"
@@ -47,6 +48,13 @@ using namespace fractal;
 template <fractal::enumCalculationMode Mode>
 void Compute(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *out)
 {
+	// simple scenes can be calculated in single precision
+	if (Mode == calcModeNormal && fractals.UseSinglePrecision() && in.forcedFormulaIndex <= 0)
+	{
+		ComputeScalar<float>(fractals, in, out);
+		return;
+	}
+
 	cAbstractFractal *fractalFormulaFunction;
 
 	// repeat, move and rotate
@@ -0,0 +1,189 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * ComputeScalar - fractal computation for simple scenes templated on the scalar type
+ */
+
+#include "compute_fractal_scalar.hpp"
+
+#include <cmath>
+
+#include "common_math.h"
+#include "compute_fractal.hpp"
+#include "fractal.h"
+#include "nine_fractals.hpp"
+#include "parameters.hpp"
+
+#include "formula/definition/scalar_fractal_formulas.hpp"
+
+using namespace fractal;
+
+bool IsComputeScalarSupported(
+	const cNineFractals &fractals, std::shared_ptr<const cParameterContainer> generalPar)
+{
+	if (fractals.IsHybrid() || generalPar->Get<bool>("boolean_operators")) return false;
+	if (generalPar->Get<bool>("box_folding") || generalPar->Get<bool>("spherical_folding"))
+		return false;
+	if (fractals.GetDEType(0) != analyticDEType || !fractals.IsCheckForBailout(0)
+			|| fractals.UseAdditionalBailoutCond(0))
+		return false;
+
+	const sFractal *fractal = fractals.GetFractal(0);
+	switch (fractal->formula)
+	{
+		case mandelbulb:
+			return fractals.GetDEAnalyticFunction(0) == analyticFunctionLogarithmic
+						 || fractals.GetDEAnalyticFunction(0) == analyticFunctionLinear;
+		case mandelbox:
+			return !fractal->mandelbox.rotationsEnabled && !fractal->mandelbox.mainRotationEnabled
+						 && (fractals.GetDEAnalyticFunction(0) == analyticFunctionLogarithmic
+								 || fractals.GetDEAnalyticFunction(0) == analyticFunctionLinear);
+		default: return false;
+	}
+}
+
+namespace
+{
+// vector type for formula templates in any precision
+template <typename T>
+struct sScalarVector4
+{
+	T x, y, z, w;
+	T Length() const { return std::sqrt(x * x + y * y + z * z + w * w); }
+	bool IsNotANumber() const
+	{
+		return std::isnan(x) || std::isnan(y) || std::isnan(z) || std::isnan(w);
+	}
+};
+} // namespace
+
+template <typename T>
+void ComputeScalar(const cNineFractals &fractals, const sFractalIn &in, sFractalOut *out)
+{
+	// repeat, move and rotate are calculated in double precision as in Compute()
+	CVector3 pointTransformed = in.point - in.common->fractalPosition;
+	pointTransformed = in.common->mRotFractalRotation.RotateVector(pointTransformed);
+	pointTransformed = pointTransformed.mod(in.common->repeat);
+
+	const sFractal *fractal = fractals.GetFractal(0);
+	const enumFractalFormula formula = fractal->formula;
+
+	sScalarVector4<T> z;
+	z.x = T(pointTransformed.x);
+	z.y = T(pointTransformed.y);
+	z.z = T(pointTransformed.z);
+	z.w = T(fractals.GetInitialWAxis(0));
+
+	// constant added after each iteration
+	sScalarVector4<T> c = {0, 0, 0, 0};
+	if (fractals.IsAddCConstant(0))
+	{
+		const CVector3 multiplier = fractals.GetConstantMultiplier(0);
+		if (fractals.IsJuliaEnabled(0))
+		{
+			const CVector3 juliaC = fractals.GetJuliaConstant(0) * multiplier;
+			c.x = T(juliaC.x);
+			c.y = T(juliaC.y);
+			c.z = T(juliaC.z);
+		}
+		else
+		{
+			c.x = z.x * T(multiplier.x);
+			c.y = z.y * T(multiplier.y);
+			c.z = z.z * T(multiplier.z);
+			c.w = z.w;
+		}
+	}
+
+	const T bailout = T(fractals.GetBailout(0));
+
+	T r = z.Length();
+	T DE = 1;
+	T color = 1; // not used in calcModeNormal
+	out->maxiter = true;
+	out->orbitTrapR = 0.0;
+
+	int i;
+	for (i = 0; i < in.maxN; i++)
+	{
+		const sScalarVector4<T> lastZ = z;
+
+		if (formula == mandelbulb)
+		{
+			MandelbulbIteration(z, r, DE, fractal);
+		}
+		else // mandelbox
+		{
+			MandelboxBoxFold(z, color, fractal);
+			MandelboxSphericalFold(z, DE, color, fractal);
+			MandelboxScale(z, DE, fractal);
+		}
+
+		z.x += c.x;
+		z.y += c.y;
+		z.z += c.z;
+		z.w += c.w;
+
+		r = z.Length();
+
+		if (z.IsNotANumber())
+		{
+			z = lastZ;
+			r = z.Length();
+			out->maxiter = true;
+			break;
+		}
+
+		if (r > bailout)
+		{
+			out->maxiter = false;
+			break;
+		}
+	}
+
+	if (DE > T(0))
+	{
+		if (fractals.GetDEAnalyticFunction(0) == analyticFunctionLogarithmic)
+			out->distance = double(T(0.5) * r * std::log(r) / DE);
+		else
+			out->distance = double(r / DE);
+	}
+	else
+	{
+		out->distance = double(r);
+	}
+
+	out->iters = i + 1;
+	out->z = CVector3(double(z.x), double(z.y), double(z.z));
+}
+
+template void ComputeScalar<float>(
+	const cNineFractals &fractals, const sFractalIn &in, sFractalOut *out);
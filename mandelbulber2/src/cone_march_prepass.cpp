@@ -0,0 +1,157 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ * cConeMarchPrepass - low resolution visibility pre-pass for primary rays
+ */
+
+#include "cone_march_prepass.hpp"
+
+#include "calculate_distance.hpp"
+#include "common_math.h"
+#include "fractparams.hpp"
+#include "nine_fractals.hpp"
+#include "projection_3d.hpp"
+#include "render_data.hpp"
+#include "render_worker.hpp"
+#include "reprojection_cache.hpp"
+#include "system_data.hpp"
+
+cConeMarchPrepass::cConeMarchPrepass()
+{
+	tilesX = 0;
+	tilesY = 0;
+	emptyDepth = 0.0f;
+}
+
+cConeMarchPrepass::~cConeMarchPrepass()
+{
+	// nothing to delete
+}
+
+bool cConeMarchPrepass::IsApplicable(const sParamRender &params, const sRenderData &data)
+{
+	// the same restrictions as for start distances reprojected from previous frame
+	return cReprojectionCache::IsApplicable(params, data);
+}
+
+bool cConeMarchPrepass::Calculate(const sParamRender &params, const cNineFractals &fractals,
+	sRenderData *data, int width, int height)
+{
+	tilesX = (width + tileSize - 1) / tileSize;
+	tilesY = (height + tileSize - 1) / tileSize;
+	tileDepth.assign(size_t(tilesX) * size_t(tilesY), 0.0f);
+	emptyDepth = float(params.viewDistanceMax);
+	std::vector<int> tileSteps(tileDepth.size(), 0);
+
+	double aspectRatio = double(width) / height;
+	CRotationMatrix mRot = cReprojectionCache::CameraRotation(params);
+	CVector3 start = params.camera;
+
+	// step multipliers bigger than 1.0 could jump over the surface inside the cone
+	double stepFactor = min(params.DEFactor, 1.0);
+
+	for (int ty = 0; ty < tilesY; ty++)
+	{
+		if (*data->stopRequest || systemData.globalStopRequest) return false;
+
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			// corners of the tile extended by one pixel for anti-aliasing offsets
+			int x1 = tx * tileSize - 1;
+			int y1 = ty * tileSize - 1;
+			int x2 = min((tx + 1) * tileSize, width);
+			int y2 = min((ty + 1) * tileSize, height);
+
+			CVector3 corners[4];
+			CVector3 direction;
+			for (int i = 0; i < 4; i++)
+			{
+				CVector2<int> screenPoint((i & 1) ? x2 : x1, (i & 2) ? y2 : y1);
+				CVector2<double> imagePoint =
+					data->screenRegion.transpose(data->imageRegion, screenPoint);
+				imagePoint.x *= aspectRatio;
+				corners[i] = CalculateViewVector(imagePoint, params.fov, params.perspectiveType, mRot);
+				corners[i].Normalize();
+				direction += corners[i];
+			}
+			direction.Normalize();
+
+			// maximum distance between axis of the cone and tile rays per unit of ray length
+			double coneSpread = 0.0;
+			for (const CVector3 &corner : corners)
+				coneSpread = max(coneSpread, (corner - direction).Length());
+
+			double scan = 0.0;
+			double emptyScan = 0.0;
+			int steps = 0;
+			while (steps < MAX_RAYMARCHING)
+			{
+				CVector3 point = start + direction * scan;
+				double distThresh = cRenderWorker::CalcDistThresh(point, params, *data);
+				sDistanceIn distanceIn(point, distThresh, false);
+				sDistanceOut distanceOut;
+				double dist = CalculateDistance(params, fractals, distanceIn, &distanceOut, data);
+				steps++;
+
+				// unbounding sphere has to contain whole cross-section of the cone
+				double coneRadius = scan * coneSpread;
+				if (dist < coneRadius + distThresh) break;
+
+				emptyScan = scan;
+				scan += (dist - coneRadius - 0.5 * distThresh) * stepFactor;
+				if (scan > params.viewDistanceMax)
+				{
+					emptyScan = params.viewDistanceMax;
+					break;
+				}
+			}
+
+			tileDepth[size_t(tx) + size_t(ty) * size_t(tilesX)] = float(emptyScan);
+			tileSteps[size_t(tx) + size_t(ty) * size_t(tilesX)] = steps;
+		}
+	}
+
+	// every ray of the tile skips all cone steps except the last one
+	for (int ty = 0; ty < tilesY; ty++)
+	{
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			int tilePixels = (min((tx + 1) * tileSize, width) - tx * tileSize)
+											 * (min((ty + 1) * tileSize, height) - ty * tileSize);
+			long long steps = tileSteps[size_t(tx) + size_t(ty) * size_t(tilesX)];
+			data->statistics.numberOfConeMarchingSteps += steps;
+			data->statistics.numberOfConeSkippedSteps += (steps - 1) * tilePixels;
+		}
+	}
+	data->statistics.numberOfConeMarchedPixels += size_t(width) * size_t(height);
+
+	return true;
+}
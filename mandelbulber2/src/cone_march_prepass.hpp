@@ -0,0 +1,87 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ * cConeMarchPrepass - low resolution visibility pre-pass for primary rays
+ *
+ * Image is divided into small tiles. For each tile one cone, which contains all primary rays of
+ * the tile, is marched using distance estimation. The cone can advance only as long as the
+ * unbounding sphere is bigger than the cross-section of the cone, so the found depth is a safe
+ * starting distance for every full resolution ray of the tile. Hit criteria of the rays stay
+ * the same as without the pre-pass.
+ * Tiles whose cone reached the maximum view distance form a coverage mask of certainly empty
+ * screen areas. Rays of these tiles are not marched at all.
+ */
+
+#ifndef MANDELBULBER2_SRC_CONE_MARCH_PREPASS_HPP_
+#define MANDELBULBER2_SRC_CONE_MARCH_PREPASS_HPP_
+
+#include <vector>
+
+// forward declarations
+class cNineFractals;
+struct sParamRender;
+struct sRenderData;
+
+class cConeMarchPrepass
+{
+public:
+	cConeMarchPrepass();
+	~cConeMarchPrepass();
+
+	// checks if primary rays can start from depth found by the pre-pass
+	static bool IsApplicable(const sParamRender &params, const sRenderData &data);
+
+	// cone-marches all tiles of the image. Returns false when rendering was stopped
+	bool Calculate(const sParamRender &params, const cNineFractals &fractals, sRenderData *data,
+		int width, int height);
+
+	float GetStartDistance(int x, int y) const
+	{
+		return tileDepth[size_t(x / tileSize) + size_t(y / tileSize) * size_t(tilesX)];
+	}
+
+	// coverage mask: no ray of the tile can hit any object before maximum view distance
+	bool IsEmpty(int x, int y) const { return GetStartDistance(x, y) >= emptyDepth; }
+
+	int GetTileSize() const { return tileSize; }
+	int GetNumberOfTilesX() const { return tilesX; }
+	int GetNumberOfTilesY() const { return tilesY; }
+	const std::vector<float> &GetTileDepths() const { return tileDepth; }
+
+private:
+	static const int tileSize = 8;
+
+	std::vector<float> tileDepth;
+	int tilesX;
+	int tilesY;
+	float emptyDepth;
+};
+
+#endif /* MANDELBULBER2_SRC_CONE_MARCH_PREPASS_HPP_ */
@@ -40,6 +40,7 @@
 #include "common_math.h"
 #include "global_data.hpp"
 #include "progress_text.hpp"
+#include "render_trace.hpp"
 #include "system_data.hpp"
 
 using std::max;
@@ -50,6 +51,7 @@ cPostRenderingDOF::cPostRenderingDOF(std::shared_ptr<cImage> _image) : QObject()
 void cPostRenderingDOF::Render(cRegion<int> screenRegion, float deep, float neutral,
 	int numberOfPasses, float blurOpacity, float maxRadius, bool *stopRequest)
 {
+	cTraceSpan traceSpan("DOF", "postprocess");
 	quint64 imageWidth = image->GetWidth();
 	quint64 imageHeight = image->GetHeight();
 
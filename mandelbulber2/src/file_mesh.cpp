@@ -37,7 +37,11 @@
 
 #include "file_mesh.hpp"
 
-#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
 #include <QDir>
 #include <QFileInfo>
 
@@ -46,25 +50,6 @@
 #include "initparameters.hpp"
 #include "parameters.hpp"
 
-MeshFileSave::MeshFileSave(
-	QString filename, structSaveMeshConfig meshConfig, structSaveMeshData meshData)
-{
-	this->filename = filename;
-	this->meshConfig = meshConfig;
-	this->meshData = meshData;
-}
-
-MeshFileSave *MeshFileSave::create(
-	QString filename, structSaveMeshConfig meshConfig, structSaveMeshData meshData)
-{
-	switch (meshConfig.fileType)
-	{
-		case MESH_FILE_TYPE_PLY: return new MeshFileSavePLY(filename, meshConfig, meshData);
-	}
-	qCritical() << "fileType " << MeshFileExtension(meshConfig.fileType) << " not supported!";
-	return nullptr;
-}
-
 QString MeshFileSave::MeshFileExtension(enumMeshFileType meshFileType)
 {
 	switch (meshFileType)
@@ -93,41 +78,188 @@ QString MeshFileSave::MeshNameWithoutExtension(QString path)
 	return fi.path() + QDir::separator() + fileName;
 }
 
-void MeshFileSavePLY::SaveMesh()
+MeshFileSavePLYStream::MeshFileSavePLYStream(
+	QString filename, MeshFileSave::structSaveMeshConfig meshConfig, bool optimizeVertexCache)
+		: QObject()
 {
-	emit updateProgressAndStatus(getJobName(), QString("Started"), 0.0);
-	SavePLY();
-	emit updateProgressAndStatus(getJobName(), QString("Finished"), 1.0);
+	this->filename = filename;
+	this->meshConfig = meshConfig;
+	this->optimizeVertexCache = optimizeVertexCache;
+	withColor = meshConfig.contentTypes.contains(MeshFileSave::MESH_CONTENT_COLOR);
+	isBinary = meshConfig.fileModeType == MeshFileSave::MESH_BINARY;
+	verticesBody.setFileName(filename + ".vertices.tmp");
+	polygonsBody.setFileName(filename + ".faces.tmp");
 }
 
-void MeshFileSavePLY::SavePLY()
+MeshFileSavePLYStream::~MeshFileSavePLYStream()
 {
-	QFile qFile(filename);
+	Abort();
+}
+
+bool MeshFileSavePLYStream::Open()
+{
+	vertexCount = 0;
+	polygonCount = 0;
+	if (!verticesBody.open(QFile::WriteOnly | QFile::Truncate)
+			|| !polygonsBody.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		QString statusText = tr("Mesh Export - Failed to open output file!");
+		emit updateProgressAndStatus(statusText, "", 1.0);
+		Abort();
+		return false;
+	}
+	return true;
+}
 
-	bool withColor = meshConfig.contentTypes.contains(MESH_CONTENT_COLOR);
-	bool isBinary = meshConfig.fileModeType == MESH_BINARY;
+void MeshFileSavePLYStream::SetColorMapping(
+	const cColorGradient &gradient, double colorSpeed, double colorOffset)
+{
+	this->gradient = gradient;
+	this->colorSpeed = colorSpeed;
+	this->colorOffset = colorOffset;
+}
 
-	double alpha = 1.0;
-	char polygonSize = 3;
-	QString plyFormat = isBinary ? "binary_little_endian" : "ascii";
+sRGB8 MeshFileSavePLYStream::ColorIndexToRGB8(double colorIndex) const
+{
+	double nrCol = fmod(fabs(colorIndex), 248.0 * 256.0); // kept for compatibility
+	double colorPosition = fmod(nrCol / 256.0 / 10.0 * colorSpeed + colorOffset, 1.0);
+	sRGB color = gradient.GetColor(colorPosition, false);
+	return sRGB8(uchar(color.R), uchar(color.G), uchar(color.B));
+}
+
+void MeshFileSavePLYStream::AppendSlab(const std::vector<double> &vertices,
+	std::vector<long long> &polygons, const std::vector<double> &colorIndices)
+{
+	if (!verticesBody.isOpen() || !polygonsBody.isOpen()) return;
+
+	if (optimizeVertexCache) OptimizeVertexCache(polygons);
+
+	quint64 slabVertexCount = vertices.size() / 3;
+	quint64 slabPolygonCount = polygons.size() / 3;
+
+	// s and t properties are kept as in previous PLY files: red component of the color and alpha
+	const double alpha = 1.0;
+
+	if (isBinary)
+	{
+		int vertexRecordSize =
+			sizeof(float) * 3 + sizeof(double) * 2 + (withColor ? sizeof(sRGB8) : 0);
+		QByteArray buffer;
+		buffer.resize(int(slabVertexCount * vertexRecordSize));
+		char *ptr = buffer.data();
+		for (quint64 i = 0; i < slabVertexCount; i++)
+		{
+			float xyz[3] = {float(vertices[i * 3]), float(vertices[i * 3 + 1]),
+				float(vertices[i * 3 + 2])};
+			memcpy(ptr, xyz, sizeof(xyz));
+			ptr += sizeof(xyz);
+			sRGB8 colour = ColorIndexToRGB8(colorIndices[i]);
+			double st[2] = {double(colour.R), alpha};
+			memcpy(ptr, st, sizeof(st));
+			ptr += sizeof(st);
+			if (withColor)
+			{
+				memcpy(ptr, &colour, sizeof(sRGB8));
+				ptr += sizeof(sRGB8);
+			}
+		}
+		verticesBody.write(buffer);
+
+		int polygonRecordSize = sizeof(uchar) + sizeof(quint32) * 3;
+		buffer.resize(int(slabPolygonCount * polygonRecordSize));
+		ptr = buffer.data();
+		for (quint64 i = 0; i < slabPolygonCount; i++)
+		{
+			uchar polygonSize = 3;
+			quint32 p[3] = {quint32(polygons[i * 3 + 2]), quint32(polygons[i * 3 + 1]),
+				quint32(polygons[i * 3 + 0])};
+			memcpy(ptr, &polygonSize, sizeof(uchar));
+			ptr += sizeof(uchar);
+			memcpy(ptr, p, sizeof(p));
+			ptr += sizeof(p);
+		}
+		polygonsBody.write(buffer);
+	}
+	else
+	{
+		QTextStream oV(&verticesBody);
+		for (quint64 i = 0; i < slabVertexCount; i++)
+		{
+			oV << QString("%1 %2 %3")
+						.arg(vertices[i * 3])
+						.arg(vertices[i * 3 + 1])
+						.arg(vertices[i * 3 + 2])
+						.toLatin1();
+			sRGB8 colour = ColorIndexToRGB8(colorIndices[i]);
+			oV << QString(" %1 %2").arg(colour.R).arg(alpha).toLatin1();
+			if (withColor)
+			{
+				oV << QString(" %1 %2 %3").arg(colour.R).arg(colour.G).arg(colour.B).toLatin1();
+			}
+			oV << QString("\n").toLatin1();
+		}
+		oV.flush();
+
+		QTextStream oP(&polygonsBody);
+		for (quint64 i = 0; i < slabPolygonCount; i++)
+		{
+			oP << QString("3 %1 %2 %3\n")
+						.arg(polygons[i * 3 + 2])
+						.arg(polygons[i * 3 + 1])
+						.arg(polygons[i * 3 + 0])
+						.toLatin1();
+		}
+		oP.flush();
+	}
+
+	vertexCount += slabVertexCount;
+	polygonCount += slabPolygonCount;
+}
+
+bool MeshFileSavePLYStream::AppendFile(QFile *target, QFile *source)
+{
+	if (!source->open(QFile::ReadOnly)) return false;
+	const qint64 chunkSize = 1 << 20;
+	while (!source->atEnd())
+	{
+		QByteArray chunk = source->read(chunkSize);
+		if (target->write(chunk) != chunk.size())
+		{
+			source->close();
+			return false;
+		}
+	}
+	source->close();
+	return true;
+}
+
+bool MeshFileSavePLYStream::Finish()
+{
+	verticesBody.close();
+	polygonsBody.close();
 
+	emit updateProgressAndStatus(getJobName(), QString("Started"), 0.0);
+
+	QFile qFile(filename);
 	if (!qFile.open(QFile::WriteOnly))
 	{
 		QString statusText = tr("Mesh Export - Failed to open output file!");
 		emit updateProgressAndStatus(statusText, "", 1.0);
-		return;
+		Abort();
+		return false;
 	}
-	QDataStream oB(&qFile);
-	QTextStream oT(&qFile);
+
+	QString plyFormat = isBinary ? "binary_little_endian" : "ascii";
 
 	// write the file header
+	QTextStream oT(&qFile);
 	oT << QString("ply\n").toLatin1();
 	oT << QString("format %1 1.0\n").arg(plyFormat).toLatin1();
 	oT << QString("comment Mandelbulber Exported Mesh\n").toLatin1();
-	oT << QString("element vertex %1\n").arg(meshData.vertices->size() / 3).toLatin1();
-	oT << QString("property double x\n").toLatin1();
-	oT << QString("property double y\n").toLatin1();
-	oT << QString("property double z\n").toLatin1();
+	oT << QString("element vertex %1\n").arg(vertexCount).toLatin1();
+	oT << QString("property float x\n").toLatin1();
+	oT << QString("property float y\n").toLatin1();
+	oT << QString("property float z\n").toLatin1();
 	oT << QString("property double s\n").toLatin1();
 	oT << QString("property double t\n").toLatin1();
 	if (withColor)
@@ -136,67 +268,178 @@ void MeshFileSavePLY::SavePLY()
 		oT << QString("property uchar green\n").toLatin1();
 		oT << QString("property uchar blue\n").toLatin1();
 	}
-	oT << QString("element face %1\n").arg(meshData.polygons->size() / 3).toLatin1();
-	oT << QString("property list uchar int vertex_index\n").toLatin1();
+	oT << QString("element face %1\n").arg(polygonCount).toLatin1();
+	oT << QString("property list uchar uint vertex_index\n").toLatin1();
 	oT << QString("end_header\n").toLatin1();
 	oT.flush();
 
-	// write vertices
-	for (unsigned long long i = 0; i < meshData.vertices->size() / 3; i++)
+	bool result = AppendFile(&qFile, &verticesBody);
+	result = result && AppendFile(&qFile, &polygonsBody);
+	qFile.close();
+
+	verticesBody.remove();
+	polygonsBody.remove();
+
+	if (!result)
+	{
+		QString statusText = tr("Mesh Export - Failed to write output file!");
+		emit updateProgressAndStatus(statusText, "", 1.0);
+		return false;
+	}
+
+	emit updateProgressAndStatus(getJobName(), QString("Finished"), 1.0);
+	return true;
+}
+
+void MeshFileSavePLYStream::Abort()
+{
+	if (verticesBody.isOpen()) verticesBody.close();
+	if (polygonsBody.isOpen()) polygonsBody.close();
+	if (verticesBody.exists()) verticesBody.remove();
+	if (polygonsBody.exists()) polygonsBody.remove();
+}
+
+void MeshFileSavePLYStream::OptimizeVertexCache(std::vector<long long> &polygons)
+{
+	const int cacheSize = 32;
+	const double cacheDecayPower = 1.5;
+	const double lastTriScore = 0.75;
+	const double valenceBoostScale = 2.0;
+	const double valenceBoostPower = 0.5;
+
+	long long triangleCount = polygons.size() / 3;
+	if (triangleCount < 2) return;
+
+	// map global vertex indices to local ones
+	std::unordered_map<long long, int> localIndices;
+	std::vector<int> triangleVertices(polygons.size());
+	for (size_t i = 0; i < polygons.size(); i++)
+	{
+		auto it = localIndices.find(polygons[i]);
+		if (it == localIndices.end())
+			it = localIndices.insert(std::make_pair(polygons[i], int(localIndices.size()))).first;
+		triangleVertices[i] = it->second;
+	}
+	int vertexCount = int(localIndices.size());
+
+	// vertex -> triangles adjacency
+	std::vector<int> activeTriangles(vertexCount, 0);
+	for (int v : triangleVertices)
+		activeTriangles[v]++;
+	std::vector<int> adjacencyOffset(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + activeTriangles[v];
+	std::vector<int> adjacency(adjacencyOffset[vertexCount]);
 	{
-		if (isBinary)
+		std::vector<int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (long long t = 0; t < triangleCount; t++)
+			for (int k = 0; k < 3; k++)
+				adjacency[fill[triangleVertices[t * 3 + k]]++] = int(t);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<double> vertexScore(vertexCount, 0.0);
+	std::vector<double> triangleScore(triangleCount, 0.0);
+	std::vector<bool> triangleAdded(triangleCount, false);
+
+	auto scoreVertex = [&](int v) {
+		if (activeTriangles[v] == 0) return -1.0;
+		double score = 0.0;
+		int position = cachePosition[v];
+		if (position >= 0)
 		{
-			oB.writeRawData(reinterpret_cast<char *>(&meshData.vertices->at(i * 3)), sizeof(double) * 3);
-			oB.writeRawData(reinterpret_cast<char *>(&meshData.colorIndices->at(i)), sizeof(double) * 1);
-			oB.writeRawData(reinterpret_cast<char *>(&alpha), sizeof(double) * 1);
+			if (position < 3)
+				score = lastTriScore;
+			else
+			{
+				double scaler = 1.0 / (cacheSize - 3);
+				score = pow(1.0 - (position - 3) * scaler, cacheDecayPower);
+			}
 		}
-		else
+		score += valenceBoostScale * pow(double(activeTriangles[v]), -valenceBoostPower);
+		return score;
+	};
+
+	for (int v = 0; v < vertexCount; v++)
+		vertexScore[v] = scoreVertex(v);
+	for (long long t = 0; t < triangleCount; t++)
+		triangleScore[t] = vertexScore[triangleVertices[t * 3]]
+											 + vertexScore[triangleVertices[t * 3 + 1]]
+											 + vertexScore[triangleVertices[t * 3 + 2]];
+
+	std::vector<long long> output;
+	output.reserve(polygons.size());
+	std::vector<int> cache;
+	cache.reserve(cacheSize + 3);
+	long long scanCursor = 0;
+	long long bestTriangle = -1;
+
+	for (long long added = 0; added < triangleCount; added++)
+	{
+		if (bestTriangle < 0)
 		{
-			oT << QString("%1 %2 %3")
-							.arg(meshData.vertices->at(i * 3))
-							.arg(meshData.vertices->at(i * 3 + 1))
-							.arg(meshData.vertices->at(i * 3 + 2))
-							.toLatin1();
-			oT << QString(" %1 %2").arg(meshData.colorIndices->at(i).R).arg(alpha).toLatin1();
+			// nothing adjacent to the cache - take next not added triangle
+			while (triangleAdded[scanCursor])
+				scanCursor++;
+			bestTriangle = scanCursor;
 		}
 
-		if (withColor)
+		triangleAdded[bestTriangle] = true;
+		for (int k = 0; k < 3; k++)
 		{
-			sRGB8 colour = meshData.colorIndices->at(i);
-			if (isBinary)
-			{
-				oB.writeRawData((char *)&colour, sizeof(sRGB8));
-			}
-			else
+			int v = triangleVertices[bestTriangle * 3 + k];
+			output.push_back(polygons[bestTriangle * 3 + k]);
+
+			// remove triangle from vertex adjacency list
+			int *begin = &adjacency[adjacencyOffset[v]];
+			int *end = begin + activeTriangles[v];
+			int *found = std::find(begin, end, int(bestTriangle));
+			if (found != end)
 			{
-				oT << QString(" %1 %2 %3").arg(colour.R).arg(colour.G).arg(colour.B).toLatin1();
+				std::swap(*found, *(end - 1));
+				activeTriangles[v]--;
 			}
+
+			// move vertex to the front of the LRU cache
+			auto inCache = std::find(cache.begin(), cache.end(), v);
+			if (inCache != cache.end()) cache.erase(inCache);
+			cache.insert(cache.begin(), v);
 		}
-		if (!isBinary) oT << QString("\n").toLatin1();
-	}
 
-	// write polygons
-	for (unsigned long long i = 0; i < meshData.polygons->size(); i += 3)
-	{
-		if (isBinary)
+		// evict vertices which fell out of the cache
+		while (int(cache.size()) > cacheSize)
+		{
+			int v = cache.back();
+			cache.pop_back();
+			cachePosition[v] = -1;
+			vertexScore[v] = scoreVertex(v);
+		}
+
+		for (int i = 0; i < int(cache.size()); i++)
 		{
-			qint64 p1 = meshData.polygons->at(i + 2);
-			qint64 p2 = meshData.polygons->at(i + 1);
-			qint64 p3 = meshData.polygons->at(i + 0);
-			oB.writeRawData(reinterpret_cast<char *>(&polygonSize), sizeof(char) * 1);
-			oB.writeRawData(reinterpret_cast<char *>(&p1), sizeof(int) * 1);
-			oB.writeRawData(reinterpret_cast<char *>(&p2), sizeof(int) * 1);
-			oB.writeRawData(reinterpret_cast<char *>(&p3), sizeof(int) * 1);
+			cachePosition[cache[i]] = i;
+			vertexScore[cache[i]] = scoreVertex(cache[i]);
 		}
-		else
+
+		// rescore triangles touching the cache and choose the best one
+		bestTriangle = -1;
+		double bestScore = -1.0;
+		for (int v : cache)
 		{
-			oT << QString("%1 %2 %3 %4\n")
-							.arg(polygonSize)
-							.arg(meshData.polygons->at(i + 2))
-							.arg(meshData.polygons->at(i + 1))
-							.arg(meshData.polygons->at(i + 0))
-							.toLatin1();
+			for (int a = adjacencyOffset[v]; a < adjacencyOffset[v] + activeTriangles[v]; a++)
+			{
+				int t = adjacency[a];
+				triangleScore[t] = vertexScore[triangleVertices[t * 3]]
+													 + vertexScore[triangleVertices[t * 3 + 1]]
+													 + vertexScore[triangleVertices[t * 3 + 2]];
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
 		}
 	}
-	qFile.close();
+
+	polygons.swap(output);
 }
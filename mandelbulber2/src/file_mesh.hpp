@@ -41,16 +41,17 @@
 #include <utility>
 #include <vector>
 
+#include <QFile>
 #include <QList>
 #include <QObject>
 #include <QString>
 
+#include "color_gradient.h"
 #include "color_structures.hpp"
 
-class MeshFileSave : public QObject
+// types and helpers common for mesh files
+class MeshFileSave
 {
-	Q_OBJECT
-
 public:
 	enum enumMeshFileType
 	{
@@ -86,55 +87,59 @@ public:
 		enumMeshFileModeType fileModeType{MESH_ASCII};
 	};
 
-	struct structSaveMeshData
-	{
-		structSaveMeshData()
-		{
-			vertices = nullptr;
-			polygons = nullptr;
-			colorIndices = nullptr;
-		}
-
-		structSaveMeshData(std::vector<double> *_vertices, std::vector<long long> *_polygons,
-			std::vector<sRGB8> *_colorIndices)
-				: vertices(_vertices), polygons(_polygons), colorIndices(_colorIndices)
-		{
-		}
-		std::vector<double> *vertices;
-		std::vector<long long> *polygons;
-		std::vector<sRGB8> *colorIndices;
-	};
-
 	static QString MeshFileExtension(enumMeshFileType meshFileType);
 	static QString MeshNameWithoutExtension(QString path);
 	static enumMeshFileType MeshFileType(QString meshFileExtension);
-	static MeshFileSave *create(
-		QString filename, structSaveMeshConfig meshConfig, structSaveMeshData meshData);
-	virtual void SaveMesh() = 0;
-	virtual QString getJobName() = 0;
+};
 
-protected:
+// PLY writer which receives the mesh in slabs (one marching cubes layer at a time).
+// Vertices (float32 position, s and t as in earlier PLY files) and faces (uint32 indices) are
+// written to two temporary body files, so the final counts are known only when Finish()
+// concatenates the header with both bodies.
+// Peak memory is bounded by the size of a single slab.
+class MeshFileSavePLYStream : public QObject
+{
+	Q_OBJECT
+public:
+	MeshFileSavePLYStream(QString filename, MeshFileSave::structSaveMeshConfig meshConfig,
+		bool optimizeVertexCache);
+	~MeshFileSavePLYStream() override;
+
+	bool Open();
+	void SetColorMapping(const cColorGradient &gradient, double colorSpeed, double colorOffset);
+	void AppendSlab(const std::vector<double> &vertices, std::vector<long long> &polygons,
+		const std::vector<double> &colorIndices);
+	bool Finish();
+	void Abort();
+
+	quint64 GetVertexCount() const { return vertexCount; }
+	quint64 GetPolygonCount() const { return polygonCount; }
+	QString getJobName() { return tr("Saving %1").arg("PLY"); }
+
+	// reorders triangles of the slab for better post-transform vertex cache usage
+	// (linear-speed vertex cache optimisation by T. Forsyth)
+	static void OptimizeVertexCache(std::vector<long long> &polygons);
+
+private:
+	sRGB8 ColorIndexToRGB8(double colorIndex) const;
+	bool AppendFile(QFile *target, QFile *source);
 	QString filename;
-	structSaveMeshConfig meshConfig;
-	structSaveMeshData meshData;
+	MeshFileSave::structSaveMeshConfig meshConfig;
+	bool optimizeVertexCache;
+	bool withColor;
+	bool isBinary;
 
-	MeshFileSave(QString filename, structSaveMeshConfig meshConfig, structSaveMeshData meshData);
+	QFile verticesBody;
+	QFile polygonsBody;
+	quint64 vertexCount{0};
+	quint64 polygonCount{0};
+
+	cColorGradient gradient;
+	double colorSpeed{1.0};
+	double colorOffset{0.0};
 
 signals:
 	void updateProgressAndStatus(const QString &text, const QString &progressText, double progress);
 };
 
-class MeshFileSavePLY : public MeshFileSave
-{
-	Q_OBJECT
-public:
-	MeshFileSavePLY(QString filename, structSaveMeshConfig meshConfig, structSaveMeshData meshData)
-			: MeshFileSave(filename, meshConfig, meshData)
-	{
-	}
-	void SaveMesh() override;
-	QString getJobName() override { return tr("Saving %1").arg("PLY"); }
-	void SavePLY();
-};
-
 #endif /* MANDELBULBER2_SRC_FILE_MESH_HPP_ */
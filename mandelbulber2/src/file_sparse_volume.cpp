@@ -0,0 +1,241 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cSparseVolumeFileSave - writes the voxel volume as a single chunked, compressed sparse grid
+ */
+
+#include "file_sparse_volume.hpp"
+
+#include <cfloat>
+#include <cstring>
+
+#include <QDataStream>
+#include <QDebug>
+
+#include "lzo_compression.h"
+
+cSparseVolumeFileSave::cSparseVolumeFileSave(QString filename, int w, int h, int l,
+	CVector3 limitMin, CVector3 limitMax, double distThresh, int maxIter)
+{
+	this->filename = filename;
+	this->w = w;
+	this->h = h;
+	this->l = l;
+	this->limitMin = limitMin;
+	this->limitMax = limitMax;
+	this->distThresh = distThresh;
+	this->maxIter = maxIter;
+
+	// bricks which don't have any voxel closer than one voxel diagonal to the surface are skipped
+	CVector3 step((limitMax.x - limitMin.x) / w, (limitMax.y - limitMin.y) / h,
+		(limitMax.z - limitMin.z) / l);
+	emptyDistance = distThresh + step.Length();
+
+	layersInSlab = 0;
+	slabIndex = 0;
+	skippedBricks = 0;
+}
+
+cSparseVolumeFileSave::~cSparseVolumeFileSave()
+{
+	Abort();
+}
+
+bool cSparseVolumeFileSave::Open()
+{
+	file.setFileName(filename + ".tmp");
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		qCritical() << "Cannot write to file " << file.fileName();
+		return false;
+	}
+
+	distanceSlab.resize(size_t(w) * h * brickSize);
+	iterationSlab.resize(size_t(w) * h * brickSize);
+	layersInSlab = 0;
+	slabIndex = 0;
+	brickIndex.clear();
+	skippedBricks = 0;
+
+	return WriteHeader(0);
+}
+
+bool cSparseVolumeFileSave::WriteHeader(quint64 indexOffset)
+{
+	file.seek(0);
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+	stream.writeRawData("MBSV", 4);
+	stream << quint32(formatVersion);
+	stream << qint32(w) << qint32(h) << qint32(l) << qint32(brickSize);
+	stream << limitMin.x << limitMin.y << limitMin.z;
+	stream << limitMax.x << limitMax.y << limitMax.z;
+	stream << distThresh << emptyDistance;
+	stream << qint32(maxIter);
+	stream << quint32(channelDistance | channelIterations);
+	stream << quint32(compressionLzo);
+	// brick count and index offset are rewritten in Finish()
+	stream << quint64(brickIndex.size()) << indexOffset;
+
+	return stream.status() == QDataStream::Ok;
+}
+
+bool cSparseVolumeFileSave::AppendLayer(
+	const std::vector<double> &distances, const std::vector<int> &iterations)
+{
+	if (!file.isOpen()) return false;
+
+	size_t layerSize = size_t(w) * h;
+	size_t slabOffset = layerSize * layersInSlab;
+	for (size_t i = 0; i < layerSize; i++)
+	{
+		distanceSlab[slabOffset + i] = float(distances[i]);
+		iterationSlab[slabOffset + i] = quint16(qBound(0, iterations[i], 65535));
+	}
+	layersInSlab++;
+
+	if (layersInSlab == brickSize) return FlushBrickRow();
+	return true;
+}
+
+bool cSparseVolumeFileSave::FlushBrickRow()
+{
+	if (layersInSlab == 0) return true;
+
+	const int voxelsInBrick = brickSize * brickSize * brickSize;
+	QByteArray payload;
+	payload.resize(voxelsInBrick * int(sizeof(float) + sizeof(quint16)));
+	float *brickDistances = reinterpret_cast<float *>(payload.data());
+	quint16 *brickIterations =
+		reinterpret_cast<quint16 *>(payload.data() + voxelsInBrick * sizeof(float));
+
+	const int bricksX = (w + brickSize - 1) / brickSize;
+	const int bricksY = (h + brickSize - 1) / brickSize;
+	const size_t layerSize = size_t(w) * h;
+
+	for (int by = 0; by < bricksY; by++)
+	{
+		for (int bx = 0; bx < bricksX; bx++)
+		{
+			float minDistance = FLT_MAX;
+			int ptr = 0;
+			for (int z = 0; z < brickSize; z++)
+			{
+				for (int y = 0; y < brickSize; y++)
+				{
+					for (int x = 0; x < brickSize; x++, ptr++)
+					{
+						int vx = bx * brickSize + x;
+						int vy = by * brickSize + y;
+						if (vx < w && vy < h && z < layersInSlab)
+						{
+							size_t address = z * layerSize + vx + size_t(vy) * w;
+							brickDistances[ptr] = distanceSlab[address];
+							brickIterations[ptr] = iterationSlab[address];
+							minDistance = qMin(minDistance, distanceSlab[address]);
+						}
+						else
+						{
+							// padding outside of the volume
+							brickDistances[ptr] = FLT_MAX;
+							brickIterations[ptr] = 0;
+						}
+					}
+				}
+			}
+
+			if (minDistance > emptyDistance)
+			{
+				skippedBricks++;
+				continue;
+			}
+
+			QByteArray compressed = lzoCompress(payload);
+			sBrickIndexEntry entry;
+			entry.x = bx;
+			entry.y = by;
+			entry.z = slabIndex;
+			entry.offset = quint64(file.pos());
+			entry.size = quint32(compressed.size());
+			if (file.write(compressed) != compressed.size())
+			{
+				qCritical() << "Cannot write to file " << filename;
+				return false;
+			}
+			brickIndex.push_back(entry);
+		}
+	}
+
+	layersInSlab = 0;
+	slabIndex++;
+	return true;
+}
+
+bool cSparseVolumeFileSave::Finish()
+{
+	if (!file.isOpen()) return false;
+
+	bool result = FlushBrickRow();
+
+	quint64 indexOffset = quint64(file.pos());
+	{
+		QDataStream stream(&file);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		for (const sBrickIndexEntry &entry : brickIndex)
+		{
+			stream << entry.x << entry.y << entry.z << entry.offset << entry.size;
+		}
+		result = result && stream.status() == QDataStream::Ok;
+	}
+
+	// update brick count and index offset
+	result = result && WriteHeader(indexOffset);
+
+	file.close();
+
+	if (result)
+	{
+		if (QFile::exists(filename)) QFile::remove(filename);
+		result = file.rename(filename);
+		if (!result) qCritical() << "Cannot rename" << file.fileName() << "to" << filename;
+	}
+	if (!result) file.remove();
+	return result;
+}
+
+void cSparseVolumeFileSave::Abort()
+{
+	if (!file.isOpen()) return;
+	file.close();
+	file.remove();
+}
@@ -0,0 +1,123 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cSparseVolumeFileSave - writes the voxel volume as a single chunked, compressed sparse grid
+ *
+ * The volume is divided into bricks of 8x8x8 voxels. Each brick stores the distance field
+ * (float32) and iteration count (uint16) channels compressed with LZO. Bricks which are far
+ * from the fractal surface are skipped. The brick index is placed at the end of the file,
+ * so the writer needs to keep in memory only one row of bricks (8 layers).
+ *
+ * File layout (little endian):
+ *   header: "MBSV", version, w, h, l, brick size, limitMin, limitMax, distThresh,
+ *           emptyDistance, maxIter, channels, compression, brick count, index offset
+ *   brick data: compressed brick payloads
+ *   index: for each stored brick: x, y, z (in bricks), offset, compressed size
+ */
+
+#ifndef MANDELBULBER2_SRC_FILE_SPARSE_VOLUME_HPP_
+#define MANDELBULBER2_SRC_FILE_SPARSE_VOLUME_HPP_
+
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+#include "algebra.hpp"
+
+class cSparseVolumeFileSave
+{
+public:
+	static const int brickSize = 8;
+	static const quint32 formatVersion = 1;
+
+	enum enumChannels
+	{
+		channelDistance = 1,
+		channelIterations = 2
+	};
+
+	enum enumCompression
+	{
+		compressionNone = 0,
+		compressionLzo = 1
+	};
+
+	cSparseVolumeFileSave(QString filename, int w, int h, int l, CVector3 limitMin,
+		CVector3 limitMax, double distThresh, int maxIter);
+	~cSparseVolumeFileSave();
+
+	bool Open();
+
+	// layer data is indexed as x + y * w
+	bool AppendLayer(const std::vector<double> &distances, const std::vector<int> &iterations);
+
+	// volume is written to a temporary file which gets the final name only in Finish().
+	// Abort() deletes the incomplete volume
+	bool Finish();
+	void Abort();
+
+	quint64 GetStoredBricksCount() const { return brickIndex.size(); }
+	quint64 GetSkippedBricksCount() const { return skippedBricks; }
+	static QString FileExtension() { return "mbsv"; }
+
+private:
+	struct sBrickIndexEntry
+	{
+		qint32 x;
+		qint32 y;
+		qint32 z;
+		quint64 offset;
+		quint32 size;
+	};
+
+	bool WriteHeader(quint64 indexOffset);
+	bool FlushBrickRow();
+
+	QString filename;
+	QFile file;
+	int w, h, l;
+	CVector3 limitMin;
+	CVector3 limitMax;
+	double distThresh;
+	double emptyDistance;
+	int maxIter;
+
+	std::vector<float> distanceSlab;
+	std::vector<quint16> iterationSlab;
+	int layersInSlab;
+	int slabIndex;
+
+	std::vector<sBrickIndexEntry> brickIndex;
+	quint64 skippedBricks;
+};
+
+#endif /* MANDELBULBER2_SRC_FILE_SPARSE_VOLUME_HPP_ */
@@ -45,6 +45,7 @@
 #include "cimage.hpp"
 #include "error_message.hpp"
 #include "initparameters.hpp"
+#include "render_trace.hpp"
 #include "system_data.hpp"
 #include "system_directories.hpp"
 #include "write_log.hpp"
@@ -253,6 +254,7 @@ void BufferNormalize16(sRGB16 *buffer, unsigned int size)
 QStringList SaveImage(QString filename, ImageFileSave::enumImageFileType fileType,
 	std::shared_ptr<cImage> image, QObject *updateReceiver)
 {
+	cTraceSpan traceSpan("SaveImage", "file");
 	QStringList listOfSavedFiles;
 
 	ImageFileSave::ImageConfig imageConfig;
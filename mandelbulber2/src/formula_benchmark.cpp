@@ -0,0 +1,422 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cFormulaBenchmark - microbenchmark of every registered fractal formula
+ */
+
+#include "formula_benchmark.hpp"
+
+#include <cmath>
+#include <random>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "calculate_distance.hpp"
+#include "fractal.h"
+#include "fractal_container.hpp"
+#include "fractparams.hpp"
+#include "initparameters.hpp"
+#include "material.h"
+#include "nine_fractals.hpp"
+#include "opencl_device.h"
+#include "opencl_engine_render_fractal.h"
+#include "opencl_global.h"
+#include "opencl_hardware.h"
+#include "parameters.hpp"
+#include "render_data.hpp"
+#include "system.hpp"
+#include "write_log.hpp"
+
+#include "formula/definition/all_fractal_list.hpp"
+
+namespace
+{
+// names of measured values in JSON output, in the same order as in sFormulaResult
+const char *const metricNames[] = {"iterationsPerSecond", "analyticDESamplesPerSecond",
+	"deltaDESamplesPerSecond", "openClAnalyticDESamplesPerSecond", "openClDeltaDESamplesPerSecond"};
+const int numberOfMetrics = 5;
+
+double GetMetric(const cFormulaBenchmark::sFormulaResult &result, int index)
+{
+	switch (index)
+	{
+		case 0: return result.iterationsPerSecond;
+		case 1: return result.analyticDESamplesPerSecond;
+		case 2: return result.deltaDESamplesPerSecond;
+		case 3: return result.openClAnalyticDESamplesPerSecond;
+		case 4: return result.openClDeltaDESamplesPerSecond;
+		default: return -1.0;
+	}
+}
+} // namespace
+
+cFormulaBenchmark::cFormulaBenchmark(int _difficulty)
+{
+	difficulty = _difficulty;
+	measureTime = qint64(difficulty) * 10000000; // 10ms per difficulty level
+	openClAvailable = false;
+
+	// the same set of points for every formula and every run
+	std::mt19937 generator(12345);
+	std::uniform_real_distribution<double> distribution(-2.0, 2.0);
+	samplePoints.reserve(1024);
+	for (int i = 0; i < 1024; i++)
+	{
+		const double x = distribution(generator);
+		const double y = distribution(generator);
+		const double z = distribution(generator);
+		samplePoints.append(CVector3(x, y, z));
+	}
+}
+
+cFormulaBenchmark::~cFormulaBenchmark() = default;
+
+bool cFormulaBenchmark::InitOpenClCpuDevice()
+{
+#ifdef USE_OPENCL
+	gPar->Set("opencl_enabled", true);
+	gPar->Set("opencl_device_type", int(cOpenClDevice::openClDeviceTypeCPU));
+	gOpenCl->Reset();
+	gOpenCl->openClHardware->ListOpenClPlatforms();
+
+	for (int platform = 0; platform < gOpenCl->openClHardware->getNumberOfPlatforms(); platform++)
+	{
+		gOpenCl->openClHardware->CreateContext(platform, cOpenClDevice::openClDeviceTypeCPU);
+		const QList<cOpenClDevice::sDeviceInformation> &devices =
+			gOpenCl->openClHardware->getDevicesInformation();
+		for (int d = 0; d < devices.size(); d++)
+		{
+			if (devices[d].compilerAvailable)
+			{
+				gPar->Set("opencl_platform", platform);
+				gPar->Set("opencl_device_list", QString(devices[d].hash.toHex()));
+				gOpenCl->openClHardware->EnableDevice(d);
+				openClDeviceName = devices[d].deviceName;
+				return true;
+			}
+		}
+	}
+
+	gPar->Set("opencl_enabled", false);
+#endif // USE_OPENCL
+	return false;
+}
+
+void cFormulaBenchmark::PrepareParameters(
+	const cAbstractFractal *formula, fractal::enumDEMethod deMethod)
+{
+	// default settings with only the tested formula, application settings (OpenCL) are kept
+	par.reset(new cParameterContainer(*gPar));
+	par->ResetAllToDefault();
+	par->Set("formula", 1, int(formula->getInternalId()));
+	par->Set("delta_DE_method", int(deMethod));
+
+	parFractal.reset(new cFractalContainer(*gParFractal));
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		parFractal->at(i)->ResetAllToDefault();
+	}
+}
+
+void cFormulaBenchmark::Run()
+{
+	results.clear();
+	openClAvailable = InitOpenClCpuDevice();
+	if (openClAvailable)
+		WriteLogString("Formula benchmark - OpenCL CPU device", openClDeviceName, 1);
+	else
+		WriteLog("Formula benchmark - no OpenCL CPU device, OpenCL paths are skipped", 1);
+
+	for (int index = 0; index < newFractalList.size(); index++)
+	{
+		cAbstractFractal *formula = newFractalList[index];
+
+		// custom formula has only OpenCL code
+		if (formula->getInternalId() == fractal::none || formula->getInternalId() == fractal::custom)
+			continue;
+
+		sFormulaResult result;
+		result.name = formula->getInternalName();
+		result.id = int(formula->getInternalId());
+		result.analyticDESamplesPerSecond = -1.0;
+		result.openClAnalyticDESamplesPerSecond = -1.0;
+		result.openClDeltaDESamplesPerSecond = -1.0;
+
+		// analytic DE is measured only for formulas which have it
+		const bool hasAnalyticDE = formula->getDeType() == fractal::analyticDEType;
+		const bool hasOpenClCode =
+			openClAvailable && QFileInfo::exists(formula->getOpenCLFilename());
+
+		PrepareParameters(formula, fractal::forceDeltaDEMethod);
+		result.iterationsPerSecond = MeasureFormulaCode();
+		result.deltaDESamplesPerSecond = MeasureDistance();
+		if (hasOpenClCode) result.openClDeltaDESamplesPerSecond = MeasureOpenClDistance();
+
+		if (hasAnalyticDE)
+		{
+			PrepareParameters(formula, fractal::forceAnalyticDE);
+			result.analyticDESamplesPerSecond = MeasureDistance();
+			if (hasOpenClCode) result.openClAnalyticDESamplesPerSecond = MeasureOpenClDistance();
+		}
+
+		WriteLog(QString("Formula benchmark - %1: %2 it/s, analytic DE %3 samples/s, delta DE %4 "
+										 "samples/s")
+							 .arg(result.name)
+							 .arg(result.iterationsPerSecond, 0, 'g', 4)
+							 .arg(result.analyticDESamplesPerSecond, 0, 'g', 4)
+							 .arg(result.deltaDESamplesPerSecond, 0, 'g', 4),
+			2);
+
+		results.append(result);
+	}
+
+#ifdef USE_OPENCL
+	if (openClAvailable) gOpenCl->openClEngineRenderFractal->ReleaseMemory();
+#endif
+}
+
+double cFormulaBenchmark::MeasureFormulaCode()
+{
+	const cNineFractals fractals(parFractal, par);
+	cAbstractFractal *formula = fractals.GetFractalFormulaFunction(0);
+	const sFractal *fractal = fractals.GetFractal(0);
+	const double bailout = fractals.GetBailout(0);
+	const int maxN = par->Get<int>("N");
+
+	qint64 iterations = 0;
+	int pointIndex = 0;
+	QElapsedTimer timer;
+	timer.start();
+	do
+	{
+		for (int batch = 0; batch < 64; batch++)
+		{
+			CVector4 z(samplePoints[pointIndex], fractals.GetInitialWAxis(0));
+			pointIndex = (pointIndex + 1) % samplePoints.size();
+
+			// the same initial values as in Compute()
+			sExtendedAux aux;
+			aux.c = z;
+			aux.const_c = z;
+			aux.old_z = z;
+			aux.pos_neg = 1.0;
+			aux.r = z.Length();
+			aux.DE = 1.0;
+			aux.DE0 = 0.0;
+			aux.dist = 1000.0;
+			aux.pseudoKleinianDE = 1.0;
+			aux.actualScale = fractal->mandelbox.scale;
+			aux.actualScaleA = 0.0;
+			aux.color = 1.0;
+			aux.colorHybrid = 0.0;
+			aux.temp1000 = 1000.0;
+
+			for (int i = 0; i < maxN; i++)
+			{
+				aux.i = i;
+				formula->FormulaCode(z, fractal, aux);
+				iterations++;
+				aux.r = z.Length();
+				if (aux.r > bailout || !std::isfinite(aux.r)) break;
+			}
+		}
+	} while (timer.nsecsElapsed() < measureTime);
+
+	return iterations / (timer.nsecsElapsed() * 1e-9);
+}
+
+double cFormulaBenchmark::MeasureDistance()
+{
+	std::shared_ptr<sRenderData> renderData(new sRenderData);
+	renderData->objectData.resize(NUMBER_OF_FRACTALS);
+	const cNineFractals fractals(parFractal, par);
+	const sParamRender params(par, &renderData->objectData);
+	CreateMaterialsMap(par, &renderData->materials, false, true, false);
+	renderData->ValidateObjects();
+
+	qint64 samples = 0;
+	int pointIndex = 0;
+	QElapsedTimer timer;
+	timer.start();
+	do
+	{
+		for (int batch = 0; batch < 64; batch++)
+		{
+			const sDistanceIn in(samplePoints[pointIndex], 1e-5, false);
+			sDistanceOut out;
+			CalculateDistance(params, fractals, in, &out, renderData.get());
+			pointIndex = (pointIndex + 1) % samplePoints.size();
+			samples++;
+		}
+	} while (timer.nsecsElapsed() < measureTime);
+
+	return samples / (timer.nsecsElapsed() * 1e-9);
+}
+
+double cFormulaBenchmark::MeasureOpenClDistance()
+{
+#ifdef USE_OPENCL
+	// slices of a 64x64x64 grid calculated by the mesh export kernel
+	const int gridSize = 64;
+
+	if (cOpenClEngineRenderFractal::enumClRenderEngineMode(par->Get<int>("opencl_mode"))
+			== cOpenClEngineRenderFractal::clRenderEngineTypeNone)
+		par->Set("opencl_mode", int(cOpenClEngineRenderFractal::clRenderEngineTypeFull));
+
+	bool stopRequest = false;
+	std::shared_ptr<sRenderData> renderData(new sRenderData);
+	renderData->objectData.resize(NUMBER_OF_FRACTALS);
+	renderData->stopRequest = &stopRequest;
+	std::shared_ptr<cNineFractals> fractals(new cNineFractals(parFractal, par));
+	std::shared_ptr<sParamRender> params(new sParamRender(par, &renderData->objectData));
+	CreateMaterialsMap(par, &renderData->materials, false, true, false);
+	renderData->ValidateObjects();
+
+	sClMeshExport clMeshParams;
+	clMeshParams.distThresh = 1e-5;
+	clMeshParams.limitMin = toClFloat3(CVector3(-2.0, -2.0, -2.0));
+	clMeshParams.limitMax = toClFloat3(CVector3(2.0, 2.0, 2.0));
+	clMeshParams.maxiter = params->N;
+	clMeshParams.size = toClInt3(gridSize, gridSize, gridSize);
+	clMeshParams.sliceHeight = gridSize;
+	clMeshParams.sliceWidth = gridSize;
+	clMeshParams.coloredMesh = false;
+
+	std::vector<double> distances(gridSize * gridSize);
+	std::vector<int> iterations(gridSize * gridSize);
+
+	cOpenClEngineRenderFractal *engine = gOpenCl->openClEngineRenderFractal;
+	engine->Lock();
+	engine->SetParameters(par, parFractal, params, fractals, renderData, true);
+	engine->SetMeshExportParameters(&clMeshParams);
+
+	// compilation time is not measured
+	double samplesPerSecond = -1.0;
+	if (engine->LoadSourcesAndCompile(par))
+	{
+		engine->CreateKernel4Program(par);
+		engine->PreAllocateBuffers(par);
+		engine->CreateCommandQueue();
+
+		qint64 samples = 0;
+		int slice = 0;
+		bool ok = true;
+		QElapsedTimer timer;
+		timer.start();
+		do
+		{
+			ok = engine->Render(
+				&distances, nullptr, &iterations, slice, &stopRequest, renderData.get(), 0);
+			slice = (slice + 1) % gridSize;
+			samples += gridSize * gridSize;
+		} while (ok && timer.nsecsElapsed() < measureTime);
+
+		if (ok) samplesPerSecond = samples / (timer.nsecsElapsed() * 1e-9);
+	}
+	engine->ReleaseMemory();
+	engine->Unlock();
+	return samplesPerSecond;
+#else
+	return -1.0;
+#endif // USE_OPENCL
+}
+
+QByteArray cFormulaBenchmark::ToJson() const
+{
+	QJsonArray formulas;
+	for (const sFormulaResult &result : results)
+	{
+		QJsonObject formula;
+		formula["name"] = result.name;
+		formula["id"] = result.id;
+		for (int m = 0; m < numberOfMetrics; m++)
+		{
+			const double value = GetMetric(result, m);
+			formula[metricNames[m]] = value >= 0.0 ? QJsonValue(value) : QJsonValue();
+		}
+		formulas.append(formula);
+	}
+
+	QJsonObject root;
+	root["version"] = QString(MANDELBULBER_VERSION_STRING);
+	root["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	root["difficulty"] = difficulty;
+	root["openClDevice"] = openClAvailable ? QJsonValue(openClDeviceName) : QJsonValue();
+	root["formulas"] = formulas;
+	return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+QStringList cFormulaBenchmark::CompareWithBaseline(
+	const QByteArray &baselineJson, double tolerancePercent, bool *parseOk) const
+{
+	QStringList regressions;
+
+	QJsonParseError error;
+	const QJsonDocument baseline = QJsonDocument::fromJson(baselineJson, &error);
+	*parseOk = error.error == QJsonParseError::NoError && baseline.isObject();
+	if (!*parseOk) return regressions;
+
+	QHash<QString, QJsonObject> baselineFormulas;
+	for (const QJsonValue &formula : baseline.object()["formulas"].toArray())
+	{
+		baselineFormulas.insert(formula.toObject()["name"].toString(), formula.toObject());
+	}
+
+	// formulas and paths which are missing on any side are not compared
+	const double minRatio = 1.0 - tolerancePercent / 100.0;
+	for (const sFormulaResult &result : results)
+	{
+		if (!baselineFormulas.contains(result.name)) continue;
+		const QJsonObject &baselineFormula = baselineFormulas[result.name];
+		for (int m = 0; m < numberOfMetrics; m++)
+		{
+			const double value = GetMetric(result, m);
+			const double baselineValue = baselineFormula[metricNames[m]].toDouble(-1.0);
+			if (value < 0.0 || baselineValue <= 0.0) continue;
+
+			if (value / baselineValue < minRatio)
+			{
+				regressions.append(QString("%1 %2: %3 -> %4 (%5%)")
+														 .arg(result.name, metricNames[m])
+														 .arg(baselineValue, 0, 'g', 4)
+														 .arg(value, 0, 'g', 4)
+														 .arg((value / baselineValue - 1.0) * 100.0, 0, 'f', 1));
+			}
+		}
+	}
+	return regressions;
+}
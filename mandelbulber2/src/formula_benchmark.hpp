@@ -0,0 +1,101 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cFormulaBenchmark - microbenchmark of every registered fractal formula
+ *
+ * For each formula from newFractalList it measures iterations per second of the bare
+ * FormulaCode() and distance estimation samples per second of CalculateDistance() with forced
+ * analytic and forced delta DE. When OpenCL support is compiled in and a CPU OpenCL device is
+ * available, the same DE paths are measured with the mesh export kernel. Results are written as
+ * JSON and can be compared with a baseline file to detect performance regressions.
+ */
+
+#ifndef MANDELBULBER2_SRC_FORMULA_BENCHMARK_HPP_
+#define MANDELBULBER2_SRC_FORMULA_BENCHMARK_HPP_
+
+#include <memory>
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "algebra.hpp"
+#include "fractal_enums.h"
+
+// forward declarations
+class cAbstractFractal;
+class cFractalContainer;
+class cParameterContainer;
+
+class cFormulaBenchmark
+{
+public:
+	struct sFormulaResult
+	{
+		QString name;
+		int id;
+		// negative value means that the path was not measured
+		double iterationsPerSecond;
+		double analyticDESamplesPerSecond;
+		double deltaDESamplesPerSecond;
+		double openClAnalyticDESamplesPerSecond;
+		double openClDeltaDESamplesPerSecond;
+	};
+
+	cFormulaBenchmark(int difficulty);
+	~cFormulaBenchmark();
+
+	void Run();
+	QByteArray ToJson() const;
+	QStringList CompareWithBaseline(
+		const QByteArray &baselineJson, double tolerancePercent, bool *parseOk) const;
+	const QList<sFormulaResult> &GetResults() const { return results; }
+
+private:
+	void PrepareParameters(const cAbstractFractal *formula, fractal::enumDEMethod deMethod);
+	double MeasureFormulaCode();
+	double MeasureDistance();
+	double MeasureOpenClDistance();
+	bool InitOpenClCpuDevice();
+
+	std::shared_ptr<cParameterContainer> par;
+	std::shared_ptr<cFractalContainer> parFractal;
+	QVector<CVector3> samplePoints;
+	QList<sFormulaResult> results;
+	QString openClDeviceName;
+	qint64 measureTime; // [ns]
+	int difficulty;
+	bool openClAvailable;
+};
+
+#endif /* MANDELBULBER2_SRC_FORMULA_BENCHMARK_HPP_ */
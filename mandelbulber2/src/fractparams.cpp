@@ -101,6 +101,7 @@ sParamRender::sParamRender(
 	DEThresh = container->Get<double>("DE_thresh");
 	DOFEnabled = container->Get<bool>("DOF_enabled");
 	DOFFocus = container->Get<double>("DOF_focus");
+	enhancedSphereTracingFactor = container->Get<double>("enhanced_sphere_tracing_factor");
 	DOFRadius = container->Get<double>("DOF_radius");
 	DOFMaxRadius = container->Get<double>("DOF_max_radius");
 	DOFHDRMode = container->Get<bool>("DOF_HDR");
@@ -111,9 +112,13 @@ sParamRender::sParamRender(
 	DOFMinSamples = container->Get<int>("DOF_min_samples");
 	DOFBlurOpacity = container->Get<double>("DOF_blur_opacity");
 	DOFMaxNoise = container->Get<double>("DOF_max_noise");
+	denoiserEnabled = container->Get<bool>("denoiser_enabled");
+	denoiserIterations = container->Get<int>("denoiser_iterations");
+	denoiserStrength = container->Get<double>("denoiser_strength");
 	DOFMonteCarloChromaticAberration = container->Get<bool>("DOF_MC_CA_enable");
 	DOFMonteCarloCADispersionGain = container->Get<float>("DOF_MC_CA_dispersion_gain");
 	DOFMonteCarloCACameraDispersion = container->Get<float>("DOF_MC_CA_camera_dispersion");
+	enhancedSphereTracing = container->Get<bool>("enhanced_sphere_tracing");
 	envMappingEnable = container->Get<bool>("env_mapping_enable");
 	fakeLightsColor = toRGBFloat(container->Get<sRGB>("fake_lights_color"));
 	fakeLightsEnabled = container->Get<bool>("fake_lights_enabled");
@@ -162,8 +167,12 @@ sParamRender::sParamRender(
 	monteCarloSoftShadows = container->Get<bool>("MC_soft_shadows_enable");
 	monteCarloGIRadianceLimit = container->Get<float>("MC_GI_radiance_limit");
 	monteCarloGIVolumetric = container->Get<bool>("MC_global_illumination_volumetric");
+	monteCarloGICache = container->Get<bool>("MC_GI_cache_enabled");
+	monteCarloGICacheAccuracy = container->Get<float>("MC_GI_cache_accuracy");
+	monteCarloGICacheSamples = container->Get<int>("MC_GI_cache_samples");
 	N = container->Get<int>("N");
 	raytracedReflections = container->Get<bool>("raytraced_reflections");
+	secantHitRefinement = container->Get<bool>("secant_hit_refinement");
 	reflectionsMax = container->Get<int>("reflections_max");
 	relMaxMarchingStep = container->Get<double>("rel_max_marching_step");
 	relMinMarchingStep = container->Get<double>("rel_min_marching_step");
@@ -172,6 +181,7 @@ sParamRender::sParamRender(
 	slowShading = container->Get<bool>("slow_shading");
 	smoothness = container->Get<double>("smoothness");
 	SSAO_random_mode = container->Get<bool>("SSAO_random_mode");
+	SSAO_hierarchical = container->Get<bool>("SSAO_hierarchical");
 	stereoEyeDistance = container->Get<double>("stereo_eye_distance");
 	stereoInfiniteCorrection = container->Get<double>("stereo_infinite_correction");
 	stereoSwapEyes = container->Get<bool>("stereo_swap_eyes");
@@ -213,6 +223,7 @@ sParamRender::sParamRender(
 		formulaRotation[i] = container->Get<CVector3>("formula_rotation", i + 1);
 		formulaRepeat[i] = container->Get<CVector3>("formula_repeat", i + 1);
 		formulaScale[i] = 1.0 / container->Get<double>("formula_scale", i + 1);
+		formulaBoundingRadius[i] = container->Get<double>("formula_bounding_radius", i + 1);
 		mRotFormulaRotation[i].SetRotation2(formulaRotation[i] * (M_PI / 180.0));
 		formulaMaterialId[i] = container->Get<int>("formula_material_id", i + 1);
 
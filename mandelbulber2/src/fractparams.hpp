@@ -86,6 +86,8 @@ struct sParamRender
 	int DOFNumberOfPasses;
 	int DOFSamples;
 	int DOFMinSamples;
+	int denoiserIterations;
+	int monteCarloGICacheSamples;
 
 	params::enumPerspectiveType perspectiveType;
 	params::enumAOMode ambientOcclusionMode;
@@ -111,6 +113,8 @@ struct sParamRender
 	bool DOFMonteCarlo;
 	bool DOFMonteCarloGlobalIllumination;
 	bool DOFMonteCarloChromaticAberration;
+	bool denoiserEnabled;
+	bool enhancedSphereTracing;
 	bool envMappingEnable;
 	bool fakeLightsEnabled;
 	bool fogEnabled;
@@ -125,8 +129,11 @@ struct sParamRender
 	bool limitsEnabled; // enable limits (intersections)
 	bool monteCarloSoftShadows;
 	bool monteCarloGIVolumetric;
+	bool monteCarloGICache;
 	bool raytracedReflections;
+	bool secantHitRefinement;
 	bool slowShading; // enable fake gradient calculation for shading
+	bool SSAO_hierarchical; // horizon based SSAO on depth pyramid
 	bool SSAO_random_mode;
 	bool stereoSwapEyes;
 	bool texturedBackground; // enable textured background
@@ -179,10 +186,12 @@ struct sParamRender
 	double detailSizeMin;
 	double DEThresh;
 	double DOFFocus;
+	double enhancedSphereTracingFactor;
 	double DOFRadius;
 	double DOFMaxRadius;
 	double DOFBlurOpacity;
 	double DOFMaxNoise;
+	double denoiserStrength;
 	float DOFMonteCarloCADispersionGain;
 	float DOFMonteCarloCACameraDispersion;
 	double fakeLightsIntensity;
@@ -190,6 +199,7 @@ struct sParamRender
 	float fakeLightsVisibilitySize;
 	double fogVisibility;
 	double formulaScale[NUMBER_OF_FRACTALS];
+	double formulaBoundingRadius[NUMBER_OF_FRACTALS]; // 0 if boolean component is not bounded
 	double fov; // perspective factor
 	float glowIntensity;
 	double hdrBlurIntensity;
@@ -201,6 +211,7 @@ struct sParamRender
 	float iterFogOpacityTrimHigh;
 	float iterFogBrightnessBoost;
 	float monteCarloGIRadianceLimit;
+	float monteCarloGICacheAccuracy;
 	double relMaxMarchingStep;
 	double relMinMarchingStep;
 	double resolution; // resolution of image in fractal coordinates
@@ -0,0 +1,173 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cGeometryBuffer - per-pixel cache of primary ray hits for incremental re-shading
+ */
+
+#include "geometry_buffer.hpp"
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include "fractal_container.hpp"
+#include "fractparams.hpp"
+#include "parameters.hpp"
+#include "render_data.hpp"
+
+cGeometryBuffer::cGeometryBuffer()
+{
+	width = 0;
+	height = 0;
+}
+
+cGeometryBuffer::~cGeometryBuffer()
+{
+	// nothing to delete
+}
+
+bool cGeometryBuffer::IsApplicable(const sParamRender &params, const sRenderData &data)
+{
+	// effects which integrate along the whole primary ray need all ray-marching steps
+	if (params.glowEnabled || params.fogEnabled || params.volFogEnabled || params.iterFogEnabled
+			|| params.cloudsEnable || params.fakeLightsEnabled)
+		return false;
+
+	for (int i = 0; i < data.lights.GetNumberOfLights(); i++)
+	{
+		const cLight *light = data.lights.GetLight(i);
+		if (light->enabled && light->volumetric) return false;
+		// visible light halos are accumulated along the ray-marching steps as well
+		if (light->IsVisibleAlongRays()) return false;
+	}
+
+	// only one primary ray per pixel which is the same in every render
+	if (params.DOFMonteCarlo || params.antialiasingEnabled || data.stereo.isEnabled()) return false;
+
+	return data.reduceDetail == 1.0;
+}
+
+bool cGeometryBuffer::IsShadingParameter(const QString &name)
+{
+	static const QRegularExpression reLight("^light[0-9]+_(.*)$");
+	static const QRegularExpression reMaterial("^mat[0-9]+_(.*)$");
+
+	QRegularExpressionMatch matchLight = reLight.match(name);
+	if (matchLight.hasMatch())
+	{
+		// position, size, visibility etc. can change what is seen along the primary rays
+		static const QStringList lightShadingParameters = {"intensity", "color", "decayFunction",
+			"cast_shadows", "penetrating", "soft_shadow_cone", "cone_angle", "cone_soft_angle",
+			"contour_sharpness", "rotation", "file_texture", "repeat_texture",
+			"projection_horizonal_angle", "projection_vertical_angle"};
+		return lightShadingParameters.contains(matchLight.captured(1));
+	}
+
+	QRegularExpressionMatch matchMaterial = reMaterial.match(name);
+	if (matchMaterial.hasMatch())
+	{
+		// fractal colouring changes the colour index and displacement changes the surface
+		QString materialParameter = matchMaterial.captured(1);
+		return !(materialParameter.startsWith("fractal_coloring")
+						 || materialParameter.contains("displacement")
+						 || materialParameter.startsWith("texture_"));
+	}
+
+	static const QStringList shadingPrefixes = {"brightness", "contrast", "gamma", "hdr",
+		"saturation", "ambient_occlusion", "SSAO_", "glow_", "textured_background", "background_",
+		"raytraced_reflections", "reflections_max", "env_mapping_enable", "fog_color",
+		"volumetric_fog_", "iteration_fog_", "clouds_", "fill_light_color", "basic_fog_", "DOF_",
+		"MC_", "random_lights_color", "random_lights_intensity", "random_lights_one_color_enable",
+		"random_lights_soft_shadow_cone", "random_lights_penetrating", "random_lights_cast_shadows",
+		"fake_lights_", "file_background", "file_envmap", "file_lightmap", "all_primitives_invisible_alpha"};
+
+	for (const QString &prefix : shadingPrefixes)
+	{
+		if (name.startsWith(prefix)) return true;
+	}
+	return false;
+}
+
+QByteArray cGeometryBuffer::CalculateGeometryHash(
+	const cParameterContainer &params, const cFractalContainer &fractals)
+{
+	QCryptographicHash hashCrypt(QCryptographicHash::Md4);
+
+	for (const QString &parameterName : params.GetListOfParameters())
+	{
+		enumParameterType parameterType = params.GetParameterType(parameterName);
+		if (parameterType == paramApp || parameterType == paramNoSave) continue;
+		if (IsShadingParameter(parameterName)) continue;
+		hashCrypt.addData((parameterName + "=" + params.Get<QString>(parameterName) + ";").toUtf8());
+	}
+
+	// all formula parameters change the geometry
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		const std::shared_ptr<cParameterContainer> fractal = fractals.at(i);
+		for (const QString &parameterName : fractal->GetListOfParameters())
+		{
+			hashCrypt.addData(
+				(parameterName + "=" + fractal->Get<QString>(parameterName) + ";").toUtf8());
+		}
+	}
+
+	return hashCrypt.result();
+}
+
+void cGeometryBuffer::Prepare(const QByteArray &geometryHash, int _width, int _height)
+{
+	if (geometryHash != hash || _width != width || _height != height)
+	{
+		hash = geometryHash;
+		width = _width;
+		height = _height;
+		sGeometrySample emptySample = sGeometrySample();
+		samples.assign(size_t(width) * size_t(height), emptySample);
+	}
+}
+
+void cGeometryBuffer::Clear()
+{
+	samples.clear();
+	hash.clear();
+	width = 0;
+	height = 0;
+}
+
+bool cGeometryBuffer::IsComplete() const
+{
+	return !samples.empty()
+				 && std::all_of(samples.begin(), samples.end(),
+					 [](const sGeometrySample &sample) { return sample.valid; });
+}
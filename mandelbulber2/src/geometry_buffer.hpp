@@ -0,0 +1,101 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cGeometryBuffer - per-pixel cache of primary ray hits for incremental re-shading
+ *
+ * The buffer keeps the result of ray-marching of primary rays (depth, normal vector, object id
+ * and colour index) together with a hash of all parameters which can change the geometry. When
+ * the next render differs only in shading parameters (lights, materials colours, effects, ...)
+ * the primary rays are not marched again and only the shaders are recalculated.
+ */
+
+#ifndef MANDELBULBER2_SRC_GEOMETRY_BUFFER_HPP_
+#define MANDELBULBER2_SRC_GEOMETRY_BUFFER_HPP_
+
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+// forward declarations
+class cFractalContainer;
+class cParameterContainer;
+struct sParamRender;
+struct sRenderData;
+
+struct sGeometrySample
+{
+	double depth;
+	float distThresh;
+	float lastDist;
+	float normalX;
+	float normalY;
+	float normalZ;
+	float colorIndex; // negative if colour index was not calculated
+	int objectId;
+	bool found;
+	bool valid;
+};
+
+class cGeometryBuffer
+{
+public:
+	cGeometryBuffer();
+	~cGeometryBuffer();
+
+	// checks if primary rays are deterministic and if shaders don't need ray-marching steps
+	static bool IsApplicable(const sParamRender &params, const sRenderData &data);
+
+	// hash of all parameters which can change the primary ray hits
+	static QByteArray CalculateGeometryHash(
+		const cParameterContainer &params, const cFractalContainer &fractals);
+
+	// keeps stored samples if hash and size didn't change, otherwise invalidates them
+	void Prepare(const QByteArray &geometryHash, int width, int height);
+
+	void Clear();
+	bool IsComplete() const;
+
+	sGeometrySample *GetSample(int x, int y)
+	{
+		return &samples[size_t(x) + size_t(y) * size_t(width)];
+	}
+
+private:
+	static bool IsShadingParameter(const QString &name);
+
+	std::vector<sGeometrySample> samples;
+	QByteArray hash;
+	int width;
+	int height;
+};
+
+#endif /* MANDELBULBER2_SRC_GEOMETRY_BUFFER_HPP_ */
@@ -50,7 +50,9 @@
 #include "opencl_engine_render_fractal.h"
 #include "opencl_engine_render_ssao.h"
 #include "opencl_global.h"
+#include "progress_metrics.hpp"
 #include "queue.hpp"
+#include "render_daemon.hpp"
 #include "render_job.hpp"
 #include "rendering_configuration.hpp"
 #include "system_data.hpp"
@@ -61,10 +63,11 @@ cHeadless::cHeadless(QObject *parent) : QObject(parent) {}
 
 cHeadless::~cHeadless() = default;
 
-void cHeadless::RenderStillImage(QString filename, QString imageFileFormat)
+QString cHeadless::RenderStillImage(QString filename, QString imageFileFormat)
 {
 	std::shared_ptr<cImage> image(
 		new cImage(gPar->Get<int>("image_width"), gPar->Get<int>("image_height")));
+	cProgressMetrics::SetImage(image);
 	std::unique_ptr<cRenderJob> renderJob(
 		new cRenderJob(gPar, gParFractal, image, &gMainInterface->stopRequest));
 
@@ -75,13 +78,15 @@ void cHeadless::RenderStillImage(QString filename, QString imageFileFormat)
 		SLOT(slotUpdateStatistics(cStatistics)));
 
 #ifdef USE_OPENCL
-	// connect signal for progress bar update
+	// connect signal for progress bar update (only once, render daemon renders many images)
 	connect(gOpenCl->openClEngineRenderFractal,
 		SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
-		SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)));
+		SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)),
+		Qt::UniqueConnection);
 	connect(gOpenCl->openClEngineRenderSSAO,
 		SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
-		SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)));
+		SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)),
+		Qt::UniqueConnection);
 #endif
 
 	cRenderingConfiguration config;
@@ -114,10 +119,18 @@ void cHeadless::RenderStillImage(QString filename, QString imageFileFormat)
 		SaveImage(filenameWithoutExtension + ext, imageFileType, image, this);
 	}
 
-	QTextStream out(stdout);
-	out << tr("Image saved to: %1\n").arg(filenameWithoutExtension + ext);
+	if (cProgressMetrics::IsJsonLinesEnabled())
+	{
+		cProgressMetrics::ReportSavedFile(filenameWithoutExtension + ext);
+	}
+	else
+	{
+		QTextStream out(stdout);
+		out << tr("Image saved to: %1\n").arg(filenameWithoutExtension + ext);
+	}
 
 	emit finished();
+	return filenameWithoutExtension + ext;
 }
 
 void cHeadless::RenderQueue()
@@ -177,12 +190,15 @@ void cHeadless::RenderVoxel(QString voxelFormat)
 	if (samplesX > 0 && samplesY > 0 && samplesZ > 0)
 	{
 
-		if (voxelFormat == "slice")
+		if (voxelFormat == "slice" || voxelFormat == "volume")
 		{
 			QString folderString = gPar->Get<QString>("voxel_image_path");
 			QDir folder(folderString);
+			cVoxelExport::enumVoxelFormat format = voxelFormat == "volume"
+																							 ? cVoxelExport::voxelFormatSparseVolume
+																							 : cVoxelExport::voxelFormatSlice;
 			std::unique_ptr<cVoxelExport> voxelExport(new cVoxelExport(
-				samplesX, samplesY, samplesZ, limitMin, limitMax, folder, maxIter, greyscale));
+				samplesX, samplesY, samplesZ, limitMin, limitMax, folder, maxIter, greyscale, format));
 			QObject::connect(voxelExport.get(),
 				SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
 				SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)));
@@ -211,6 +227,7 @@ void cHeadless::RenderFlightAnimation()
 {
 	std::shared_ptr<cImage> image(
 		new cImage(gPar->Get<int>("image_width"), gPar->Get<int>("image_height")));
+	cProgressMetrics::SetImage(image);
 	gFlightAnimation =
 		new cFlightAnimation(gMainInterface, gAnimFrames, image, nullptr, gPar, gParFractal, this);
 	QObject::connect(gFlightAnimation,
@@ -234,6 +251,7 @@ void cHeadless::RenderKeyframeAnimation()
 {
 	std::shared_ptr<cImage> image(
 		new cImage(gPar->Get<int>("image_width"), gPar->Get<int>("image_height")));
+	cProgressMetrics::SetImage(image);
 	gKeyframeAnimation =
 		new cKeyframeAnimation(gMainInterface, gKeyframes, image, nullptr, gPar, gParFractal, this);
 	QObject::connect(gKeyframeAnimation,
@@ -258,6 +276,7 @@ void cHeadless::slotNetRender()
 	gMainInterface->stopRequest = true;
 	std::shared_ptr<cImage> image(
 		new cImage(gPar->Get<int>("image_width"), gPar->Get<int>("image_height")));
+	cProgressMetrics::SetImage(image);
 	std::unique_ptr<cRenderJob> renderJob(
 		new cRenderJob(gPar, gParFractal, image, &gMainInterface->stopRequest));
 	QObject::connect(renderJob.get(),
@@ -280,6 +299,16 @@ void cHeadless::slotNetRender()
 void cHeadless::slotUpdateProgressAndStatus(const QString &text, const QString &progressText,
 	double progress, cProgressText::enumProgressType progressType)
 {
+	// progress is also streamed to the client of render daemon
+	if (gRenderDaemon) gRenderDaemon->SendProgress(text, progressText, progress);
+
+	if (cProgressMetrics::IsEnabled())
+	{
+		cProgressMetrics::UpdateProgress(text, progressText, progress, progressType);
+		// JSON lines are not mixed with terminal progress bars
+		if (cProgressMetrics::IsJsonLinesEnabled()) return;
+	}
+
 	static bool firstCallProgressUpdate = true;
 	if (firstCallProgressUpdate)
 	{
@@ -328,6 +357,12 @@ void cHeadless::slotUpdateProgressAndStatus(const QString &text, const QString &
 
 void cHeadless::slotUpdateStatistics(const cStatistics &stat) const
 {
+	if (cProgressMetrics::IsEnabled())
+	{
+		cProgressMetrics::UpdateStatistics(stat);
+		if (cProgressMetrics::IsJsonLinesEnabled()) return;
+	}
+
 	if (!systemData.statsOnCLI) return;
 	/*ui->label_histogram_de->SetBarColor(QColor(0, 255, 0));
 	 ui->label_histogram_de->UpdateHistogram(stat.histogramStepCount);
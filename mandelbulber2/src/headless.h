@@ -61,7 +61,7 @@ public:
 		ansiWhite = 7
 	};
 
-	void RenderStillImage(QString filename, QString imageFileFormat);
+	QString RenderStillImage(QString filename, QString imageFileFormat);
 	[[noreturn]] static void RenderQueue();
 	void RenderVoxel(QString voxelFormat);
 	void RenderFlightAnimation();
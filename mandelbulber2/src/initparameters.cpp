@@ -83,6 +83,8 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("flight_rotation_speed", 10.0, morphNone, paramStandard);
 	par->addParam("flight_show_thumbnails", false, morphNone, paramApp);
 	par->addParam("flight_add_speeds", true, morphNone, paramStandard);
+	par->addParam("flight_reprojection_cache", false, morphNone, paramApp);
+	par->addParam("flight_parallel_frames", 1, 1, 64, morphNone, paramApp);
 	par->addParam("flight_movement_speed_vector", CVector3(0.0, 0.0, 0.0), morphNone, paramStandard);
 	par->addParam("flight_rotation_speed_vector", CVector3(0.0, 0.0, 0.0), morphNone, paramStandard);
 	par->addParam("flight_sec_per_frame", 1.0, morphNone, paramApp);
@@ -97,6 +99,7 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("keyframe_last_to_render", 9999999, 0, 9999999, morphNone, paramStandard);
 	par->addParam("show_keyframe_thumbnails", false, morphNone, paramApp);
 	par->addParam("keyframe_animation_image_type", 0, morphNone, paramApp, qslImageType);
+	par->addParam("keyframe_parallel_frames", 1, 1, 64, morphNone, paramApp);
 	par->addParam("anim_keyframe_dir", systemDirectories.GetAnimationFolder() + QDir::separator(),
 		morphNone, paramStandard);
 	par->addParam("keyframe_collision_thresh", 1.0e-6, 1e-15, 1.0e2, morphNone, paramStandard);
@@ -160,6 +163,7 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 		par->addParam("formula_rotation", i, CVector3(0.0, 0.0, 0.0), morphAkimaAngle, paramStandard);
 		par->addParam("formula_repeat", i, CVector3(0.0, 0.0, 0.0), morphAkima, paramStandard);
 		par->addParam("formula_scale", i, 1.0, morphAkima, paramStandard);
+		par->addParam("formula_bounding_radius", i, 0.0, 0.0, 1e15, morphAkima, paramStandard);
 		par->addParam("dont_add_c_constant", i, false, morphLinear, paramStandard);
 		par->addParam("check_for_bailout", i, true, morphLinear, paramStandard);
 		par->addParam("formula_material_id", i, 1, morphLinear, paramStandard);
@@ -179,6 +183,14 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("iteration_threshold_mode", false, morphNone, paramStandard);
 	par->addParam("analityc_DE_mode", true, morphNone, paramStandard);
 	par->addParam("DE_factor", 1.0, 1e-15, 1e15, morphLinear, paramStandard);
+	par->addParam("enhanced_sphere_tracing", false, morphNone, paramStandard);
+	par->addParam("enhanced_sphere_tracing_factor", 1.6, 1.0, 1.99, morphLinear, paramStandard);
+	par->addParam("secant_hit_refinement", false, morphNone, paramStandard);
+	par->addParam("cone_march_prepass", false, morphNone, paramApp);
+	par->addParam("auto_bounds_enabled", false, morphNone, paramApp);
+	par->addParam("incremental_reshading", false, morphNone, paramApp);
+	par->addParam("checkpoint_enabled", false, morphNone, paramApp);
+	par->addParam("checkpoint_interval", 60, 5, 86400, morphNone, paramApp);
 	par->addParam("slow_shading", false, morphLinear, paramStandard);
 	par->addParam("view_distance_max", 50.0, 1e-15, 1e15, morphLinear, paramStandard);
 	par->addParam("view_distance_min", 1e-15, 1e-15, 1e15, morphLinear, paramStandard);
@@ -228,6 +240,7 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 		paramStandard);
 	par->addParam("voxel_show_information", true, morphLinear, paramApp);
 	par->addParam("voxel_greyscale_iterations", false, morphLinear, paramApp);
+	par->addParam("voxel_sparse_volume", false, morphNone, paramApp);
 
 	// mesh export
 	par->addParam("mesh_output_filename",
@@ -235,6 +248,7 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 		paramStandard);
 	par->addParam("mesh_color", true, morphNone, paramApp);
 	par->addParam("mesh_file_mode", int(MeshFileSave::MESH_BINARY), morphNone, paramApp);
+	par->addParam("mesh_optimize_vertex_cache", false, morphNone, paramApp);
 
 	// foldings
 	par->addParam("box_folding", false, morphLinear, paramStandard);
@@ -259,6 +273,7 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 		"ambient_occlusion_mode", int(params::AOModeScreenSpace), morphLinear, paramStandard);
 	par->addParam("ambient_occlusion_color", sRGB(65535, 65535, 65535), morphLinear, paramStandard);
 	par->addParam("SSAO_random_mode", false, morphLinear, paramStandard);
+	par->addParam("SSAO_hierarchical", false, morphLinear, paramStandard);
 	par->addParam("glow_enabled", true, morphLinear, paramStandard);
 	par->addParam("glow_intensity", 0.2, 0.0, 1e15, morphLinear, paramStandard);
 	par->addParam("textured_background", false, morphLinear, paramStandard);
@@ -332,6 +347,10 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("hdr_blur_radius", 10.0, 0.1, 1000.0, morphLinear, paramStandard);
 	par->addParam("hdr_blur_intensity", 0.1, 0.0, 1000.0, morphLinear, paramStandard);
 
+	par->addParam("denoiser_enabled", false, morphNone, paramStandard);
+	par->addParam("denoiser_strength", 1.0, 0.01, 100.0, morphLinear, paramStandard);
+	par->addParam("denoiser_iterations", 4, 1, 8, morphNone, paramStandard);
+
 	par->addParam("fill_light_color", sRGB(0, 0, 0), morphLinear, paramStandard);
 
 	// fog
@@ -358,6 +377,9 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("DOF_MC_CA_camera_dispersion", 1.0, 1e-15, 1000.0, morphLinear, paramStandard);
 	par->addParam("MC_soft_shadows_enable", false, morphLinear, paramStandard);
 	par->addParam("MC_GI_radiance_limit", 10.0, 0.001, 1e10, morphLinear, paramStandard);
+	par->addParam("MC_GI_cache_enabled", false, morphNone, paramStandard);
+	par->addParam("MC_GI_cache_accuracy", 0.3, 0.01, 1.0, morphLinear, paramStandard);
+	par->addParam("MC_GI_cache_samples", 32, 1, 1024, morphNone, paramStandard);
 
 	// aux lights
 
@@ -450,6 +472,7 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("netrender_client_remote_address", QString("localhost"), morphNone, paramApp);
 	par->addParam("netrender_client_remote_port", 5555, morphNone, paramApp);
 	par->addParam("netrender_server_local_port", 5555, morphNone, paramApp);
+	par->addParam("daemon_socket_name", QString("mandelbulber2-daemon"), morphNone, paramApp);
 
 	par->addParam("default_image_path", systemDirectories.GetImagesFolder(), morphNone, paramApp);
 	par->addParam(
@@ -459,6 +482,7 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 
 	par->addParam("show_queue_thumbnails", false, morphNone, paramApp);
 	par->addParam("queue_image_format", 0, morphNone, paramApp, qslImageType);
+	par->addParam("queue_concurrent_items", 1, 1, 256, morphNone, paramApp);
 
 	par->addParam("quit_do_not_ask_again", false, morphNone, paramApp);
 	par->addParam("upgrade_do_not_ask_again", false, morphNone, paramApp);
@@ -503,6 +527,8 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("display_tooltips", true, morphNone, paramApp);
 
 	par->addParam("limit_CPU_cores", get_cpu_count(), 1, get_cpu_count(), morphNone, paramApp);
+	par->addParam(
+		"cpu_precision", 1, morphNone, paramApp, QStringList({"single", "double", "auto"}));
 
 	par->addParam(
 		"randomizer_preview_quality", 1, morphNone, paramApp, QStringList({"low", "medium", "high"}));
@@ -565,12 +591,16 @@ void InitParams(std::shared_ptr<cParameterContainer> par)
 	par->addParam("opencl_device_list", QString(""), morphNone, paramApp);
 	par->addParam(
 		"opencl_mode", 3, morphNone, paramApp, QStringList({"none", "fast", "limited", "full"}));
-	par->addParam("opencl_precision", 0, morphNone, paramApp, QStringList({"single", "double"}));
+	par->addParam(
+		"opencl_precision", 0, morphNone, paramApp, QStringList({"single", "double", "auto"}));
 	par->addParam("opencl_memory_limit", 512, 1, 100000, morphNone, paramApp);
 	par->addParam("opencl_disable_build_cache", false, morphNone, paramApp);
 	par->addParam("opencl_use_fast_relaxed_math", true, morphNone, paramApp);
 	par->addParam("opencl_job_size_multiplier", 2, morphNone, paramApp);
 	par->addParam("opencl_reserved_gpu_time", 0.1, morphNone, paramApp);
+	par->addParam("opencl_cpu_co_rendering", false, morphNone, paramApp);
+	par->addParam("opencl_adaptive_tiles", false, morphNone, paramApp);
+	par->addParam("opencl_tile_target_latency", 50.0, 1.0, 10000.0, morphNone, paramApp);
 	par->addParam("thumbnails_with_opencl", false, morphNone, paramApp);
 	par->addParam("clang_format_path", QString("clang-format"), morphNone, paramApp);
 
@@ -55,10 +55,12 @@
 #include "my_ui_loader.h"
 #include "netrender.hpp"
 #include "nine_fractals.hpp"
+#include "opencl_engine_render_denoiser.h"
 #include "opencl_engine_render_dof.h"
 #include "opencl_engine_render_fractal.h"
 #include "opencl_engine_render_ssao.h"
 #include "opencl_global.h"
+#include "post_effect_denoiser.h"
 #include "post_effect_hdr_blur.h"
 #include "queue.hpp"
 #include "random.hpp"
@@ -999,6 +1001,53 @@ void cInterface::RefreshPostEffects()
 		gPar->Set("image_height", int(mainImage->GetHeight()));
 
 		stopRequest = false;
+		if (gPar->Get<bool>("denoiser_enabled"))
+		{
+			if (gPar->Get<bool>("opencl_enabled")
+					&& cOpenClEngineRenderFractal::enumClRenderEngineMode(gPar->Get<int>("opencl_mode"))
+							 != cOpenClEngineRenderFractal::clRenderEngineTypeNone)
+			{
+#ifdef USE_OPENCL
+				sParamRender params(gPar);
+				// only full engine fills normal vectors and world positions
+				const bool useGeometryGuides = gPar->Get<int>("opencl_mode")
+																			 == cOpenClEngineRenderFractal::clRenderEngineTypeFull;
+				gOpenCl->openClEngineRenderDenoiser->Lock();
+				gOpenCl->openClEngineRenderDenoiser->SetParameters(&params, mainImage, useGeometryGuides);
+				if (gOpenCl->openClEngineRenderDenoiser->LoadSourcesAndCompile(gPar))
+				{
+					gOpenCl->openClEngineRenderDenoiser->CreateKernel4Program(gPar);
+					size_t neededMem = gOpenCl->openClEngineRenderDenoiser->CalcNeededMemory();
+					WriteLogDouble("OpenCl render denoiser - needed mem:", neededMem / 1048576.0, 2);
+					if (neededMem / 1048576 < size_t(gPar->Get<int>("opencl_memory_limit")))
+					{
+						gOpenCl->openClEngineRenderDenoiser->PreAllocateBuffers(gPar);
+						gOpenCl->openClEngineRenderDenoiser->CreateCommandQueue();
+						gOpenCl->openClEngineRenderDenoiser->Render(mainImage, &stopRequest);
+					}
+					else
+					{
+						cErrorMessage::showMessage(
+							QObject::tr("Not enough free memory in OpenCL device to run denoiser!"),
+							cErrorMessage::errorMessage, mainWindow);
+					}
+				}
+				gOpenCl->openClEngineRenderDenoiser->ReleaseMemory();
+				gOpenCl->openClEngineRenderDenoiser->Unlock();
+#endif
+			}
+			else
+			{
+				sParamRender params(gPar);
+				cPostEffectDenoiser denoiser(mainImage);
+				QObject::connect(&denoiser,
+					SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), mainWindow,
+					SLOT(slotUpdateProgressAndStatus(const QString &, const QString &, double)));
+				denoiser.SetParameters(params.denoiserStrength, params.denoiserIterations, true);
+				denoiser.Render(&stopRequest);
+			}
+		}
+
 		if (gPar->Get<bool>("ambient_occlusion_enabled")
 				&& gPar->Get<int>("ambient_occlusion_mode") == params::AOModeScreenSpace)
 		{
@@ -2748,7 +2797,7 @@ void cInterface::ResetFormula(int fractalNumber) const
 	QStringList listToReset = {"formula_iterations", "formula_weight", "formula_start_iteration",
 		"formula_stop_iteration", "julia_mode", "julia_c", "fractal_constant_factor", "initial_waxis",
 		"formula_position", "formula_rotation", "formula_repeat", "formula_scale",
-		"dont_add_c_constant", "check_for_bailout"};
+		"formula_bounding_radius", "dont_add_c_constant", "check_for_bailout"};
 
 	for (int i = 0; i < listToReset.size(); i++)
 	{
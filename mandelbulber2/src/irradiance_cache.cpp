@@ -0,0 +1,193 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cIrradianceCache - world-space cache of Monte Carlo global illumination samples
+ */
+
+#include "irradiance_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "write_log.hpp"
+
+cIrradianceCache::cIrradianceCache(quint64 _maxNumberOfRecords, float _accuracy)
+{
+	maxNumberOfRecords = _maxNumberOfRecords;
+	accuracy = _accuracy;
+	numberOfRecords = 0;
+	usedLevels = 0;
+
+	quint64 numberOfBuckets = 1;
+	while (numberOfBuckets < maxNumberOfRecords)
+		numberOfBuckets <<= 1;
+	bucketMask = numberOfBuckets - 1;
+
+	records.reset(new sRecord[maxNumberOfRecords]);
+	buckets.reset(new std::atomic<qint32>[numberOfBuckets]);
+	for (quint64 i = 0; i < numberOfBuckets; i++)
+		buckets[i].store(-1, std::memory_order_relaxed);
+}
+
+cIrradianceCache::~cIrradianceCache()
+{
+	// nothing to delete
+}
+
+int cIrradianceCache::LevelForDistance(double distance)
+{
+	// cell of the level has to be at least as big as influence distance of the record
+	int level = int(std::ceil(std::log2(distance)));
+	if (level < minLevel) return minLevel;
+	if (level > maxLevel) return maxLevel;
+	return level;
+}
+
+quint64 cIrradianceCache::Hash(int level, qint64 x, qint64 y, qint64 z) const
+{
+	quint64 hash = quint64(x) * 73856093ULL;
+	hash ^= quint64(y) * 19349663ULL;
+	hash ^= quint64(z) * 83492791ULL;
+	hash ^= quint64(level - minLevel) * 2654435761ULL;
+	return hash & bucketMask;
+}
+
+bool cIrradianceCache::Insert(const CVector3 &point, const CVector3 &normal,
+	const sRGBFloat &irradiance, const CVector3 gradient[3], double radius)
+{
+	quint64 index = numberOfRecords.fetch_add(1, std::memory_order_relaxed);
+	if (index >= maxNumberOfRecords)
+	{
+		if (index == maxNumberOfRecords)
+		{
+			// logged only by the thread which hits the limit first
+			WriteLogInt("cIrradianceCache: cache is full, uncached paths will be used. Records",
+				int(maxNumberOfRecords), 1);
+		}
+		return false;
+	}
+
+	sRecord &record = records[index];
+	record.point = point;
+	record.normal = normal;
+	for (int i = 0; i < 3; i++)
+		record.gradient[i] = gradient[i];
+	record.irradiance = irradiance;
+	record.radius = float(radius);
+
+	int level = LevelForDistance(radius * accuracy);
+	double cellSize = std::ldexp(1.0, level);
+	std::atomic<qint32> &bucket = buckets[Hash(level, qint64(std::floor(point.x / cellSize)),
+		qint64(std::floor(point.y / cellSize)), qint64(std::floor(point.z / cellSize)))];
+
+	// record is complete before it becomes visible for other threads
+	qint32 head = bucket.load(std::memory_order_relaxed);
+	do
+	{
+		record.next = head;
+	} while (!bucket.compare_exchange_weak(
+		head, qint32(index), std::memory_order_release, std::memory_order_relaxed));
+
+	usedLevels.fetch_or(1ULL << (level - minLevel), std::memory_order_relaxed);
+	return true;
+}
+
+bool cIrradianceCache::Lookup(
+	const CVector3 &point, const CVector3 &normal, sRGBFloat *irradiance) const
+{
+	double totalWeight = 0.0;
+	double sumR = 0.0, sumG = 0.0, sumB = 0.0;
+	const double maxWeight = 1e6;
+
+	quint64 levels = usedLevels.load(std::memory_order_relaxed);
+	for (int level = minLevel; level <= maxLevel; level++)
+	{
+		if (!(levels & (1ULL << (level - minLevel)))) continue;
+
+		double cellSize = std::ldexp(1.0, level);
+		qint64 cx = qint64(std::floor(point.x / cellSize));
+		qint64 cy = qint64(std::floor(point.y / cellSize));
+		qint64 cz = qint64(std::floor(point.z / cellSize));
+
+		// influence of records is not bigger than the cell, so only neighbours have to be checked
+		for (qint64 z = cz - 1; z <= cz + 1; z++)
+		{
+			for (qint64 y = cy - 1; y <= cy + 1; y++)
+			{
+				for (qint64 x = cx - 1; x <= cx + 1; x++)
+				{
+					qint32 index = buckets[Hash(level, x, y, z)].load(std::memory_order_acquire);
+					while (index >= 0)
+					{
+						const sRecord &record = records[index];
+						index = record.next;
+
+						double normalDot = normal.Dot(record.normal);
+						if (normalDot <= 0.0) continue;
+
+						CVector3 delta = point - record.point;
+						double error =
+							delta.Length() / record.radius + std::sqrt(std::max(0.0, 1.0 - normalDot));
+						if (error >= accuracy) continue;
+
+						// record lying in front of the point can't see the same environment
+						if (delta.Dot(normal + record.normal) < -0.1 * record.radius) continue;
+
+						// weight falls to zero at the border of validity area
+						double weight = std::min(1.0 / std::max(error, 1e-9) - 1.0 / accuracy, maxWeight);
+
+						sumR += weight * std::max(0.0, record.irradiance.R + delta.Dot(record.gradient[0]));
+						sumG += weight * std::max(0.0, record.irradiance.G + delta.Dot(record.gradient[1]));
+						sumB += weight * std::max(0.0, record.irradiance.B + delta.Dot(record.gradient[2]));
+						totalWeight += weight;
+					}
+				}
+			}
+		}
+	}
+
+	if (totalWeight <= 0.0) return false;
+
+	irradiance->R = float(sumR / totalWeight);
+	irradiance->G = float(sumG / totalWeight);
+	irradiance->B = float(sumB / totalWeight);
+	return true;
+}
+
+bool cIrradianceCache::IsFull() const
+{
+	return numberOfRecords.load(std::memory_order_relaxed) >= maxNumberOfRecords;
+}
+
+quint64 cIrradianceCache::GetNumberOfRecords() const
+{
+	return std::min(numberOfRecords.load(std::memory_order_relaxed), maxNumberOfRecords);
+}
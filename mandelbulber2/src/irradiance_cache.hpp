@@ -0,0 +1,97 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cIrradianceCache - world-space cache of Monte Carlo global illumination samples
+ *
+ * Indirect diffuse light changes slowly across surfaces, so it is calculated only at sparse
+ * points and interpolated for the remaining shading points (Ward's irradiance caching). Records
+ * are kept in a hashed multi-level grid: level of a record is chosen from its validity radius, so
+ * only neighbouring cells of each used level have to be checked. Records are never removed or
+ * modified after insertion, so all render threads can share the cache without locking.
+ */
+
+#ifndef MANDELBULBER2_SRC_IRRADIANCE_CACHE_HPP_
+#define MANDELBULBER2_SRC_IRRADIANCE_CACHE_HPP_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QtGlobal>
+
+#include "algebra.hpp"
+#include "color_structures.hpp"
+
+class cIrradianceCache
+{
+public:
+	// accuracy is the maximum allowed interpolation error (parameter 'a' in Ward's paper)
+	cIrradianceCache(quint64 maxNumberOfRecords, float accuracy);
+	~cIrradianceCache();
+
+	// interpolates irradiance from records around the point. Returns false when there are no
+	// records which are valid for this point
+	bool Lookup(const CVector3 &point, const CVector3 &normal, sRGBFloat *irradiance) const;
+
+	// adds new record. Returns false when the cache is already full
+	bool Insert(const CVector3 &point, const CVector3 &normal, const sRGBFloat &irradiance,
+		const CVector3 gradient[3], double radius);
+
+	bool IsFull() const;
+	quint64 GetNumberOfRecords() const;
+
+private:
+	struct sRecord
+	{
+		CVector3 point;
+		CVector3 normal;
+		CVector3 gradient[3]; // translational gradient of R, G and B
+		sRGBFloat irradiance;
+		float radius;
+		qint32 next; // next record in the same hash bucket
+	};
+
+	static const int minLevel = -48;
+	static const int maxLevel = 15;
+
+	static int LevelForDistance(double distance);
+	quint64 Hash(int level, qint64 x, qint64 y, qint64 z) const;
+
+	std::unique_ptr<sRecord[]> records;
+	std::unique_ptr<std::atomic<qint32>[]> buckets;
+	quint64 maxNumberOfRecords;
+	quint64 bucketMask;
+	std::atomic<quint64> numberOfRecords;
+	std::atomic<quint64> usedLevels; // bit mask of levels which contain any record
+	float accuracy;
+};
+
+#endif /* MANDELBULBER2_SRC_IRRADIANCE_CACHE_HPP_ */
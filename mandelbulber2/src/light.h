@@ -39,6 +39,11 @@ public:
 	}
 
 	inline float Decay(float distance) const { return pow(distance, float(decayFunction + 1)); }
+	// halo of the light is integrated along every ray by VolumetricShader()
+	bool IsVisibleAlongRays() const
+	{
+		return enabled && intensity > 0.0f && visibility > 0.0f && type != lightDirectional;
+	}
 	float CalculateCone(const CVector3 &lightVector, sRGBFloat &outColor) const;
 	CVector3 CalculateLightVector(const CVector3 &point, double delta, double resolution,
 		double viewDistanceMax, double &outDistance) const;
@@ -56,6 +56,7 @@
 #include "system.hpp"
 #include "system_data.hpp"
 #include "system_directories.hpp"
+#include "thumbnail_render_service.hpp"
 #include "undo.h"
 #include "write_log.hpp"
 
@@ -185,6 +186,7 @@ int main(int argc, char *argv[])
 
 	if (!commandLineInterface.isNoGUI())
 	{
+		gThumbnailRenderService = new cThumbnailRenderService(gApplication);
 		gMainInterface->ShowUi();
 		gFlightAnimation = new cFlightAnimation(gMainInterface, gAnimFrames, gMainInterface->mainImage,
 			gMainInterface->renderedImage, gPar, gParFractal, gMainInterface->mainWindow);
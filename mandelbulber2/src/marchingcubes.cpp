@@ -42,6 +42,7 @@
 #include "common_math.h"
 #include "compute_fractal.hpp"
 #include "fractal_container.hpp"
+#include "file_mesh.hpp"
 #include "fractparams.hpp"
 #include "initparameters.hpp"
 #include "nine_fractals.hpp"
@@ -62,8 +63,8 @@ MarchingCubes::MarchingCubes(std::shared_ptr<const cParameterContainer> paramsCo
 	std::shared_ptr<cNineFractals> fractals, std::shared_ptr<sRenderData> renderData, int numx,
 	int numy, int numz, const CVector3 &lower, const CVector3 &upper, double dist_thresh, bool *stop,
 	std::vector<double> &vertices, std::vector<long long> &polygons,
-	std::vector<double> &colorIndices)
-		: vertices{vertices}, polygons{polygons}, colorIndices{colorIndices}
+	std::vector<double> &colorIndices, MeshFileSavePLYStream *meshStream)
+		: vertices{vertices}, polygons{polygons}, colorIndices{colorIndices}, meshStream{meshStream}
 {
 	this->numx = numx;
 	this->numy = numy;
@@ -92,6 +93,9 @@ MarchingCubes::MarchingCubes(std::shared_ptr<const cParameterContainer> paramsCo
 
 	this->stop = stop;
 
+	vertexIndexOffset = 0;
+	polygonsCount = 0;
+
 	coloredMesh = paramsContainer->Get<bool>("mesh_color");
 
 	try
@@ -162,7 +166,7 @@ void MarchingCubes::RunMarchingCube()
 	// numx, numy and numz are the numbers of evaluations in each direction
 	for (long long i = 0; i < numx; ++i)
 	{
-		emit signalUpdateProgressAndStatus(i, polygons.size());
+		emit signalUpdateProgressAndStatus(i, polygonsCount + polygons.size() / 3);
 
 		// shift voxel planes
 		if (i > 0)
@@ -199,6 +203,7 @@ void MarchingCubes::RunMarchingCube()
 		if (i > 0)
 		{
 			calculateEdges(i);
+			flushSlab();
 		}
 		if (*stop || systemData.globalStopRequest) break;
 	}
@@ -214,6 +219,20 @@ void MarchingCubes::RunMarchingCube()
 	emit finished();
 }
 
+void MarchingCubes::flushSlab()
+{
+	if (!meshStream) return;
+
+	// vertices of previous layers are referenced only by index (shared_indices),
+	// so they can be written out and released
+	meshStream->AppendSlab(vertices, polygons, colorIndices);
+	vertexIndexOffset += vertices.size() / 3;
+	polygonsCount += polygons.size() / 3;
+	vertices.clear();
+	polygons.clear();
+	colorIndices.clear();
+}
+
 void MarchingCubes::calculateVoxelPlane(int i)
 {
 	// calculate voxel plane
@@ -301,21 +320,21 @@ void MarchingCubes::calculateEdges(int i)
 			std::vector<long long> indices(12, -1);
 			if (edges & 0x040)
 			{
-				indices[6] = vertices.size() / 3;
+				indices[6] = vertexIndexOffset + vertices.size() / 3;
 				shared_indices[i_mod_2 * yz3 + j * z3 + k * 3 + 0] = indices[6];
 				mc_add_vertex(x_dx, y_dy, z_dz, x, 0, v[6], v[7], dist_thresh, &vertices, colorIndex[6],
 					colorIndex[7], &colorIndices);
 			}
 			if (edges & 0x020)
 			{
-				indices[5] = vertices.size() / 3;
+				indices[5] = vertexIndexOffset + vertices.size() / 3;
 				shared_indices[i_mod_2 * yz3 + j * z3 + k * 3 + 1] = indices[5];
 				mc_add_vertex(x_dx, y, z_dz, y_dy, 1, v[5], v[6], dist_thresh, &vertices, colorIndex[5],
 					colorIndex[6], &colorIndices);
 			}
 			if (edges & 0x400)
 			{
-				indices[10] = vertices.size() / 3;
+				indices[10] = vertexIndexOffset + vertices.size() / 3;
 				shared_indices[i_mod_2 * yz3 + j * z3 + k * 3 + 2] = indices[10];
 				mc_add_vertex(x_dx, y + dx, z, z_dz, 2, v[2], v[6], dist_thresh, &vertices, colorIndex[2],
 					colorIndex[6], &colorIndices);
@@ -325,7 +344,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (j == 0 || k == 0)
 				{
-					indices[0] = vertices.size() / 3;
+					indices[0] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x, y, z, x_dx, 0, v[0], v[1], dist_thresh, &vertices, colorIndex[0],
 						colorIndex[1], &colorIndices);
 				}
@@ -336,7 +355,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (k == 0)
 				{
-					indices[1] = vertices.size() / 3;
+					indices[1] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x_dx, y, z, y_dy, 1, v[1], v[2], dist_thresh, &vertices, colorIndex[1],
 						colorIndex[2], &colorIndices);
 				}
@@ -347,7 +366,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (k == 0)
 				{
-					indices[2] = vertices.size() / 3;
+					indices[2] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x_dx, y_dy, z, x, 0, v[2], v[3], dist_thresh, &vertices, colorIndex[2],
 						colorIndex[3], &colorIndices);
 				}
@@ -358,7 +377,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (i == 0 || k == 0)
 				{
-					indices[3] = vertices.size() / 3;
+					indices[3] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x, y_dy, z, y, 1, v[3], v[0], dist_thresh, &vertices, colorIndex[3],
 						colorIndex[0], &colorIndices);
 				}
@@ -369,7 +388,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (j == 0)
 				{
-					indices[4] = vertices.size() / 3;
+					indices[4] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x, y, z_dz, x_dx, 0, v[4], v[5], dist_thresh, &vertices, colorIndex[4],
 						colorIndex[5], &colorIndices);
 				}
@@ -380,7 +399,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (i == 0)
 				{
-					indices[7] = vertices.size() / 3;
+					indices[7] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x, y_dy, z_dz, y, 1, v[7], v[4], dist_thresh, &vertices, colorIndex[7],
 						colorIndex[4], &colorIndices);
 				}
@@ -391,7 +410,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (i == 0 || j == 0)
 				{
-					indices[8] = vertices.size() / 3;
+					indices[8] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x, y, z, z_dz, 2, v[0], v[4], dist_thresh, &vertices, colorIndex[0],
 						colorIndex[4], &colorIndices);
 				}
@@ -402,7 +421,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (j == 0)
 				{
-					indices[9] = vertices.size() / 3;
+					indices[9] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x_dx, y, z, z_dz, 2, v[1], v[5], dist_thresh, &vertices, colorIndex[1],
 						colorIndex[3], &colorIndices);
 				}
@@ -413,7 +432,7 @@ void MarchingCubes::calculateEdges(int i)
 			{
 				if (i == 0)
 				{
-					indices[11] = vertices.size() / 3;
+					indices[11] = vertexIndexOffset + vertices.size() / 3;
 					mc_add_vertex(x, y_dy, z, z_dz, 2, v[3], v[7], dist_thresh, &vertices, colorIndex[3],
 						colorIndex[7], &colorIndices);
 				}
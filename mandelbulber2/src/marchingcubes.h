@@ -50,6 +50,7 @@ class cNineFractals;
 struct sRenderData;
 class cParameterContainer;
 class cFractalContainer;
+class MeshFileSavePLYStream;
 
 class MarchingCubes : public QObject
 {
@@ -61,7 +62,7 @@ public:
 		std::shared_ptr<cNineFractals> fractals, std::shared_ptr<sRenderData> renderData, int numx,
 		int numy, int numz, const CVector3 &lower, const CVector3 &upper, double dist_thresh,
 		bool *stop, std::vector<double> &vertices, std::vector<long long> &polygons,
-		std::vector<double> &colorIndices);
+		std::vector<double> &colorIndices, MeshFileSavePLYStream *meshStream = nullptr);
 
 	~MarchingCubes() override { FreeBuffers(); }
 
@@ -114,6 +115,13 @@ private:
 	std::vector<long long> &polygons;
 	std::vector<double> &colorIndices;
 
+	// when set, each finished layer is flushed to the stream and the buffers are cleared
+	MeshFileSavePLYStream *meshStream;
+	long long vertexIndexOffset;
+	quint64 polygonsCount;
+
+	void flushSlab();
+
 	void calculateVoxelPlane(int i);
 
 	void calculateEdges(int i);
@@ -0,0 +1,159 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cMaterialTable - materials of all objects compiled for fast access by shaders
+ */
+
+#include "material_table.hpp"
+
+#include "color_gradient.h"
+#include "material.h"
+#include "object_data.hpp"
+
+sRGBFloat sCompiledMaterial::GradientColor(enumGradient index, float position) const
+{
+	// values out of range are extrapolated by original gradient
+	if (position < 0.0f || position >= 1.0f || !gradientLut[index])
+		return gradient[index]->GetColorFloat(position, false);
+
+	const float lutPosition = position * lutSize;
+	const int lutIndex = int(lutPosition);
+	const float delta = lutPosition - lutIndex;
+	const float nDelta = 1.0f - delta;
+	const sRGBFloat &color1 = gradientLut[index][lutIndex];
+	const sRGBFloat &color2 = gradientLut[index][lutIndex + 1];
+	return sRGBFloat(color1.R * nDelta + color2.R * delta, color1.G * nDelta + color2.G * delta,
+		color1.B * nDelta + color2.B * delta);
+}
+
+cMaterialTable::cMaterialTable()
+{
+	// nothing to initialize
+}
+
+cMaterialTable::~cMaterialTable()
+{
+	// nothing to delete
+}
+
+quint32 cMaterialTable::MaterialFlags(const cMaterial &material)
+{
+	quint32 flags = 0;
+
+	if (material.useColorsFromPalette)
+	{
+		flags |= sCompiledMaterial::flagColorsFromPalette;
+		if (material.surfaceGradientEnable) flags |= sCompiledMaterial::flagSurfaceGradient;
+		if (material.specularGradientEnable) flags |= sCompiledMaterial::flagSpecularGradient;
+		if (material.diffuseGradientEnable) flags |= sCompiledMaterial::flagDiffuseGradient;
+		if (material.luminosityGradientEnable) flags |= sCompiledMaterial::flagLuminosityGradient;
+		if (material.roughnessGradientEnable) flags |= sCompiledMaterial::flagRoughnessGradient;
+		if (material.reflectanceGradientEnable) flags |= sCompiledMaterial::flagReflectanceGradient;
+		if (material.transparencyGradientEnable)
+			flags |= sCompiledMaterial::flagTransparencyGradient;
+	}
+
+	if (material.colorTexture.IsLoaded()) flags |= sCompiledMaterial::flagColorTexture;
+	if (material.diffusionTexture.IsLoaded()) flags |= sCompiledMaterial::flagDiffusionTexture;
+	if (material.luminosityTexture.IsLoaded()) flags |= sCompiledMaterial::flagLuminosityTexture;
+	if (material.reflectanceTexture.IsLoaded()) flags |= sCompiledMaterial::flagReflectanceTexture;
+	if (material.transparencyTexture.IsLoaded())
+		flags |= sCompiledMaterial::flagTransparencyTexture;
+	if (material.roughnessTexture.IsLoaded()) flags |= sCompiledMaterial::flagRoughnessTexture;
+	if (material.normalMapTexture.IsLoaded()) flags |= sCompiledMaterial::flagNormalMapTexture;
+	if (material.displacementTexture.IsLoaded())
+		flags |= sCompiledMaterial::flagDisplacementTexture;
+
+	return flags;
+}
+
+void cMaterialTable::Compile(
+	std::map<int, cMaterial> &materials, const QVector<cObjectData> &objectData)
+{
+	// one more entry for interpolation of the last position
+	const int lutLength = sCompiledMaterial::lutSize + 1;
+	const size_t noLut = size_t(-1);
+
+	// first all lookup tables are calculated, because pointers to them can be taken only when
+	// the storage will not be reallocated any more
+	std::map<int, sCompiledMaterial> compiledMaterials;
+	std::map<int, std::vector<size_t>> lutOffsets;
+	lutStorage.clear();
+
+	for (auto &element : materials)
+	{
+		cMaterial &material = element.second;
+
+		sCompiledMaterial compiled;
+		compiled.material = &material;
+		compiled.flags = MaterialFlags(material);
+		compiled.gradient[sCompiledMaterial::gradientSurface] = &material.gradientSurface;
+		compiled.gradient[sCompiledMaterial::gradientSpecular] = &material.gradientSpecular;
+		compiled.gradient[sCompiledMaterial::gradientDiffuse] = &material.gradientDiffuse;
+		compiled.gradient[sCompiledMaterial::gradientLuminosity] = &material.gradientLuminosity;
+		compiled.gradient[sCompiledMaterial::gradientRoughness] = &material.gradientRoughness;
+		compiled.gradient[sCompiledMaterial::gradientReflectance] = &material.gradientReflectance;
+		compiled.gradient[sCompiledMaterial::gradientTransparency] = &material.gradientTransparency;
+
+		std::vector<size_t> &offsets = lutOffsets[element.first];
+		offsets.assign(sCompiledMaterial::numberOfGradients, noLut);
+		for (int g = 0; g < sCompiledMaterial::numberOfGradients; g++)
+		{
+			if (!(compiled.flags & (1 << g))) continue;
+
+			offsets[g] = lutStorage.size();
+			for (int i = 0; i < lutLength; i++)
+			{
+				float position = float(i) / sCompiledMaterial::lutSize;
+				lutStorage.push_back(compiled.gradient[g]->GetColorFloat(position, false));
+			}
+		}
+
+		compiledMaterials.emplace(element.first, compiled);
+	}
+
+	for (auto &element : compiledMaterials)
+	{
+		const std::vector<size_t> &offsets = lutOffsets[element.first];
+		for (int g = 0; g < sCompiledMaterial::numberOfGradients; g++)
+		{
+			if (offsets[g] != noLut) element.second.gradientLut[g] = &lutStorage[offsets[g]];
+		}
+	}
+
+	objects.assign(size_t(objectData.size()), sCompiledMaterial());
+	for (int i = 0; i < objectData.size(); i++)
+	{
+		auto compiled = compiledMaterials.find(objectData[i].materialId);
+		if (compiled != compiledMaterials.end()) objects[size_t(i)] = compiled->second;
+		objects[size_t(i)].objectType = objectData[i].objectType;
+	}
+}
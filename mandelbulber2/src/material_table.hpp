@@ -0,0 +1,123 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cMaterialTable - materials of all objects compiled for fast access by shaders
+ *
+ * Table is a dense array indexed by object id, so shaders don't need to search materials map.
+ * Enabled gradients are baked into lookup tables with fixed number of entries and all texture
+ * and gradient switches are reduced to one bit mask.
+ */
+
+#ifndef MANDELBULBER2_SRC_MATERIAL_TABLE_HPP_
+#define MANDELBULBER2_SRC_MATERIAL_TABLE_HPP_
+
+#include <map>
+#include <vector>
+
+#include <QVector>
+
+#include "color_structures.hpp"
+#include "object_types.hpp"
+
+// forward declarations
+class cColorGradient;
+class cMaterial;
+class cObjectData;
+
+struct sCompiledMaterial
+{
+	enum enumGradient
+	{
+		gradientSurface = 0,
+		gradientSpecular = 1,
+		gradientDiffuse = 2,
+		gradientLuminosity = 3,
+		gradientRoughness = 4,
+		gradientReflectance = 5,
+		gradientTransparency = 6,
+		numberOfGradients = 7
+	};
+
+	// gradient flags are set only when material uses colors from palette
+	enum enumFlags
+	{
+		flagSurfaceGradient = 1 << gradientSurface,
+		flagSpecularGradient = 1 << gradientSpecular,
+		flagDiffuseGradient = 1 << gradientDiffuse,
+		flagLuminosityGradient = 1 << gradientLuminosity,
+		flagRoughnessGradient = 1 << gradientRoughness,
+		flagReflectanceGradient = 1 << gradientReflectance,
+		flagTransparencyGradient = 1 << gradientTransparency,
+		flagColorsFromPalette = 1 << 8,
+		flagColorTexture = 1 << 9,
+		flagDiffusionTexture = 1 << 10,
+		flagLuminosityTexture = 1 << 11,
+		flagReflectanceTexture = 1 << 12,
+		flagTransparencyTexture = 1 << 13,
+		flagRoughnessTexture = 1 << 14,
+		flagNormalMapTexture = 1 << 15,
+		flagDisplacementTexture = 1 << 16
+	};
+
+	static const int lutSize = 256;
+
+	cMaterial *material{nullptr};
+	quint32 flags{0};
+	fractal::enumObjectType objectType{fractal::objNone};
+	const sRGBFloat *gradientLut[numberOfGradients]{};
+	const cColorGradient *gradient[numberOfGradients]{};
+
+	bool Has(enumFlags flag) const { return flags & flag; }
+
+	// the same as cColorGradient::GetColorFloat(position, false) for baked gradients
+	sRGBFloat GradientColor(enumGradient index, float position) const;
+};
+
+class cMaterialTable
+{
+public:
+	cMaterialTable();
+	~cMaterialTable();
+
+	// has to be called again when materials, textures or objects were changed
+	void Compile(std::map<int, cMaterial> &materials, const QVector<cObjectData> &objectData);
+
+	const sCompiledMaterial &GetMaterial(int objectId) const { return objects[objectId]; }
+	bool IsCompiled() const { return !objects.empty(); }
+
+private:
+	static quint32 MaterialFlags(const cMaterial &material);
+
+	std::vector<sCompiledMaterial> objects;
+	std::vector<sRGBFloat> lutStorage;
+};
+
+#endif /* MANDELBULBER2_SRC_MATERIAL_TABLE_HPP_ */
@@ -131,12 +131,29 @@ void cMeshExport::ProcessVolume()
 	std::vector<long long> polygons;
 	std::vector<double> colorIndices;
 
+	// mesh is streamed to the file layer by layer, so only one slab is kept in memory
+	std::unique_ptr<MeshFileSavePLYStream> meshStream(new MeshFileSavePLYStream(
+		outputFileName, meshConfig, gPar->Get<bool>("mesh_optimize_vertex_cache")));
+	QObject::connect(meshStream.get(), &MeshFileSavePLYStream::updateProgressAndStatus, this,
+		&cMeshExport::signalUpdateProgressAndStatus);
+
+	cColorGradient gradient;
+	gradient.SetColorsFromString(gPar->Get<QString>("mat1_surface_color_gradient"));
+	meshStream->SetColorMapping(gradient, gPar->Get<double>("mat1_coloring_speed"),
+		gPar->Get<double>("mat1_coloring_palette_offset"));
+
+	if (!meshStream->Open())
+	{
+		emit finished();
+		return;
+	}
+
 	WriteLog("Starting marching cubes...", 2);
 	MarchingCubes *marchingCube;
 	try
 	{
 		marchingCube = new MarchingCubes(gPar, gParFractal, params, fractals, renderData, w, h, l,
-			limitMin, limitMax, dist_thresh, &stop, vertices, polygons, colorIndices);
+			limitMin, limitMax, dist_thresh, &stop, vertices, polygons, colorIndices, meshStream.get());
 	}
 	catch (std::bad_alloc &ba)
 	{
@@ -165,35 +182,22 @@ void cMeshExport::ProcessVolume()
 
 	WriteLog("Marching cubes done.", 2);
 
-	std::vector<sRGB8> colorsRGB;
-	cColorGradient gradient;
-	gradient.SetColorsFromString(gPar->Get<QString>("mat1_surface_color_gradient"));
-	double colorSpeed = gPar->Get<double>("mat1_coloring_speed");
-	double colorOffset = gPar->Get<double>("mat1_coloring_palette_offset");
-
-	for (double colorIndice : colorIndices)
-	{
-		double nrCol = fmod(fabs(colorIndice), 248.0 * 256.0); // kept for compatibility
-		double colorPosition = fmod(nrCol / 256.0 / 10.0 * colorSpeed + colorOffset, 1.0);
-		sRGB color = gradient.GetColor(colorPosition, false);
-		sRGB8 color8(uchar(color.R), uchar(color.G), uchar(color.B));
-		colorsRGB.push_back(color8);
-	}
-
-	// Save to file
-	MeshFileSave::structSaveMeshData meshData(&vertices, &polygons, &colorsRGB);
-	MeshFileSave *meshFileSave = MeshFileSave::create(outputFileName, meshConfig, meshData);
-	QObject::connect(meshFileSave, &MeshFileSave::updateProgressAndStatus, this,
-		&cMeshExport::signalUpdateProgressAndStatus);
-	meshFileSave->SaveMesh();
+	// incomplete mesh is not saved under the final file name
+	bool saved = false;
+	if (stop)
+		meshStream->Abort();
+	else
+		saved = meshStream->Finish();
 
 	QString statusText;
 	if (stop)
 		statusText = tr("Mesh Export finished - Cancelled export");
+	else if (!saved)
+		statusText = tr("Mesh Export finished - Failed to write output file");
 	else
 		statusText = tr("Mesh Export finished - Processed %1 layers and got %2 polygons")
 									 .arg(w)
-									 .arg(polygons.size());
+									 .arg(meshStream->GetPolygonCount());
 	emit signalUpdateProgressAndStatus(statusText, progressText.getText(1.0), 1.0);
 	emit finished();
 }
@@ -47,6 +47,7 @@
 #include "initparameters.hpp"
 #include "interface.hpp"
 #include "netrender_file_sender.hpp"
+#include "render_trace.hpp"
 #include "render_window.hpp"
 #include "settings.hpp"
 #include "system_data.hpp"
@@ -215,6 +216,7 @@ void CNetRenderClient::SendRenderedLines(
 
 void CNetRenderClient::ProcessData()
 {
+	cTraceSpan traceSpan("NetRender client message", "netrender", msgFromServer.command);
 	sMessage *inMsg = &msgFromServer;
 	switch (netCommandServer(inMsg->command))
 	{
@@ -45,6 +45,7 @@
 #include "interface.hpp"
 #include "keyframes.hpp"
 #include "netrender_file_receiver.hpp"
+#include "render_trace.hpp"
 #include "render_window.hpp"
 #include "settings.hpp"
 #include "system_data.hpp"
@@ -213,6 +214,7 @@ void cNetRenderServer::ClientReceive(int index)
 
 void cNetRenderServer::ProcessData(QTcpSocket *socket, sMessage *inMsg)
 {
+	cTraceSpan traceSpan("NetRender server message", "netrender", inMsg->command);
 	int index = GetClientIndexFromSocket(socket);
 	if (index > -1)
 	{
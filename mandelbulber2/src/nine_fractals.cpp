@@ -36,10 +36,13 @@
 #include "nine_fractals.hpp"
 
 #include <algorithm>
+#include <limits>
 
+#include "compute_fractal_scalar.hpp"
 #include "fractal.h"
 #include "fractal_container.hpp"
 #include "parameters.hpp"
+#include "projection_3d.hpp"
 
 // custom includes
 #ifdef USE_OPENCL
@@ -47,7 +50,7 @@
 #endif
 
 cNineFractals::cNineFractals(std::shared_ptr<const cFractalContainer> par,
-	std::shared_ptr<const cParameterContainer> generalPar)
+	std::shared_ptr<const cParameterContainer> generalPar, bool allowSinglePrecision)
 {
 	fractals.resize(NUMBER_OF_FRACTALS);
 	bool useDefaultBailout = generalPar->Get<bool>("use_default_bailout");
@@ -319,6 +322,50 @@ cNineFractals::cNineFractals(std::shared_ptr<const cFractalContainer> par,
 			useAdditionalBailoutCond[0] = true;
 		}
 	}
+
+	// single precision calculation of distance estimation for simple scenes
+	useSinglePrecision = false;
+	if (allowSinglePrecision)
+	{
+		switch (enumCpuPrecision(generalPar->Get<int>("cpu_precision")))
+		{
+			case cpuPrecisionSingle:
+				useSinglePrecision = IsComputeScalarSupported(*this, generalPar);
+				break;
+			case cpuPrecisionDouble: useSinglePrecision = false; break;
+			case cpuPrecisionAuto:
+				useSinglePrecision =
+					IsComputeScalarSupported(*this, generalPar) && IsSinglePrecisionSufficient(generalPar);
+				break;
+		}
+	}
+}
+
+bool cNineFractals::IsSinglePrecisionSufficient(std::shared_ptr<const cParameterContainer> params)
+{
+	const CVector3 camera = params->Get<CVector3>("camera");
+	const CVector3 target = params->Get<CVector3>("target");
+	const params::enumPerspectiveType perspectiveType =
+		params::enumPerspectiveType(params->Get<int>("perspective_type"));
+	const double fov = CalcFOV(params->Get<double>("fov"), perspectiveType);
+	const double resolution = 1.0 / params->Get<int>("image_height");
+
+	// size of the smallest detail at the target point, the same as in CalcDistThresh()
+	double distThresh;
+	if (params->Get<bool>("constant_DE_threshold"))
+		distThresh = params->Get<double>("DE_thresh");
+	else
+		distThresh =
+			(target - camera).Length() * resolution * fov / params->Get<double>("detail_level");
+
+	// distance between neighbouring float numbers around the camera. Fractal formulas work on
+	// values of order of 1 even for coordinates close to zero
+	const double magnitude = std::max(std::max(camera.Length(), target.Length()), 1.0);
+	const double floatStep = magnitude * double(std::numeric_limits<float>::epsilon());
+
+	// distance estimation and normal vectors need a few more bits below the detail size
+	const double margin = 256.0;
+	return distThresh > floatStep * margin;
 }
 
 void cNineFractals::CreateSequence(std::shared_ptr<const cParameterContainer> generalPar)
@@ -58,8 +58,17 @@ class cAbstractFractal;
 class cNineFractals
 {
 public:
+	enum enumCpuPrecision
+	{
+		cpuPrecisionSingle = 0,
+		cpuPrecisionDouble = 1,
+		cpuPrecisionAuto = 2
+	};
+
+	// allowSinglePrecision has to be set only for rendering of images seen from the camera.
+	// Single precision is selected according to camera and not suitable e.g. for export of meshes
 	cNineFractals(std::shared_ptr<const cFractalContainer> fractalPar,
-		std::shared_ptr<const cParameterContainer> generalPar);
+		std::shared_ptr<const cParameterContainer> generalPar, bool allowSinglePrecision = false);
 	sFractal *GetFractal(int index) const { return fractals[index].get(); }
 	int GetSequence(const int i) const;
 	bool IsHybrid() const { return isHybrid; }
@@ -70,6 +79,7 @@ public:
 	inline bool IsAddCConstant(int formulaIndex) const { return addCConstant[formulaIndex]; }
 	inline bool IsCheckForBailout(int formulaIndex) const { return checkForBailout[formulaIndex]; }
 	inline bool UseOptimizedDE() const { return useOptimizedDE; }
+	inline bool UseSinglePrecision() const { return useSinglePrecision; }
 	QString GetDETypeString() const;
 	inline double GetBailout(int formulaIndex) const { return bailout[formulaIndex]; }
 	inline bool IsJuliaEnabled(int formulaIndex) const { return juliaEnabled[formulaIndex]; }
@@ -97,6 +107,8 @@ public:
 	}
 
 	static int GetIndexOnFractalList(fractal::enumFractalFormula formula);
+	// checks if single precision numbers can resolve the smallest details seen from the camera
+	static bool IsSinglePrecisionSufficient(std::shared_ptr<const cParameterContainer> params);
 
 #ifdef USE_OPENCL
 	void CopyToOpenclData(sClFractalSequence *sequence) const;
@@ -110,6 +122,7 @@ private:
 	bool isBoolean;
 	fractal::enumDEFunctionType optimizedDEType;
 	bool useOptimizedDE;
+	bool useSinglePrecision;
 	int maxFractalIndex;
 	int maxN;
 	std::vector<int> hybridSequence;
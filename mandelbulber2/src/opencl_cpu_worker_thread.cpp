@@ -0,0 +1,185 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * CPU thread which renders tiles together with OpenCL devices
+ */
+
+#ifdef USE_OPENCL
+
+#include "opencl_cpu_worker_thread.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+
+#include "cimage.hpp"
+#include "opencl_scheduler.h"
+#include "opencl_worker_output_queue.h"
+#include "region.hpp"
+#include "render_data.hpp"
+#include "render_worker.hpp"
+#include "scheduler.hpp"
+#include "system_data.hpp"
+
+cOpenClCpuWorkerThread::cOpenClCpuWorkerThread(std::shared_ptr<cOpenClScheduler> scheduler,
+	std::shared_ptr<const sParamRender> params, std::shared_ptr<const cNineFractals> fractals,
+	std::shared_ptr<sRenderData> renderData, std::shared_ptr<cImage> image, int _workerIndex)
+		: QObject(), workerIndex(_workerIndex)
+{
+	this->scheduler = scheduler;
+	this->params = params;
+	this->fractals = fractals;
+	this->renderData = renderData;
+	this->image = image;
+	stopRequest = nullptr;
+	optimalStepX = 0;
+	optimalStepY = 0;
+	finishedWithSuccess = false;
+}
+
+cOpenClCpuWorkerThread::~cOpenClCpuWorkerThread()
+{
+	// nothing to destroy
+}
+
+void cOpenClCpuWorkerThread::ProcessRenderingLoop()
+{
+	const quint64 imageWidth = image->GetWidth();
+	const quint64 imageHeight = image->GetHeight();
+	const cRegion<int> fullScreenRegion = renderData->screenRegion;
+	const cRegion<double> fullImageRegion = renderData->imageRegion;
+
+	// the same render worker is used for all tiles, only its region and scheduler change
+	std::shared_ptr<cRenderWorker::sThreadData> threadData(new cRenderWorker::sThreadData);
+	threadData->id = workerIndex + 1;
+	threadData->ownRegion = true;
+	cRenderWorker worker(params, fractals, threadData, renderData, image);
+
+	QElapsedTimer tileTimer;
+
+	// renders rectangle of image and returns average time of one pixel
+	auto renderRect = [&](quint64 jobX, quint64 jobY, quint64 jobWidth, quint64 jobHeight,
+											int tile) -> double {
+		tileTimer.start();
+
+		// image region of the tile has to give the same camera rays as for the whole image
+		cRegion<int> tileRegion(int(jobX), int(jobY), int(jobX + jobWidth), int(jobY + jobHeight));
+		CVector2<double> corner1 =
+			fullScreenRegion.transpose(fullImageRegion, CVector2<int>(tileRegion.x1, tileRegion.y1));
+		CVector2<double> corner2 =
+			fullScreenRegion.transpose(fullImageRegion, CVector2<int>(tileRegion.x2, tileRegion.y2));
+		threadData->screenRegion = tileRegion;
+		threadData->imageRegion.Set(corner1.x, corner1.y, corner2.x, corner2.y);
+		threadData->startLine = tileRegion.y1;
+		threadData->scheduler.reset(new cScheduler(tileRegion, 1));
+
+		worker.doWork();
+
+		double pixelTime = double(tileTimer.nsecsElapsed()) / (jobWidth * jobHeight);
+
+		cOpenCLWorkerOutputQueue::sClSingleOutput outputDataForQueue;
+		outputDataForQueue.jobX = jobX;
+		outputDataForQueue.jobY = jobY;
+		outputDataForQueue.gridX = scheduler->getTileSequence()->at(tile).x();
+		outputDataForQueue.gridY = scheduler->getTileSequence()->at(tile).y();
+		outputDataForQueue.tileIndex = tile;
+		outputDataForQueue.jobWidth = jobWidth;
+		outputDataForQueue.jobHeight = jobHeight;
+		outputDataForQueue.monteCarloLoop = 1;
+		outputDataForQueue.aaDepth = 0;
+		outputDataForQueue.renderedByCpu = true;
+		outputQueue->AddToQueue(&outputDataForQueue);
+
+		return pixelTime;
+	};
+
+	double pixelTime = 0.0;
+
+	if (scheduler->IsAdaptive())
+	{
+		cOpenClScheduler::sWorkItem item;
+		while (scheduler->IsWorthRenderingOnCpu(pixelTime, 1)
+					 && scheduler->TakeWorkItem(pixelTime, &item))
+		{
+			if (*stopRequest || systemData.globalStopRequest)
+			{
+				finishedWithSuccess = false;
+				emit finished();
+				return;
+			}
+
+			if (!item.rect.isEmpty())
+			{
+				pixelTime = renderRect(quint64(item.rect.x()), quint64(item.rect.y()),
+					quint64(item.rect.width()), quint64(item.rect.height()), item.tileIndex);
+			}
+			scheduler->WorkItemDone(item);
+		}
+
+		finishedWithSuccess = true;
+		emit finished();
+		return;
+	}
+
+	int tile = scheduler->ReserveFirstFreeTile(1);
+	while (tile >= 0)
+	{
+		if (*stopRequest || systemData.globalStopRequest)
+		{
+			finishedWithSuccess = false;
+			emit finished();
+			return;
+		}
+
+		quint64 jobX = scheduler->getTileSequence()->at(tile).x() * optimalStepX;
+		quint64 jobY = scheduler->getTileSequence()->at(tile).y() * optimalStepY;
+
+		if (jobX < imageWidth && jobY < imageHeight)
+		{
+			quint64 jobWidth = std::min(optimalStepX, imageWidth - jobX);
+			quint64 jobHeight = std::min(optimalStepY, imageHeight - jobY);
+			pixelTime = renderRect(jobX, jobY, jobWidth, jobHeight, tile);
+		}
+
+		// last tiles are left for OpenCL devices when they can finish them sooner
+		if (!scheduler->IsWorthRenderingOnCpu(pixelTime, 1))
+		{
+			scheduler->MarkTileDone(tile, 1);
+			break;
+		}
+		tile = scheduler->GetNextTileToRender(tile, 1);
+	}
+
+	finishedWithSuccess = true;
+	emit finished();
+}
+
+#endif // USE_OPENCL
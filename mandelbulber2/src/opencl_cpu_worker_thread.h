@@ -0,0 +1,98 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * CPU thread which renders tiles together with OpenCL devices
+ *
+ * The thread takes tiles from the same cOpenClScheduler as OpenCL workers and renders them with
+ * cRenderWorker directly into the image. Finished tiles are announced through the output queue,
+ * so the main loop of cOpenClEngineRenderFractal::RenderMulti() refreshes them as other tiles.
+ */
+
+#ifndef MANDELBULBER2_SRC_OPENCL_CPU_WORKER_THREAD_H_
+#define MANDELBULBER2_SRC_OPENCL_CPU_WORKER_THREAD_H_
+
+#ifdef USE_OPENCL
+
+#include <memory>
+
+#include <QObject>
+
+class cImage;
+class cNineFractals;
+class cOpenCLWorkerOutputQueue;
+class cOpenClScheduler;
+struct sParamRender;
+struct sRenderData;
+
+class cOpenClCpuWorkerThread : public QObject
+{
+	Q_OBJECT
+
+public:
+	cOpenClCpuWorkerThread(std::shared_ptr<cOpenClScheduler> scheduler,
+		std::shared_ptr<const sParamRender> params, std::shared_ptr<const cNineFractals> fractals,
+		std::shared_ptr<sRenderData> renderData, std::shared_ptr<cImage> image, int workerIndex);
+	~cOpenClCpuWorkerThread() override;
+
+	void setOptimalStepX(quint64 optimalStepX) { this->optimalStepX = optimalStepX; }
+	void setOptimalStepY(quint64 optimalStepY) { this->optimalStepY = optimalStepY; }
+	void setOutputQueue(const std::shared_ptr<cOpenCLWorkerOutputQueue> &outputQueue)
+	{
+		this->outputQueue = outputQueue;
+	}
+	void setStopRequest(bool *stopRequest) { this->stopRequest = stopRequest; }
+	bool wasFishedWithSuccess() const { return finishedWithSuccess; }
+
+private:
+	std::shared_ptr<cOpenClScheduler> scheduler;
+	std::shared_ptr<const sParamRender> params;
+	std::shared_ptr<const cNineFractals> fractals;
+	std::shared_ptr<sRenderData> renderData;
+	std::shared_ptr<cImage> image;
+	std::shared_ptr<cOpenCLWorkerOutputQueue> outputQueue;
+	bool *stopRequest;
+
+	quint64 optimalStepX;
+	quint64 optimalStepY;
+	bool finishedWithSuccess;
+
+	const int workerIndex;
+
+public slots:
+	void ProcessRenderingLoop();
+
+signals:
+	void finished();
+};
+
+#endif // USE_OPENCL
+
+#endif /* MANDELBULBER2_SRC_OPENCL_CPU_WORKER_THREAD_H_ */
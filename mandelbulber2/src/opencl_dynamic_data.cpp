@@ -38,6 +38,7 @@
 #include <map>
 
 #include "color_gradient.h"
+#include "cone_march_prepass.hpp"
 #include "light.h"
 #include "lights.hpp"
 #include "material.h"
@@ -55,7 +56,7 @@
 
 #ifdef USE_OPENCL
 cOpenClDynamicData::cOpenClDynamicData()
-		: cOpenClAbstractDynamicData(5) // this container has 5
+		: cOpenClAbstractDynamicData(6) // this container has 6
 																		// items
 {
 }
@@ -872,4 +873,57 @@ void cOpenClDynamicData::BuildObjectsData(const QVector<cObjectData> *objectData
 		sizeof(arrayOffset));
 }
 
+void cOpenClDynamicData::BuildConeMarchData(const cConeMarchPrepass *coneMarchPrepass)
+{
+	/*
+	 * header:
+	 * cl_int tileSize
+	 * cl_int numberOfTilesX
+	 * cl_int numberOfTilesY
+	 * cl_int arrayOffset;
+	 *
+	 * array (aligned to 16):
+	 * 	cl_float depth of tile 0
+	 * 	cl_float depth of tile 1
+	 *  ...
+	 * 	cl_float depth of tile N
+	 */
+
+	totalDataOffset += PutDummyToAlign(totalDataOffset, 16, &data);
+	itemOffsets[coneMarchItemIndex].itemOffset = totalDataOffset;
+
+	cl_int tileSize = coneMarchPrepass ? coneMarchPrepass->GetTileSize() : 0;
+	data.append(reinterpret_cast<char *>(&tileSize), sizeof(tileSize));
+	totalDataOffset += sizeof(tileSize);
+
+	cl_int numberOfTilesX = coneMarchPrepass ? coneMarchPrepass->GetNumberOfTilesX() : 0;
+	data.append(reinterpret_cast<char *>(&numberOfTilesX), sizeof(numberOfTilesX));
+	totalDataOffset += sizeof(numberOfTilesX);
+
+	cl_int numberOfTilesY = coneMarchPrepass ? coneMarchPrepass->GetNumberOfTilesY() : 0;
+	data.append(reinterpret_cast<char *>(&numberOfTilesY), sizeof(numberOfTilesY));
+	totalDataOffset += sizeof(numberOfTilesY);
+
+	// reserve bytes for array offset
+	cl_int arrayOffset = 0;
+	int arrayOffsetAddress = totalDataOffset;
+	data.append(reinterpret_cast<char *>(&arrayOffset), sizeof(arrayOffset));
+	totalDataOffset += sizeof(arrayOffset);
+
+	totalDataOffset += PutDummyToAlign(totalDataOffset, 16, &data);
+	arrayOffset = totalDataOffset;
+
+	if (coneMarchPrepass)
+	{
+		const std::vector<float> &tileDepths = coneMarchPrepass->GetTileDepths();
+		int arraySize = int(tileDepths.size() * sizeof(cl_float));
+		data.append(reinterpret_cast<const char *>(tileDepths.data()), arraySize);
+		totalDataOffset += arraySize;
+	}
+
+	// replace arrayOffset:
+	data.replace(arrayOffsetAddress, sizeof(arrayOffset), reinterpret_cast<char *>(&arrayOffset),
+		sizeof(arrayOffset));
+}
+
 #endif // USE_OPENCL
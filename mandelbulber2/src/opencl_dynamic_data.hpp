@@ -44,6 +44,7 @@ struct sVectorsAround;
 class cLights;
 class cPrimitives;
 class cObjectData;
+class cConeMarchPrepass;
 
 #ifdef USE_OPENCL
 class cOpenClDynamicData : public cOpenClAbstractDynamicData
@@ -58,6 +59,7 @@ public:
 	void BuildLightsData(const cLights *lights, const QMap<QString, int> &textureIndexes);
 	QString BuildPrimitivesData(const cPrimitives *primitives); // return definesCollector;
 	void BuildObjectsData(const QVector<cObjectData> *objectData);
+	void BuildConeMarchData(const cConeMarchPrepass *coneMarchPrepass);
 
 private:
 	const int materialsItemIndex = 0;
@@ -65,6 +67,7 @@ private:
 	const int lightsItemIndex = 2;
 	const int primitivesItemIndex = 3;
 	const int objectsItemIndex = 4;
+	const int coneMarchItemIndex = 5;
 };
 
 #endif // USE_OPENCL
@@ -47,6 +47,7 @@
 #include "error_message.hpp"
 #include "opencl_hardware.h"
 #include "parameters.hpp"
+#include "render_trace.hpp"
 #include "write_log.hpp"
 
 cOpenClEngine::cOpenClEngine(cOpenClHardware *_hardware) : QObject(_hardware), hardware(_hardware)
@@ -92,6 +93,7 @@ bool cOpenClEngine::checkErr(cl_int err, QString functionName)
 
 bool cOpenClEngine::Build(const QByteArray &programString, QString *errorText, bool quiet)
 {
+	cTraceSpan traceSpan("cOpenClEngine::Build", "opencl");
 	if (hardware->getClDevices(0).size() > 0 && hardware->getEnabledDevices().size() > 0)
 	{
 		// calculating hash code of the program
@@ -0,0 +1,370 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cOpenClEngineRenderDenoiser - OpenCL version of edge-aware a-trous wavelet denoiser
+ */
+
+#include "opencl_engine_render_denoiser.h"
+
+#include "cimage.hpp"
+#include "files.h"
+#include "fractparams.hpp"
+#include "global_data.hpp"
+#include "opencl_hardware.h"
+#include "parameters.hpp"
+#include "post_effect_denoiser.h"
+#include "progress_text.hpp"
+#include "render_trace.hpp"
+#include "system_data.hpp"
+#include "system_directories.hpp"
+#include "write_log.hpp"
+
+cOpenClEngineRenderDenoiser::cOpenClEngineRenderDenoiser(cOpenClHardware *_hardware)
+		: cOpenClEngine(_hardware)
+{
+#ifdef USE_OPENCL
+	paramsDenoiser.width = 0;
+	paramsDenoiser.height = 0;
+	paramsDenoiser.step = 1;
+	paramsDenoiser.useNormals = false;
+	paramsDenoiser.useWorld = false;
+	paramsDenoiser.sigmaLuminance = 1.0f;
+	paramsDenoiser.sigmaDepth = cPostEffectDenoiser::sigmaDepth;
+	paramsDenoiser.sigmaAlbedo = cPostEffectDenoiser::sigmaAlbedo;
+	paramsDenoiser.normalPower = cPostEffectDenoiser::normalPower;
+	strength = 1.0f;
+	iterations = 0;
+	numberOfPixels = 0;
+	useDiffuse = false;
+	optimalJob.sizeOfPixel = 0; // memory usage doens't depend on job size
+	optimalJob.optimalProcessingCycle = 0.5;
+#endif
+}
+
+cOpenClEngineRenderDenoiser::~cOpenClEngineRenderDenoiser()
+{
+#ifdef USE_OPENCL
+	ReleaseMemory();
+#endif
+}
+
+#ifdef USE_OPENCL
+
+QString cOpenClEngineRenderDenoiser::GetKernelName()
+{
+	return QString("Denoiser");
+}
+
+void cOpenClEngineRenderDenoiser::SetParameters(
+	const sParamRender *paramRender, std::shared_ptr<cImage> image, bool useGeometryGuides)
+{
+	paramsDenoiser.width = int(image->GetWidth());
+	paramsDenoiser.height = int(image->GetHeight());
+	// normal vectors and world positions are calculated only by full OpenCL engine
+	paramsDenoiser.useNormals = useGeometryGuides && image->GetImageOptional()->optionalNormalWorld;
+	paramsDenoiser.useWorld = useGeometryGuides && image->GetImageOptional()->optionalWorld;
+	useDiffuse = image->GetImageOptional()->optionalDiffuse;
+	numberOfPixels = quint64(paramsDenoiser.width) * quint64(paramsDenoiser.height);
+	strength = float(paramRender->denoiserStrength);
+	iterations = paramRender->denoiserIterations;
+
+	definesCollector.clear();
+}
+
+bool cOpenClEngineRenderDenoiser::LoadSourcesAndCompile(
+	std::shared_ptr<const cParameterContainer> params, QString *compilerErrorOutput)
+{
+	programsLoaded = false;
+	readyForRendering = false;
+	emit updateProgressAndStatus(
+		tr("OpenCl denoiser - initializing"), tr("Compiling sources for denoiser"), 0.0);
+
+	QString openclPath = systemDirectories.sharedDir + "opencl" + QDir::separator();
+	QString openclEnginePath = openclPath + "engines" + QDir::separator();
+
+	QByteArray programEngine;
+	// pass through define constants
+	programEngine.append("#define USE_OPENCL 1\n");
+
+	QStringList clHeaderFiles;
+	clHeaderFiles.append("opencl_typedefs.h"); // definitions of common opencl types
+	clHeaderFiles.append("denoiser_cl.h");		 // main data structures
+	for (int i = 0; i < clHeaderFiles.size(); i++)
+	{
+		AddInclude(programEngine, openclPath + clHeaderFiles.at(i));
+	}
+
+	QString engineFileName = "denoiser.cl";
+	QString engineFullFileName = openclEnginePath + engineFileName;
+	programEngine.append(LoadUtf8TextFromFile(engineFullFileName));
+
+	SetUseFastRelaxedMath(params->Get<bool>("opencl_use_fast_relaxed_math"));
+
+	// building OpenCl kernel
+	QString errorString;
+
+	QElapsedTimer timer;
+	timer.start();
+	if (Build(programEngine, &errorString, false))
+	{
+		programsLoaded = true;
+	}
+	else
+	{
+		programsLoaded = false;
+		WriteLog(errorString, 0);
+	}
+
+	if (compilerErrorOutput) *compilerErrorOutput = errorString;
+
+	WriteLogDouble(
+		"cOpenClEngineRenderDenoiser: Opencl build time [s]", timer.nsecsElapsed() / 1.0e9, 2);
+
+	return programsLoaded;
+}
+
+void cOpenClEngineRenderDenoiser::RegisterInputOutputBuffers(
+	std::shared_ptr<const cParameterContainer> params)
+{
+	Q_UNUSED(params);
+	inputBuffers[0] << sClInputOutputBuffer(sizeof(cl_float) * 3, numberOfPixels, "color buffer");
+	inputBuffers[0] << sClInputOutputBuffer(sizeof(cl_float), numberOfPixels, "z-buffer");
+	inputBuffers[0] << sClInputOutputBuffer(sizeof(cl_float) * 3, numberOfPixels, "albedo buffer");
+	// only one item is allocated for guides which are not used
+	inputBuffers[0] << sClInputOutputBuffer(sizeof(cl_float) * 3,
+		paramsDenoiser.useNormals ? numberOfPixels : 1, "normal buffer");
+	inputBuffers[0] << sClInputOutputBuffer(
+		sizeof(cl_float) * 3, paramsDenoiser.useWorld ? numberOfPixels : 1, "world buffer");
+	outputBuffers[0] << sClInputOutputBuffer(sizeof(cl_float) * 3, numberOfPixels, "output buffer");
+}
+
+bool cOpenClEngineRenderDenoiser::AssignParametersToKernelAdditional(
+	uint argIterator, int deviceIndex)
+{
+	int err = clKernels.at(deviceIndex)->setArg(argIterator++, paramsDenoiser);
+	if (!checkErr(err, "kernel->setArg(" + QString::number(argIterator) + ", paramsDenoiser)"))
+	{
+		emit showErrorMessage(
+			QObject::tr("Cannot set OpenCL argument for %1").arg(QObject::tr("denoiser params")),
+			cErrorMessage::errorMessage, nullptr);
+		return false;
+	}
+	return true;
+}
+
+bool cOpenClEngineRenderDenoiser::ProcessQueue(quint64 pixelsLeft, quint64 pixelIndex)
+{
+	quint64 limitedWorkgroupSize = optimalJob.workGroupSize;
+	quint64 stepSize = optimalJob.stepSize;
+
+	if (optimalJob.stepSize > pixelsLeft)
+	{
+		quint64 mul = pixelsLeft / optimalJob.workGroupSize;
+		if (mul > 0)
+		{
+			stepSize = mul * optimalJob.workGroupSize;
+		}
+		else
+		{
+			// in this case will be limited workGroupSize
+			stepSize = pixelsLeft;
+			limitedWorkgroupSize = pixelsLeft;
+		}
+	}
+	optimalJob.stepSize = stepSize;
+
+	cl_int err = clQueues.at(0)->enqueueNDRangeKernel(*clKernels.at(0), cl::NDRange(pixelIndex),
+		cl::NDRange(stepSize), cl::NDRange(limitedWorkgroupSize));
+	if (!checkErr(err, "CommandQueue::enqueueNDRangeKernel()"))
+	{
+		emit showErrorMessage(
+			QObject::tr("Cannot enqueue OpenCL rendering jobs"), cErrorMessage::errorMessage, nullptr);
+		return false;
+	}
+
+	err = clQueues.at(0)->finish();
+	if (!checkErr(err, "CommandQueue::finish() - enqueueNDRangeKernel"))
+	{
+		emit showErrorMessage(
+			QObject::tr("Cannot finish denoising"), cErrorMessage::errorMessage, nullptr);
+		return false;
+	}
+
+	return true;
+}
+
+bool cOpenClEngineRenderDenoiser::Render(std::shared_ptr<cImage> image, bool *stopRequest)
+{
+	if (!programsLoaded) return false;
+
+	cTraceSpan traceSpan("denoiser", "opencl");
+
+	const quint64 width = quint64(paramsDenoiser.width);
+	const quint64 height = quint64(paramsDenoiser.height);
+
+	cProgressText progressText;
+	progressText.ResetTimer();
+
+	emit updateProgressAndStatus(tr("OpenCl - denoising image"), progressText.getText(0.0), 0.0);
+
+	QElapsedTimer timer;
+	timer.start();
+
+	// copy image and guide buffers to input buffers
+	cl_float *colorBuffer = reinterpret_cast<cl_float *>(inputBuffers[0][colorIndex].ptr.get());
+	cl_float *zBuffer = reinterpret_cast<cl_float *>(inputBuffers[0][zBufferIndex].ptr.get());
+	cl_float *albedoBuffer = reinterpret_cast<cl_float *>(inputBuffers[0][albedoIndex].ptr.get());
+	cl_float *normalBuffer = reinterpret_cast<cl_float *>(inputBuffers[0][normalIndex].ptr.get());
+	cl_float *worldBuffer = reinterpret_cast<cl_float *>(inputBuffers[0][worldIndex].ptr.get());
+	for (quint64 y = 0; y < height; y++)
+	{
+		for (quint64 x = 0; x < width; x++)
+		{
+			quint64 i = x + y * width;
+			sRGBFloat pixel = image->GetPixelPostImage(x, y);
+			colorBuffer[i * 3] = pixel.R;
+			colorBuffer[i * 3 + 1] = pixel.G;
+			colorBuffer[i * 3 + 2] = pixel.B;
+			zBuffer[i] = image->GetPixelZBuffer(x, y);
+			sRGBFloat albedo;
+			if (useDiffuse)
+			{
+				albedo = image->GetPixelDiffuse(x, y);
+			}
+			else
+			{
+				sRGB8 colour = image->GetPixelColor(x, y);
+				albedo = sRGBFloat(colour.R / 255.0f, colour.G / 255.0f, colour.B / 255.0f);
+			}
+			albedoBuffer[i * 3] = albedo.R;
+			albedoBuffer[i * 3 + 1] = albedo.G;
+			albedoBuffer[i * 3 + 2] = albedo.B;
+			if (paramsDenoiser.useNormals)
+			{
+				sRGBFloat normal = image->GetPixelNormalWorld(x, y);
+				normalBuffer[i * 3] = normal.R;
+				normalBuffer[i * 3 + 1] = normal.G;
+				normalBuffer[i * 3 + 2] = normal.B;
+			}
+			if (paramsDenoiser.useWorld)
+			{
+				sRGBFloat world = image->GetPixelWorld(x, y);
+				worldBuffer[i * 3] = world.R;
+				worldBuffer[i * 3 + 1] = world.G;
+				worldBuffer[i * 3 + 2] = world.B;
+			}
+		}
+	}
+
+	// writing data to queue
+	if (!WriteBuffersToQueue()) return false;
+
+	for (int iteration = 0; iteration < iterations; iteration++)
+	{
+		// distance between samples is doubled with every iteration
+		paramsDenoiser.step = 1 << iteration;
+		paramsDenoiser.sigmaLuminance = strength / paramsDenoiser.step;
+
+		for (quint64 pixelIndex = 0; pixelIndex < width * height; pixelIndex += optimalJob.stepSize)
+		{
+			size_t pixelsLeft = width * height - pixelIndex;
+			UpdateOptimalJobStart(pixelsLeft);
+
+			// assign parameters to kernel
+			if (!AssignParametersToKernel(0)) return false;
+
+			// processing queue
+			if (!ProcessQueue(pixelsLeft, pixelIndex)) return false;
+
+			UpdateOptimalJobEnd();
+
+			if (*stopRequest || systemData.globalStopRequest) return false;
+		}
+
+		// output of this iteration is input of next one. Data stays in device memory
+		if (iteration < iterations - 1)
+		{
+			cl_int err = clQueues.at(0)->enqueueCopyBuffer(*outputBuffers[0][outputIndex].clPtr,
+				*inputBuffers[0][colorIndex].clPtr, 0, 0, outputBuffers[0][outputIndex].size());
+			if (!checkErr(err, "CommandQueue::enqueueCopyBuffer()")) return false;
+		}
+
+		double percentDone = double(iteration + 1) / iterations;
+		emit updateProgressAndStatus(
+			tr("OpenCl - denoising image"), progressText.getText(percentDone), percentDone);
+		gApplication->processEvents();
+	}
+
+	if (!ReadBuffersFromQueue(0)) return false;
+
+	const cl_float *output = reinterpret_cast<cl_float *>(outputBuffers[0][outputIndex].ptr.get());
+	for (quint64 y = 0; y < height; y++)
+	{
+		for (quint64 x = 0; x < width; x++)
+		{
+			quint64 i = x + y * width;
+			image->PutPixelPostImage(
+				x, y, sRGBFloat(output[i * 3], output[i * 3 + 1], output[i * 3 + 2]));
+		}
+	}
+
+	WriteLogDouble(
+		"cOpenClEngineRenderDenoiser: OpenCL Rendering time [s]", timer.nsecsElapsed() / 1.0e9, 2);
+
+	WriteLog("image->CompileImage()", 2);
+	image->CompileImage();
+
+	if (image->IsPreview())
+	{
+		WriteLog("image->ConvertTo8bit()", 2);
+		image->ConvertTo8bitChar();
+		WriteLog("image->UpdatePreview()", 2);
+		image->UpdatePreview();
+		WriteLog("image->GetImageWidget()->update()", 2);
+		emit updateImage();
+	}
+
+	emit updateProgressAndStatus(
+		tr("OpenCl - denoising image finished"), progressText.getText(1.0), 1.0);
+
+	return true;
+}
+
+size_t cOpenClEngineRenderDenoiser::CalcNeededMemory()
+{
+	// colour, z-buffer, albedo, output and optional normals and world positions
+	int floatsPerPixel = 10;
+	if (paramsDenoiser.useNormals) floatsPerPixel += 3;
+	if (paramsDenoiser.useWorld) floatsPerPixel += 3;
+	return numberOfPixels * sizeof(cl_float) * floatsPerPixel;
+}
+
+#endif // USE_OPENCL
@@ -44,6 +44,7 @@
 #include "camera_target.hpp"
 #include "cimage.hpp"
 #include "common_math.h"
+#include "cone_march_prepass.hpp"
 #include "files.h"
 #include "fractal.h"
 #include "fractparams.hpp"
@@ -51,6 +52,7 @@
 #include "material.h"
 #include "netrender.hpp"
 #include "nine_fractals.hpp"
+#include "opencl_cpu_worker_thread.h"
 #include "opencl_dynamic_data.hpp"
 #include "opencl_hardware.h"
 #include "opencl_scheduler.h"
@@ -62,6 +64,7 @@
 #include "progress_text.hpp"
 #include "rectangle.hpp"
 #include "render_data.hpp"
+#include "render_trace.hpp"
 #include "render_worker.hpp"
 #include "system_data.hpp"
 #include "system_directories.hpp"
@@ -91,6 +94,8 @@ cOpenClEngineRenderFractal::cOpenClEngineRenderFractal(cOpenClHardware *_hardwar
 	meshExportMode = false;
 	distanceMode = false;
 	reservedGpuTime = 0.0;
+	adaptiveTiles = false;
+	tileTargetLatency = 0.0;
 
 	// create empty list of custom formulas
 	customFormulaCodes.reserve(NUMBER_OF_FRACTALS);
@@ -126,6 +131,9 @@ void cOpenClEngineRenderFractal::ReleaseMemory()
 	inTextureBuffer.clear();
 	perlinNoiseSeeds.clear();
 	inCLPerlinNoiseSeedsBuffer.clear();
+	cpuCoRenderingParams.reset();
+	cpuCoRenderingFractals.reset();
+	cpuCoRenderingData.reset();
 
 	cOpenClEngine::ReleaseMemory();
 	distanceMode = false;
@@ -326,7 +334,7 @@ bool cOpenClEngineRenderFractal::LoadSourcesAndCompile(
 		// pass through define constants
 		programEngine.append("#define USE_OPENCL 1\n");
 
-		if (params->Get<bool>("opencl_precision"))
+		if (UseDoublePrecision(params))
 			programEngine.append(
 				QString("#define DOUBLE_PRECISION " + QString::number(1) + "\n").toUtf8());
 
@@ -376,6 +384,34 @@ bool cOpenClEngineRenderFractal::LoadSourcesAndCompile(
 	return programsLoaded;
 }
 
+bool cOpenClEngineRenderFractal::UseDoublePrecision(
+	std::shared_ptr<const cParameterContainer> params)
+{
+	bool doublePrecision = false;
+	switch (enumClPrecision(params->Get<int>("opencl_precision")))
+	{
+		case clPrecisionSingle: doublePrecision = false; break;
+		case clPrecisionDouble: doublePrecision = true; break;
+		case clPrecisionAuto:
+		{
+			doublePrecision = !cNineFractals::IsSinglePrecisionSufficient(params);
+			for (const cOpenClDevice::sDeviceInformation &device :
+				hardware->getSelectedDevicesInformation())
+			{
+				if (doublePrecision && device.doubleFpConfig == 0)
+				{
+					WriteLog("OpenCl device doesn't support double precision. Single precision is used", 1);
+					doublePrecision = false;
+				}
+			}
+			break;
+		}
+	}
+
+	WriteLogString("OpenCl rendering precision", doublePrecision ? "double" : "single", 2);
+	return doublePrecision;
+}
+
 void cOpenClEngineRenderFractal::SetParametersForDistanceEstimationMethod(
 	cNineFractals *fractals, sParamRender *paramRender)
 {
@@ -851,6 +887,8 @@ void cOpenClEngineRenderFractal::SetParameters(
 
 	meshExportMode = meshExportModeEnable;
 	reservedGpuTime = paramContainer->Get<double>("opencl_reserved_gpu_time");
+	adaptiveTiles = paramContainer->Get<bool>("opencl_adaptive_tiles");
+	tileTargetLatency = paramContainer->Get<double>("opencl_tile_target_latency");
 
 	constantInBuffer.reset(new sClInConstants);
 
@@ -929,6 +967,14 @@ void cOpenClEngineRenderFractal::SetParameters(
 		// definesCollector += " -DOBJ_ARRAY_SIZE=" + QString::number(renderData->objectData.size());
 	}
 
+	// start distances for primary rays
+	const cConeMarchPrepass *coneMarchPrepass =
+		(renderData && !meshExportMode && !distanceMode) ? renderData->coneMarchPrepass.get() : nullptr;
+	dynamicData->BuildConeMarchData(coneMarchPrepass);
+	if (coneMarchPrepass
+			&& (renderEngineMode == clRenderEngineTypeFast || renderEngineMode == clRenderEngineTypeFull))
+		definesCollector += " -DCONE_MARCH_PREPASS";
+
 	dynamicData->FillHeader();
 
 	inBuffer = dynamicData->GetData();
@@ -941,6 +987,19 @@ void cOpenClEngineRenderFractal::SetParameters(
 	monteCarlo =
 		(paramRender->DOFMonteCarlo && renderEngineMode != clRenderEngineTypeFast) || antiAliasing;
 
+	// CPU can render tiles together with OpenCL devices only if every tile is rendered once
+	cpuCoRenderingParams.reset();
+	cpuCoRenderingFractals.reset();
+	cpuCoRenderingData.reset();
+	if (renderData && paramContainer->Get<bool>("opencl_cpu_co_rendering")
+			&& renderEngineMode == clRenderEngineTypeFull && !monteCarlo && !meshExportMode
+			&& !distanceMode)
+	{
+		cpuCoRenderingParams = paramRender;
+		cpuCoRenderingFractals = fractals;
+		cpuCoRenderingData = renderData;
+	}
+
 	// copy all cl parameters to constant buffer
 	constantInBuffer->params = clCopySParamRenderCl(*paramRender);
 
@@ -1155,6 +1214,33 @@ void cOpenClEngineRenderFractal::CreateThreadsForOpenCLWorkers(int numberOfOpenC
 	}
 }
 
+void cOpenClEngineRenderFractal::CreateThreadsForCpuWorkers(int numberOfCpuWorkers,
+	const std::shared_ptr<cOpenClScheduler> &scheduler, std::shared_ptr<cImage> image,
+	const std::shared_ptr<cOpenCLWorkerOutputQueue> &outputQueue,
+	QList<std::shared_ptr<QThread>> &threads,
+	QList<std::shared_ptr<cOpenClCpuWorkerThread>> &workers, bool *stopRequest)
+{
+	for (int i = 0; i < numberOfCpuWorkers; i++)
+	{
+		WriteLog(QString("Thread for CPU worker") + QString::number(i) + " create", 3);
+		threads.append(std::shared_ptr<QThread>(new QThread));
+		workers.append(std::shared_ptr<cOpenClCpuWorkerThread>(new cOpenClCpuWorkerThread(scheduler,
+			cpuCoRenderingParams, cpuCoRenderingFractals, cpuCoRenderingData, image, i)));
+		workers[i]->setOptimalStepX(optimalJob.stepSizeX);
+		workers[i]->setOptimalStepY(optimalJob.stepSizeY);
+		workers[i]->setOutputQueue(outputQueue);
+		workers[i]->setStopRequest(stopRequest);
+		workers[i]->moveToThread(threads[i].get());
+		QObject::connect(
+			threads[i].get(), SIGNAL(started()), workers[i].get(), SLOT(ProcessRenderingLoop()));
+		QObject::connect(workers[i].get(), SIGNAL(finished()), threads[i].get(), SLOT(quit()));
+		threads[i]->setObjectName("OpenCLCpuWorker #" + QString::number(i));
+		threads[i]->start();
+		threads[i]->setPriority(systemData.GetQThreadPriority(systemData.threadsPriority));
+		WriteLog(QString("CPU thread ") + QString::number(i) + " started", 3);
+	}
+}
+
 sRGBFloat cOpenClEngineRenderFractal::MCMixColor(
 	const cOpenCLWorkerOutputQueue::sClSingleOutput &output, const sRGBFloat &pixel,
 	const sRGBFloat &oldPixel)
@@ -1187,6 +1273,16 @@ void cOpenClEngineRenderFractal::PutMultiPixel(quint64 xx, quint64 yy, const sRG
 	image->PutPixelOpacity(xx, yy, opacity);
 	if (image->GetImageOptional()->optionalDiffuse)
 		image->PutPixelDiffuse(xx, yy, sRGBFloat(color.R / 255.0f, color.G / 255.0f, color.B / 255.0f));
+
+	// only full engine calculates normal vectors and surface positions
+	if (renderEngineMode == clRenderEngineTypeFull)
+	{
+		if (image->GetImageOptional()->optionalNormalWorld)
+			image->PutPixelNormalWorld(
+				xx, yy, sRGBFloat(pixelCl.normalX, pixelCl.normalY, pixelCl.normalZ));
+		if (image->GetImageOptional()->optionalWorld)
+			image->PutPixelWorld(xx, yy, sRGBFloat(pixelCl.worldX, pixelCl.worldY, pixelCl.worldZ));
+	}
 }
 
 int cOpenClEngineRenderFractal::PeriodicRefreshOfTiles(int lastRefreshTime,
@@ -1340,6 +1436,15 @@ bool cOpenClEngineRenderFractal::RenderMulti(
 
 		// create scheduler
 		std::shared_ptr<cOpenClScheduler> scheduler(new cOpenClScheduler(&tileSequence));
+		scheduler->SetNumberOfOpenClDevices(numberOfOpenCLWorkers);
+		scheduler->SetTileSize(optimalJob.stepSizeX, optimalJob.stepSizeY);
+
+		// adaptive tiles are used only when every tile is rendered once
+		if (adaptiveTiles && !monteCarlo)
+		{
+			scheduler->EnableAdaptiveTiles(width, height, qint64(tileTargetLatency * 1e6));
+		}
+
 		// create output FIFO buffer
 		std::shared_ptr<cOpenCLWorkerOutputQueue> outputQueue(new cOpenCLWorkerOutputQueue);
 
@@ -1349,6 +1454,26 @@ bool cOpenClEngineRenderFractal::RenderMulti(
 		CreateThreadsForOpenCLWorkers(numberOfOpenCLWorkers, scheduler, width, height, outputQueue,
 			numberOfSamples, antiAliasingDepth, threads, workers, stopRequest);
 
+		// CPU workers which take tiles from the same scheduler
+		QList<std::shared_ptr<QThread>> cpuThreads;
+		QList<std::shared_ptr<cOpenClCpuWorkerThread>> cpuWorkers;
+		if (cpuCoRenderingData)
+		{
+			// one CPU thread is left for feeding OpenCL devices and collecting results
+			int numberOfCpuWorkers = max(1, cpuCoRenderingData->configuration.GetNumberOfThreads() - 1);
+
+			// start tiles of OpenCL workers can't be taken by CPU workers
+			if (!scheduler->IsAdaptive())
+			{
+				for (int d = 0; d < min(numberOfOpenCLWorkers, tileSequence.size()); d++)
+					scheduler->ReserveTile(d);
+			}
+
+			WriteLog(QString("Creating threads for CPU workers"), 2);
+			CreateThreadsForCpuWorkers(
+				numberOfCpuWorkers, scheduler, image, outputQueue, cpuThreads, cpuWorkers, stopRequest);
+		}
+
 		// while loop continue condition
 		bool continueWhileLoop = false;
 
@@ -1382,64 +1507,67 @@ bool cOpenClEngineRenderFractal::RenderMulti(
 					float maxBrightness = 0.0;
 					float minBrightness = 100.0;
 
-					// processing pixels of tile
-					for (quint64 x = 0; x < jobWidth; x++)
+					// processing pixels of tile (CPU workers write pixels directly to the image)
+					if (!output.renderedByCpu)
 					{
-						for (quint64 y = 0; y < jobHeight; y++)
+						for (quint64 x = 0; x < jobWidth; x++)
 						{
-							// getting pixel from output buffer
-							sClPixel pixelCl = reinterpret_cast<const sClPixel *>(
-								output.outputBuffers.at(outputIndex).data.data())[x + y * jobWidth];
-							sRGBFloat pixel = {pixelCl.R, pixelCl.G, pixelCl.B};
-							sRGB8 color = {pixelCl.colR, pixelCl.colG, pixelCl.colB};
-							unsigned short opacity = pixelCl.opacity;
-							unsigned short alpha = pixelCl.alpha;
-							size_t xx = x + jobX;
-							size_t yy = y + jobY;
-
-							// if MC then paint pixels and calculate noise statistics
-							if (monteCarlo)
+							for (quint64 y = 0; y < jobHeight; y++)
 							{
-								// painting pixels with reduced opacity (averaging of MC samples)
-								sRGBFloat oldPixel = image->GetPixelImage(xx, yy);
-								sRGBFloat newPixel = MCMixColor(output, pixel, oldPixel);
-
-								unsigned short oldAlpha = image->GetPixelAlpha(xx, yy);
-								unsigned short newAlpha =
-									ushort(double(oldAlpha) * (1.0 - 1.0 / output.monteCarloLoop)
-												 + alpha * (1.0 / output.monteCarloLoop));
-
-								PutMultiPixel(xx, yy, newPixel, pixelCl, newAlpha, color, opacity, image);
-
-								// noise estimation
-								float noise = (newPixel.R - oldPixel.R) * (newPixel.R - oldPixel.R)
-															+ (newPixel.G - oldPixel.G) * (newPixel.G - oldPixel.G)
-															+ (newPixel.B - oldPixel.B) * (newPixel.B - oldPixel.B);
-								noise *= 0.3333f;
-
-								float sumBrightness = newPixel.R + newPixel.G + newPixel.B;
-								maxBrightness = max(sumBrightness, maxBrightness);
-								minBrightness = min(sumBrightness, minBrightness);
-
-								if (qIsInf(sumBrightness))
+								// getting pixel from output buffer
+								sClPixel pixelCl = reinterpret_cast<const sClPixel *>(
+									output.outputBuffers.at(outputIndex).data.data())[x + y * jobWidth];
+								sRGBFloat pixel = {pixelCl.R, pixelCl.G, pixelCl.B};
+								sRGB8 color = {pixelCl.colR, pixelCl.colG, pixelCl.colB};
+								unsigned short opacity = pixelCl.opacity;
+								unsigned short alpha = pixelCl.alpha;
+								size_t xx = x + jobX;
+								size_t yy = y + jobY;
+
+								// if MC then paint pixels and calculate noise statistics
+								if (monteCarlo)
 								{
-									sumBrightness = 0.0;
-									noise = 0.0;
-									image->PutPixelImage(xx, yy, sRGBFloat());
+									// painting pixels with reduced opacity (averaging of MC samples)
+									sRGBFloat oldPixel = image->GetPixelImage(xx, yy);
+									sRGBFloat newPixel = MCMixColor(output, pixel, oldPixel);
+
+									unsigned short oldAlpha = image->GetPixelAlpha(xx, yy);
+									unsigned short newAlpha =
+										ushort(double(oldAlpha) * (1.0 - 1.0 / output.monteCarloLoop)
+													 + alpha * (1.0 / output.monteCarloLoop));
+
+									PutMultiPixel(xx, yy, newPixel, pixelCl, newAlpha, color, opacity, image);
+
+									// noise estimation
+									float noise = (newPixel.R - oldPixel.R) * (newPixel.R - oldPixel.R)
+																+ (newPixel.G - oldPixel.G) * (newPixel.G - oldPixel.G)
+																+ (newPixel.B - oldPixel.B) * (newPixel.B - oldPixel.B);
+									noise *= 0.3333f;
+
+									float sumBrightness = newPixel.R + newPixel.G + newPixel.B;
+									maxBrightness = max(sumBrightness, maxBrightness);
+									minBrightness = min(sumBrightness, minBrightness);
+
+									if (qIsInf(sumBrightness))
+									{
+										sumBrightness = 0.0;
+										noise = 0.0;
+										image->PutPixelImage(xx, yy, sRGBFloat());
+									}
+
+									if (sumBrightness > 1.0f) noise /= (sumBrightness * sumBrightness);
+
+									monteCarloNoiseSum += noise;
+									if (noise > maxNoise) maxNoise = noise;
 								}
-
-								if (sumBrightness > 1.0f) noise /= (sumBrightness * sumBrightness);
-
-								monteCarloNoiseSum += noise;
-								if (noise > maxNoise) maxNoise = noise;
-							}
-							// if not MC then just paint pixels
-							else
-							{
-								PutMultiPixel(xx, yy, pixel, pixelCl, alpha, color, opacity, image);
-							}
-						} // next y
-					}		// next x
+								// if not MC then just paint pixels
+								else
+								{
+									PutMultiPixel(xx, yy, pixel, pixelCl, alpha, color, opacity, image);
+								}
+							} // next y
+						}		// next x
+					}
 
 					// total noise in last rectangle
 					if (monteCarlo)
@@ -1526,6 +1654,14 @@ bool cOpenClEngineRenderFractal::RenderMulti(
 				totalNoise /= noiseTableSize;
 				renderData->statistics.totalNoise = totalNoise * width * height;
 
+				renderData->statistics.openClDevicesThroughput.resize(numberOfOpenCLWorkers);
+				for (int d = 0; d < numberOfOpenCLWorkers; d++)
+				{
+					const double timePerPixel = scheduler->GetOpenClTimePerPixel(d);
+					renderData->statistics.openClDevicesThroughput[d] =
+						timePerPixel > 0.0 ? 1e9 / timePerPixel : 0.0;
+				}
+
 				emit updateStatistics(renderData->statistics);
 
 				progressRefreshTimer.restart();
@@ -1558,6 +1694,17 @@ bool cOpenClEngineRenderFractal::RenderMulti(
 					if (!workers[d]->wasFishedWithSuccess()) finallResult = false;
 				}
 			}
+			for (int i = 0; i < cpuThreads.size(); i++)
+			{
+				if (cpuThreads[i]->isRunning())
+				{
+					continueWhileLoop = true;
+				}
+				else if (!cpuWorkers[i]->wasFishedWithSuccess())
+				{
+					finallResult = false;
+				}
+			}
 			if (!outputQueue->isEmpty()) continueWhileLoop = true;
 
 		} while (continueWhileLoop);
@@ -1874,6 +2021,7 @@ bool cOpenClEngineRenderFractal::WriteBuffersToQueue()
 bool cOpenClEngineRenderFractal::ProcessQueue(
 	quint64 jobX, quint64 jobY, quint64 pixelsLeftX, quint64 pixelsLeftY)
 {
+	cTraceSpan traceSpan("ProcessQueue", "opencl");
 	WriteLog(QString("Processing OpenCL queue"), 3);
 	quint64 stepSizeX = optimalJob.stepSizeX;
 	if (pixelsLeftX < stepSizeX) stepSizeX = pixelsLeftX;
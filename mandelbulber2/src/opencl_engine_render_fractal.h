@@ -61,6 +61,7 @@ struct sRenderData;
 class cOpenClScheduler;
 class cOpenCLWorkerOutputQueue;
 class cOpenClWorkerThread;
+class cOpenClCpuWorkerThread;
 
 class cOpenClEngineRenderFractal : public cOpenClEngine
 {
@@ -75,6 +76,13 @@ public:
 		clRenderEngineTypeFull = 3
 	};
 
+	enum enumClPrecision
+	{
+		clPrecisionSingle = 0,
+		clPrecisionDouble = 1,
+		clPrecisionAuto = 2
+	};
+
 	cOpenClEngineRenderFractal(cOpenClHardware *_hardware);
 	~cOpenClEngineRenderFractal() override;
 
@@ -128,6 +136,7 @@ private:
 		std::shared_ptr<const cParameterContainer> params, const QString &openclEnginePath,
 		QByteArray &programEngine);
 	void LoadSourceWithMainEngine(const QString &openclEnginePath, QByteArray &programEngine);
+	bool UseDoublePrecision(std::shared_ptr<const cParameterContainer> params);
 	void SetParametersForDistanceEstimationMethod(cNineFractals *fractals, sParamRender *paramRender);
 	void CreateListOfUsedFormulas(
 		cNineFractals *fractals, std::shared_ptr<const cFractalContainer> fractalContainer);
@@ -145,6 +154,11 @@ private:
 		const std::shared_ptr<cOpenCLWorkerOutputQueue> &outputQueue, int numberOfSamples,
 		int antiAliasingDepth, QList<std::shared_ptr<QThread>> &threads,
 		QList<std::shared_ptr<cOpenClWorkerThread>> &workers, bool *stopRequest);
+	void CreateThreadsForCpuWorkers(int numberOfCpuWorkers,
+		const std::shared_ptr<cOpenClScheduler> &scheduler, std::shared_ptr<cImage> image,
+		const std::shared_ptr<cOpenCLWorkerOutputQueue> &outputQueue,
+		QList<std::shared_ptr<QThread>> &threads,
+		QList<std::shared_ptr<cOpenClCpuWorkerThread>> &workers, bool *stopRequest);
 	sRGBFloat MCMixColor(const cOpenCLWorkerOutputQueue::sClSingleOutput &output,
 		const sRGBFloat &pixel, const sRGBFloat &oldPixel);
 	void PutMultiPixel(quint64 xx, quint64 yy, const sRGBFloat &newPixel, const sClPixel &pixelCl,
@@ -188,6 +202,13 @@ private:
 	cl_float3 pointToCalculateDistance;
 	bool distanceMode;
 	double reservedGpuTime;
+	bool adaptiveTiles;
+	double tileTargetLatency; // [ms]
+
+	// data for CPU workers which render tiles together with OpenCL devices
+	std::shared_ptr<const sParamRender> cpuCoRenderingParams;
+	std::shared_ptr<const cNineFractals> cpuCoRenderingFractals;
+	std::shared_ptr<sRenderData> cpuCoRenderingData;
 
 #endif
 
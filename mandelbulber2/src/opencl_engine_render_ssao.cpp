@@ -34,6 +34,8 @@
 
 #include "opencl_engine_render_ssao.h"
 
+#include <algorithm>
+
 #include "cimage.hpp"
 #include "files.h"
 #include "fractparams.hpp"
@@ -55,8 +57,12 @@ cOpenClEngineRenderSSAO::cOpenClEngineRenderSSAO(cOpenClHardware *_hardware)
 	paramsSSAO.height = 0;
 	paramsSSAO.quality = 0;
 	paramsSSAO.random_mode = false;
+	paramsSSAO.hierarchical = false;
+	paramsSSAO.numberOfSteps = 0;
+	paramsSSAO.maxDepthRangeRatio = cSSAODepthPyramid::maxDepthRangeRatio;
 	intensity = 0.0;
 	numberOfPixels = 0;
+	numberOfPyramidCells = 0;
 	optimalJob.sizeOfPixel = 0; // memory usage doens't depend on job size
 	optimalJob.optimalProcessingCycle = 0.5;
 #endif
@@ -87,6 +93,24 @@ void cOpenClEngineRenderSSAO::SetParameters(
 	if (paramsSSAO.quality < 3) paramsSSAO.quality = 3;
 	paramsSSAO.random_mode = paramRender->SSAO_random_mode;
 	numberOfPixels = quint64(paramsSSAO.width) * quint64(paramsSSAO.height);
+
+	// buffers for hierarchical mode are not used by standard SSAO, so they get minimal size
+	paramsSSAO.hierarchical = paramRender->SSAO_hierarchical;
+	if (paramsSSAO.hierarchical)
+	{
+		pyramidLevels = cSSAODepthPyramid::CreateLevels(region.width, region.height);
+		steps = cSSAODepthPyramid::CreateSteps(region.width, int(pyramidLevels.size()));
+		numberOfPyramidCells = quint64(pyramidLevels.back().offset)
+													 + quint64(pyramidLevels.back().width) * pyramidLevels.back().height;
+	}
+	else
+	{
+		pyramidLevels.assign(1, cSSAODepthPyramid::sLevel{1, 1, 0});
+		steps.assign(1, cSSAODepthPyramid::sStep{1.0f, 0});
+		numberOfPyramidCells = 1;
+	}
+	paramsSSAO.numberOfSteps = int(steps.size());
+	paramsSSAO.maxDepthRangeRatio = cSSAODepthPyramid::maxDepthRangeRatio;
 	intensity = paramRender->ambientOcclusion;
 	aoColor = paramRender->ambientOcclusionColor;
 
@@ -153,6 +177,11 @@ void cOpenClEngineRenderSSAO::RegisterInputOutputBuffers(
 	inputBuffers[0] << sClInputOutputBuffer(sizeof(cl_float), numberOfPixels, "z-buffer");
 	inputBuffers[0] << sClInputOutputBuffer(
 		sizeof(cl_float), 2 * paramsSSAO.quality, "sine-cosine buffer");
+	inputBuffers[0] << sClInputOutputBuffer(
+		2 * sizeof(cl_float), numberOfPyramidCells, "depth pyramid buffer");
+	inputBuffers[0] << sClInputOutputBuffer(
+		4 * sizeof(cl_int), pyramidLevels.size(), "pyramid levels buffer");
+	inputBuffers[0] << sClInputOutputBuffer(2 * sizeof(cl_float), steps.size(), "steps buffer");
 	outputBuffers[0] << sClInputOutputBuffer(sizeof(cl_float), numberOfPixels, "output buffer");
 }
 
@@ -247,6 +276,37 @@ bool cOpenClEngineRenderSSAO::Render(std::shared_ptr<cImage> image, bool *stopRe
 				cosf(float(i) / paramsSSAO.quality * 2.0f * float(M_PI));
 		}
 
+		cl_float *pyramidBuffer =
+			reinterpret_cast<cl_float *>(inputBuffers[0][depthPyramidIndex].ptr.get());
+		if (paramsSSAO.hierarchical)
+		{
+			const cSSAODepthPyramid depthPyramid(image.get(), imageRegion);
+			const std::vector<float> &pyramidData = depthPyramid.GetData();
+			std::copy(pyramidData.begin(), pyramidData.end(), pyramidBuffer);
+		}
+		else
+		{
+			pyramidBuffer[0] = 0.0f;
+			pyramidBuffer[1] = 0.0f;
+		}
+
+		cl_int *levelsBuffer =
+			reinterpret_cast<cl_int *>(inputBuffers[0][pyramidLevelsIndex].ptr.get());
+		for (size_t i = 0; i < pyramidLevels.size(); i++)
+		{
+			levelsBuffer[i * 4 + 0] = pyramidLevels[i].width;
+			levelsBuffer[i * 4 + 1] = pyramidLevels[i].height;
+			levelsBuffer[i * 4 + 2] = pyramidLevels[i].offset;
+			levelsBuffer[i * 4 + 3] = 0;
+		}
+
+		cl_float *stepsBuffer = reinterpret_cast<cl_float *>(inputBuffers[0][stepsIndex].ptr.get());
+		for (size_t i = 0; i < steps.size(); i++)
+		{
+			stepsBuffer[i * 2 + 0] = steps[i].radius;
+			stepsBuffer[i * 2 + 1] = float(steps[i].level);
+		}
+
 		// writing data to queue
 		if (!WriteBuffersToQueue()) return false;
 
@@ -331,7 +391,9 @@ bool cOpenClEngineRenderSSAO::Render(std::shared_ptr<cImage> image, bool *stopRe
 
 size_t cOpenClEngineRenderSSAO::CalcNeededMemory()
 {
-	return numberOfPixels * sizeof(cl_float) + paramsSSAO.quality * 2 * sizeof(cl_float);
+	return numberOfPixels * sizeof(cl_float) + paramsSSAO.quality * 2 * sizeof(cl_float)
+				 + numberOfPyramidCells * 2 * sizeof(cl_float) + pyramidLevels.size() * 4 * sizeof(cl_int)
+				 + steps.size() * 2 * sizeof(cl_float);
 }
 
 #endif // USE_OPENCL
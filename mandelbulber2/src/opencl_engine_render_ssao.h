@@ -36,11 +36,13 @@
 #define MANDELBULBER2_SRC_OPENCL_ENGINE_RENDER_SSAO_H_
 
 #include <memory>
+#include <vector>
 
 #include "color_structures.hpp"
 #include "include_header_wrapper.hpp"
 #include "opencl_engine.h"
 #include "region.hpp"
+#include "ssao_depth_pyramid.hpp"
 
 // custom includes
 #ifdef USE_OPENCL
@@ -71,6 +73,9 @@ public:
 private:
 	const int zBufferIndex = 0;
 	const int sineCosineIndex = 1;
+	const int depthPyramidIndex = 2;
+	const int pyramidLevelsIndex = 3;
+	const int stepsIndex = 4;
 	const int outputIndex = 0;
 
 	QString GetKernelName() override;
@@ -80,6 +85,9 @@ private:
 	float intensity;
 	sRGBFloat aoColor;
 	quint64 numberOfPixels;
+	quint64 numberOfPyramidCells;
+	std::vector<cSSAODepthPyramid::sLevel> pyramidLevels;
+	std::vector<cSSAODepthPyramid::sStep> steps;
 #endif
 
 signals:
@@ -36,6 +36,7 @@
 
 #include "initparameters.hpp"
 #include "interface.hpp"
+#include "opencl_engine_render_denoiser.h"
 #include "opencl_engine_render_dof.h"
 #include "opencl_engine_render_fractal.h"
 #include "opencl_engine_render_ssao.h"
@@ -51,6 +52,7 @@ cGlobalOpenCl::cGlobalOpenCl(QObject *parent) : QObject(parent)
 	openClEngineRenderFractal = new cOpenClEngineRenderFractal(openClHardware);
 	openClEngineRenderSSAO = new cOpenClEngineRenderSSAO(openClHardware);
 	openclEngineRenderDOF = new cOpenClEngineRenderDOF(openClHardware);
+	openClEngineRenderDenoiser = new cOpenClEngineRenderDenoiser(openClHardware);
 #endif
 }
 
@@ -65,6 +67,7 @@ void cGlobalOpenCl::Reset()
 	openClEngineRenderFractal->Reset();
 	openClEngineRenderSSAO->Reset();
 	openclEngineRenderDOF->Reset();
+	openClEngineRenderDenoiser->Reset();
 }
 
 void cGlobalOpenCl::InitPlatfromAndDevices()
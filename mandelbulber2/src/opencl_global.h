@@ -40,6 +40,7 @@
 class cOpenClHardware;
 class cOpenClEngineRenderFractal;
 class cOpenClEngineRenderSSAO;
+class cOpenClEngineRenderDenoiser;
 class cOpenClEngineRenderDOF;
 
 class cGlobalOpenCl : public QObject
@@ -58,6 +59,7 @@ public:
 	cOpenClEngineRenderFractal *openClEngineRenderFractal;
 	cOpenClEngineRenderSSAO *openClEngineRenderSSAO;
 	cOpenClEngineRenderDOF *openclEngineRenderDOF;
+	cOpenClEngineRenderDenoiser *openClEngineRenderDenoiser;
 	cOpenClHardware *openClHardware;
 };
 
@@ -38,6 +38,18 @@ cOpenClScheduler::cOpenClScheduler(const QList<QPoint> *tileSequence)
 {
 	this->tileSequence = tileSequence;
 
+	openClThroughput = 0.0;
+	tilePixels = 1;
+	stepX = 1;
+	stepY = 1;
+
+	adaptive = false;
+	imageWidth = 0;
+	imageHeight = 0;
+	targetLatency = 0;
+	nextQuarter = 0;
+	doneQuarters = 0;
+
 	sTileStatus initStatus;
 	initStatus.enabled = true;
 	initStatus.reserved = false;
@@ -70,6 +82,8 @@ void cOpenClScheduler::Clear()
 		status.done = 0;
 		status.reserved = 0;
 	}
+	nextQuarter = 0;
+	doneQuarters = 0;
 	lock.unlock();
 }
 
@@ -108,8 +122,34 @@ int cOpenClScheduler::GetNextTileToRender(int lastTile, int monteCarloIteration)
 	return nextTile;
 }
 
+int cOpenClScheduler::ReserveFirstFreeTile(int monteCarloIteration)
+{
+	lock.lock();
+	int freeTile = -1;
+	for (int i = 0; i < tileSequence->size(); i++)
+	{
+		if (tiles[i].reserved < monteCarloIteration && tiles[i].enabled)
+		{
+			freeTile = i;
+			tiles[i].reserved = monteCarloIteration;
+			break;
+		}
+	}
+	lock.unlock();
+	return freeTile;
+}
+
+void cOpenClScheduler::MarkTileDone(int tileIndex, int monteCarloIteration)
+{
+	lock.lock();
+	tiles[tileIndex].done = monteCarloIteration;
+	lock.unlock();
+}
+
 bool cOpenClScheduler::AllDone(int monteCarloIteration)
 {
+	if (adaptive) return doneQuarters >= 4 * tiles.size();
+
 	for (sTileStatus &status : tiles)
 	{
 		if (status.done < monteCarloIteration)
@@ -118,3 +158,148 @@ bool cOpenClScheduler::AllDone(int monteCarloIteration)
 	}
 	return true;
 }
+
+void cOpenClScheduler::SetNumberOfOpenClDevices(int numberOfDevices)
+{
+	lock.lock();
+	openClPixelTimes.fill(0.0, numberOfDevices);
+	openClThroughput = 0.0;
+	lock.unlock();
+}
+
+void cOpenClScheduler::SetTileSize(quint64 _stepX, quint64 _stepY)
+{
+	stepX = _stepX;
+	stepY = _stepY;
+	tilePixels = stepX * stepY;
+}
+
+void cOpenClScheduler::ReportOpenClTime(int deviceIndex, qint64 nanoSeconds, quint64 pixels)
+{
+	if (pixels == 0) return;
+
+	lock.lock();
+	if (deviceIndex < openClPixelTimes.size())
+	{
+		double pixelTime = double(nanoSeconds) / pixels;
+		double &averageTime = openClPixelTimes[deviceIndex];
+		averageTime = (averageTime == 0.0) ? pixelTime : 0.8 * averageTime + 0.2 * pixelTime;
+
+		double throughput = 0.0;
+		for (double time : openClPixelTimes)
+		{
+			if (time > 0.0) throughput += 1.0 / time;
+		}
+		openClThroughput = throughput;
+	}
+	lock.unlock();
+}
+
+double cOpenClScheduler::GetOpenClTimePerPixel(int deviceIndex)
+{
+	lock.lock();
+	double time = (deviceIndex < openClPixelTimes.size()) ? openClPixelTimes[deviceIndex] : 0.0;
+	lock.unlock();
+	return time;
+}
+
+bool cOpenClScheduler::IsWorthRenderingOnCpu(double cpuTimePerPixel, int monteCarloIteration)
+{
+	double throughput = openClThroughput;
+	if (throughput == 0.0) return true; // nothing measured yet
+
+	quint64 pixelsLeft;
+	quint64 cpuJobPixels;
+	if (adaptive)
+	{
+		// at the end CPU would take at least a quarter of tile
+		pixelsLeft = quint64(qMax(0, 4 * tiles.size() - nextQuarter)) * tilePixels / 4;
+		cpuJobPixels = tilePixels / 4;
+	}
+	else
+	{
+		int tilesLeft = 0;
+		lock.lock();
+		for (const sTileStatus &status : tiles)
+		{
+			if (status.enabled && status.reserved < monteCarloIteration) tilesLeft++;
+		}
+		lock.unlock();
+		pixelsLeft = quint64(tilesLeft) * tilePixels;
+		cpuJobPixels = tilePixels;
+	}
+
+	// CPU takes the job only if it finishes it before OpenCL devices finish all remaining tiles
+	return cpuTimePerPixel * cpuJobPixels <= pixelsLeft / throughput;
+}
+
+void cOpenClScheduler::EnableAdaptiveTiles(
+	quint64 _imageWidth, quint64 _imageHeight, qint64 _targetLatency)
+{
+	adaptive = true;
+	imageWidth = _imageWidth;
+	imageHeight = _imageHeight;
+	targetLatency = _targetLatency;
+	nextQuarter = 0;
+	doneQuarters = 0;
+}
+
+bool cOpenClScheduler::TakeWorkItem(double ownTimePerPixel, sWorkItem *item)
+{
+	const int totalQuarters = 4 * tiles.size();
+
+	int cursor = nextQuarter;
+	int quarters;
+	do
+	{
+		if (cursor >= totalQuarters) return false;
+
+		// whole tile is taken while remaining work keeps all devices busy for at least two such
+		// tiles, otherwise tile quarters are taken to not leave devices idle at the end
+		quarters = 1;
+		if (cursor % 4 == 0)
+		{
+			double throughput = openClThroughput;
+			double ownTileTime = ownTimePerPixel * tilePixels;
+			double timeLeft =
+				(throughput > 0.0) ? (totalQuarters - cursor) * tilePixels / 4.0 / throughput : 0.0;
+			if (ownTileTime == 0.0 || timeLeft >= 2.0 * ownTileTime) quarters = 4;
+		}
+	} while (!nextQuarter.compare_exchange_weak(cursor, cursor + quarters));
+
+	int tileIndex = cursor / 4;
+	QPoint grid = tileSequence->at(tileIndex);
+	QRect tileRect(int(grid.x() * stepX), int(grid.y() * stepY), int(stepX), int(stepY));
+
+	item->tileIndex = tileIndex;
+	item->quarters = quarters;
+	if (quarters == 4)
+	{
+		item->rect = tileRect;
+	}
+	else
+	{
+		// quarters closer to the image center are rendered first
+		int quarter = cursor % 4;
+		int halfX = int(stepX / 2);
+		int halfY = int(stepY / 2);
+		bool leftSide = tileRect.center().x() < int(imageWidth / 2);
+		bool topSide = tileRect.center().y() < int(imageHeight / 2);
+		int qx = (quarter % 2) ^ (leftSide ? 1 : 0);
+		int qy = (quarter / 2) ^ (topSide ? 1 : 0);
+		int x1 = tileRect.x() + qx * halfX;
+		int y1 = tileRect.y() + qy * halfY;
+		int width = qx ? int(stepX) - halfX : halfX;
+		int height = qy ? int(stepY) - halfY : halfY;
+		item->rect = QRect(x1, y1, width, height);
+	}
+
+	// tiles at right and bottom edges are cut to image size (can become empty)
+	item->rect &= QRect(0, 0, int(imageWidth), int(imageHeight));
+	return true;
+}
+
+void cOpenClScheduler::WorkItemDone(const sWorkItem &item)
+{
+	doneQuarters += item.quarters;
+}
@@ -35,9 +35,13 @@
 #ifndef MANDELBULBER2_SRC_OPENCL_SCHEDULER_H_
 #define MANDELBULBER2_SRC_OPENCL_SCHEDULER_H_
 
+#include <atomic>
+
 #include <QList>
 #include <QMutex>
 #include <QPoint>
+#include <QRect>
+#include <QVector>
 
 class cOpenClScheduler
 {
@@ -49,6 +53,14 @@ class cOpenClScheduler
 	};
 
 public:
+	// part of tile taken by worker in adaptive mode
+	struct sWorkItem
+	{
+		int tileIndex;
+		int quarters; // number of tile quarters covered by the item (4 = whole tile)
+		QRect rect;		// image pixels covered by the item
+	};
+
 	cOpenClScheduler(const QList<QPoint> *tileSequence);
 	~cOpenClScheduler();
 	void EnableAllTiles();
@@ -57,13 +69,42 @@ public:
 	bool IsTileEnabled(int tileIndex) { return tiles[tileIndex].enabled; }
 	void Clear();
 	int GetNextTileToRender(int lastTile, int monteCarloIteration);
+	int ReserveFirstFreeTile(int monteCarloIteration);
+	void MarkTileDone(int tileIndex, int monteCarloIteration);
 	bool AllDone(int monteCarloIteration);
 
+	// balancing of CPU workers which render tiles together with OpenCL devices
+	void SetNumberOfOpenClDevices(int numberOfDevices);
+	void SetTileSize(quint64 stepX, quint64 stepY);
+	void ReportOpenClTime(int deviceIndex, qint64 nanoSeconds, quint64 pixels);
+	double GetOpenClTimePerPixel(int deviceIndex);
+	bool IsWorthRenderingOnCpu(double cpuTimePerPixel, int monteCarloIteration);
+
+	// adaptive mode (only for single pass rendering): tiles are taken with atomic cursor and are
+	// split into quarters at the end of the frame
+	void EnableAdaptiveTiles(quint64 imageWidth, quint64 imageHeight, qint64 targetLatency);
+	bool IsAdaptive() const { return adaptive; }
+	qint64 GetTargetLatency() const { return targetLatency; }
+	bool TakeWorkItem(double ownTimePerPixel, sWorkItem *item);
+	void WorkItemDone(const sWorkItem &item);
+
 	const QList<QPoint> *getTileSequence() const { return tileSequence; }
 
 private:
 	const QList<QPoint> *tileSequence;
 	QList<sTileStatus> tiles;
+	QVector<double> openClPixelTimes; // averaged time of one pixel for each OpenCL device [ns]
+	std::atomic<double> openClThroughput; // sum of throughputs of OpenCL devices [pixels / ns]
+	quint64 tilePixels;
+	quint64 stepX;
+	quint64 stepY;
+
+	bool adaptive;
+	quint64 imageWidth;
+	quint64 imageHeight;
+	qint64 targetLatency; // target time of a single OpenCL dispatch [ns]
+	std::atomic<int> nextQuarter;
+	std::atomic<int> doneQuarters;
 
 	QMutex lock;
 };
@@ -68,6 +68,7 @@ public:
 		quint64 tileIndex;
 		int monteCarloLoop;
 		int aaDepth;
+		bool renderedByCpu = false; // pixels were written directly to the image by CPU worker
 		QList<sClDataBuffer> outputBuffers;
 	};
 
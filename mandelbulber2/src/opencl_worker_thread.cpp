@@ -46,6 +46,7 @@
 #include "opencl_engine.h"
 #include "opencl_scheduler.h"
 #include "opencl_worker_output_queue.h"
+#include "render_trace.hpp"
 #include "system_data.hpp"
 #include "wait.hpp"
 
@@ -87,6 +88,12 @@ bool cOpenClWorkerThread::checkErr(cl_int err, QString functionName)
 
 void cOpenClWorkerThread::ProcessRenderingLoop()
 {
+	if (scheduler->IsAdaptive())
+	{
+		ProcessAdaptiveRenderingLoop();
+		return;
+	}
+
 	int startTile = deviceIndex;
 	if (startTile >= scheduler->getTileSequence()->length())
 	{
@@ -97,9 +104,6 @@ void cOpenClWorkerThread::ProcessRenderingLoop()
 
 	scheduler->ReserveTile(startTile);
 
-	QElapsedTimer openclProcessingTime;
-	qint64 openclprocessingTimeNanoSeconds = 0;
-
 	int actualAADepth = 0;
 	int actualAARepeatIndex = 0;
 
@@ -124,10 +128,8 @@ void cOpenClWorkerThread::ProcessRenderingLoop()
 			quint64 gridY = scheduler->getTileSequence()->at(tile).y();
 			quint64 jobX = gridX * optimalStepX;
 			quint64 jobY = gridY * optimalStepY;
-			quint64 pixelsLeftX = imageWidth - jobX;
-			quint64 pixelsLeftY = imageHeight - jobY;
-			quint64 jobWidth = min(optimalStepX, pixelsLeftX);
-			quint64 jobHeight = min(optimalStepY, pixelsLeftY);
+			quint64 jobWidth = min(optimalStepX, imageWidth - jobX);
+			quint64 jobHeight = min(optimalStepY, imageHeight - jobY);
 
 			if (*stopRequest || systemData.globalStopRequest)
 			{
@@ -138,55 +140,12 @@ void cOpenClWorkerThread::ProcessRenderingLoop()
 
 			if (jobX < imageWidth && jobY < imageHeight)
 			{
-				openclProcessingTime.restart();
-				int result = ProcessClQueue(jobX, jobY, pixelsLeftX, pixelsLeftY);
-				if (!result)
+				if (!RenderJob(jobX, jobY, jobWidth, jobHeight, tile, monteCarloLoop, actualAADepth))
 				{
 					emit finished();
 					finishedWithSuccess = false;
 					return;
 				}
-
-				result = engine->ReadBuffersFromQueue(deviceIndex);
-				if (!result)
-				{
-					emit finished();
-					finishedWithSuccess = false;
-					return;
-				}
-
-				openclprocessingTimeNanoSeconds = openclProcessingTime.nsecsElapsed();
-
-				quint64 outputItemSize = outputBuffers.at(outputIndex).itemSize;
-				quint64 outputItemlength = outputBuffers.at(outputIndex).length;
-				cOpenCLWorkerOutputQueue::sClDataBuffer dataBuffer(outputItemSize, outputItemlength);
-
-				char *startPtr = outputBuffers.at(outputIndex).ptr.get();
-				char *endPtr = startPtr + outputBuffers.at(outputIndex).size();
-				dataBuffer.data.assign(startPtr, endPtr);
-
-				cOpenCLWorkerOutputQueue::sClSingleOutput outputDataForQueue;
-				outputDataForQueue.jobX = jobX;
-				outputDataForQueue.jobY = jobY;
-				outputDataForQueue.gridX = gridX;
-				outputDataForQueue.gridY = gridY;
-				outputDataForQueue.tileIndex = tile;
-				outputDataForQueue.jobWidth = jobWidth;
-				outputDataForQueue.jobHeight = jobHeight;
-				outputDataForQueue.monteCarloLoop = monteCarloLoop;
-				outputDataForQueue.aaDepth = actualAADepth;
-				outputDataForQueue.outputBuffers.append(dataBuffer);
-
-				outputQueue->AddToQueue(&outputDataForQueue);
-
-				// reserve GPU time for the system
-				if (reservedGpuTime > 0.0)
-				{
-					unsigned long int waitTime =
-						reservedGpuTime * openclprocessingTimeNanoSeconds / 1000.0 / 100.0;
-					if (waitTime == 0) waitTime = 1;
-					thread()->usleep(waitTime);
-				}
 			}
 
 			// slow down to reduce length of queue
@@ -221,6 +180,104 @@ void cOpenClWorkerThread::ProcessRenderingLoop()
 	emit finished();
 }
 
+void cOpenClWorkerThread::ProcessAdaptiveRenderingLoop()
+{
+	cOpenClScheduler::sWorkItem item;
+	while (scheduler->TakeWorkItem(scheduler->GetOpenClTimePerPixel(deviceIndex), &item))
+	{
+		if (*stopRequest || systemData.globalStopRequest)
+		{
+			emit finished();
+			finishedWithSuccess = false;
+			return;
+		}
+
+		// refresh parameters (needed to update random seed)
+		engine->AssignParametersToKernel(deviceIndex);
+		if (isFullEngine) AddAntiAliasingParameters(0, 0);
+
+		// the item is rendered in strips which should take not more than target latency
+		quint64 jobX = item.rect.x();
+		quint64 jobWidth = item.rect.width();
+		quint64 stripHeight = item.rect.height();
+		double timePerPixel = scheduler->GetOpenClTimePerPixel(deviceIndex);
+		if (timePerPixel > 0.0 && jobWidth > 0)
+		{
+			double rows = scheduler->GetTargetLatency() / (timePerPixel * jobWidth);
+			stripHeight = qBound(qMax(optimalStepY / 8, quint64(1)), quint64(rows), stripHeight);
+		}
+
+		for (int y = item.rect.top(); y <= item.rect.bottom(); y += int(stripHeight))
+		{
+			quint64 jobHeight = min(stripHeight, quint64(item.rect.bottom() + 1 - y));
+			if (!RenderJob(jobX, quint64(y), jobWidth, jobHeight, item.tileIndex, 1, 0))
+			{
+				emit finished();
+				finishedWithSuccess = false;
+				return;
+			}
+		}
+
+		scheduler->WorkItemDone(item);
+
+		// slow down to reduce length of queue
+		int queueLength = outputQueue->getQueueLength();
+		if (queueLength > 100)
+		{
+			Wait((queueLength - 100));
+		}
+	}
+
+	finishedWithSuccess = true;
+	emit finished();
+}
+
+bool cOpenClWorkerThread::RenderJob(quint64 jobX, quint64 jobY, quint64 jobWidth,
+	quint64 jobHeight, int tile, int monteCarloLoop, int aaDepth)
+{
+	cTraceSpan traceSpan("OpenCL tile", "opencl", tile);
+	QElapsedTimer openclProcessingTime;
+	openclProcessingTime.start();
+
+	if (!ProcessClQueue(jobX, jobY, jobWidth, jobHeight)) return false;
+	if (!engine->ReadBuffersFromQueue(deviceIndex)) return false;
+
+	qint64 openclprocessingTimeNanoSeconds = openclProcessingTime.nsecsElapsed();
+	scheduler->ReportOpenClTime(deviceIndex, openclprocessingTimeNanoSeconds, jobWidth * jobHeight);
+
+	quint64 outputItemSize = outputBuffers.at(outputIndex).itemSize;
+	quint64 outputItemlength = outputBuffers.at(outputIndex).length;
+	cOpenCLWorkerOutputQueue::sClDataBuffer dataBuffer(outputItemSize, outputItemlength);
+
+	char *startPtr = outputBuffers.at(outputIndex).ptr.get();
+	char *endPtr = startPtr + outputBuffers.at(outputIndex).size();
+	dataBuffer.data.assign(startPtr, endPtr);
+
+	cOpenCLWorkerOutputQueue::sClSingleOutput outputDataForQueue;
+	outputDataForQueue.jobX = jobX;
+	outputDataForQueue.jobY = jobY;
+	outputDataForQueue.gridX = scheduler->getTileSequence()->at(tile).x();
+	outputDataForQueue.gridY = scheduler->getTileSequence()->at(tile).y();
+	outputDataForQueue.tileIndex = tile;
+	outputDataForQueue.jobWidth = jobWidth;
+	outputDataForQueue.jobHeight = jobHeight;
+	outputDataForQueue.monteCarloLoop = monteCarloLoop;
+	outputDataForQueue.aaDepth = aaDepth;
+	outputDataForQueue.outputBuffers.append(dataBuffer);
+
+	outputQueue->AddToQueue(&outputDataForQueue);
+
+	// reserve GPU time for the system
+	if (reservedGpuTime > 0.0)
+	{
+		unsigned long int waitTime = reservedGpuTime * openclprocessingTimeNanoSeconds / 1000.0 / 100.0;
+		if (waitTime == 0) waitTime = 1;
+		thread()->usleep(waitTime);
+	}
+
+	return true;
+}
+
 bool cOpenClWorkerThread::ProcessClQueue(
 	quint64 jobX, quint64 jobY, quint64 pixelsLeftX, quint64 pixelsLeftY)
 {
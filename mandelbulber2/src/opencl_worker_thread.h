@@ -88,6 +88,9 @@ public:
 	bool wasFishedWithSuccess() { return finishedWithSuccess; }
 
 private:
+	void ProcessAdaptiveRenderingLoop();
+	bool RenderJob(quint64 jobX, quint64 jobY, quint64 jobWidth, quint64 jobHeight, int tile,
+		int monteCarloLoop, int aaDepth);
 	bool ProcessClQueue(quint64 jobX, quint64 jobY, quint64 pixelsLeftX, quint64 pixelsLeftY);
 	static bool checkErr(cl_int err, QString functionName);
 	bool AddAntiAliasingParameters(int actualDepth, int repeatIndex);
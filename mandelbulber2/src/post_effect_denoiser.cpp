@@ -0,0 +1,216 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cPostEffectDenoiser - edge-aware a-trous wavelet filter which removes Monte Carlo noise
+ * using z-buffer, world positions, diffuse colour and normal vectors as guides
+ */
+
+#include "post_effect_denoiser.h"
+
+#include <cmath>
+
+#include "cimage.hpp"
+#include "global_data.hpp"
+#include "progress_text.hpp"
+#include "render_trace.hpp"
+#include "system_data.hpp"
+
+cPostEffectDenoiser::cPostEffectDenoiser(std::shared_ptr<cImage> _image)
+		: QObject(), image(_image)
+{
+	strength = 1.0;
+	iterations = 4;
+	useNormals = false;
+	useWorld = false;
+	useDiffuse = false;
+}
+
+cPostEffectDenoiser::~cPostEffectDenoiser()
+{
+	// nothing to delete
+}
+
+void cPostEffectDenoiser::SetParameters(
+	double _strength, int _iterations, bool _useGeometryGuides)
+{
+	strength = _strength;
+	iterations = _iterations;
+	useNormals = _useGeometryGuides && image->GetImageOptional()->optionalNormalWorld;
+	useWorld = _useGeometryGuides && image->GetImageOptional()->optionalWorld;
+	useDiffuse = image->GetImageOptional()->optionalDiffuse;
+}
+
+void cPostEffectDenoiser::PrepareGuides()
+{
+	const qint64 width = image->GetWidth();
+	const qint64 height = image->GetHeight();
+	depth.resize(width * height);
+	albedo.resize(width * height);
+	normal.resize(useNormals ? width * height : 0);
+	world.resize(useWorld ? width * height : 0);
+
+#pragma omp parallel for
+	for (qint64 y = 0; y < height; y++)
+	{
+		for (qint64 x = 0; x < width; x++)
+		{
+			const qint64 index = x + y * width;
+			depth[index] = image->GetPixelZBuffer(x, y);
+			if (useDiffuse)
+			{
+				albedo[index] = image->GetPixelDiffuse(x, y);
+			}
+			else
+			{
+				const sRGB8 colour = image->GetPixelColor(x, y);
+				albedo[index] = sRGBFloat(colour.R / 255.0f, colour.G / 255.0f, colour.B / 255.0f);
+			}
+			if (useNormals) normal[index] = image->GetPixelNormalWorld(x, y);
+			if (useWorld) world[index] = image->GetPixelWorld(x, y);
+		}
+	}
+}
+
+void cPostEffectDenoiser::Iteration(
+	int step, const std::vector<sRGBFloat> &input, std::vector<sRGBFloat> &output)
+{
+	const qint64 width = image->GetWidth();
+	const qint64 height = image->GetHeight();
+
+	// B3 spline kernel
+	const float kernel[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+
+	// luminance differences are tolerated less on coarser levels
+	const float sigmaLuminance = float(strength) / float(step);
+
+#pragma omp parallel for schedule(dynamic)
+	for (qint64 y = 0; y < height; y++)
+	{
+		for (qint64 x = 0; x < width; x++)
+		{
+			const qint64 index = x + y * width;
+			const sRGBFloat pixel = input[index];
+			const float luminance = pixel.R * 0.299f + pixel.G * 0.587f + pixel.B * 0.114f;
+			const float z = depth[index];
+			const sRGBFloat a = albedo[index];
+
+			sRGBFloat sum;
+			float weightSum = 0.0f;
+
+			for (int dy = -2; dy <= 2; dy++)
+			{
+				const qint64 yy = y + dy * step;
+				if (yy < 0 || yy >= height) continue;
+				for (int dx = -2; dx <= 2; dx++)
+				{
+					const qint64 xx = x + dx * step;
+					if (xx < 0 || xx >= width) continue;
+
+					const qint64 index2 = xx + yy * width;
+					const sRGBFloat pixel2 = input[index2];
+					const float luminance2 = pixel2.R * 0.299f + pixel2.G * 0.587f + pixel2.B * 0.114f;
+
+					// distance between surfaces relative to distance from camera
+					float distance = fabsf(depth[index2] - z);
+					if (useWorld)
+					{
+						const sRGBFloat p = world[index];
+						const sRGBFloat p2 = world[index2];
+						const float dp2 = (p2.R - p.R) * (p2.R - p.R) + (p2.G - p.G) * (p2.G - p.G)
+															+ (p2.B - p.B) * (p2.B - p.B);
+						distance = qMax(distance, sqrtf(dp2));
+					}
+					const float dz = distance / (z * sigmaDepth * step + 1e-6f);
+
+					const sRGBFloat a2 = albedo[index2];
+					const float da = ((a2.R - a.R) * (a2.R - a.R) + (a2.G - a.G) * (a2.G - a.G)
+														 + (a2.B - a.B) * (a2.B - a.B))
+													 / sigmaAlbedo;
+
+					// noise is roughly proportional to square root of intensity
+					const float dl = fabsf(luminance2 - luminance)
+													 / (sigmaLuminance * sqrtf(qMax(luminance, luminance2)) + 1e-4f);
+
+					float weight = kernel[abs(dx)] * kernel[abs(dy)] * expf(-dz - da - dl);
+
+					if (useNormals)
+					{
+						const sRGBFloat n = normal[index];
+						const sRGBFloat n2 = normal[index2];
+						const float dot = n.R * n2.R + n.G * n2.G + n.B * n2.B;
+						weight *= powf(qMax(0.0f, dot), normalPower);
+					}
+
+					sum.R += pixel2.R * weight;
+					sum.G += pixel2.G * weight;
+					sum.B += pixel2.B * weight;
+					weightSum += weight;
+				}
+			}
+
+			// central pixel has always non-zero weight
+			output[index] = sRGBFloat(sum.R / weightSum, sum.G / weightSum, sum.B / weightSum);
+		}
+	}
+}
+
+void cPostEffectDenoiser::Render(bool *stopRequest)
+{
+	cTraceSpan traceSpan("denoiser", "postprocess");
+
+	const QString statusText = QObject::tr("Denoising image");
+	cProgressText progressText;
+	progressText.ResetTimer();
+
+	emit updateProgressAndStatus(statusText, progressText.getText(0.0), 0.0);
+
+	PrepareGuides();
+
+	std::vector<sRGBFloat> buffer = image->GetPostImageFloat();
+	std::vector<sRGBFloat> temp(buffer.size());
+
+	for (int i = 0; i < iterations; i++)
+	{
+		if (*stopRequest || systemData.globalStopRequest) return;
+
+		// distance between samples is doubled with every iteration
+		Iteration(1 << i, buffer, temp);
+		buffer.swap(temp);
+
+		const double percentDone = double(i + 1) / iterations;
+		emit updateProgressAndStatus(statusText, progressText.getText(percentDone), percentDone);
+		gApplication->processEvents();
+	}
+
+	image->GetPostImageFloat() = buffer;
+
+	emit updateProgressAndStatus(statusText, progressText.getText(1.0), 1.0);
+}
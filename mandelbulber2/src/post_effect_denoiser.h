@@ -0,0 +1,85 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cPostEffectDenoiser - edge-aware a-trous wavelet filter which removes Monte Carlo noise
+ * using z-buffer, surface colour and normal vectors as guides
+ */
+
+#ifndef MANDELBULBER2_SRC_POST_EFFECT_DENOISER_H_
+#define MANDELBULBER2_SRC_POST_EFFECT_DENOISER_H_
+
+#include <memory>
+#include <vector>
+
+#include <QObject>
+
+#include "color_structures.hpp"
+
+// forward declarations
+class cImage;
+
+class cPostEffectDenoiser : public QObject
+{
+	Q_OBJECT
+
+public:
+	cPostEffectDenoiser(std::shared_ptr<cImage> _image);
+	~cPostEffectDenoiser() override;
+	// normals and world positions are not filled by fast and limited OpenCL engines
+	void SetParameters(double _strength, int _iterations, bool _useGeometryGuides);
+
+	void Render(bool *stopRequest);
+
+	// weights of edge-stopping functions, the same are used in denoiser.cl
+	static constexpr float sigmaDepth = 0.02f;
+	static constexpr float sigmaAlbedo = 0.1f;
+	static constexpr float normalPower = 64.0f;
+
+private:
+	void PrepareGuides();
+	void Iteration(int step, const std::vector<sRGBFloat> &input, std::vector<sRGBFloat> &output);
+
+	std::shared_ptr<cImage> image;
+	std::vector<float> depth;
+	std::vector<sRGBFloat> albedo;
+	std::vector<sRGBFloat> normal;
+	std::vector<sRGBFloat> world;
+	double strength;
+	int iterations;
+	bool useNormals;
+	bool useWorld;
+	bool useDiffuse;
+
+signals:
+	void updateProgressAndStatus(const QString &text, const QString &progressText, double progress);
+};
+
+#endif /* MANDELBULBER2_SRC_POST_EFFECT_DENOISER_H_ */
@@ -37,6 +37,7 @@
 #include "cimage.hpp"
 #include "global_data.hpp"
 #include "progress_text.hpp"
+#include "render_trace.hpp"
 #include "system_data.hpp"
 
 cPostEffectHdrBlur::cPostEffectHdrBlur(std::shared_ptr<cImage> _image) : QObject(), image(_image)
@@ -53,7 +54,7 @@ cPostEffectHdrBlur::~cPostEffectHdrBlur()
 
 void cPostEffectHdrBlur::Render(bool *stopRequest)
 {
-
+	cTraceSpan traceSpan("HDR blur", "postprocess");
 	tempImage = image->GetPostImageFloat();
 
 	const double blurSize = radius * (image->GetWidth() + image->GetHeight()) * 0.001;
@@ -0,0 +1,283 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cProgressMetrics - machine-readable progress and statistics for headless rendering
+ */
+
+#include "progress_metrics.hpp"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMap>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include "cimage.hpp"
+#include "netrender.hpp"
+#include "opencl_global.h"
+#include "opencl_hardware.h"
+
+bool cProgressMetrics::jsonLines = false;
+QString cProgressMetrics::prometheusFile;
+std::weak_ptr<const cImage> cProgressMetrics::image;
+cProgressMetrics::sProgress cProgressMetrics::progress[3];
+cStatistics cProgressMetrics::lastStatistics;
+QElapsedTimer cProgressMetrics::prometheusTimer;
+
+namespace
+{
+const char *const progressTypeNames[] = {"image", "animation", "queue"};
+} // namespace
+
+void cProgressMetrics::UpdateProgress(const QString &text, const QString &progressText,
+	double _progress, cProgressText::enumProgressType progressType)
+{
+	Q_UNUSED(progressText);
+	sProgress &p = progress[progressType];
+
+	// new task started
+	if (!p.timer.isValid() || _progress < p.progress) p.timer.start();
+
+	p.text = text;
+	p.progress = _progress;
+	if (_progress > 0.0)
+		p.eta = p.timer.elapsed() / 1000.0 * (1.0 - _progress) / _progress;
+	else
+		p.eta = -1.0;
+
+	if (jsonLines)
+	{
+		QJsonObject object = CreateJsonObject("progress");
+		object["type"] = progressTypeNames[progressType];
+		WriteJsonLine(object);
+	}
+	WritePrometheusFile(_progress >= 1.0);
+}
+
+void cProgressMetrics::UpdateStatistics(const cStatistics &stat)
+{
+	lastStatistics = stat;
+	if (jsonLines) WriteJsonLine(CreateJsonObject("statistics"));
+	WritePrometheusFile(false);
+}
+
+void cProgressMetrics::ReportSavedFile(const QString &fileName)
+{
+	if (!jsonLines) return;
+	QJsonObject object;
+	object["event"] = "saved";
+	object["time"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+	object["file"] = fileName;
+	WriteJsonLine(object);
+}
+
+QJsonObject cProgressMetrics::CreateJsonObject(const QString &event)
+{
+	QJsonObject object;
+	object["event"] = event;
+	object["time"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+
+	for (int t = 0; t < 3; t++)
+	{
+		if (!progress[t].timer.isValid()) continue;
+		QJsonObject progressObject;
+		progressObject["text"] = progress[t].text;
+		progressObject["percentDone"] = progress[t].progress * 100.0;
+		progressObject["etaSeconds"] =
+			progress[t].eta >= 0.0 ? QJsonValue(progress[t].eta) : QJsonValue();
+		object[progressTypeNames[t]] = progressObject;
+	}
+
+	const cStatistics &stat = lastStatistics;
+	// OpenCL renderer doesn't measure time in statistics
+	double time = stat.time;
+	if (time <= 0.0 && progress[0].timer.isValid()) time = progress[0].timer.elapsed() / 1000.0;
+	object["raysPerSecond"] = time > 0.0 ? stat.numberOfRaymarchings / time : 0.0;
+	object["iterationsPerSecond"] = time > 0.0 ? stat.totalNumberOfIterations / time : 0.0;
+	object["missedDEPercent"] =
+		stat.numberOfRaymarchings > 0 ? stat.GetMissedDEPercentage() : 0.0;
+	object["deEvaluationsPerRay"] = stat.GetDistanceEvaluationsPerRay();
+	object["backgroundRaysPercent"] = stat.GetBackgroundRaysPercentage();
+
+	std::shared_ptr<const cImage> usedImage = image.lock();
+	object["memoryMB"] = usedImage ? usedImage->GetUsedMB() : 0;
+
+	QJsonArray devices;
+	for (int d = 0; d < stat.openClDevicesThroughput.size(); d++)
+	{
+		QJsonObject device;
+		device["index"] = d;
+#ifdef USE_OPENCL
+		const QList<cOpenClDevice::sDeviceInformation> &devicesInformation =
+			gOpenCl->openClHardware->getSelectedDevicesInformation();
+		if (d < devicesInformation.size()) device["name"] = devicesInformation[d].deviceName;
+#endif
+		device["pixelsPerSecond"] = stat.openClDevicesThroughput[d];
+		devices.append(device);
+	}
+	object["openClDevices"] = devices;
+
+	QJsonObject netRender;
+	if (gNetRender->IsServer())
+	{
+		netRender["role"] = "server";
+		QJsonArray clients;
+		for (int i = 0; i < gNetRender->GetClientCount(); i++)
+		{
+			const sClient &client = gNetRender->GetClient(i);
+			QJsonObject clientObject;
+			clientObject["name"] = client.name;
+			clientObject["status"] = NetRenderStatusName(client.status);
+			clientObject["workers"] = client.clientWorkerCount;
+			clientObject["itemsRendered"] = client.itemsRendered;
+			clients.append(clientObject);
+		}
+		netRender["clients"] = clients;
+	}
+	else if (gNetRender->IsClient())
+	{
+		netRender["role"] = "client";
+		netRender["status"] = NetRenderStatusName(gNetRender->GetStatus());
+	}
+	else
+	{
+		netRender["role"] = "none";
+	}
+	object["netRender"] = netRender;
+
+	return object;
+}
+
+void cProgressMetrics::WriteJsonLine(const QJsonObject &object)
+{
+	QTextStream out(stdout);
+	out << QJsonDocument(object).toJson(QJsonDocument::Compact) << "\n";
+	out.flush();
+}
+
+void cProgressMetrics::WritePrometheusFile(bool force)
+{
+	if (prometheusFile.isEmpty()) return;
+	if (!force && prometheusTimer.isValid() && prometheusTimer.elapsed() < 1000) return;
+	prometheusTimer.start();
+
+	const QJsonObject object = CreateJsonObject("metrics");
+	QString text;
+	QTextStream out(&text);
+
+	out << "# HELP mandelbulber_progress_ratio Done part of actual task (0..1).\n";
+	out << "# TYPE mandelbulber_progress_ratio gauge\n";
+	for (int t = 0; t < 3; t++)
+	{
+		if (!progress[t].timer.isValid()) continue;
+		out << "mandelbulber_progress_ratio{type=\"" << progressTypeNames[t] << "\"} "
+				<< progress[t].progress << "\n";
+	}
+	out << "# HELP mandelbulber_eta_seconds Estimated time to finish actual task.\n";
+	out << "# TYPE mandelbulber_eta_seconds gauge\n";
+	for (int t = 0; t < 3; t++)
+	{
+		if (!progress[t].timer.isValid() || progress[t].eta < 0.0) continue;
+		out << "mandelbulber_eta_seconds{type=\"" << progressTypeNames[t] << "\"} " << progress[t].eta
+				<< "\n";
+	}
+
+	out << "# TYPE mandelbulber_rays_per_second gauge\n";
+	out << "mandelbulber_rays_per_second " << object["raysPerSecond"].toDouble() << "\n";
+	out << "# TYPE mandelbulber_iterations_per_second gauge\n";
+	out << "mandelbulber_iterations_per_second " << object["iterationsPerSecond"].toDouble() << "\n";
+	out << "# TYPE mandelbulber_missed_de_percent gauge\n";
+	out << "mandelbulber_missed_de_percent " << object["missedDEPercent"].toDouble() << "\n";
+	out << "# TYPE mandelbulber_de_evaluations_per_ray gauge\n";
+	out << "mandelbulber_de_evaluations_per_ray " << object["deEvaluationsPerRay"].toDouble() << "\n";
+	out << "# TYPE mandelbulber_background_rays_percent gauge\n";
+	out << "mandelbulber_background_rays_percent " << object["backgroundRaysPercent"].toDouble()
+			<< "\n";
+	out << "# TYPE mandelbulber_memory_used_megabytes gauge\n";
+	out << "mandelbulber_memory_used_megabytes " << object["memoryMB"].toInt() << "\n";
+
+	const QJsonArray devices = object["openClDevices"].toArray();
+	if (!devices.isEmpty())
+	{
+		out << "# TYPE mandelbulber_opencl_device_pixels_per_second gauge\n";
+		for (const QJsonValue &device : devices)
+		{
+			QString name = device.toObject()["name"].toString();
+			name.replace("\\", "\\\\").replace("\"", "\\\"");
+			out << "mandelbulber_opencl_device_pixels_per_second{device=\""
+					<< device.toObject()["index"].toInt() << "\",name=\"" << name << "\"} "
+					<< device.toObject()["pixelsPerSecond"].toDouble() << "\n";
+		}
+	}
+
+	const QJsonObject netRender = object["netRender"].toObject();
+	if (netRender["role"].toString() == "server")
+	{
+		// number of clients in each state
+		QMap<QString, int> clientsByStatus;
+		for (const QJsonValue &client : netRender["clients"].toArray())
+			clientsByStatus[client.toObject()["status"].toString()]++;
+
+		out << "# TYPE mandelbulber_netrender_clients gauge\n";
+		for (auto it = clientsByStatus.constBegin(); it != clientsByStatus.constEnd(); ++it)
+			out << "mandelbulber_netrender_clients{status=\"" << it.key() << "\"} " << it.value() << "\n";
+	}
+	else if (netRender["role"].toString() == "client")
+	{
+		out << "# TYPE mandelbulber_netrender_client_status gauge\n";
+		out << "mandelbulber_netrender_client_status{status=\"" << netRender["status"].toString()
+				<< "\"} 1\n";
+	}
+	out.flush();
+
+	// QSaveFile replaces the file atomically, so the collector never reads a partial file
+	QSaveFile file(prometheusFile);
+	if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		file.write(text.toUtf8());
+		file.commit();
+	}
+}
+
+QString cProgressMetrics::NetRenderStatusName(int status)
+{
+	switch (netRenderStatus(status))
+	{
+		case netRenderSts_DISABLED: return "disabled";
+		case netRenderSts_READY: return "ready";
+		case netRenderSts_WORKING: return "working";
+		case netRenderSts_NEW: return "new";
+		case netRenderSts_CONNECTING: return "connecting";
+		case netRenderSts_ERROR: return "error";
+	}
+	return "unknown";
+}
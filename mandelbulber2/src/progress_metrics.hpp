@@ -0,0 +1,92 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cProgressMetrics - machine-readable progress and statistics for headless rendering
+ *
+ * Progress and statistics updates of cHeadless are emitted as JSON lines on stdout (one object
+ * per update) and/or written to a Prometheus textfile (node_exporter textfile collector format).
+ * The textfile is replaced atomically and not more often than once per second.
+ */
+
+#ifndef MANDELBULBER2_SRC_PROGRESS_METRICS_HPP_
+#define MANDELBULBER2_SRC_PROGRESS_METRICS_HPP_
+
+#include <memory>
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QString>
+
+#include "progress_text.hpp"
+#include "statistics.h"
+
+// forward declarations
+class cImage;
+
+class cProgressMetrics
+{
+public:
+	static void EnableJsonLines() { jsonLines = true; }
+	static void EnablePrometheusFile(const QString &fileName) { prometheusFile = fileName; }
+	static bool IsEnabled() { return jsonLines || !prometheusFile.isEmpty(); }
+	static bool IsJsonLinesEnabled() { return jsonLines; }
+
+	// image used to report memory usage
+	static void SetImage(std::shared_ptr<const cImage> _image) { image = _image; }
+
+	static void UpdateProgress(const QString &text, const QString &progressText, double progress,
+		cProgressText::enumProgressType progressType);
+	static void UpdateStatistics(const cStatistics &stat);
+	static void ReportSavedFile(const QString &fileName);
+
+private:
+	struct sProgress
+	{
+		QString text;
+		double progress = 0.0;
+		double eta = -1.0; // [s]
+		QElapsedTimer timer;
+	};
+
+	static QJsonObject CreateJsonObject(const QString &event);
+	static void WriteJsonLine(const QJsonObject &object);
+	static void WritePrometheusFile(bool force);
+	static QString NetRenderStatusName(int status);
+
+	static bool jsonLines;
+	static QString prometheusFile;
+	static std::weak_ptr<const cImage> image;
+	static sProgress progress[3]; // image, animation, queue
+	static cStatistics lastStatistics;
+	static QElapsedTimer prometheusTimer;
+};
+
+#endif /* MANDELBULBER2_SRC_PROGRESS_METRICS_HPP_ */
@@ -0,0 +1,208 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cRenderCheckpoint - saves completed image lines of long still renders to disk, so rendering
+ * can be continued after the program was stopped or crashed
+ */
+
+#include "render_checkpoint.hpp"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+
+#include "cimage.hpp"
+#include "render_trace.hpp"
+#include "system_directories.hpp"
+#include "write_log.hpp"
+
+namespace
+{
+const quint32 checkpointMagic = 0x4d42434b; // "MBCK"
+const qint32 checkpointVersion = 1;
+} // namespace
+
+cRenderCheckpointWriter::cRenderCheckpointWriter(
+	const QString &_fileName, const QByteArray &_header)
+		: QObject()
+{
+	fileName = _fileName;
+	header = _header;
+}
+
+cRenderCheckpointWriter::~cRenderCheckpointWriter()
+{
+	// nothing to delete
+}
+
+void cRenderCheckpointWriter::slotWriteLines(QList<int> lineNumbers, QList<QByteArray> lines)
+{
+	cTraceSpan traceSpan("checkpoint write", "io", lineNumbers.size());
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		qCritical() << "Cannot write render checkpoint" << fileName << file.errorString();
+		return;
+	}
+	if (file.size() == 0) file.write(header);
+
+	QByteArray chunk;
+	QDataStream stream(&chunk, QIODevice::WriteOnly);
+	for (int i = 0; i < lineNumbers.size(); i++)
+	{
+		stream << qint32(lineNumbers.at(i));
+		stream.writeRawData(lines.at(i).constData(), lines.at(i).size());
+	}
+
+	// one write per chunk, so only the last record can be incomplete after crash
+	file.write(chunk);
+	file.flush();
+	file.close();
+}
+
+cRenderCheckpoint::cRenderCheckpoint(
+	const QString &settingsHash, int _width, int _height, double _interval)
+		: QObject()
+{
+	width = _width;
+	height = _height;
+	interval = _interval;
+	lineSize = int(sizeof(sAllImageData)) * width;
+	savedLines.resize(size_t(height), false);
+
+	fileName = systemDirectories.GetCheckpointsFolder() + QDir::separator() + settingsHash
+						 + QString("_%1x%2.checkpoint").arg(width).arg(height);
+
+	QDataStream stream(&header, QIODevice::WriteOnly);
+	stream << checkpointMagic << checkpointVersion << settingsHash << qint32(width) << qint32(height)
+				 << qint32(lineSize);
+
+	writer = new cRenderCheckpointWriter(fileName, header);
+	writer->moveToThread(&writerThread);
+	connect(&writerThread, SIGNAL(finished()), writer, SLOT(deleteLater()));
+	connect(this, SIGNAL(writeLines(QList<int>, QList<QByteArray>)), writer,
+		SLOT(slotWriteLines(QList<int>, QList<QByteArray>)));
+	writerThread.setObjectName("RenderCheckpoint");
+	writerThread.start(QThread::LowPriority);
+
+	timer.start();
+}
+
+cRenderCheckpoint::~cRenderCheckpoint()
+{
+	StopWriter();
+}
+
+void cRenderCheckpoint::StopWriter()
+{
+	// pending lines are written before thread finishes
+	if (writerThread.isRunning())
+	{
+		writerThread.quit();
+		writerThread.wait();
+	}
+}
+
+bool cRenderCheckpoint::Load(QList<int> *lineNumbers, QList<QByteArray> *lines)
+{
+	QFile file(fileName);
+	if (!file.exists()) return false;
+
+	cTraceSpan traceSpan("checkpoint load", "io");
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qCritical() << "Cannot read render checkpoint" << fileName << file.errorString();
+		return false;
+	}
+
+	if (file.read(header.size()) != header)
+	{
+		WriteLogString("Render checkpoint doesn't match settings, deleted", fileName, 2);
+		file.close();
+		file.remove();
+		return false;
+	}
+
+	QDataStream stream(&file);
+	const int recordSize = int(sizeof(qint32)) + lineSize;
+	while (file.bytesAvailable() >= recordSize)
+	{
+		qint32 line;
+		stream >> line;
+		QByteArray lineData(lineSize, Qt::Uninitialized);
+		stream.readRawData(lineData.data(), lineSize);
+		if (line < 0 || line >= height) break;
+
+		if (!savedLines[size_t(line)])
+		{
+			savedLines[size_t(line)] = true;
+			lineNumbers->append(line);
+			lines->append(lineData);
+		}
+	}
+	file.close();
+
+	WriteLogInt("Render resumed from checkpoint, lines", lineNumbers->size(), 1);
+	return !lineNumbers->isEmpty();
+}
+
+bool cRenderCheckpoint::IsTimeToSave() const
+{
+	return timer.elapsed() > interval * 1000.0;
+}
+
+bool cRenderCheckpoint::IsLineSaved(int line) const
+{
+	return line >= 0 && line < height && savedLines[size_t(line)];
+}
+
+void cRenderCheckpoint::SaveLines(const QList<int> &lineNumbers, const QList<QByteArray> &lines)
+{
+	timer.restart();
+	if (lineNumbers.isEmpty()) return;
+
+	for (int line : lineNumbers)
+		savedLines[size_t(line)] = true;
+
+	emit writeLines(lineNumbers, lines);
+}
+
+void cRenderCheckpoint::Remove()
+{
+	StopWriter();
+	if (QFile::exists(fileName))
+	{
+		QFile::remove(fileName);
+	}
+}
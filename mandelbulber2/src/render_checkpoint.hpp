@@ -0,0 +1,101 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cRenderCheckpoint - saves completed image lines of long still renders to disk, so rendering
+ * can be continued after the program was stopped or crashed
+ *
+ * Checkpoint file is a header followed by records of line number and raw line data. Records are
+ * only appended, so a file cut during writing still contains all earlier records.
+ */
+
+#ifndef MANDELBULBER2_SRC_RENDER_CHECKPOINT_HPP_
+#define MANDELBULBER2_SRC_RENDER_CHECKPOINT_HPP_
+
+#include <vector>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QThread>
+
+// appends lines to checkpoint file. Lives in background thread
+class cRenderCheckpointWriter : public QObject
+{
+	Q_OBJECT
+public:
+	cRenderCheckpointWriter(const QString &_fileName, const QByteArray &_header);
+	~cRenderCheckpointWriter() override;
+
+public slots:
+	void slotWriteLines(QList<int> lineNumbers, QList<QByteArray> lines);
+
+private:
+	QString fileName;
+	QByteArray header;
+};
+
+class cRenderCheckpoint : public QObject
+{
+	Q_OBJECT
+public:
+	cRenderCheckpoint(const QString &settingsHash, int _width, int _height, double _interval);
+	~cRenderCheckpoint() override;
+
+	// reads lines saved by earlier render of the same settings. Invalid file is deleted
+	bool Load(QList<int> *lineNumbers, QList<QByteArray> *lines);
+	bool IsTimeToSave() const;
+	bool IsLineSaved(int line) const;
+	// lines are written in background thread
+	void SaveLines(const QList<int> &lineNumbers, const QList<QByteArray> &lines);
+	// deletes checkpoint file when image is completed
+	void Remove();
+	QString GetFileName() const { return fileName; }
+
+private:
+	void StopWriter();
+
+	QString fileName;
+	QByteArray header;
+	int width;
+	int height;
+	int lineSize;
+	double interval;
+	std::vector<bool> savedLines;
+	QElapsedTimer timer;
+	QThread writerThread;
+	cRenderCheckpointWriter *writer;
+
+signals:
+	void writeLines(QList<int> lineNumbers, QList<QByteArray> lines);
+};
+
+#endif /* MANDELBULBER2_SRC_RENDER_CHECKPOINT_HPP_ */
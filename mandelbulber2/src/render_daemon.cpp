@@ -0,0 +1,332 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cRenderDaemon - long running headless process which renders jobs received over a local socket
+ */
+
+#include "render_daemon.hpp"
+
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTextStream>
+#include <QTimer>
+
+#include "animation_frames.hpp"
+#include "error_message.hpp"
+#include "file_image.hpp"
+#include "fractal_container.hpp"
+#include "headless.h"
+#include "initparameters.hpp"
+#include "interface.hpp"
+#include "keyframes.hpp"
+#include "settings.hpp"
+#include "system_data.hpp"
+#include "texture.hpp"
+#include "write_log.hpp"
+
+cRenderDaemon *gRenderDaemon = nullptr;
+
+cRenderDaemon::cRenderDaemon(cHeadless *_headless, QObject *parent) : QObject(parent)
+{
+	headless = _headless;
+	server = new QLocalServer(this);
+	actualJobId = 0;
+	jobCounter = 0;
+	busy = false;
+	quitRequest = false;
+
+	// decoded textures are reused by next jobs
+	cTexture::EnableCache(true);
+
+	connect(server, &QLocalServer::newConnection, this, &cRenderDaemon::slotNewConnection);
+}
+
+cRenderDaemon::~cRenderDaemon()
+{
+	cTexture::EnableCache(false);
+}
+
+bool cRenderDaemon::Listen(const QString &socketName)
+{
+	// remove socket file which could stay after crashed daemon
+	QLocalServer::removeServer(socketName);
+
+	if (!server->listen(socketName))
+	{
+		cErrorMessage::showMessage(
+			QObject::tr("Cannot start render daemon on socket %1: %2")
+				.arg(socketName, server->errorString()),
+			cErrorMessage::errorMessage);
+		return false;
+	}
+
+	QTextStream out(stdout);
+	out << tr("Render daemon is waiting for jobs on socket: %1\n").arg(server->fullServerName());
+	out.flush();
+	WriteLogString("Render daemon listening", server->fullServerName(), 2);
+	return true;
+}
+
+void cRenderDaemon::slotNewConnection()
+{
+	while (server->hasPendingConnections())
+	{
+		QLocalSocket *client = server->nextPendingConnection();
+		inputBuffers.insert(client, QByteArray());
+		connect(client, &QLocalSocket::readyRead, this, &cRenderDaemon::slotReadyRead);
+		connect(client, &QLocalSocket::disconnected, this, [this, client]() {
+			inputBuffers.remove(client);
+			client->deleteLater();
+		});
+		WriteLog("Render daemon: new client connected", 2);
+	}
+}
+
+void cRenderDaemon::slotReadyRead()
+{
+	QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+	if (client) ParseInput(client);
+}
+
+void cRenderDaemon::ParseInput(QLocalSocket *client)
+{
+	QByteArray &buffer = inputBuffers[client];
+	buffer.append(client->readAll());
+
+	while (true)
+	{
+		int endOfLine = buffer.indexOf('\n');
+		if (endOfLine < 0) return;
+
+		QString line = QString::fromUtf8(buffer.left(endOfLine)).trimmed();
+		QStringList fields = line.split(' ');
+
+		if (fields.first() == "JOB")
+		{
+			bool lengthOk = false;
+			int length = (fields.size() >= 4) ? fields[3].toInt(&lengthOk) : 0;
+			if (!lengthOk || length < 0)
+			{
+				buffer.remove(0, endOfLine + 1);
+				Send(client, "ERROR 0 wrong JOB header, expected: JOB <type> <format> <length> [<output>]");
+				continue;
+			}
+
+			// wait for whole settings text
+			if (buffer.size() < endOfLine + 1 + length) return;
+
+			sJob job;
+			job.client = client;
+			job.id = ++jobCounter;
+			job.type = fields[1];
+			job.format = fields[2];
+			job.output = QStringList(fields.mid(4)).join(' ');
+			job.settingsText = QString::fromUtf8(buffer.mid(endOfLine + 1, length));
+			buffer.remove(0, endOfLine + 1 + length);
+
+			jobs.append(job);
+			Send(client, QString("ACCEPTED %1").arg(job.id));
+			QTimer::singleShot(0, this, &cRenderDaemon::slotProcessNextJob);
+		}
+		else
+		{
+			buffer.remove(0, endOfLine + 1);
+			if (line == "STOP")
+			{
+				if (busy && actualClient == client) gMainInterface->stopRequest = true;
+			}
+			else if (line == "QUIT")
+			{
+				quitRequest = true;
+				QTimer::singleShot(0, this, &cRenderDaemon::slotProcessNextJob);
+			}
+			else if (!line.isEmpty())
+			{
+				Send(client, QString("ERROR 0 unknown command: %1").arg(line));
+			}
+		}
+	}
+}
+
+void cRenderDaemon::slotProcessNextJob()
+{
+	// rendering processes events, so this slot can be called again during the job
+	if (busy) return;
+
+	if (quitRequest)
+	{
+		emit finished();
+		return;
+	}
+
+	if (jobs.isEmpty()) return;
+
+	busy = true;
+	sJob job = jobs.takeFirst();
+	if (job.client) ProcessJob(job);
+	busy = false;
+
+	if (!jobs.isEmpty() || quitRequest)
+		QTimer::singleShot(0, this, &cRenderDaemon::slotProcessNextJob);
+}
+
+bool cRenderDaemon::LoadSettings(const sJob &job)
+{
+	cSettings parSettings(cSettings::formatFullText);
+	parSettings.BeQuiet(true);
+	if (!parSettings.LoadFromString(job.settingsText)) return false;
+	if (!parSettings.Decode(gPar, gParFractal, gAnimFrames, gKeyframes)) return false;
+	systemData.lastSettingsFile = QString("daemon job %1").arg(job.id);
+	return true;
+}
+
+void cRenderDaemon::ProcessJob(const sJob &job)
+{
+	actualClient = job.client;
+	actualJobId = job.id;
+	gMainInterface->stopRequest = false;
+
+	WriteLogString("Render daemon: processing job", job.type, 2);
+
+	if (!LoadSettings(job))
+	{
+		Send(job.client, QString("ERROR %1 cannot decode settings").arg(job.id));
+	}
+	else if (job.type == "still")
+	{
+		QStringList allowedImageFileFormat({"jpg", "png", "png16", "png16alpha", "exr", "tiff"});
+		QString format = (job.format == "-") ? QString("jpg") : job.format;
+		if (allowedImageFileFormat.contains(format))
+		{
+			QString output = job.output;
+			if (output.isEmpty())
+			{
+				output = gPar->Get<QString>("default_image_path") + QDir::separator()
+								 + QString("daemon_job_%1").arg(job.id);
+			}
+			QString savedFile = headless->RenderStillImage(output, format);
+			Send(job.client, QString("RESULT %1 %2").arg(job.id).arg(savedFile));
+		}
+		else
+		{
+			Send(job.client, QString("ERROR %1 image format is not valid, allowed formats are: %2")
+												 .arg(job.id)
+												 .arg(allowedImageFileFormat.join(", ")));
+		}
+	}
+	else if (job.type == "voxel")
+	{
+		QStringList allowedVoxelFormat({"ply", "slice", "volume"});
+		QString format = (job.format == "-") ? QString("slice") : job.format;
+		QString resultPath;
+		if (format == "ply")
+		{
+			if (!job.output.isEmpty()) gPar->Set("mesh_output_filename", job.output);
+			resultPath = gPar->Get<QString>("mesh_output_filename");
+		}
+		else
+		{
+			if (!job.output.isEmpty()) gPar->Set("voxel_image_path", job.output);
+			resultPath = gPar->Get<QString>("voxel_image_path");
+		}
+
+		if (!allowedVoxelFormat.contains(format))
+		{
+			Send(job.client, QString("ERROR %1 voxel format is not valid, allowed formats are: %2")
+												 .arg(job.id)
+												 .arg(allowedVoxelFormat.join(", ")));
+		}
+		else if (format != "ply" && !QDir(resultPath).exists())
+		{
+			Send(job.client, QString("ERROR %1 folder %2 does not exist").arg(job.id).arg(resultPath));
+		}
+		else
+		{
+			headless->RenderVoxel(format);
+			Send(job.client, QString("RESULT %1 %2").arg(job.id).arg(resultPath));
+		}
+	}
+	else if (job.type == "flight" || job.type == "keyframe")
+	{
+		bool flight = (job.type == "flight");
+		int numberOfFrames =
+			flight ? gAnimFrames->GetNumberOfFrames() : gKeyframes->GetNumberOfFrames();
+		QString dirParameter = flight ? "anim_flight_dir" : "anim_keyframe_dir";
+
+		if (!job.output.isEmpty()) gPar->Set(dirParameter, job.output);
+		if (job.format != "-")
+		{
+			int fileType = int(ImageFileSave::ImageFileType(job.format));
+			gPar->Set(flight ? "flight_animation_image_type" : "keyframe_animation_image_type", fileType);
+		}
+
+		if (numberOfFrames == 0)
+		{
+			Send(job.client, QString("ERROR %1 there are no animation frames in settings").arg(job.id));
+		}
+		else
+		{
+			if (flight)
+				headless->RenderFlightAnimation();
+			else
+				headless->RenderKeyframeAnimation();
+			Send(job.client, QString("RESULT %1 %2").arg(job.id).arg(gPar->Get<QString>(dirParameter)));
+		}
+	}
+	else
+	{
+		Send(job.client, QString("ERROR %1 unknown job type: %2").arg(job.id).arg(job.type));
+	}
+
+	if (gMainInterface->stopRequest)
+		Send(job.client, QString("ERROR %1 job was stopped").arg(job.id));
+
+	Send(job.client, QString("FINISHED %1").arg(job.id));
+	actualClient = nullptr;
+	actualJobId = 0;
+}
+
+void cRenderDaemon::SendProgress(const QString &text, const QString &progressText, double progress)
+{
+	if (!actualClient) return;
+	Send(actualClient, QString("PROGRESS %1 %2 %3: %4")
+											 .arg(actualJobId)
+											 .arg(progress, 0, 'f', 4)
+											 .arg(text, progressText));
+}
+
+void cRenderDaemon::Send(QLocalSocket *client, const QString &line)
+{
+	if (!client || client->state() != QLocalSocket::ConnectedState) return;
+	client->write((line + "\n").toUtf8());
+	client->flush();
+}
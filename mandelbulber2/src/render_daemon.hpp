@@ -0,0 +1,115 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cRenderDaemon - long running headless process which renders jobs received over a local socket
+ *
+ * The daemon is started with --daemon and keeps the process with initialized parameters,
+ * registered formulas, OpenCL devices and compiled kernels, and cached textures between jobs.
+ * Clients connect to a QLocalServer (Unix domain socket or Windows named pipe) with name from
+ * "daemon_socket_name" parameter. The protocol is line based (UTF-8):
+ *
+ * client -> daemon
+ *   JOB <type> <format> <length> [<output>]  followed by <length> bytes of settings text
+ *       type: still | voxel | flight | keyframe
+ *       format: image format (still, animation) or voxel format (slice, ply, volume)
+ *       output: image file without extension (still), folder (voxel slice/volume, animation)
+ *               or mesh file (voxel ply)
+ *   STOP   stops actual job
+ *   QUIT   finishes the daemon
+ *
+ * daemon -> client
+ *   ACCEPTED <id>, PROGRESS <id> <0..1> <text>, RESULT <id> <path>, ERROR <id> <message>,
+ *   FINISHED <id>
+ */
+
+#ifndef MANDELBULBER2_SRC_RENDER_DAEMON_HPP_
+#define MANDELBULBER2_SRC_RENDER_DAEMON_HPP_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+// forward declarations
+class cHeadless;
+class QLocalServer;
+class QLocalSocket;
+
+class cRenderDaemon : public QObject
+{
+	Q_OBJECT
+public:
+	cRenderDaemon(cHeadless *headless, QObject *parent);
+	~cRenderDaemon() override;
+
+	bool Listen(const QString &socketName);
+	void SendProgress(const QString &text, const QString &progressText, double progress);
+
+private:
+	struct sJob
+	{
+		QPointer<QLocalSocket> client;
+		int id;
+		QString type;
+		QString format;
+		QString output;
+		QString settingsText;
+	};
+
+	void ParseInput(QLocalSocket *client);
+	void ProcessJob(const sJob &job);
+	bool LoadSettings(const sJob &job);
+	void Send(QLocalSocket *client, const QString &line);
+
+	cHeadless *headless;
+	QLocalServer *server;
+	QList<sJob> jobs;
+	QHash<QLocalSocket *, QByteArray> inputBuffers;
+	QPointer<QLocalSocket> actualClient;
+	int actualJobId;
+	int jobCounter;
+	bool busy;
+	bool quitRequest;
+
+private slots:
+	void slotNewConnection();
+	void slotReadyRead();
+	void slotProcessNextJob();
+
+signals:
+	void finished();
+};
+
+extern cRenderDaemon *gRenderDaemon;
+
+#endif /* MANDELBULBER2_SRC_RENDER_DAEMON_HPP_ */
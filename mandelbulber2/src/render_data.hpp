@@ -40,6 +40,7 @@
 
 #include "lights.hpp"
 #include "material.h"
+#include "material_table.hpp"
 #include "object_data.hpp"
 #include "region.hpp"
 #include "rendering_configuration.hpp"
@@ -47,6 +48,13 @@
 #include "stereo.h"
 #include "texture.hpp"
 
+class cAutoBounds;
+class cConeMarchPrepass;
+class cGeometryBuffer;
+class cIrradianceCache;
+class cRenderCheckpoint;
+class cReprojectionCache;
+
 struct sTextures
 {
 	cTexture backgroundTexture;
@@ -80,8 +88,27 @@ struct sRenderData
 
 	std::map<int, cMaterial> materials; // 'int' is an ID
 	QVector<cObjectData> objectData;
+	cMaterialTable materialTable; // materials indexed by object id, compiled by ValidateObjects()
 	cStereo stereo;
 
+	// start distances for primary rays reprojected from previous animation frame
+	std::shared_ptr<cReprojectionCache> reprojectionCache;
+
+	// start distances for primary rays found by cone-marching of image tiles
+	std::shared_ptr<cConeMarchPrepass> coneMarchPrepass;
+
+	// automatically estimated bounding boxes of objects
+	std::shared_ptr<const cAutoBounds> autoBounds;
+
+	// primary ray hits from previous render used when only shading parameters changed
+	std::shared_ptr<cGeometryBuffer> geometryBuffer;
+
+	// global illumination samples shared by all render threads
+	std::shared_ptr<cIrradianceCache> irradianceCache;
+
+	// completed lines saved to disk to continue interrupted render
+	std::shared_ptr<cRenderCheckpoint> checkpoint;
+
 	void ValidateObjects()
 	{
 		for (cObjectData &object : objectData)
@@ -110,6 +137,8 @@ struct sRenderData
 				object.materialId = substituteMaterialId;
 			}
 		}
+
+		materialTable.Compile(materials, objectData);
 	}
 };
 
@@ -43,8 +43,10 @@
 #include "fractparams.hpp"
 #include "global_data.hpp"
 #include "netrender.hpp"
+#include "post_effect_denoiser.h"
 #include "post_effect_hdr_blur.h"
 #include "progress_text.hpp"
+#include "render_checkpoint.hpp"
 #include "render_data.hpp"
 #include "render_ssao.h"
 #include "render_worker.hpp"
@@ -341,6 +343,16 @@ void cRenderer::RenderDOF()
 	}
 }
 
+void cRenderer::RenderDenoiser()
+{
+	std::unique_ptr<cPostEffectDenoiser> denoiser(new cPostEffectDenoiser(image));
+	denoiser->SetParameters(params->denoiserStrength, params->denoiserIterations, true);
+	connect(denoiser.get(),
+		SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
+		SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
+	denoiser->Render(data->stopRequest);
+}
+
 void cRenderer::RenderHDRBlur()
 {
 	std::unique_ptr<cPostEffectHdrBlur> hdrBlur(new cPostEffectHdrBlur(image));
@@ -371,8 +383,22 @@ bool cRenderer::RenderImage()
 			data->configuration.GetNumberOfThreads());
 		std::vector<cRenderWorker *> workers(data->configuration.GetNumberOfThreads());
 
+		// lines saved by interrupted render of the same settings
+		QList<int> checkpointLines;
+		QList<QByteArray> checkpointData;
+		if (data->checkpoint && data->checkpoint->Load(&checkpointLines, &checkpointData))
+		{
+			progressive = 1; // resumed image is rendered in one pass
+		}
+
 		scheduler.reset(new cScheduler(data->screenRegion, progressive));
 
+		if (!checkpointLines.isEmpty())
+		{
+			NewLinesArrived(checkpointLines, checkpointData);
+			scheduler->MarkReceivedLines(checkpointLines);
+		}
+
 		InitializeThreadData(threadsData);
 
 		QString statusText;
@@ -452,6 +478,8 @@ bool cRenderer::RenderImage()
 						listToRefresh.clear();
 					} // timerRefresh
 				}		// isPreview
+
+				SaveCheckpoint(false);
 			}			// while scheduler
 
 			for (int i = 0; i < data->configuration.GetNumberOfThreads(); i++)
@@ -465,6 +493,15 @@ bool cRenderer::RenderImage()
 			}
 		} while (scheduler->ProgressiveNextStep());
 
+		if (data->checkpoint)
+		{
+			// checkpoint is kept only when rendering was interrupted
+			if (*data->stopRequest || systemData.globalStopRequest)
+				SaveCheckpoint(true);
+			else
+				data->checkpoint->Remove();
+		}
+
 		// send last rendered lines
 		SendRenderedLinesToNetRenderAfterRendering(listToSend);
 
@@ -482,6 +519,10 @@ bool cRenderer::RenderImage()
 		if (!((gNetRender->IsClient() && !gNetRender->IsAnimation())
 					&& data->configuration.UseNetRender()))
 		{
+			if (params->denoiserEnabled && !*data->stopRequest && !systemData.globalStopRequest)
+			{
+				RenderDenoiser();
+			}
 			if (params->ambientOcclusionEnabled
 					&& params->ambientOcclusionMode == params::AOModeScreenSpace)
 			{
@@ -582,6 +623,27 @@ void cRenderer::CreateLineData(int y, QByteArray *lineData) const
 	}
 }
 
+void cRenderer::SaveCheckpoint(bool force)
+{
+	// lines of progressive passes are not final
+	if (!data->checkpoint || scheduler->GetProgressiveStep() > 1) return;
+	if (!force && !data->checkpoint->IsTimeToSave()) return;
+
+	QList<int> lineNumbers;
+	QList<QByteArray> lines;
+	for (int line : scheduler->CreateDoneList())
+	{
+		if (data->checkpoint->IsLineSaved(line)) continue;
+		QByteArray lineData;
+		CreateLineData(line, &lineData);
+		lineNumbers.append(line);
+		lines.append(lineData);
+	}
+
+	// only copying of lines is done here, writing to disk is done in background thread
+	data->checkpoint->SaveLines(lineNumbers, lines);
+}
+
 void cRenderer::NewLinesArrived(QList<int> lineNumbers, QList<QByteArray> lines) const
 {
 	for (int i = 0; i < lineNumbers.size(); i++)
@@ -75,8 +75,10 @@ private:
 	void SendRenderedLinesToNetRender(QList<int> &listToSend);
 	void UpdateNetRenderToDoList();
 	void SendRenderedLinesToNetRenderAfterRendering(QList<int> listToSend);
+	void SaveCheckpoint(bool force);
 	void RenderSSAO();
 	void RenderDOF();
+	void RenderDenoiser();
 	void RenderHDRBlur();
 
 	std::shared_ptr<const sParamRender> params;
@@ -39,21 +39,31 @@
 #include <QWidget>
 
 #include "ao_modes.h"
+#include "auto_bounds.hpp"
 #include "cimage.hpp"
+#include "cone_march_prepass.hpp"
 #include "fractparams.hpp"
+#include "geometry_buffer.hpp"
 #include "global_data.hpp"
 #include "image_scale.hpp"
+#include "irradiance_cache.hpp"
 #include "netrender.hpp"
 #include "nine_fractals.hpp"
+#include "opencl_engine_render_denoiser.h"
 #include "opencl_engine_render_dof.h"
 #include "opencl_engine_render_fractal.h"
 #include "opencl_engine_render_ssao.h"
 #include "opencl_global.h"
+#include "post_effect_denoiser.h"
 #include "progress_text.hpp"
+#include "render_checkpoint.hpp"
 #include "render_data.hpp"
 #include "render_image.hpp"
 #include "render_ssao.h"
+#include "render_trace.hpp"
 #include "rendering_configuration.hpp"
+#include "reprojection_cache.hpp"
+#include "settings.hpp"
 #include "stereo.h"
 #include "system_data.hpp"
 #include "write_log.hpp"
@@ -103,7 +113,7 @@ cRenderJob::cRenderJob(const std::shared_ptr<cParameterContainer> _params,
 	// qDebug() << "Id" << id;
 }
 int cRenderJob::id = 0;
-int cRenderJob::runningJobs = 0;
+std::atomic<int> cRenderJob::runningJobs(0);
 
 cRenderJob::~cRenderJob()
 {
@@ -117,6 +127,7 @@ cRenderJob::~cRenderJob()
 
 bool cRenderJob::Init(enumMode _mode, const cRenderingConfiguration &config)
 {
+	cTraceSpan traceSpan("cRenderJob::Init", "render");
 	WriteLog("cRenderJob::Init id = " + QString::number(id), 2);
 
 	mode = _mode;
@@ -153,6 +164,14 @@ bool cRenderJob::Init(enumMode _mode, const cRenderingConfiguration &config)
 	imageOptional.optionalWorld = paramsContainer->Get<bool>("world_enabled");
 	imageOptional.optionalDiffuse = paramsContainer->Get<bool>("diffuse_enabled");
 
+	// normal vectors, world positions and diffuse colours are used by denoiser to preserve edges
+	if (paramsContainer->Get<bool>("denoiser_enabled"))
+	{
+		imageOptional.optionalNormalWorld = true;
+		imageOptional.optionalWorld = true;
+		imageOptional.optionalDiffuse = true;
+	}
+
 	emit updateProgressAndStatus(
 		QObject::tr("Initialization"), QObject::tr("Setting up image buffers"), 0.0);
 	// gApplication->processEvents();
@@ -231,6 +250,7 @@ bool cRenderJob::InitImage(int w, int h, const sImageOptional &optional)
 
 void cRenderJob::LoadTextures(int frameNo, const cRenderingConfiguration &config)
 {
+	cTraceSpan traceSpan("LoadTextures", "texture");
 	//	if (gNetRender->IsClient() && renderData->configuration.UseNetRender())
 	//	{
 	//		// get received textures from NetRender buffer
@@ -270,6 +290,7 @@ void cRenderJob::LoadTextures(int frameNo, const cRenderingConfiguration &config
 
 void cRenderJob::PrepareData()
 {
+	cTraceSpan traceSpan("cRenderJob::PrepareData", "render");
 	WriteLog("Init renderData", 2);
 	renderData->rendererID = id;
 
@@ -331,6 +352,7 @@ void cRenderJob::PrepareData()
 
 bool cRenderJob::Execute()
 {
+	cTraceSpan traceSpan("cRenderJob::Execute", "render");
 	image->BlockImage();
 
 	runningJobs++;
@@ -372,7 +394,8 @@ bool cRenderJob::Execute()
 			// move parameters from containers to structures
 			std::shared_ptr<sParamRender> params(
 				new sParamRender(paramsContainer, &renderData->objectData));
-			std::shared_ptr<cNineFractals> fractals(new cNineFractals(fractalContainer, paramsContainer));
+			std::shared_ptr<cNineFractals> fractals(
+				new cNineFractals(fractalContainer, paramsContainer, true));
 
 			renderData->ValidateObjects();
 
@@ -388,6 +411,26 @@ bool cRenderJob::Execute()
 			renderData->statistics.Reset();
 			renderData->statistics.usedDEType = fractals->GetDETypeString();
 
+			bool useReprojection = reprojectionCache && noOfRepeats == 1
+														 && cReprojectionCache::IsApplicable(*params, *renderData);
+			if (useReprojection)
+			{
+				reprojectionCache->Prepare(
+					*params, *renderData, int(image->GetWidth()), int(image->GetHeight()));
+				renderData->reprojectionCache = reprojectionCache;
+			}
+			else
+			{
+				if (reprojectionCache) reprojectionCache->Clear();
+				renderData->reprojectionCache.reset();
+			}
+
+			PrepareGeometryBuffer(*params);
+			PrepareAutoBounds(*params, *fractals);
+			PrepareConeMarchPrepass(*params, *fractals);
+			PrepareCheckpoint(noOfRepeats);
+			PrepareIrradianceCache(*params);
+
 			// create and execute renderer
 			std::unique_ptr<cRenderer> renderer(new cRenderer(params, fractals, renderData, image));
 
@@ -400,6 +443,15 @@ bool cRenderJob::Execute()
 
 			result = renderer->RenderImage();
 
+			if (renderData->irradianceCache)
+			{
+				WriteLogSizeT("Irradiance cache - number of records",
+					renderData->irradianceCache->GetNumberOfRecords(), 2);
+				renderData->irradianceCache.reset();
+			}
+
+			if (useReprojection && result) reprojectionCache->Store(*image, *params, *renderData);
+
 			if (twoPassStereo && repeat == 0) renderData->stereo.StoreImageInBuffer(image);
 		}
 	}
@@ -422,13 +474,30 @@ bool cRenderJob::Execute()
 			// move parameters from containers to structures
 			std::shared_ptr<sParamRender> params(
 				new sParamRender(paramsContainer, &renderData->objectData));
-			std::shared_ptr<cNineFractals> fractals(new cNineFractals(fractalContainer, paramsContainer));
+			std::shared_ptr<cNineFractals> fractals(
+				new cNineFractals(fractalContainer, paramsContainer, true));
 
 			renderData->ValidateObjects();
 
 			image->SetImageParameters(params->imageAdjustments);
 
 			InitStatistics(fractals.get());
+
+			// cone-marching pre-pass is implemented only in fast and full engines
+			cOpenClEngineRenderFractal::enumClRenderEngineMode clMode =
+				cOpenClEngineRenderFractal::enumClRenderEngineMode(
+					paramsContainer->Get<int>("opencl_mode"));
+			if (clMode == cOpenClEngineRenderFractal::clRenderEngineTypeFast
+					|| clMode == cOpenClEngineRenderFractal::clRenderEngineTypeFull)
+			{
+				params->resolution = 1.0 / image->GetHeight();
+				PrepareConeMarchPrepass(*params, *fractals);
+			}
+			else
+			{
+				renderData->coneMarchPrepass.reset();
+			}
+
 			emit updateStatistics(renderData->statistics);
 
 			image->SetFastPreview(true);
@@ -436,6 +505,8 @@ bool cRenderJob::Execute()
 			// render all with OpenCL
 			result = RenderFractalWithOpenCl(params, fractals, &progressText);
 
+			RenderDenoiserWithOpenCl(params, &progressText, &result);
+
 			if (renderData->stereo.isEnabled()
 					&& (renderData->stereo.GetMode() == cStereo::stereoLeftRight
 							|| renderData->stereo.GetMode() == cStereo::stereoTopBottom))
@@ -629,10 +700,115 @@ void cRenderJob::InitStatistics(const cNineFractals *fractals)
 	renderData->statistics.usedDEType = fractals->GetDETypeString();
 }
 
+void cRenderJob::PrepareGeometryBuffer(const sParamRender &params)
+{
+	renderData->geometryBuffer.reset();
+
+	if (!paramsContainer->Get<bool>("incremental_reshading"))
+	{
+		image->FreeGeometryBuffer();
+		return;
+	}
+
+	// buffer is kept in the image, so it survives between renders of the same image
+	if (!renderData->configuration.UseNetRender()
+			&& cGeometryBuffer::IsApplicable(params, *renderData))
+	{
+		std::shared_ptr<cGeometryBuffer> geometryBuffer = image->GetGeometryBuffer();
+		geometryBuffer->Prepare(
+			cGeometryBuffer::CalculateGeometryHash(*paramsContainer, *fractalContainer),
+			int(image->GetWidth()), int(image->GetHeight()));
+		renderData->geometryBuffer = geometryBuffer;
+	}
+}
+
+void cRenderJob::PrepareConeMarchPrepass(const sParamRender &params, const cNineFractals &fractals)
+{
+	renderData->coneMarchPrepass.reset();
+
+	// all primary rays will be taken from the geometry buffer
+	if (renderData->geometryBuffer && renderData->geometryBuffer->IsComplete()) return;
+
+	if (paramsContainer->Get<bool>("cone_march_prepass")
+			&& cConeMarchPrepass::IsApplicable(params, *renderData))
+	{
+		emit updateProgressAndStatus(
+			QObject::tr("Rendering image"), QObject::tr("Cone-marching pre-pass"), 0.0);
+
+		std::shared_ptr<cConeMarchPrepass> coneMarchPrepass(new cConeMarchPrepass());
+		if (coneMarchPrepass->Calculate(params, fractals, renderData.get(), int(image->GetWidth()),
+					int(image->GetHeight())))
+		{
+			renderData->coneMarchPrepass = coneMarchPrepass;
+		}
+	}
+}
+
+void cRenderJob::PrepareAutoBounds(const sParamRender &params, const cNineFractals &fractals)
+{
+	renderData->autoBounds.reset();
+
+	if (!paramsContainer->Get<bool>("auto_bounds_enabled")) return;
+
+	// bounds don't depend on camera, so they are calculated only once for animation
+	QByteArray boundsHash = cAutoBounds::CalculateBoundsHash(*paramsContainer, *fractalContainer);
+	std::shared_ptr<const cAutoBounds> autoBounds = cAutoBounds::GetCached(boundsHash);
+
+	if (!autoBounds)
+	{
+		emit updateProgressAndStatus(
+			QObject::tr("Rendering image"), QObject::tr("Estimation of object bounds"), 0.0);
+
+		std::shared_ptr<cAutoBounds> newAutoBounds(new cAutoBounds());
+		if (!newAutoBounds->Calculate(params, fractals, renderData.get(),
+					paramsContainer->Get<double>("limit_outer_bounding")))
+			return;
+
+		cAutoBounds::StoreInCache(boundsHash, newAutoBounds);
+		autoBounds = newAutoBounds;
+	}
+
+	renderData->autoBounds = autoBounds;
+}
+
+void cRenderJob::PrepareCheckpoint(int noOfRepeats)
+{
+	renderData->checkpoint.reset();
+
+	// only long still images are worth to resume. Animation frames are resumed by animation
+	// renderer and NetRender lines come from other computers
+	if (!paramsContainer->Get<bool>("checkpoint_enabled") || mode != still || noOfRepeats > 1
+			|| gNetRender->IsClient() || gNetRender->IsServer())
+		return;
+
+	// checkpoint is valid only for exactly the same settings
+	cSettings settings(cSettings::formatCondensedText);
+	settings.CreateText(paramsContainer, fractalContainer);
+
+	renderData->checkpoint.reset(new cRenderCheckpoint(settings.GetHashCode(),
+		int(image->GetWidth()), int(image->GetHeight()),
+		paramsContainer->Get<int>("checkpoint_interval")));
+}
+
+void cRenderJob::PrepareIrradianceCache(const sParamRender &params)
+{
+	renderData->irradianceCache.reset();
+
+	if (params.DOFMonteCarlo && params.DOFMonteCarloGlobalIllumination && params.monteCarloGICache)
+	{
+		// records are much sparser than pixels, also for reflected and refracted rays
+		quint64 maxNumberOfRecords = std::max(quint64(image->GetWidth()) * image->GetHeight() / 8,
+			quint64(65536));
+		renderData->irradianceCache.reset(
+			new cIrradianceCache(maxNumberOfRecords, params.monteCarloGICacheAccuracy));
+	}
+}
+
 #ifdef USE_OPENCL
 bool cRenderJob::RenderFractalWithOpenCl(std::shared_ptr<sParamRender> params,
 	std::shared_ptr<cNineFractals> fractals, cProgressText *progressText)
 {
+	cTraceSpan traceSpan("RenderFractalWithOpenCl", "opencl");
 	bool result = false;
 	connect(gOpenCl->openClEngineRenderFractal, SIGNAL(updateStatistics(cStatistics)), this,
 		SIGNAL(updateStatistics(cStatistics)), Qt::UniqueConnection);
@@ -672,6 +848,7 @@ bool cRenderJob::RenderFractalWithOpenCl(std::shared_ptr<sParamRender> params,
 void cRenderJob::RenderSSAOWithOpenCl(std::shared_ptr<sParamRender> params,
 	const cRegion<int> &region, cProgressText *progressText, bool *result)
 {
+	cTraceSpan traceSpan("RenderSSAOWithOpenCl", "opencl");
 	if (!*renderData->stopRequest && *result == true)
 	{
 		if (params->ambientOcclusionEnabled && params->ambientOcclusionMode == params::AOModeScreenSpace
@@ -738,8 +915,73 @@ void cRenderJob::RenderSSAOWithOpenCl(std::shared_ptr<sParamRender> params,
 	}
 }
 
+void cRenderJob::RenderDenoiserWithOpenCl(
+	std::shared_ptr<sParamRender> params, cProgressText *progressText, bool *result)
+{
+	cTraceSpan traceSpan("RenderDenoiserWithOpenCl", "opencl");
+	if (!*renderData->stopRequest && *result == true && params->denoiserEnabled)
+	{
+		connect(
+			gOpenCl->openClEngineRenderDenoiser, SIGNAL(updateImage()), this, SIGNAL(updateImage()));
+		connect(gOpenCl->openClEngineRenderDenoiser,
+			SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
+			SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
+
+		// only full engine fills normal vectors and world positions
+		const bool useGeometryGuides = paramsContainer->Get<int>("opencl_mode")
+																	 == cOpenClEngineRenderFractal::clRenderEngineTypeFull;
+
+		gOpenCl->openClEngineRenderDenoiser->Lock();
+		gOpenCl->openClEngineRenderDenoiser->SetParameters(params.get(), image, useGeometryGuides);
+		if (gOpenCl->openClEngineRenderDenoiser->LoadSourcesAndCompile(paramsContainer))
+		{
+			gOpenCl->openClEngineRenderDenoiser->CreateKernel4Program(paramsContainer);
+			qint64 neededMem = gOpenCl->openClEngineRenderDenoiser->CalcNeededMemory();
+			WriteLogDouble("OpenCl render denoiser - needed mem:", neededMem / 1048576.0, 2);
+			if (neededMem / 1048576 < paramsContainer->Get<int>("opencl_memory_limit"))
+			{
+				gOpenCl->openClEngineRenderDenoiser->PreAllocateBuffers(paramsContainer);
+				gOpenCl->openClEngineRenderDenoiser->CreateCommandQueue();
+				*result = gOpenCl->openClEngineRenderDenoiser->Render(image, renderData->stopRequest);
+			}
+			else
+			{
+				qCritical() << "Not enough GPU mem!";
+				*result = false;
+			}
+
+			if (!*result && !*renderData->stopRequest)
+			{
+				cPostEffectDenoiser denoiser(image);
+				connect(&denoiser,
+					SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)), this,
+					SIGNAL(updateProgressAndStatus(const QString &, const QString &, double)));
+				denoiser.SetParameters(
+					params->denoiserStrength, params->denoiserIterations, useGeometryGuides);
+				denoiser.Render(renderData->stopRequest);
+
+				WriteLog("image->CompileImage()", 2);
+				image->CompileImage();
+				if (image->IsPreview())
+				{
+					image->ConvertTo8bitChar();
+					image->UpdatePreview();
+					emit updateImage();
+				}
+				*result = true;
+			}
+		}
+		gOpenCl->openClEngineRenderDenoiser->ReleaseMemory();
+		gOpenCl->openClEngineRenderDenoiser->Unlock();
+
+		emit updateProgressAndStatus(
+			tr("OpenCl - denoising finished"), progressText->getText(1.0), 1.0);
+	}
+}
+
 void cRenderJob::RenderDOFWithOpenCl(std::shared_ptr<sParamRender> params, bool *result)
 {
+	cTraceSpan traceSpan("RenderDOFWithOpenCl", "opencl");
 	if (!*renderData->stopRequest)
 	{
 		if (params->DOFEnabled && !params->DOFMonteCarlo)
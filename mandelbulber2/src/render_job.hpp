@@ -39,6 +39,7 @@
 #define _USE_MATH_DEFINES
 #endif
 
+#include <atomic>
 #include <memory>
 
 #include <QObject>
@@ -58,6 +59,7 @@ struct sImageOptional;
 class cNineFractals;
 class cRenderer;
 class cProgressText;
+class cReprojectionCache;
 struct sParamRender;
 
 class cRenderJob : public QObject
@@ -92,6 +94,12 @@ public:
 	static int GetRunningJobCount() { return runningJobs; }
 	cStatistics GetStatistics() const;
 
+	// used by animations to start primary rays from depth reprojected from previous frame
+	void SetReprojectionCache(std::shared_ptr<cReprojectionCache> cache)
+	{
+		reprojectionCache = cache;
+	}
+
 public slots:
 	void slotExecute();
 
@@ -104,6 +112,11 @@ private:
 	void SetupStereoEyes(int repeat, bool twoPassStereo);
 	void InitNetRender();
 	void InitStatistics(const cNineFractals *fractals);
+	void PrepareGeometryBuffer(const sParamRender &params);
+	void PrepareConeMarchPrepass(const sParamRender &params, const cNineFractals &fractals);
+	void PrepareAutoBounds(const sParamRender &params, const cNineFractals &fractals);
+	void PrepareCheckpoint(int noOfRepeats);
+	void PrepareIrradianceCache(const sParamRender &params);
 	void ConnectUpdateSinalsSlots(const cRenderer *renderer);
 	void ConnectNetRenderSignalsSlots(const cRenderer *renderer);
 
@@ -112,6 +125,8 @@ private:
 		std::shared_ptr<cNineFractals> fractals, cProgressText *progressText);
 	void RenderSSAOWithOpenCl(std::shared_ptr<sParamRender> params, const cRegion<int> &region,
 		cProgressText *progressText, bool *result);
+	void RenderDenoiserWithOpenCl(
+		std::shared_ptr<sParamRender> params, cProgressText *progressText, bool *result);
 	void RenderDOFWithOpenCl(std::shared_ptr<sParamRender> params, bool *result);
 #endif
 
@@ -131,11 +146,12 @@ private:
 	int width;
 	QWidget *imageWidget;
 	std::shared_ptr<sRenderData> renderData;
+	std::shared_ptr<cReprojectionCache> reprojectionCache;
 	bool *stopRequest;
 	bool canUseNetRender;
 
 	static int id; // global identifier of actual rendering job
-	static int runningJobs;
+	static std::atomic<int> runningJobs;
 
 signals:
 	void finished();
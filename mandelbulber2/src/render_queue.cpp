@@ -34,9 +34,12 @@
 
 #include "render_queue.hpp"
 
+#include <QThread>
+
 #include "animation_flight.hpp"
 #include "animation_frames.hpp"
 #include "animation_keyframes.hpp"
+#include "cimage.hpp"
 #include "error_message.hpp"
 #include "file_image.hpp"
 #include "files.h"
@@ -53,6 +56,7 @@
 #include "rendering_configuration.hpp"
 #include "settings.hpp"
 #include "system_data.hpp"
+#include "wait.hpp"
 #include "write_log.hpp"
 
 cRenderQueue::cRenderQueue(std::shared_ptr<cImage> _image, RenderedImage *widget) : QObject()
@@ -117,7 +121,12 @@ void cRenderQueue::slotRenderQueue()
 	WriteLog("cRenderQueue::slotRenderQueue()", 2);
 	gQueue->stopRequest = false;
 
-	while (!gQueue->stopRequest && !systemData.globalStopRequest)
+	// small still images can be rendered at the same time, each with a part of threads
+	const int concurrentItems = gPar->Get<int>("queue_concurrent_items");
+	bool failed = false;
+	if (concurrentItems > 1) failed = !RenderConcurrently(concurrentItems, &queueFinished);
+
+	while (!failed && !gQueue->stopRequest && !systemData.globalStopRequest)
 	{
 		int queueTotalLeft = gQueue->GetQueueSize();
 		cQueue::structQueueItem queueItem = gQueue->GetNextFromList();
@@ -129,22 +138,9 @@ void cRenderQueue::slotRenderQueue()
 
 		if (QFile::exists(queueItem.filename))
 		{
-			*queuePar = *gPar;
-			cSettings parSettings(cSettings::formatFullText);
-			parSettings.LoadFromFile(queueItem.filename);
-			parSettings.Decode(queuePar, queueParFractal, queueAnimFrames, queueKeyframes);
+			LoadItem(queueItem, queuePar, queueParFractal);
 
-			queuePar->Set("image_preview_scale", 0);
-			queuePar->Set("limit_CPU_cores", systemData.numberOfThreads);
-			queuePar->Set("threads_priority", int(systemData.threadsPriority));
-
-			bool result = false;
-			switch (queueItem.renderType)
-			{
-				case cQueue::queue_STILL: result = RenderStill(queueItem); break;
-				case cQueue::queue_FLIGHT: result = RenderFlight(queueItem); break;
-				case cQueue::queue_KEYFRAME: result = RenderKeyframe(queueItem); break;
-			}
+			bool result = RenderItem(queueItem);
 
 			if (result)
 			{
@@ -169,6 +165,190 @@ void cRenderQueue::slotRenderQueue()
 	emit finished();
 }
 
+void cRenderQueue::LoadItem(const cQueue::structQueueItem &queueItem,
+	std::shared_ptr<cParameterContainer> par, std::shared_ptr<cFractalContainer> parFractal) const
+{
+	*par = *gPar;
+	cSettings parSettings(cSettings::formatFullText);
+	parSettings.LoadFromFile(queueItem.filename);
+	parSettings.Decode(par, parFractal, queueAnimFrames, queueKeyframes);
+
+	par->Set("image_preview_scale", 0);
+	par->Set("limit_CPU_cores", systemData.numberOfThreads);
+	par->Set("threads_priority", int(systemData.threadsPriority));
+}
+
+bool cRenderQueue::RenderItem(const cQueue::structQueueItem &queueItem)
+{
+	bool result = false;
+	switch (queueItem.renderType)
+	{
+		case cQueue::queue_STILL: result = RenderStill(queueItem); break;
+		case cQueue::queue_FLIGHT: result = RenderFlight(queueItem); break;
+		case cQueue::queue_KEYFRAME: result = RenderKeyframe(queueItem); break;
+	}
+	return result;
+}
+
+int cRenderQueue::ThreadBudget(int width, int height)
+{
+	// one thread for each 256x256 pixels. Smaller part of image per thread doesn't scale because
+	// of serial initialization, post-processing and saving
+	const qint64 pixelsPerThread = 256 * 256;
+	const qint64 pixels = qint64(width) * height;
+	const int threads = int((pixels + pixelsPerThread - 1) / pixelsPerThread);
+	return qBound(1, threads, systemData.numberOfThreads);
+}
+
+bool cRenderQueue::RenderConcurrently(int maxItems, int *queueFinished)
+{
+	WriteLogInt("cRenderQueue::RenderConcurrently() max items", maxItems, 2);
+
+	QList<std::shared_ptr<cRenderQueueItemWorker>> running;
+	QList<std::shared_ptr<QThread>> threads;
+	QList<cQueue::structQueueItem> skipped;
+	int usedThreads = 0;
+	bool failed = false;
+
+	// item which waits for free threads. It is loaded only once
+	bool pending = false;
+	cQueue::structQueueItem queueItem("", cQueue::queue_STILL);
+	std::shared_ptr<cParameterContainer> par;
+	std::shared_ptr<cFractalContainer> parFractal;
+	int budget = 0;
+	bool concurrent = false;
+	int queueTotal = 0;
+
+	while (true)
+	{
+		// collect finished items and update queue list
+		for (int i = running.size() - 1; i >= 0; i--)
+		{
+			if (!running[i]->IsFinished()) continue;
+			threads[i]->wait();
+			usedThreads -= running[i]->GetNumberOfThreads();
+			if (running[i]->GetResult())
+			{
+				gQueue->RemoveQueueItem(running[i]->GetQueueItem());
+				(*queueFinished)++;
+			}
+			else
+			{
+				failed = true;
+			}
+			running.removeAt(i);
+			threads.removeAt(i);
+		}
+
+		if (gQueue->stopRequest || systemData.globalStopRequest || failed)
+		{
+			// each item has own stop flag, because every cRenderJob::Execute() clears it
+			if (gQueue->stopRequest || systemData.globalStopRequest)
+			{
+				for (const std::shared_ptr<cRenderQueueItemWorker> &worker : running)
+					worker->Stop();
+			}
+			if (running.isEmpty()) break;
+			Wait(10);
+			continue;
+		}
+
+		if (!pending)
+		{
+			// find first item which is not started yet
+			const QList<cQueue::structQueueItem> list = gQueue->GetListFromQueueFile();
+			queueItem = cQueue::structQueueItem("", cQueue::queue_STILL);
+			for (const cQueue::structQueueItem &item : list)
+			{
+				bool started = skipped.contains(item);
+				for (const std::shared_ptr<cRenderQueueItemWorker> &worker : running)
+					if (worker->GetQueueItem() == item) started = true;
+				if (!started)
+				{
+					queueItem = item;
+					break;
+				}
+			}
+
+			if (queueItem.filename == "")
+			{
+				if (running.isEmpty()) break;
+				Wait(10);
+				continue;
+			}
+
+			if (!QFile::exists(queueItem.filename))
+			{
+				cErrorMessage::showMessage("Cannot load file!\n", cErrorMessage::errorMessage);
+				qCritical() << "\nSetting file " << queueItem.filename << " not found\n";
+				skipped.append(queueItem);
+				continue;
+			}
+
+			par.reset(new cParameterContainer());
+			parFractal.reset(new cFractalContainer());
+			LoadItem(queueItem, par, parFractal);
+
+			budget = ThreadBudget(par->Get<int>("image_width"), par->Get<int>("image_height"));
+
+			// animations, OpenCL renders and big images use whole machine (and the main image widget)
+			concurrent = queueItem.renderType == cQueue::queue_STILL
+									 && !par->Get<bool>("opencl_enabled") && budget < systemData.numberOfThreads;
+
+			// finished items are removed from the list, so the sum doesn't change while waiting
+			queueTotal = list.size() + *queueFinished;
+			pending = true;
+		}
+
+		if (!concurrent || running.size() >= maxItems
+				|| (!running.isEmpty() && usedThreads + budget > systemData.numberOfThreads))
+		{
+			// wait for running items to free threads
+			if (!running.isEmpty())
+			{
+				Wait(10);
+				continue;
+			}
+		}
+
+		pending = false;
+		emit updateProgressAndStatus(QFileInfo(queueItem.filename).fileName(),
+			QObject::tr("Queue Item %1 of %2").arg(*queueFinished + 1).arg(queueTotal),
+			(1.0 * *queueFinished / queueTotal), cProgressText::progress_QUEUE);
+
+		if (!concurrent)
+		{
+			*queuePar = *par;
+			*queueParFractal = *parFractal;
+			if (RenderItem(queueItem))
+			{
+				gQueue->RemoveQueueItem(queueItem);
+				(*queueFinished)++;
+			}
+			else
+			{
+				failed = true;
+			}
+			continue;
+		}
+
+		std::shared_ptr<cRenderQueueItemWorker> worker(
+			new cRenderQueueItemWorker(queueItem, par, parFractal, budget));
+		std::shared_ptr<QThread> thread(new QThread);
+		worker->moveToThread(thread.get());
+		connect(thread.get(), SIGNAL(started()), worker.get(), SLOT(doWork()));
+		connect(worker.get(), SIGNAL(finished()), thread.get(), SLOT(quit()));
+		thread->setObjectName("QueueItem");
+		thread->start();
+
+		running.append(worker);
+		threads.append(thread);
+		usedThreads += budget;
+	}
+
+	return !failed;
+}
+
 bool cRenderQueue::RenderFlight(const cQueue::structQueueItem &queueItem) const
 {
 	bool result;
@@ -215,11 +395,6 @@ bool cRenderQueue::RenderKeyframe(const cQueue::structQueueItem &queueItem) cons
 
 bool cRenderQueue::RenderStill(const cQueue::structQueueItem &queueItem)
 {
-	ImageFileSave::enumImageFileType imageFormat =
-		ImageFileSave::enumImageFileType(gPar->Get<int>("queue_image_format"));
-	QString extension = ImageFileSave::ImageFileExtension(imageFormat);
-	QString saveFilename = QFileInfo(queueItem.filename).baseName() + "." + extension;
-
 	// setup of rendering engine
 	std::unique_ptr<cRenderJob> renderJob(
 		new cRenderJob(queuePar, queueParFractal, image, &gQueue->stopRequest, imageWidget));
@@ -240,7 +415,9 @@ bool cRenderQueue::RenderStill(const cQueue::structQueueItem &queueItem)
 	config.EnableNetRender();
 	renderJob->Init(cRenderJob::still, config);
 
-	gQueue->stopRequest = false;
+	// the flag is reset only when the queue starts. Stop requested before this item
+	// would be cleared by cRenderJob::Execute()
+	if (gQueue->stopRequest) return false;
 
 	// render image
 	bool result = renderJob->Execute();
@@ -249,15 +426,68 @@ bool cRenderQueue::RenderStill(const cQueue::structQueueItem &queueItem)
 		return false;
 	}
 
+	SaveStill(queueItem, image, queuePar, queueParFractal, this);
+
+	return true;
+}
+
+void cRenderQueue::SaveStill(const cQueue::structQueueItem &queueItem,
+	std::shared_ptr<cImage> image, std::shared_ptr<cParameterContainer> par,
+	std::shared_ptr<cFractalContainer> parFractal, QObject *updateReceiver)
+{
+	ImageFileSave::enumImageFileType imageFormat =
+		ImageFileSave::enumImageFileType(gPar->Get<int>("queue_image_format"));
+	QString extension = ImageFileSave::ImageFileExtension(imageFormat);
+	QString saveFilename = QFileInfo(queueItem.filename).baseName() + "." + extension;
+
 	QString fullSaveFilename =
 		gPar->Get<QString>("default_image_path") + QDir::separator() + saveFilename;
-	SaveImage(fullSaveFilename, imageFormat, image, this);
+	SaveImage(fullSaveFilename, imageFormat, image, updateReceiver);
 
 	fullSaveFilename = gPar->Get<QString>("default_image_path") + QDir::separator()
 										 + QFileInfo(queueItem.filename).baseName() + ".fract";
 	cSettings parSettings(cSettings::formatCondensedText);
-	parSettings.CreateText(queuePar, queueParFractal);
+	parSettings.CreateText(par, parFractal);
 	parSettings.SaveToFile(fullSaveFilename);
+}
 
-	return true;
+cRenderQueueItemWorker::cRenderQueueItemWorker(const cQueue::structQueueItem &_queueItem,
+	std::shared_ptr<cParameterContainer> _par, std::shared_ptr<cFractalContainer> _parFractal,
+	int _numberOfThreads)
+		: QObject(), queueItem(_queueItem)
+{
+	par = _par;
+	parFractal = _parFractal;
+	numberOfThreads = _numberOfThreads;
+	finishedFlag = false;
+	stopRequest = false;
+	result = false;
+}
+
+cRenderQueueItemWorker::~cRenderQueueItemWorker()
+{
+	// nothing to delete
+}
+
+void cRenderQueueItemWorker::doWork()
+{
+	// own image, main image is used only by items rendered alone
+	std::shared_ptr<cImage> image(
+		new cImage(par->Get<int>("image_width"), par->Get<int>("image_height")));
+	std::unique_ptr<cRenderJob> renderJob(
+		new cRenderJob(par, parFractal, image, &stopRequest));
+
+	cRenderingConfiguration config;
+	config.DisableProgressiveRender();
+	config.DisableRefresh();
+	config.SetNumberOfThreads(numberOfThreads);
+
+	if (renderJob->Init(cRenderJob::still, config))
+	{
+		result = renderJob->Execute();
+		if (result) cRenderQueue::SaveStill(queueItem, image, par, parFractal, nullptr);
+	}
+
+	finishedFlag = true;
+	emit finished();
 }
@@ -35,6 +35,7 @@
 #ifndef MANDELBULBER2_SRC_RENDER_QUEUE_HPP_
 #define MANDELBULBER2_SRC_RENDER_QUEUE_HPP_
 
+#include <atomic>
 #include <memory>
 
 #include <QObject>
@@ -53,6 +54,38 @@ class cKeyframeAnimation;
 class cKeyframes;
 class cImage;
 
+// renders one small still image from the queue in its own thread with limited number of threads
+class cRenderQueueItemWorker : public QObject
+{
+	Q_OBJECT
+public:
+	cRenderQueueItemWorker(const cQueue::structQueueItem &_queueItem,
+		std::shared_ptr<cParameterContainer> _par, std::shared_ptr<cFractalContainer> _parFractal,
+		int _numberOfThreads);
+	~cRenderQueueItemWorker() override;
+
+	const cQueue::structQueueItem &GetQueueItem() const { return queueItem; }
+	int GetNumberOfThreads() const { return numberOfThreads; }
+	bool IsFinished() const { return finishedFlag; }
+	bool GetResult() const { return result; }
+	void Stop() { stopRequest = true; }
+
+public slots:
+	void doWork();
+
+signals:
+	void finished();
+
+private:
+	cQueue::structQueueItem queueItem;
+	std::shared_ptr<cParameterContainer> par;
+	std::shared_ptr<cFractalContainer> parFractal;
+	int numberOfThreads;
+	std::atomic<bool> finishedFlag;
+	bool stopRequest;
+	bool result;
+};
+
 class cRenderQueue : public QObject
 {
 	Q_OBJECT
@@ -63,6 +96,13 @@ public:
 	bool RenderFlight(const cQueue::structQueueItem &queueItem) const;
 	bool RenderKeyframe(const cQueue::structQueueItem &queueItem) const;
 
+	// saves rendered still image and its settings to default image folder
+	static void SaveStill(const cQueue::structQueueItem &queueItem, std::shared_ptr<cImage> image,
+		std::shared_ptr<cParameterContainer> par, std::shared_ptr<cFractalContainer> parFractal,
+		QObject *updateReceiver);
+	// number of threads worth to use for image of given resolution
+	static int ThreadBudget(int width, int height);
+
 public slots:
 	void slotRenderQueue();
 signals:
@@ -75,6 +115,12 @@ signals:
 	void finished();
 
 private:
+	// returns false when rendering of any item failed
+	bool RenderConcurrently(int maxItems, int *queueFinished);
+	void LoadItem(const cQueue::structQueueItem &queueItem, std::shared_ptr<cParameterContainer> par,
+		std::shared_ptr<cFractalContainer> parFractal) const;
+	bool RenderItem(const cQueue::structQueueItem &queueItem);
+
 	std::shared_ptr<cImage> image;
 	RenderedImage *imageWidget;
 	std::shared_ptr<cParameterContainer> queuePar;
@@ -35,6 +35,7 @@
 #include "render_ssao.h"
 
 #include <QList>
+#include <memory>
 #include <vector>
 
 #include "cimage.hpp"
@@ -42,6 +43,8 @@
 #include "global_data.hpp"
 #include "progress_text.hpp"
 #include "render_data.hpp"
+#include "render_trace.hpp"
+#include "ssao_depth_pyramid.hpp"
 #include "ssao_worker.h"
 #include "system_data.hpp"
 #include "wait.hpp"
@@ -79,6 +82,7 @@ void cRenderSSAO::SetRegion(const cRegion<int> &_region)
 
 void cRenderSSAO::RenderSSAO(QList<int> *list)
 {
+	cTraceSpan traceSpan("SSAO", "postprocess");
 	WriteLog("cRenderSSAO::RenderSSAO()", 2);
 	// prepare multiple threads
 	std::vector<QThread *> thread(numberOfThreads);
@@ -88,9 +92,13 @@ void cRenderSSAO::RenderSSAO(QList<int> *list)
 	cProgressText progressText;
 	progressText.ResetTimer();
 
+	// hierarchical mode works on depth pyramid and splits image into tiles
+	std::unique_ptr<cSSAODepthPyramid> depthPyramid;
+	if (params->SSAO_hierarchical) depthPyramid.reset(new cSSAODepthPyramid(image.get(), region));
+
 	// create list of lines to render for each CPU core
 	std::vector<QList<int>> lists;
-	if (list)
+	if (list && !depthPyramid)
 	{
 		lists.resize(numberOfThreads);
 		for (int y : *list)
@@ -123,8 +131,11 @@ void cRenderSSAO::RenderSSAO(QList<int> *list)
 		threadData[i].progressive = progressive;
 		threadData[i].stopRequest = false;
 		threadData[i].region = region;
+		threadData[i].depthPyramid = depthPyramid.get();
 
-		if (list)
+		if (list && depthPyramid)
+			threadData[i].list = *list; // lines are filtered inside every tile
+		else if (list)
 			threadData[i].list = lists[i];
 		else
 			threadData[i].list = QList<int>();
@@ -153,7 +164,12 @@ void cRenderSSAO::RenderSSAO(QList<int> *list)
 
 	int totalDone = 0;
 	int toDo;
-	if (list)
+	if (depthPyramid)
+	{
+		const int tileSize = cSSAOWorker::tileSize;
+		toDo = ((region.width + tileSize - 1) / tileSize) * ((region.height + tileSize - 1) / tileSize);
+	}
+	else if (list)
 	{
 		toDo = list->size();
 	}
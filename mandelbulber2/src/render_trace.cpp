@@ -0,0 +1,188 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cRenderTrace - optional timeline of render job stages in Chrome trace format
+ */
+
+#include "render_trace.hpp"
+
+#include <cstdlib>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+#include "write_log.hpp"
+
+std::atomic<bool> cRenderTrace::enabled(false);
+QElapsedTimer cRenderTrace::timer;
+QString cRenderTrace::traceFileName;
+QMutex cRenderTrace::buffersMutex;
+std::vector<std::unique_ptr<cRenderTrace::sThreadBuffer>> cRenderTrace::buffers;
+
+void cRenderTrace::Enable(const QString &fileName)
+{
+	if (enabled) return;
+	traceFileName = fileName;
+	timer.start();
+	std::atexit(SaveAtExit);
+	enabled = true;
+	WriteLogString("Render trace enabled, output file", fileName, 1);
+}
+
+cRenderTrace::sThreadBufferOwner::~sThreadBufferOwner()
+{
+	if (!buffer) return;
+	QMutexLocker lock(&buffersMutex);
+	buffer->inUse = false;
+}
+
+QString cRenderTrace::CurrentThreadName()
+{
+	QThread *thread = QThread::currentThread();
+	if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+		return "main";
+	return thread->objectName();
+}
+
+cRenderTrace::sThreadBuffer *cRenderTrace::GetThreadBuffer()
+{
+	thread_local sThreadBufferOwner owner;
+	if (!owner.buffer)
+	{
+		QMutexLocker lock(&buffersMutex);
+		const QString threadName = CurrentThreadName();
+
+		// buffer of finished thread is reused, preferably the one of thread with the same name
+		sThreadBuffer *freeBuffer = nullptr;
+		for (const std::unique_ptr<sThreadBuffer> &buffer : buffers)
+		{
+			if (buffer->inUse) continue;
+			if (!freeBuffer || buffer->threadName == threadName) freeBuffer = buffer.get();
+			if (buffer->threadName == threadName) break;
+		}
+
+		if (!freeBuffer)
+		{
+			std::unique_ptr<sThreadBuffer> buffer(new sThreadBuffer);
+			buffer->spans.resize(bufferCapacity);
+			buffer->writeIndex = 0;
+			buffer->threadId = int(buffers.size()) + 1;
+			freeBuffer = buffer.get();
+			buffers.push_back(std::move(buffer));
+		}
+
+		// track in the trace gets the name of the last thread which used the buffer
+		freeBuffer->threadName =
+			threadName.isEmpty() ? QString("thread %1").arg(freeBuffer->threadId) : threadName;
+		freeBuffer->inUse = true;
+		owner.buffer = freeBuffer;
+	}
+	return owner.buffer;
+}
+
+QString cRenderTrace::JsonEscaped(const QString &text)
+{
+	QString escaped;
+	for (const QChar character : text)
+	{
+		if (character == '"')
+			escaped += "\\\"";
+		else if (character == '\\')
+			escaped += "\\\\";
+		else if (character.unicode() < 0x20)
+			escaped += QString("\\u%1").arg(int(character.unicode()), 4, 16, QChar('0'));
+		else
+			escaped += character;
+	}
+	return escaped;
+}
+
+void cRenderTrace::AddSpan(
+	const char *name, const char *category, qint64 start, qint64 end, int arg)
+{
+	sThreadBuffer *buffer = GetThreadBuffer();
+	// the oldest spans are overwritten when the buffer is full
+	buffer->spans[buffer->writeIndex % bufferCapacity] = {name, category, start, end, arg};
+	buffer->writeIndex++;
+}
+
+void cRenderTrace::SaveAtExit()
+{
+	Save(traceFileName);
+}
+
+bool cRenderTrace::Save(const QString &fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qCritical() << "Cannot write render trace to" << fileName;
+		return false;
+	}
+
+	// trace is saved at exit, so it is assumed that threads don't record spans anymore
+	QMutexLocker lock(&buffersMutex);
+	QTextStream out(&file);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const std::unique_ptr<sThreadBuffer> &buffer : buffers)
+	{
+		if (!first) out << ",\n";
+		first = false;
+		out << QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,"
+									 "\"args\":{\"name\":\"%2\"}}")
+						 .arg(buffer->threadId)
+						 .arg(JsonEscaped(buffer->threadName));
+
+		const quint64 count = qMin(buffer->writeIndex, quint64(bufferCapacity));
+		const quint64 firstIndex = buffer->writeIndex - count;
+		for (quint64 i = firstIndex; i < buffer->writeIndex; i++)
+		{
+			const sSpan &span = buffer->spans[i % bufferCapacity];
+			// Chrome trace uses microseconds
+			out << QString(",\n{\"name\":\"%1\",\"cat\":\"%2\",\"ph\":\"X\",\"pid\":1,\"tid\":%3,"
+										 "\"ts\":%4,\"dur\":%5")
+							 .arg(JsonEscaped(span.name))
+							 .arg(JsonEscaped(span.category))
+							 .arg(buffer->threadId)
+							 .arg(span.start / 1000.0, 0, 'f', 3)
+							 .arg((span.end - span.start) / 1000.0, 0, 'f', 3);
+			if (span.arg >= 0) out << QString(",\"args\":{\"index\":%1}").arg(span.arg);
+			out << "}";
+		}
+	}
+	out << "\n]}\n";
+	WriteLogString("Render trace saved", fileName, 1);
+	return true;
+}
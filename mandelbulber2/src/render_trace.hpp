@@ -0,0 +1,127 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cRenderTrace - optional timeline of render job stages in Chrome trace format
+ *
+ * Every thread writes spans to its own ring buffer, so recording doesn't need any locking.
+ * When tracing is disabled a cTraceSpan costs only one relaxed atomic load. The trace is saved
+ * at program exit and can be opened in chrome://tracing or https://ui.perfetto.dev
+ */
+
+#ifndef MANDELBULBER2_SRC_RENDER_TRACE_HPP_
+#define MANDELBULBER2_SRC_RENDER_TRACE_HPP_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+class cRenderTrace
+{
+public:
+	// starts recording, trace will be written to the file at program exit
+	static void Enable(const QString &fileName);
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+	// name and category have to be string literals (only pointers are stored)
+	static void AddSpan(const char *name, const char *category, qint64 start, qint64 end, int arg);
+	static qint64 Now() { return timer.nsecsElapsed(); }
+	static bool Save(const QString &fileName);
+
+private:
+	struct sSpan
+	{
+		const char *name;
+		const char *category;
+		qint64 start; // [ns]
+		qint64 end;		// [ns]
+		int arg;
+	};
+
+	struct sThreadBuffer
+	{
+		std::vector<sSpan> spans;
+		quint64 writeIndex;
+		int threadId;
+		QString threadName;
+		bool inUse; // false when the thread which recorded spans has finished
+	};
+
+	// releases the buffer when its thread finishes
+	struct sThreadBufferOwner
+	{
+		sThreadBuffer *buffer = nullptr;
+		~sThreadBufferOwner();
+	};
+
+	static sThreadBuffer *GetThreadBuffer();
+	static QString CurrentThreadName();
+	static QString JsonEscaped(const QString &text);
+	static void SaveAtExit();
+
+	static const int bufferCapacity = 65536;
+	static std::atomic<bool> enabled;
+	static QElapsedTimer timer;
+	static QString traceFileName;
+	static QMutex buffersMutex;
+	// buffers of finished threads are kept until the trace is saved and are reused by new threads
+	// (render workers are new threads for every frame), so memory is limited by the highest number
+	// of simultaneously traced threads
+	static std::vector<std::unique_ptr<sThreadBuffer>> buffers;
+};
+
+// measures time from construction to destruction, arg is an optional index (e.g. line number)
+class cTraceSpan
+{
+public:
+	cTraceSpan(const char *_name, const char *_category, int _arg = -1)
+			: name(_name), category(_category), arg(_arg)
+	{
+		start = cRenderTrace::IsEnabled() ? cRenderTrace::Now() : -1;
+	}
+	~cTraceSpan()
+	{
+		if (start >= 0) cRenderTrace::AddSpan(name, category, start, cRenderTrace::Now(), arg);
+	}
+	cTraceSpan(const cTraceSpan &) = delete;
+	cTraceSpan &operator=(const cTraceSpan &) = delete;
+
+private:
+	const char *name;
+	const char *category;
+	qint64 start;
+	int arg;
+};
+
+#endif /* MANDELBULBER2_SRC_RENDER_TRACE_HPP_ */
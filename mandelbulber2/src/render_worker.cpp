@@ -35,18 +35,23 @@
 #include "render_worker.hpp"
 
 #include "ao_modes.h"
+#include "auto_bounds.hpp"
 #include "calculate_distance.hpp"
 #include "camera_target.hpp"
 #include "cimage.hpp"
 #include "common_math.h"
 #include "compute_fractal.hpp"
+#include "cone_march_prepass.hpp"
 #include "fractparams.hpp"
+#include "geometry_buffer.hpp"
 #include "hsv2rgb.h"
 #include "material.h"
 #include "perlin_noise_octaves.h"
 #include "projection_3d.hpp"
 #include "region.hpp"
 #include "render_data.hpp"
+#include "render_trace.hpp"
+#include "reprojection_cache.hpp"
 #include "scheduler.hpp"
 #include "stereo.h"
 #include "system_data.hpp"
@@ -61,6 +66,7 @@ cRenderWorker::cRenderWorker(std::shared_ptr<const sParamRender> _params,
 	data = _data.get();
 	image = _image;
 	threadData = _threadData;
+	rayBounds = nullptr;
 	cameraTarget = nullptr;
 	AOVectorsCount = 0;
 	baseX = CVector3(1.0, 0.0, 0.0);
@@ -91,6 +97,16 @@ void cRenderWorker::doWork()
 	bool antiAliasing = params->antialiasingEnabled;
 	int antiAliasingSize = params->antialiasingSize;
 
+	const cReprojectionCache *reprojectionCache =
+		(data->reprojectionCache && data->reprojectionCache->IsReady())
+			? data->reprojectionCache.get()
+			: nullptr;
+	const cConeMarchPrepass *coneMarchPrepass = data->coneMarchPrepass.get();
+	cGeometryBuffer *geometryBuffer = data->geometryBuffer.get();
+	rayBounds = (data->autoBounds && cAutoBounds::IsApplicable(*params, *data))
+								? data->autoBounds.get()
+								: nullptr;
+
 	if (data->stereo.isEnabled() && (params->perspectiveType != params::perspEquirectangular))
 		aspectRatio = data->stereo.ModifyAspectRatio(aspectRatio);
 
@@ -109,6 +125,14 @@ void cRenderWorker::doWork()
 
 	scheduler->InitFirstLine(threadData->id, threadData->startLine);
 
+	const cRegion<int> &screenRegion =
+		threadData->ownRegion ? threadData->screenRegion : data->screenRegion;
+	const cRegion<double> &imageRegion =
+		threadData->ownRegion ? threadData->imageRegion : data->imageRegion;
+	// tiles of co-rendering don't include their right and bottom edge (next tile starts there)
+	const int lastX = threadData->ownRegion ? screenRegion.x2 - 1 : screenRegion.x2;
+	const int lastY = threadData->ownRegion ? screenRegion.y2 - 1 : screenRegion.y2;
+
 	bool lastLineWasBroken = false;
 
 	// main loop for y
@@ -117,7 +141,9 @@ void cRenderWorker::doWork()
 	{
 		// skip if line is out of region
 		if (ys < 0) break;
-		if (ys < data->screenRegion.y1 || ys > data->screenRegion.y2) continue;
+		if (ys < screenRegion.y1 || ys > lastY) continue;
+
+		cTraceSpan lineSpan("line", "render", ys);
 
 		// main loop for x
 		for (int xs = 0; xs < width; xs += scheduler->GetProgressiveStep())
@@ -136,11 +162,11 @@ void cRenderWorker::doWork()
 				continue;
 
 			// skip if pixel is out of region;
-			if (xs < data->screenRegion.x1 || xs > data->screenRegion.x2) continue;
+			if (xs < screenRegion.x1 || xs > lastX) continue;
 
 			// calculate point in image coordinate system
 			CVector2<int> screenPoint(xs, ys);
-			CVector2<double> imagePoint = data->screenRegion.transpose(data->imageRegion, screenPoint);
+			CVector2<double> imagePoint = screenRegion.transpose(imageRegion, screenPoint);
 			cStereo::enumEye stereoEye = data->stereo.WhichEye(imagePoint);
 			if (data->stereo.isEnabled())
 			{
@@ -296,6 +322,31 @@ void cRenderWorker::doWork()
 					rayMarchingIn.direction = direction;
 					rayMarchingIn.maxScan = params->viewDistanceMax;
 					rayMarchingIn.minScan = 0; // params->viewDistanceMin;
+					data->statistics.numberOfPrimaryRays++;
+					bool certainlyEmpty = false;
+					if (coneMarchPrepass)
+					{
+						rayMarchingIn.minScan = coneMarchPrepass->GetStartDistance(xs, ys);
+
+						// empty tiles of the coverage mask go straight to background shading, the same way
+						// as rays which missed bounds of all objects
+						if (coneMarchPrepass->IsEmpty(xs, ys))
+						{
+							certainlyEmpty = true;
+							rayMarchingIn.maxScan = rayMarchingIn.minScan - 1.0;
+							data->statistics.numberOfBackgroundRays++;
+						}
+					}
+					if (reprojectionCache && !certainlyEmpty)
+					{
+						double candidate = reprojectionCache->GetStartDistance(xs, ys);
+						if (candidate > rayMarchingIn.minScan)
+							rayMarchingIn.minScan =
+								VerifiedStartDistance(startRay, direction, candidate, rayMarchingIn.minScan);
+					}
+					if (rayBounds && !certainlyEmpty)
+						rayBounds->ClipRay(
+							startRay, direction, &rayMarchingIn.minScan, &rayMarchingIn.maxScan);
 					rayMarchingIn.start = startRay;
 					rayMarchingIn.invertMode = false;
 					recursionIn.rayMarchingIn = rayMarchingIn;
@@ -303,6 +354,7 @@ void cRenderWorker::doWork()
 					recursionIn.resultShader = resultShader;
 					recursionIn.objectColour = objectColour;
 					recursionIn.rayBranch = rayBranchReflection;
+					if (geometryBuffer) recursionIn.geometrySample = geometryBuffer->GetSample(xs, ys);
 
 					sRayRecursionInOut recursionInOut;
 					sRayMarchingInOut rayMarchingInOut;
@@ -434,12 +486,12 @@ void cRenderWorker::doWork()
 			for (int yy = 0; yy < scheduler->GetProgressiveStep(); ++yy)
 			{
 				int yyy = screenPoint.y + yy;
-				if (yyy < data->screenRegion.y2)
+				if (yyy < screenRegion.y2)
 				{
 					for (int xx = 0; xx < scheduler->GetProgressiveStep(); ++xx)
 					{
 						int xxx = screenPoint.x + xx;
-						if (xxx < data->screenRegion.x2)
+						if (xxx < screenRegion.x2)
 						{
 							image->PutPixelImage(xxx, yyy, finalPixel);
 							image->PutPixelColor(xxx, yyy, colour);
@@ -479,16 +531,18 @@ void cRenderWorker::PrepareMainVectors()
 	// cameraTarget->SetCameraTargetRotation(params->camera, params->target, params->viewAngle);
 	viewAngle = cameraTarget->GetRotation();
 
-	// preparing rotation matrix
+	// preparing rotation matrix. The worker can be reused for next tiles, so rotation has to start
+	// from identity
+	mRot.Null();
 	mRot.RotateZ(viewAngle.x); // yaw
 	mRot.RotateX(viewAngle.y); // pitch
 	mRot.RotateY(viewAngle.z); // roll
 
 	// preparing base vectors
 	CVector3 vector;
-	baseX = mRot.RotateVector(baseX);
-	baseY = mRot.RotateVector(baseY);
-	baseZ = mRot.RotateVector(baseZ);
+	baseX = mRot.RotateVector(CVector3(1.0, 0.0, 0.0));
+	baseY = mRot.RotateVector(CVector3(0.0, 1.0, 0.0));
+	baseZ = mRot.RotateVector(CVector3(0.0, 0.0, 1.0));
 
 	mRot.RotateZ(-params->sweetSpotHAngle);
 	mRot.RotateX(params->sweetSpotVAngle);
@@ -562,30 +616,36 @@ void cRenderWorker::PrepareAOVectors()
 
 // calculation of distance where ray-marching stops
 double cRenderWorker::CalcDistThresh(CVector3 point) const
+{
+	return CalcDistThresh(point, *params, *data);
+}
+
+double cRenderWorker::CalcDistThresh(
+	CVector3 point, const sParamRender &params, const sRenderData &data)
 {
 	double distThresh;
-	if (params->iterThreshMode)
+	if (params.iterThreshMode)
 	{
-		distThresh = (params->camera - point).Length() * params->resolution * params->fov;
+		distThresh = (params.camera - point).Length() * params.resolution * params.fov;
 	}
 	else
 	{
-		if (params->constantDEThreshold)
-			distThresh = params->DEThresh;
+		if (params.constantDEThreshold)
+			distThresh = params.DEThresh;
 		else
 			distThresh =
-				(params->camera - point).Length() * params->resolution * params->fov / params->detailLevel;
+				(params.camera - point).Length() * params.resolution * params.fov / params.detailLevel;
 	}
 
-	if (params->perspectiveType == params::perspEquirectangular) distThresh *= 0.5;
+	if (params.perspectiveType == params::perspEquirectangular) distThresh *= 0.5;
 
-	if (params->advancedQuality)
+	if (params.advancedQuality)
 	{
-		if (distThresh > params->detailSizeMax) distThresh = params->detailSizeMax;
-		if (distThresh < params->detailSizeMin) distThresh = params->detailSizeMin;
+		if (distThresh > params.detailSizeMax) distThresh = params.detailSizeMax;
+		if (distThresh < params.detailSizeMin) distThresh = params.detailSizeMin;
 	}
 
-	distThresh /= data->reduceDetail;
+	distThresh /= data.reduceDetail;
 	return distThresh;
 }
 
@@ -598,6 +658,38 @@ double cRenderWorker::CalcDelta(CVector3 point) const
 	return delta;
 }
 
+// checks if the ray segment from emptyDistance to candidate distance is empty. Unbounding spheres
+// are chained from the candidate point back towards the camera with the same step rule as in
+// RayMarching(). Returns candidate if the whole segment is covered, otherwise emptyDistance (the
+// part of the ray which is already known to be empty).
+double cRenderWorker::VerifiedStartDistance(
+	CVector3 start, CVector3 direction, double candidate, double emptyDistance) const
+{
+	const int maxVerificationSteps = 8;
+	double threshFactor = params->interiorMode ? 0.8 : 0.5;
+	double scan = candidate;
+
+	for (int i = 0; i < maxVerificationSteps; i++)
+	{
+		CVector3 point = start + direction * scan;
+		double distThresh = CalcDistThresh(point);
+		sDistanceIn distanceIn(point, distThresh, false);
+		sDistanceOut distanceOut;
+		double dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
+		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
+
+		if (dist < distThresh) return emptyDistance; // surface close to the candidate point
+
+		scan -= (dist - threshFactor * distThresh) * params->DEFactor;
+		if (scan <= emptyDistance)
+		{
+			data->statistics.numberOfReprojectedRays++;
+			return candidate;
+		}
+	}
+	return emptyDistance;
+}
+
 // Ray-Marching
 void cRenderWorker::RayMarching(
 	sRayMarchingIn &in, sRayMarchingInOut *inOut, sRayMarchingOut *out) const
@@ -619,7 +711,22 @@ void cRenderWorker::RayMarching(
 	CVector3 lastPoint;
 	bool deadComputationFound = false;
 
-	for (int i = 0; i < MAX_RAYMARCHING; i++)
+	// over-relaxed sphere tracing (Keinert et al. 2014): steps are enlarged until two following
+	// unbounding spheres don't overlap, then the ray goes back and continues with normal steps
+	double relaxation = params->enhancedSphereTracing ? params->enhancedSphereTracingFactor : 1.0;
+	double previousDist = 0.0;
+	double stepFromLastPoint = 0.0; // distance from the last point stored in the step buffer
+	int buffIndex = 0;
+
+	// last point before the surface, used as a bracket for secant hit refinement
+	double outsideScan = -1.0;
+	double outsideDist = 0.0;
+	double outsideDistThresh = 0.0;
+
+	// ray clipped to bounds of objects can miss all of them
+	int maxSteps = (in.minScan > in.maxScan) ? 0 : MAX_RAYMARCHING;
+
+	for (int i = 0; i < maxSteps; i++)
 	{
 		lastPoint = point;
 
@@ -654,13 +761,26 @@ void cRenderWorker::RayMarching(
 		//-------------------- 4.18us for Calculate distance --------------
 
 		// printf("Distance = %g\n", dist/distThresh);
-		inOut->stepBuff[i].distance = dist;
-		inOut->stepBuff[i].iters = distanceOut.iters;
-		inOut->stepBuff[i].distThresh = distThresh;
+		inOut->stepBuff[buffIndex].distance = dist;
+		inOut->stepBuff[buffIndex].iters = distanceOut.iters;
+		inOut->stepBuff[buffIndex].distThresh = distThresh;
 
 		data->statistics.histogramIterations.Add(distanceOut.iters);
 		data->statistics.totalNumberOfIterations += distanceOut.totalIters;
 
+		if (relaxation > 1.0 && dist + previousDist < step)
+		{
+			// gap between spheres - the point is skipped and the ray goes back by over-relaxed part
+			// of the last step. Rest of the ray is marched without relaxation
+			step *= (1.0 - relaxation) / relaxation;
+			relaxation = 1.0;
+			previousDist = dist;
+			stepFromLastPoint += step;
+			scan += step / in.direction.Length();
+			continue;
+		}
+		previousDist = dist;
+
 		if (dist < distThresh)
 		{
 			if (dist < 0.1 * distThresh) data->statistics.missedDE++;
@@ -668,7 +788,11 @@ void cRenderWorker::RayMarching(
 			break;
 		}
 
-		inOut->stepBuff[i].step = step;
+		outsideScan = scan;
+		outsideDist = dist;
+		outsideDistThresh = distThresh;
+
+		inOut->stepBuff[buffIndex].step = stepFromLastPoint;
 		if (params->interiorMode)
 		{
 			step = (dist - 0.8 * distThresh) * params->DEFactor * (1.0 - Random(1000) / 10000.0);
@@ -677,6 +801,7 @@ void cRenderWorker::RayMarching(
 		{
 			step = (dist - 0.5 * distThresh) * params->DEFactor * (1.0 - Random(1000) / 10000.0);
 		}
+		step *= relaxation;
 
 		if (params->advancedQuality)
 		{
@@ -695,9 +820,11 @@ void cRenderWorker::RayMarching(
 			if (step > 3.0) step = 3.0;
 		}
 
-		inOut->stepBuff[i].point = point;
+		inOut->stepBuff[buffIndex].point = point;
 
-		(*inOut->buffCount) = i + 1;
+		buffIndex++;
+		(*inOut->buffCount) = buffIndex;
+		stepFromLastPoint = step;
 		// divided by length of view Vector to eliminate overstepping when fov is big
 		scan += step / in.direction.Length();
 		if (scan > in.maxScan)
@@ -709,10 +836,83 @@ void cRenderWorker::RayMarching(
 
 	point = in.start + in.direction * scan;
 
+	if (found && in.binaryEnable && !deadComputationFound && params->secantHitRefinement
+			&& outsideScan >= 0.0)
+	{
+		// regula falsi (Illinois variant) between the last point outside and the hit point. The
+		// searched distance is in the middle of accepted range
+		const double targetFactor = 1.0 - 0.5 * search_accuracy;
+		double scanA = outsideScan;
+		double fA = outsideDist - outsideDistThresh * targetFactor;
+		double scanB = scan;
+		double fB = dist - distThresh * targetFactor;
+		double distB = dist;
+		double distThreshB = distThresh;
+		int objectIdB = out->objectId;
+		int side = 0;
+
+		for (int i = 0; i < 30; i++)
+		{
+			if (dist < distThresh && dist > distThresh * search_limit) break;
+			if (fA == fB) break;
+
+			counter++;
+			double scanNew = scanB - fB * (scanB - scanA) / (fB - fA);
+			scan = scanNew;
+			point = in.start + in.direction * scan;
+
+			distThresh = CalcDistThresh(point);
+
+			sDistanceIn distanceIn(point, distThresh, false);
+			sDistanceOut distanceOut;
+			dist = CalculateDistance(*params, *fractal, distanceIn, &distanceOut, data);
+
+			if (in.invertMode)
+			{
+				dist = distThresh * 1.99 - dist;
+				if (dist < 0.0) dist = 0.0;
+			}
+
+			out->objectId = distanceOut.objectId;
+
+			data->statistics.histogramIterations.Add(distanceOut.iters);
+			data->statistics.totalNumberOfIterations += distanceOut.totalIters;
+
+			double fNew = dist - distThresh * targetFactor;
+			if (fNew > 0.0)
+			{
+				scanA = scanNew;
+				fA = fNew;
+				if (side == -1) fB *= 0.5;
+				side = -1;
+			}
+			else
+			{
+				scanB = scanNew;
+				fB = fNew;
+				distB = dist;
+				distThreshB = distThresh;
+				objectIdB = out->objectId;
+				if (side == 1) fA *= 0.5;
+				side = 1;
+			}
+		}
+
+		// result has to be a point on the surface side of the bracket
+		if (dist >= distThresh)
+		{
+			scan = scanB;
+			point = in.start + in.direction * scan;
+			dist = distB;
+			distThresh = distThreshB;
+			out->objectId = objectIdB;
+		}
+	}
 	// qDebug() << "------------ binary search";
-	if (found && in.binaryEnable && !deadComputationFound)
+	else if (found && in.binaryEnable && !deadComputationFound)
 	{
-		step *= 0.5;
+		// distance from the last point outside the surface
+		step = stepFromLastPoint * 0.5;
 		for (int i = 0; i < 30; i++)
 		{
 			counter++;
@@ -767,6 +967,7 @@ void cRenderWorker::RayMarching(
 	//---------- 7.19605us for binary searching ---------------
 
 	data->statistics.histogramStepCount.Add(counter);
+	data->statistics.numberOfDistanceEvaluations += counter;
 
 	out->found = found;
 	out->lastDist = dist;
@@ -802,7 +1003,27 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 			// trace the light in given direction
 			sRayMarchingOut rayMarchingOut;
 
-			RayMarching(rayStack[rayIndex].in.rayMarchingIn, &inOut.rayMarchingInOut, &rayMarchingOut);
+			// primary ray hit can be taken from the geometry buffer of previous render
+			sGeometrySample *geometrySample =
+				(rayIndex == 0) ? rayStack[rayIndex].in.geometrySample : nullptr;
+			bool reshading = geometrySample && geometrySample->valid;
+
+			if (reshading)
+			{
+				const sRayMarchingIn &rayMarchingIn = rayStack[rayIndex].in.rayMarchingIn;
+				rayMarchingOut.depth = geometrySample->depth;
+				rayMarchingOut.point = rayMarchingIn.start + rayMarchingIn.direction * rayMarchingOut.depth;
+				rayMarchingOut.distThresh = geometrySample->distThresh;
+				rayMarchingOut.lastDist = geometrySample->lastDist;
+				rayMarchingOut.objectId = geometrySample->objectId;
+				rayMarchingOut.found = geometrySample->found;
+				data->statistics.numberOfReshadedPixels++;
+			}
+			else
+			{
+				RayMarching(
+					rayStack[rayIndex].in.rayMarchingIn, &inOut.rayMarchingInOut, &rayMarchingOut);
+			}
 			CVector3 point = rayMarchingOut.point;
 
 			// prepare data for texture shaders
@@ -817,13 +1038,25 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 			shaderInputData.stepBuff = inOut.rayMarchingInOut.stepBuff;
 			shaderInputData.invertMode = rayStack[rayIndex].in.calcInside;
 			shaderInputData.objectId = rayMarchingOut.objectId;
-			cObjectData objectData = data->objectData[shaderInputData.objectId];
-			shaderInputData.material = &data->materials[objectData.materialId];
+			shaderInputData.compiledMaterial = &data->materialTable.GetMaterial(shaderInputData.objectId);
+			shaderInputData.material = shaderInputData.compiledMaterial->material;
 
 			float reflect = shaderInputData.material->reflectance;
 			float transparent = shaderInputData.material->transparencyOfSurface;
 
 			rayStack[rayIndex].out.rayMarchingOut = rayMarchingOut;
+			rayStack[rayIndex].out.colorIndex = -1.0;
+
+			if (geometrySample && !reshading)
+			{
+				geometrySample->depth = rayMarchingOut.depth;
+				geometrySample->distThresh = float(rayMarchingOut.distThresh);
+				geometrySample->lastDist = float(rayMarchingOut.lastDist);
+				geometrySample->objectId = rayMarchingOut.objectId;
+				geometrySample->found = rayMarchingOut.found;
+				geometrySample->colorIndex = -1.0f;
+				geometrySample->valid = true;
+			}
 
 			CVector3 vn;
 
@@ -831,11 +1064,35 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 			if (rayMarchingOut.found)
 			{
 				// calculate normal vector
-				vn = CalculateNormals(shaderInputData);
+				if (reshading)
+				{
+					vn = CVector3(geometrySample->normalX, geometrySample->normalY, geometrySample->normalZ);
+					shaderInputData.colorIndex = geometrySample->colorIndex;
+				}
+				else
+				{
+					vn = CalculateNormals(shaderInputData);
+
+					// colour index is calculated in advance to be stored in the geometry buffer
+					if (geometrySample
+							&& shaderInputData.compiledMaterial->objectType == fractal::objFractal
+							&& shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagColorsFromPalette))
+					{
+						shaderInputData.colorIndex = CalculateColorIndex(shaderInputData);
+					}
+
+					if (geometrySample)
+					{
+						geometrySample->normalX = float(vn.x);
+						geometrySample->normalY = float(vn.y);
+						geometrySample->normalZ = float(vn.z);
+						geometrySample->colorIndex = float(shaderInputData.colorIndex);
+					}
+				}
+				rayStack[rayIndex].out.colorIndex = shaderInputData.colorIndex;
 
 				float roughnessGradient = 1.0;
-				if (shaderInputData.material->useColorsFromPalette
-						&& shaderInputData.material->roughnessGradientEnable)
+				if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagRoughnessGradient))
 				{
 					sGradientsCollection gradients;
 					SurfaceColour(shaderInputData, &gradients);
@@ -843,7 +1100,7 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 				}
 
 				float roughnessTex = 1.0;
-				if (shaderInputData.material->roughnessTexture.IsLoaded()
+				if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagRoughnessTexture)
 						&& shaderInputData.material->useRoughnessTexture)
 				{
 					float texRoughInt = shaderInputData.material->roughnessTextureIntensity;
@@ -863,7 +1120,7 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 				}
 				shaderInputData.normal = vn;
 
-				if (shaderInputData.material->normalMapTexture.IsLoaded())
+				if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagNormalMapTexture))
 				{
 					vn = NormalMapShader(shaderInputData);
 				}
@@ -917,6 +1174,9 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 							rayMarchingIn.direction = newDirection;
 							rayMarchingIn.maxScan = params->viewDistanceMax;
 							rayMarchingIn.minScan = 0.0;
+							if (rayBounds)
+								rayBounds->ClipRay(
+									newPoint, newDirection, &rayMarchingIn.minScan, &rayMarchingIn.maxScan);
 							rayMarchingIn.start = newPoint;
 							rayMarchingIn.invertMode = false;
 							recursionIn.rayMarchingIn = rayMarchingIn;
@@ -979,6 +1239,9 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 							rayMarchingIn.direction = newDirection;
 							rayMarchingIn.maxScan = params->viewDistanceMax;
 							rayMarchingIn.minScan = 0.0;
+							if (rayBounds)
+								rayBounds->ClipRay(
+									newPoint, newDirection, &rayMarchingIn.minScan, &rayMarchingIn.maxScan);
 							rayMarchingIn.start = newPoint;
 							rayMarchingIn.invertMode =
 								!rayStack[rayIndex - 1].in.calcInside || internalReflection;
@@ -1048,13 +1311,14 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 			shaderInputData.stepBuff = inOut.rayMarchingInOut.stepBuff;
 			shaderInputData.invertMode = rayStack[rayIndex].in.calcInside;
 			shaderInputData.objectId = rayMarchingOut.objectId;
-			cObjectData objectData = data->objectData[shaderInputData.objectId];
-			shaderInputData.material = &data->materials[objectData.materialId];
+			shaderInputData.compiledMaterial = &data->materialTable.GetMaterial(shaderInputData.objectId);
+			shaderInputData.material = shaderInputData.compiledMaterial->material;
 
 			shaderInputData.normal = recursionOut.normal;
+			shaderInputData.colorIndex = recursionOut.colorIndex;
 
 			// letting colors from textures (before normal map shader)
-			if (shaderInputData.material->colorTexture.IsLoaded())
+			if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagColorTexture))
 			{
 				shaderInputData.texColor =
 					TextureShader(shaderInputData, texture::texColor, shaderInputData.material);
@@ -1062,25 +1326,25 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 			else
 				shaderInputData.texColor = sRGBFloat(1.0, 1.0, 1.0);
 
-			if (shaderInputData.material->luminosityTexture.IsLoaded())
+			if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagLuminosityTexture))
 				shaderInputData.texLuminosity =
 					TextureShader(shaderInputData, texture::texLuminosity, shaderInputData.material);
 			else
 				shaderInputData.texLuminosity = sRGBFloat(0.0, 0.0, 0.0);
 
-			if (shaderInputData.material->diffusionTexture.IsLoaded())
+			if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagDiffusionTexture))
 				shaderInputData.texDiffuse =
 					TextureShader(shaderInputData, texture::texDiffuse, shaderInputData.material);
 			else
 				shaderInputData.texDiffuse = sRGBFloat(1.0, 1.0, 1.0);
 
-			if (shaderInputData.material->reflectanceTexture.IsLoaded())
+			if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagReflectanceTexture))
 				shaderInputData.texReflectance =
 					TextureShader(shaderInputData, texture::texReflectance, shaderInputData.material);
 			else
 				shaderInputData.texReflectance = sRGBFloat(1.0, 1.0, 1.0);
 
-			if (shaderInputData.material->transparencyTexture.IsLoaded())
+			if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagTransparencyTexture))
 				shaderInputData.texTransparency =
 					TextureShader(shaderInputData, texture::texTransparency, shaderInputData.material);
 			else
@@ -1159,8 +1423,7 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 				resultShader.B = (objectShader.B + recursionOut.specular.B);
 				resultShader.A = objectShader.A;
 
-				if (shaderInputData.material->useColorsFromPalette
-						&& shaderInputData.material->transparencyGradientEnable)
+				if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagTransparencyGradient))
 				{
 					transparentShader.R *= gradients.trasparency.R;
 					transparentShader.G *= gradients.trasparency.G;
@@ -1194,8 +1457,7 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 					reflectDiffused.B = reflect * shaderInputData.texDiffuse.B * diffusionIntensity
 															+ reflect * diffusionIntensityN;
 
-					if (shaderInputData.material->useColorsFromPalette
-							&& shaderInputData.material->diffuseGradientEnable)
+					if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagDiffuseGradient))
 					{
 						reflectDiffused.R *= gradients.diffuse.R;
 						reflectDiffused.G *= gradients.diffuse.G;
@@ -1215,8 +1477,7 @@ cRenderWorker::sRayRecursionOut cRenderWorker::RayRecursion(
 					reflectDiffused.G *= iridescence.G;
 					reflectDiffused.B *= iridescence.B;
 
-					if (shaderInputData.material->useColorsFromPalette
-							&& shaderInputData.material->reflectanceGradientEnable)
+					if (shaderInputData.compiledMaterial->Has(sCompiledMaterial::flagReflectanceGradient))
 					{
 						reflectDiffused.R *= gradients.reflectance.R;
 						reflectDiffused.G *= gradients.reflectance.G;
@@ -42,10 +42,13 @@
 
 #include "algebra.hpp"
 #include "color_structures.hpp"
+#include "region.hpp"
 #include "texture_enums.hpp"
 
 // forward declarations
+class cAutoBounds;
 class cMaterial;
+struct sCompiledMaterial;
 class cLight;
 class cCameraTarget;
 class cImage;
@@ -54,6 +57,7 @@ struct sParamRender;
 class cNineFractals;
 class cScheduler;
 class cPerlinNoiseOctaves;
+struct sGeometrySample;
 
 #define MAX_RAYMARCHING 10000
 
@@ -76,6 +80,11 @@ public:
 		int id;
 		int startLine;
 		std::shared_ptr<cScheduler> scheduler;
+
+		// worker renders only given part of the image (tiles of CPU + OpenCL co-rendering)
+		bool ownRegion = false;
+		cRegion<int> screenRegion;
+		cRegion<double> imageRegion;
 	};
 
 	cRenderWorker(std::shared_ptr<const sParamRender> _params,
@@ -88,6 +97,9 @@ public:
 	const sVectorsAround *getAOVectorsAround() const { return AOVectorsAround.data(); }
 	int getAoVectorsCount() const { return AOVectorsCount; }
 
+	// CalcDistThresh() is public because is needed also for cone-marching pre-pass
+	static double CalcDistThresh(CVector3 point, const sParamRender &params, const sRenderData &data);
+
 	QThread workerThread;
 
 private:
@@ -150,6 +162,7 @@ private:
 		sRGBAfloat resultShader;
 		sRGBAfloat objectColour;
 		enumRayBranch rayBranch;
+		sGeometrySample *geometrySample = nullptr; // cached primary hit of the pixel
 	};
 
 	struct sRayRecursionOut
@@ -160,6 +173,7 @@ private:
 		sRGBAfloat objectColour;
 		sRGBAfloat specular;
 		CVector3 normal;
+		double colorIndex;
 		float fogOpacity;
 		bool found;
 	};
@@ -183,11 +197,13 @@ private:
 		int objectId;
 		bool invertMode;
 		cMaterial *material;
+		const sCompiledMaterial *compiledMaterial;
 		sRGBFloat texDiffuse;
 		sRGBFloat texColor;
 		sRGBFloat texLuminosity;
 		sRGBFloat texReflectance;
 		sRGBFloat texTransparency;
+		double colorIndex = -1.0; // negative when colour index has to be calculated
 	};
 
 	struct sRayStack
@@ -217,6 +233,8 @@ private:
 	void RayMarching(sRayMarchingIn &in, sRayMarchingInOut *inOut, sRayMarchingOut *out) const;
 	double CalcDistThresh(CVector3 point) const;
 	double CalcDelta(CVector3 point) const;
+	double VerifiedStartDistance(
+		CVector3 start, CVector3 direction, double candidate, double emptyDistance) const;
 	static double IterOpacity(
 		double step, double iters, double maxN, double trim, double trimHigh, double opacitySp);
 	double CloudOpacity(
@@ -235,6 +253,7 @@ private:
 	sRGBAfloat SpecularHighlightCombined(const sShaderInputData &input, CVector3 lightVector,
 		sRGBAfloat surfaceColor, sRGBFloat diffuseGradient) const;
 	sRGBAfloat SurfaceColour(const sShaderInputData &input, sGradientsCollection *gradients) const;
+	double CalculateColorIndex(const sShaderInputData &input) const;
 	sRGBAfloat FastAmbientOcclusion(const sShaderInputData &input) const;
 	sRGBAfloat AmbientOcclusion(const sShaderInputData &input) const;
 	sRGBAfloat EnvMapping(const sShaderInputData &input) const;
@@ -256,12 +275,16 @@ private:
 	float RoughnessTexture(const sShaderInputData &input) const;
 	sRGBFloat IridescenceShader(const sShaderInputData &input) const;
 	sRGBFloat GlobalIlumination(const sShaderInputData &input, sRGBAfloat objectColor) const;
+	sRGBFloat GlobalIluminationPath(const sShaderInputData &input, sRGBAfloat objectColor,
+		CVector3 *firstDirection, double *firstHitDistance) const;
+	sRGBFloat CachedGlobalIlumination(const sShaderInputData &input) const;
 
 	// data got from main thread
 	const sParamRender *params;
 	const cNineFractals *fractal;
 	sRenderData *data;
 	std::shared_ptr<sThreadData> threadData;
+	const cAutoBounds *rayBounds; // rays are clipped to these bounds if not nullptr
 	std::shared_ptr<cImage> image;
 
 	// internal variables
@@ -47,6 +47,7 @@ cRenderingConfiguration::cRenderingConfiguration()
 	enableIgnoreErrors = false;
 	refreshRate = 1000;
 	maxRenderTime = 1e50;
+	maxNumberOfThreads = 0;
 }
 
 bool cRenderingConfiguration::UseNetRender() const
@@ -67,7 +68,10 @@ bool cRenderingConfiguration::UseProgressive() const
 int cRenderingConfiguration::GetNumberOfThreads() const
 {
 	if (enableMultiThread)
+	{
+		if (maxNumberOfThreads > 0) return qMin(maxNumberOfThreads, systemData.numberOfThreads);
 		return systemData.numberOfThreads;
+	}
 	else
 		return 1;
 }
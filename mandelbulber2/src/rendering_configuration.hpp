@@ -47,6 +47,8 @@ public:
 	void DisableMultiThread() { enableMultiThread = false; }
 	void EnableIgnoreErrors() { enableIgnoreErrors = true; }
 	void SetMaxRenderTime(double _maxRenderTime) { maxRenderTime = _maxRenderTime; }
+	// limits number of threads used by the job (0 - all threads)
+	void SetNumberOfThreads(int _maxNumberOfThreads) { maxNumberOfThreads = _maxNumberOfThreads; }
 
 	bool UseNetRender() const;
 	bool UseImageRefresh() const;
@@ -66,6 +68,7 @@ private:
 	bool enableIgnoreErrors;
 	double maxRenderTime;
 	int refreshRate;
+	int maxNumberOfThreads;
 };
 
 #endif /* MANDELBULBER2_SRC_RENDERING_CONFIGURATION_HPP_ */
@@ -0,0 +1,182 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cReprojectionCache - temporal cache of the Z-buffer for animation frames
+ */
+
+#include "reprojection_cache.hpp"
+
+#include "camera_target.hpp"
+#include "cimage.hpp"
+#include "fractparams.hpp"
+#include "projection_3d.hpp"
+#include "render_data.hpp"
+
+cReprojectionCache::cReprojectionCache()
+{
+	width = 0;
+	height = 0;
+	ready = false;
+}
+
+cReprojectionCache::~cReprojectionCache()
+{
+	// nothing to delete
+}
+
+bool cReprojectionCache::IsApplicable(const sParamRender &params, const sRenderData &data)
+{
+	// effects which integrate along the whole primary ray need all ray-marching steps
+	if (params.glowEnabled || params.fogEnabled || params.volFogEnabled || params.iterFogEnabled
+			|| params.cloudsEnable || params.fakeLightsEnabled)
+		return false;
+
+	for (int i = 0; i < data.lights.GetNumberOfLights(); i++)
+	{
+		const cLight *light = data.lights.GetLight(i);
+		if (light->enabled && light->volumetric) return false;
+		if (light->IsVisibleAlongRays()) return false;
+	}
+
+	// start point of the ray has to be the camera
+	if (params.DOFMonteCarlo || data.stereo.isEnabled()) return false;
+
+	return params.perspectiveType == params::perspThreePoint;
+}
+
+CRotationMatrix cReprojectionCache::CameraRotation(const sParamRender &params)
+{
+	cCameraTarget cameraTarget(params.camera, params.target, params.topVector);
+	CVector3 viewAngle = cameraTarget.GetRotation();
+
+	CRotationMatrix mRot;
+	mRot.RotateZ(viewAngle.x);
+	mRot.RotateX(viewAngle.y);
+	mRot.RotateY(viewAngle.z);
+	mRot.RotateZ(-params.sweetSpotHAngle);
+	mRot.RotateX(params.sweetSpotVAngle);
+	return mRot;
+}
+
+void cReprojectionCache::Clear()
+{
+	storedPoints.clear();
+	startDistance.clear();
+	ready = false;
+}
+
+void cReprojectionCache::Store(
+	const cImage &image, const sParamRender &params, const sRenderData &data)
+{
+	storedPoints.clear();
+
+	int imageWidth = int(image.GetWidth());
+	int imageHeight = int(image.GetHeight());
+	double aspectRatio = double(imageWidth) / imageHeight;
+	CRotationMatrix mRot = CameraRotation(params);
+
+	storedPoints.reserve(size_t(imageWidth) * size_t(imageHeight));
+
+	for (int y = data.screenRegion.y1; y < data.screenRegion.y2; y++)
+	{
+		for (int x = data.screenRegion.x1; x < data.screenRegion.x2; x++)
+		{
+			float depth = image.GetPixelZBuffer(x, y);
+			if (depth >= 1e19f) continue; // background
+
+			CVector2<double> imagePoint =
+				data.screenRegion.transpose(data.imageRegion, CVector2<int>(x, y));
+			imagePoint.x *= aspectRatio;
+			CVector3 viewVector =
+				CalculateViewVector(imagePoint, params.fov, params.perspectiveType, mRot);
+			viewVector.Normalize();
+			storedPoints.push_back(params.camera + viewVector * double(depth));
+		}
+	}
+}
+
+void cReprojectionCache::Prepare(
+	const sParamRender &params, const sRenderData &data, int width, int height)
+{
+	ready = false;
+	this->width = width;
+	this->height = height;
+	startDistance.assign(size_t(width) * size_t(height), 0.0f);
+
+	if (storedPoints.empty()) return;
+
+	// projection of previous hit points into new camera (closest point wins)
+	std::vector<float> projected(startDistance.size(), -1.0f);
+	CRotationMatrix mRotInv = CameraRotation(params).Transpose();
+	double aspectRatio = double(width) / height;
+
+	for (const CVector3 &point : storedPoints)
+	{
+		CVector3 viewVector = mRotInv.RotateVector(point - params.camera);
+		if (viewVector.y <= 0.0) continue; // behind the camera
+
+		CVector2<double> imagePoint(viewVector.x / viewVector.y / params.fov / aspectRatio,
+			viewVector.z / viewVector.y / params.fov);
+		CVector2<int> screenPoint = data.imageRegion.transpose(data.screenRegion, imagePoint);
+		if (screenPoint.x < 0 || screenPoint.x >= width || screenPoint.y < 0 || screenPoint.y >= height)
+			continue;
+
+		float distance = float(viewVector.Length());
+		float &pixel = projected[size_t(screenPoint.x) + size_t(screenPoint.y) * size_t(width)];
+		if (pixel < 0.0f || distance < pixel) pixel = distance;
+	}
+
+	// min filter 3x3 - closes gaps between splatted points. Pixels without any neighbour
+	// (disocclusions, new parts of the view) start ray-marching from the camera.
+	const float safetyFactor = 0.95f;
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			float minDistance = -1.0f;
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					int xx = x + dx;
+					int yy = y + dy;
+					if (xx < 0 || xx >= width || yy < 0 || yy >= height) continue;
+					float value = projected[size_t(xx) + size_t(yy) * size_t(width)];
+					if (value >= 0.0f && (minDistance < 0.0f || value < minDistance)) minDistance = value;
+				}
+			}
+			if (minDistance > 0.0f)
+				startDistance[size_t(x) + size_t(y) * size_t(width)] = minDistance * safetyFactor;
+		}
+	}
+
+	ready = true;
+}
@@ -0,0 +1,91 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cReprojectionCache - temporal cache of the Z-buffer for animation frames
+ *
+ * Hit points of the previous frame (world positions reconstructed from the Z-buffer) are
+ * projected into the camera of the next frame. The result is a per-pixel candidate distance from
+ * which the primary ray can start ray-marching. The candidate is only a hint: cRenderWorker
+ * verifies with distance estimation that the skipped part of the ray is empty, so hit criteria
+ * stay exactly the same as without the cache.
+ */
+
+#ifndef MANDELBULBER2_SRC_REPROJECTION_CACHE_HPP_
+#define MANDELBULBER2_SRC_REPROJECTION_CACHE_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "algebra.hpp"
+
+// forward declarations
+class cImage;
+struct sParamRender;
+struct sRenderData;
+
+class cReprojectionCache
+{
+public:
+	cReprojectionCache();
+	~cReprojectionCache();
+
+	// checks if rendering with given parameters can use the cache
+	static bool IsApplicable(const sParamRender &params, const sRenderData &data);
+
+	// prepares start distances for the new camera from previously stored frame
+	void Prepare(const sParamRender &params, const sRenderData &data, int width, int height);
+
+	// stores hit points of rendered frame
+	void Store(const cImage &image, const sParamRender &params, const sRenderData &data);
+
+	void Clear();
+	bool IsReady() const { return ready; }
+
+	float GetStartDistance(int x, int y) const
+	{
+		return startDistance[size_t(x) + size_t(y) * size_t(width)];
+	}
+
+	// the same rotation as in cRenderWorker::PrepareMainVectors()
+	static CRotationMatrix CameraRotation(const sParamRender &params);
+
+private:
+
+	// world positions of hit points from the previous frame (background pixels are skipped)
+	std::vector<CVector3> storedPoints;
+
+	std::vector<float> startDistance;
+	int width;
+	int height;
+	bool ready;
+};
+
+#endif /* MANDELBULBER2_SRC_REPROJECTION_CACHE_HPP_ */
@@ -32,14 +32,101 @@
  * cRenderWorker::GlobalIlumination method - calculates global illumination using Monte Carlo
  * algorithm
  */
+#include <limits>
+#include <vector>
+
 #include "calculate_distance.hpp"
 #include "common_math.h"
 #include "fractparams.hpp"
+#include "irradiance_cache.hpp"
 #include "render_data.hpp"
 #include "render_worker.hpp"
 
 sRGBFloat cRenderWorker::GlobalIlumination(
 	const sShaderInputData &input, sRGBAfloat objectColor) const
+{
+	if (data->irradianceCache)
+	{
+		sRGBFloat irradiance = CachedGlobalIlumination(input);
+		return sRGBFloat(
+			irradiance.R * objectColor.R, irradiance.G * objectColor.G, irradiance.B * objectColor.B);
+	}
+
+	CVector3 firstDirection;
+	double firstHitDistance;
+	return GlobalIluminationPath(input, objectColor, &firstDirection, &firstHitDistance);
+}
+
+sRGBFloat cRenderWorker::CachedGlobalIlumination(const sShaderInputData &input) const
+{
+	sRGBFloat irradiance;
+	if (data->irradianceCache->Lookup(input.point, input.normal, &irradiance)) return irradiance;
+
+	const sRGBAfloat white(1.0, 1.0, 1.0, 1.0);
+
+	// new records can't be stored anymore, so calculating many paths would be wasted
+	if (data->irradianceCache->IsFull())
+	{
+		CVector3 firstDirection;
+		double firstHitDistance;
+		return GlobalIluminationPath(input, white, &firstDirection, &firstHitDistance);
+	}
+
+	// new record is calculated from many paths, because it will be reused by many pixels
+	const int numberOfSamples = params->monteCarloGICacheSamples;
+	std::vector<sRGBFloat> samples(numberOfSamples);
+	std::vector<CVector3> directions(numberOfSamples);
+	std::vector<double> inverseDistances(numberOfSamples);
+
+	double sumR = 0.0, sumG = 0.0, sumB = 0.0;
+	double sumInverseDistance = 0.0;
+	for (int i = 0; i < numberOfSamples; i++)
+	{
+		double hitDistance;
+		samples[i] = GlobalIluminationPath(input, white, &directions[i], &hitDistance);
+		inverseDistances[i] = 1.0 / hitDistance;
+		sumR += samples[i].R;
+		sumG += samples[i].G;
+		sumB += samples[i].B;
+		sumInverseDistance += inverseDistances[i];
+	}
+	irradiance = sRGBFloat(sumR / numberOfSamples, sumG / numberOfSamples, sumB / numberOfSamples);
+
+	// validity radius is the harmonic mean distance to surrounding surfaces, limited to range
+	// related to the pixel size
+	double distThresh = CalcDistThresh(input.point);
+	double minRadius = distThresh * 10.0;
+	double maxRadius = distThresh * 1000.0;
+	double radius = (sumInverseDistance > 0.0) ? numberOfSamples / sumInverseDistance : maxRadius;
+	radius = qBound(minRadius, radius, maxRadius);
+
+	// translational gradient: samples brighter than average pull irradiance towards the direction
+	// where they come from, stronger when the reflecting surface is close
+	CVector3 gradient[3];
+	for (int i = 0; i < numberOfSamples; i++)
+	{
+		CVector3 tangent = directions[i] - input.normal * input.normal.Dot(directions[i]);
+		tangent *= inverseDistances[i] / numberOfSamples;
+		gradient[0] += tangent * (samples[i].R - irradiance.R);
+		gradient[1] += tangent * (samples[i].G - irradiance.G);
+		gradient[2] += tangent * (samples[i].B - irradiance.B);
+	}
+
+	// extrapolated irradiance can't drop below zero inside validity area
+	const float channels[3] = {irradiance.R, irradiance.G, irradiance.B};
+	for (int c = 0; c < 3; c++)
+	{
+		double change = gradient[c].Length() * radius;
+		if (change > channels[c]) gradient[c] *= channels[c] / change;
+	}
+
+	data->irradianceCache->Insert(input.point, input.normal, irradiance, gradient, radius);
+
+	return irradiance;
+}
+
+sRGBFloat cRenderWorker::GlobalIluminationPath(const sShaderInputData &input,
+	sRGBAfloat objectColor, CVector3 *firstDirection, double *firstHitDistance) const
 {
 	sRGBFloat out;
 	sShaderInputData inputCopy = input;
@@ -65,6 +152,12 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 		randomizedDirection.Normalize();
 		inputCopy.viewVector = randomizedDirection;
 
+		if (rayDepth == 0)
+		{
+			*firstDirection = randomizedDirection;
+			*firstHitDistance = std::numeric_limits<double>::infinity();
+		}
+
 		double dist = 0.0f;
 		bool found = false;
 		int objectId = 0;
@@ -97,6 +190,7 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 
 			if (dist < distThresh)
 			{
+				if (rayDepth == 0) *firstHitDistance = scan;
 				if (scan < distThresh * 2.0)
 				{
 					return out;
@@ -105,6 +199,7 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 				CVector3 vn = CalculateNormals(inputCopy);
 				inputCopy.normal = vn;
 				inputCopy.objectId = objectId;
+				inputCopy.colorIndex = -1.0;
 
 				found = true;
 				break;
@@ -120,24 +215,24 @@ sRGBFloat cRenderWorker::GlobalIlumination(
 			sRGBAfloat specular;
 			sRGBFloat iridescence;
 
-			cObjectData objectData = data->objectData[inputCopy.objectId];
-			inputCopy.material = &data->materials[objectData.materialId];
+			inputCopy.compiledMaterial = &data->materialTable.GetMaterial(inputCopy.objectId);
+			inputCopy.material = inputCopy.compiledMaterial->material;
 
 			// letting colors from textures (before normal map shader)
-			if (inputCopy.material->colorTexture.IsLoaded())
+			if (inputCopy.compiledMaterial->Has(sCompiledMaterial::flagColorTexture))
 			{
 				inputCopy.texColor = TextureShader(inputCopy, texture::texColor, inputCopy.material);
 			}
 			else
 				inputCopy.texColor = sRGBFloat(1.0, 1.0, 1.0);
 
-			if (inputCopy.material->luminosityTexture.IsLoaded())
+			if (inputCopy.compiledMaterial->Has(sCompiledMaterial::flagLuminosityTexture))
 				inputCopy.texLuminosity =
 					TextureShader(inputCopy, texture::texLuminosity, inputCopy.material);
 			else
 				inputCopy.texLuminosity = sRGBFloat(0.0, 0.0, 0.0);
 
-			if (inputCopy.material->diffusionTexture.IsLoaded())
+			if (inputCopy.compiledMaterial->Has(sCompiledMaterial::flagDiffusionTexture))
 				inputCopy.texDiffuse = TextureShader(inputCopy, texture::texDiffuse, inputCopy.material);
 			else
 				inputCopy.texDiffuse = sRGBFloat(1.0, 1.0, 1.0);
@@ -35,6 +35,7 @@
 #include "fractparams.hpp"
 #include "lights.hpp"
 #include "material.h"
+#include "material_table.hpp"
 #include "render_worker.hpp"
 
 sRGBAfloat cRenderWorker::LightShading(const sShaderInputData &input, sRGBAfloat surfaceColor,
@@ -76,7 +77,7 @@ sRGBAfloat cRenderWorker::LightShading(const sShaderInputData &input, sRGBAfloat
 	specular.G *= intensity;
 	specular.B *= intensity;
 
-	if (input.material->useColorsFromPalette && input.material->specularGradientEnable)
+	if (input.compiledMaterial->Has(sCompiledMaterial::flagSpecularGradient))
 	{
 		specular.R *= gradients->specular.R / 256.0;
 		specular.G *= gradients->specular.G / 256.0;
@@ -34,6 +34,7 @@
 
 #include "fractparams.hpp"
 #include "material.h"
+#include "material_table.hpp"
 #include "render_worker.hpp"
 
 sRGBAfloat cRenderWorker::ObjectShader(const sShaderInputData &_input, sRGBAfloat *surfaceColour,
@@ -117,7 +118,7 @@ sRGBAfloat cRenderWorker::ObjectShader(const sShaderInputData &_input, sRGBAfloa
 
 	// luminosity
 	sRGBAfloat luminosity;
-	if (mat->useColorsFromPalette && mat->luminosityGradientEnable)
+	if (input.compiledMaterial->Has(sCompiledMaterial::flagLuminosityGradient))
 	{
 		luminosity.R = input.texLuminosity.R * mat->luminosityTextureIntensity
 									 + mat->luminosity * gradients->luminosity.R;
@@ -33,6 +33,7 @@
  */
 #include "common_math.h"
 #include "material.h"
+#include "material_table.hpp"
 #include "render_worker.hpp"
 
 sRGBAfloat cRenderWorker::SpecularHighlight(const sShaderInputData &input, CVector3 lightVector,
@@ -54,7 +55,7 @@ sRGBAfloat cRenderWorker::SpecularHighlight(const sShaderInputData &input, CVect
 											* (input.texDiffuse.R + input.texDiffuse.G + input.texDiffuse.B) / 3.0f);
 	}
 
-	if (input.material->useColorsFromPalette && input.material->diffuseGradientEnable)
+	if (input.compiledMaterial->Has(sCompiledMaterial::flagDiffuseGradient))
 	{
 		diffuse *= 10.0f * (1.1f - (diffuseGradient.R + diffuseGradient.G + diffuseGradient.B) / 3.0f);
 	}
@@ -30,6 +30,7 @@
  * Authors: Krzysztof Marczak (buddhi1980@gmail.com)
  *
  * cRenderWorker::SurfaceColour method - calculates color of fractal surface
+ * cRenderWorker::CalculateColorIndex method - calculates colour index of fractal surface
  */
 #include "compute_fractal.hpp"
 #include "fractparams.hpp"
@@ -40,41 +41,24 @@ sRGBAfloat cRenderWorker::SurfaceColour(
 	const sShaderInputData &input, sGradientsCollection *gradients) const
 {
 	sRGBAfloat out;
+	const sCompiledMaterial *compiled = input.compiledMaterial;
 
-	switch (data->objectData[input.objectId].objectType)
+	switch (compiled->objectType)
 	{
 		case fractal::objFractal:
 		{
 			sRGBFloat colour(1.0, 1.0, 1.0);
-			if (input.material->useColorsFromPalette)
+			if (compiled->Has(sCompiledMaterial::flagColorsFromPalette))
 			{
-				int formulaIndex = input.objectId;
-
-				CVector3 tempPoint = input.point;
-
-				if (!params->booleanOperatorsEnabled)
-					formulaIndex = -1;
-				else
-				{
-					tempPoint = tempPoint - params->formulaPosition[formulaIndex];
-					tempPoint = params->mRotFormulaRotation[formulaIndex].RotateVector(tempPoint);
-					tempPoint = tempPoint.mod(params->formulaRepeat[formulaIndex]);
-					tempPoint *= params->formulaScale[formulaIndex];
-				}
-
-				sFractalIn fractIn(
-					tempPoint, 0, params->N * 4, &params->common, formulaIndex, false, input.material);
-				sFractalOut fractOut;
-				Compute<fractal::calcModeColouring>(*fractal, fractIn, &fractOut);
-				double nrCol = fmod(fabs(fractOut.colorIndex), 248.0 * 256.0); // kept for compatibility
+				double nrCol = (input.colorIndex >= 0.0) ? input.colorIndex : CalculateColorIndex(input);
 
 				double colorPosition = fmod(
 					nrCol / 256.0 / 10.0 * input.material->coloring_speed + input.material->paletteOffset,
 					1.0);
 
-				if (input.material->surfaceGradientEnable)
+				if (compiled->Has(sCompiledMaterial::flagSurfaceGradient))
 				{
-					colour = input.material->gradientSurface.GetColorFloat(colorPosition, false);
+					colour = compiled->GradientColor(sCompiledMaterial::gradientSurface, colorPosition);
 					// TODO - smooth mode for gradient
 					gradients->surface = colour;
 				}
@@ -85,39 +69,40 @@ sRGBAfloat cRenderWorker::SurfaceColour(
 					colour.B = input.material->color.B;
 				}
 
-				if (input.material->specularGradientEnable)
+				if (compiled->Has(sCompiledMaterial::flagSpecularGradient))
 				{
 					gradients->specular =
-						input.material->gradientSpecular.GetColorFloat(colorPosition, false);
+						compiled->GradientColor(sCompiledMaterial::gradientSpecular, colorPosition);
 				}
 
-				if (input.material->diffuseGradientEnable)
+				if (compiled->Has(sCompiledMaterial::flagDiffuseGradient))
 				{
-					gradients->diffuse = input.material->gradientDiffuse.GetColorFloat(colorPosition, false);
+					gradients->diffuse =
+						compiled->GradientColor(sCompiledMaterial::gradientDiffuse, colorPosition);
 				}
 
-				if (input.material->luminosityGradientEnable)
+				if (compiled->Has(sCompiledMaterial::flagLuminosityGradient))
 				{
 					gradients->luminosity =
-						input.material->gradientLuminosity.GetColorFloat(colorPosition, false);
+						compiled->GradientColor(sCompiledMaterial::gradientLuminosity, colorPosition);
 				}
 
-				if (input.material->roughnessGradientEnable)
+				if (compiled->Has(sCompiledMaterial::flagRoughnessGradient))
 				{
 					gradients->roughness =
-						input.material->gradientRoughness.GetColorFloat(colorPosition, false);
+						compiled->GradientColor(sCompiledMaterial::gradientRoughness, colorPosition);
 				}
 
-				if (input.material->reflectanceGradientEnable)
+				if (compiled->Has(sCompiledMaterial::flagReflectanceGradient))
 				{
 					gradients->reflectance =
-						input.material->gradientReflectance.GetColorFloat(colorPosition, false);
+						compiled->GradientColor(sCompiledMaterial::gradientReflectance, colorPosition);
 				}
 
-				if (input.material->transparencyGradientEnable)
+				if (compiled->Has(sCompiledMaterial::flagTransparencyGradient))
 				{
 					gradients->trasparency =
-						input.material->gradientTransparency.GetColorFloat(colorPosition, false);
+						compiled->GradientColor(sCompiledMaterial::gradientTransparency, colorPosition);
 				}
 			}
 			else
@@ -157,3 +142,26 @@ sRGBAfloat cRenderWorker::SurfaceColour(
 
 	return out;
 }
+
+double cRenderWorker::CalculateColorIndex(const sShaderInputData &input) const
+{
+	int formulaIndex = input.objectId;
+
+	CVector3 tempPoint = input.point;
+
+	if (!params->booleanOperatorsEnabled)
+		formulaIndex = -1;
+	else
+	{
+		tempPoint = tempPoint - params->formulaPosition[formulaIndex];
+		tempPoint = params->mRotFormulaRotation[formulaIndex].RotateVector(tempPoint);
+		tempPoint = tempPoint.mod(params->formulaRepeat[formulaIndex]);
+		tempPoint *= params->formulaScale[formulaIndex];
+	}
+
+	sFractalIn fractIn(
+		tempPoint, 0, params->N * 4, &params->common, formulaIndex, false, input.material);
+	sFractalOut fractOut;
+	Compute<fractal::calcModeColouring>(*fractal, fractIn, &fractOut);
+	return fmod(fabs(fractOut.colorIndex), 248.0 * 256.0); // kept for compatibility
+}
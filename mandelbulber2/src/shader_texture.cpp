@@ -44,7 +44,7 @@ using std::max;
 sRGBFloat cRenderWorker::TextureShader(
 	const sShaderInputData &input, texture::enumTextureSelection texSelect, cMaterial *mat) const
 {
-	cObjectData objectData = data->objectData[input.objectId];
+	const cObjectData &objectData = data->objectData[input.objectId];
 	double texturePixelSize = 0.0;
 	CVector3 textureVectorX, textureVectorY;
 
@@ -449,8 +449,7 @@ sRGBAfloat cRenderWorker::VolumetricShader(
 			for (int i = 0; i < data->lights.GetNumberOfLights(); ++i)
 			{
 				const cLight *light = data->lights.GetLight(i);
-				if (light->enabled && light->intensity > 0.0 && light->visibility > 0.0
-						&& light->type != cLight::lightDirectional)
+				if (light->IsVisibleAlongRays())
 				{
 					double lastMiniSteps = -1.0;
 					double miniStep;
@@ -0,0 +1,126 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cSSAODepthPyramid - min-max mipmap pyramid of z-buffer for hierarchical SSAO
+ */
+
+#include "ssao_depth_pyramid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cimage.hpp"
+
+constexpr float cSSAODepthPyramid::maxDepthRangeRatio;
+constexpr float cSSAODepthPyramid::maxDepth;
+
+cSSAODepthPyramid::cSSAODepthPyramid(const cImage *image, const cRegion<int> &region)
+{
+	levels = CreateLevels(region.width, region.height);
+	const sLevel &lastLevel = levels.back();
+	data.resize(quint64(lastLevel.offset + lastLevel.width * lastLevel.height) * 2);
+
+	for (int y = 0; y < region.height; y++)
+	{
+		for (int x = 0; x < region.width; x++)
+		{
+			const float z = std::min(image->GetPixelZBuffer(x + region.x1, y + region.y1), maxDepth);
+			const int index = (y * region.width + x) * 2;
+			data[index] = z;
+			data[index + 1] = z;
+		}
+	}
+
+	for (size_t l = 1; l < levels.size(); l++)
+	{
+		const sLevel &prev = levels[l - 1];
+		const sLevel &actual = levels[l];
+		for (int y = 0; y < actual.height; y++)
+		{
+			const int y1 = y * 2;
+			const int y2 = std::min(y * 2 + 1, prev.height - 1);
+			for (int x = 0; x < actual.width; x++)
+			{
+				const int x1 = x * 2;
+				const int x2 = std::min(x * 2 + 1, prev.width - 1);
+				const int i1 = (prev.offset + y1 * prev.width + x1) * 2;
+				const int i2 = (prev.offset + y1 * prev.width + x2) * 2;
+				const int i3 = (prev.offset + y2 * prev.width + x1) * 2;
+				const int i4 = (prev.offset + y2 * prev.width + x2) * 2;
+				const int index = (actual.offset + y * actual.width + x) * 2;
+				data[index] = std::min(std::min(data[i1], data[i2]), std::min(data[i3], data[i4]));
+				data[index + 1] =
+					std::max(std::max(data[i1 + 1], data[i2 + 1]), std::max(data[i3 + 1], data[i4 + 1]));
+			}
+		}
+	}
+}
+
+cSSAODepthPyramid::~cSSAODepthPyramid()
+{
+	// nothing to delete
+}
+
+std::vector<cSSAODepthPyramid::sLevel> cSSAODepthPyramid::CreateLevels(int width, int height)
+{
+	// odd sizes are rounded up, so every pixel has its cell on each level
+	std::vector<sLevel> levels;
+	int w = width;
+	int h = height;
+	int numberOfCells = 0;
+	while (true)
+	{
+		levels.push_back({w, h, numberOfCells});
+		numberOfCells += w * h;
+		if (w == 1 && h == 1) break;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+	return levels;
+}
+
+std::vector<cSSAODepthPyramid::sStep> cSSAODepthPyramid::CreateSteps(int width, int numberOfLevels)
+{
+	const float maxRadius = std::max(width / 2.0f, 2.0f);
+	const int numberOfSteps = 1 + int(std::ceil(stepsPerOctave * std::log2(maxRadius)));
+
+	std::vector<sStep> steps(numberOfSteps);
+	float previousRadius = 0.0f;
+	for (int i = 0; i < numberOfSteps; i++)
+	{
+		const float radius = std::min(std::exp2(float(i) / stepsPerOctave), maxRadius);
+		const float gap = std::max(radius - previousRadius, 1.0f);
+		steps[i].radius = radius;
+		steps[i].level = std::min(int(std::floor(std::log2(gap))), numberOfLevels - 1);
+		previousRadius = radius;
+	}
+	return steps;
+}
@@ -0,0 +1,100 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cSSAODepthPyramid - min-max mipmap pyramid of z-buffer for hierarchical SSAO
+ *
+ * Every level keeps minimum and maximum depth of 2x2 cells of the previous level. Long SSAO rays
+ * sample coarse levels, so distant occluders are found with a few lookups. Cells with big depth
+ * range are refined using finer levels.
+ */
+
+#ifndef MANDELBULBER2_SRC_SSAO_DEPTH_PYRAMID_HPP_
+#define MANDELBULBER2_SRC_SSAO_DEPTH_PYRAMID_HPP_
+
+#include <vector>
+
+#include "region.hpp"
+
+// forward declarations
+class cImage;
+
+class cSSAODepthPyramid
+{
+public:
+	struct sLevel
+	{
+		int width;
+		int height;
+		int offset; // index of the first cell in data
+	};
+
+	struct sStep
+	{
+		float radius; // distance from the shaded pixel in pixels
+		int level;		// pyramid level which covers the gap to previous step
+	};
+
+	cSSAODepthPyramid(const cImage *image, const cRegion<int> &region);
+	~cSSAODepthPyramid();
+
+	// coordinates are relative to the region and given in full resolution pixels
+	void GetMinMax(int level, int x, int y, float *zMin, float *zMax) const
+	{
+		const sLevel &l = levels[level];
+		const int index = (l.offset + (y >> level) * l.width + (x >> level)) * 2;
+		*zMin = data[index];
+		*zMax = data[index + 1];
+	}
+
+	int GetNumberOfLevels() const { return int(levels.size()); }
+	const std::vector<sLevel> &GetLevels() const { return levels; }
+	const std::vector<float> &GetData() const { return data; }
+
+	// layout of levels for given image size
+	static std::vector<sLevel> CreateLevels(int width, int height);
+
+	// radial steps of SSAO rays. Rays reach half of image width (the same as in standard SSAO)
+	static std::vector<sStep> CreateSteps(int width, int numberOfLevels);
+
+	// refine cell if its depth range is bigger than this fraction of distance to the cell
+	static constexpr float maxDepthRangeRatio = 0.1f;
+
+	// depth of background is limited, so distances between samples can be calculated in float
+	static constexpr float maxDepth = 1e10f;
+
+private:
+	static const int stepsPerOctave = 2;
+
+	std::vector<sLevel> levels;
+	std::vector<float> data; // pairs of minimum and maximum depth
+};
+
+#endif /* MANDELBULBER2_SRC_SSAO_DEPTH_PYRAMID_HPP_ */
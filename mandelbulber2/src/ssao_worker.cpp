@@ -45,6 +45,7 @@
 #include "common_math.h"
 #include "fractparams.hpp"
 #include "render_data.hpp"
+#include "ssao_depth_pyramid.hpp"
 
 cSSAOWorker::cSSAOWorker(const sParamRender *_params, sThreadData *_threadData,
 	const sRenderData *_data, std::shared_ptr<cImage> _image)
@@ -62,6 +63,13 @@ cSSAOWorker::~cSSAOWorker()
 
 void cSSAOWorker::doWork()
 {
+	if (threadData->depthPyramid)
+	{
+		DoWorkHierarchical();
+		emit finished();
+		return;
+	}
+
 	int quality = threadData->quality;
 	int startLineInit = threadData->startLine;
 	int startLine = threadData->region.y1;
@@ -70,7 +78,6 @@ void cSSAOWorker::doWork()
 	int height = threadData->region.height;
 	int startX = threadData->region.x1;
 	int endX = threadData->region.x2;
-	sRGBFloat aoColor = threadData->color;
 
 	std::vector<double> cosine(quality);
 	std::vector<double> sine(quality);
@@ -89,8 +96,6 @@ void cSSAOWorker::doWork()
 
 	double fov = params->fov;
 
-	float intensity = params->ambientOcclusion;
-
 	int listIndex = 0;
 
 	int step = threadData->progressive;
@@ -238,17 +243,7 @@ void cSSAOWorker::doWork()
 				if (total_ambient < 0) total_ambient = 0;
 			}
 
-			for (int xx = 0; xx < step; xx++)
-			{
-				if (x + xx >= endX - 1) break;
-				sRGB8 colour = image->GetPixelColor(x + xx, y);
-				sRGBFloat pixel = image->GetPixelPostImage(x + xx, y);
-				float shadeFactor = 1.0f / 256.0f * total_ambient * intensity * (1.0f - opacity);
-				pixel.R = pixel.R + colour.R * shadeFactor * aoColor.R;
-				pixel.G = pixel.G + colour.G * shadeFactor * aoColor.G;
-				pixel.B = pixel.B + colour.B * shadeFactor * aoColor.B;
-				image->PutPixelPostImage(x + xx, y, pixel);
-			}
+			ShadePixels(x, y, step, total_ambient, opacity);
 		}
 
 		threadData->done++;
@@ -260,3 +255,206 @@ void cSSAOWorker::doWork()
 	emit finished();
 	return;
 }
+
+void cSSAOWorker::DoWorkHierarchical()
+{
+	const cSSAODepthPyramid *pyramid = threadData->depthPyramid;
+	const int numberOfDirections = threadData->quality;
+	const int startX = threadData->region.x1;
+	const int startY = threadData->region.y1;
+	const int width = threadData->region.width;
+	const int height = threadData->region.height;
+	const params::enumPerspectiveType perspectiveType = params->perspectiveType;
+	const bool fishEye = perspectiveType == params::perspFishEye
+											 || perspectiveType == params::perspFishEyeCut;
+	const float fov = float(params->fov);
+	const float aspectRatio =
+		(perspectiveType == params::perspEquirectangular) ? 2.0f : float(width) / height;
+
+	// all trigonometric functions are calculated only once per render
+	std::vector<float> cosine(numberOfDirections);
+	std::vector<float> sine(numberOfDirections);
+	for (int i = 0; i < numberOfDirections; i++)
+	{
+		sine[i] = float(sin(double(i) / numberOfDirections * 2.0 * M_PI));
+		cosine[i] = float(cos(double(i) / numberOfDirections * 2.0 * M_PI));
+	}
+	const std::vector<cSSAODepthPyramid::sStep> steps =
+		cSSAODepthPyramid::CreateSteps(width, pyramid->GetNumberOfLevels());
+
+	// position on view plane (for z = 1) is separable for perspective and equirectangular
+	// projection: x = columnX * rowScale, y = rowY
+	std::vector<float> columnX(width);
+	std::vector<float> rowY(height);
+	std::vector<float> rowScale(height);
+	for (int x = 0; x < width; x++)
+	{
+		const float x2 = (float(x) / width - 0.5f) * aspectRatio;
+		if (perspectiveType == params::perspEquirectangular)
+			columnX[x] = sinf(fov * float(M_PI) * x2);
+		else
+			columnX[x] = x2 * fov;
+	}
+	for (int y = 0; y < height; y++)
+	{
+		const float y2 = float(y) / height - 0.5f;
+		if (perspectiveType == params::perspEquirectangular)
+		{
+			rowY[y] = sinf(fov * float(M_PI) * y2);
+			rowScale[y] = cosf(fov * float(M_PI) * y2);
+		}
+		else
+		{
+			rowY[y] = y2 * fov;
+			rowScale[y] = 1.0f;
+		}
+	}
+	auto ViewPlane = [&](int x, int y) {
+		if (fishEye)
+		{
+			float x2 = (float(x) / width - 0.5f) * aspectRatio;
+			float y2 = float(y) / height - 0.5f;
+			const float r = sqrtf(x2 * x2 + y2 * y2);
+			if (r != 0.0f)
+			{
+				x2 = x2 / r * sinf(r * fov);
+				y2 = y2 / r * sinf(r * fov);
+			}
+			return CVector2<float>(x2, y2);
+		}
+		return CVector2<float>(columnX[x] * rowScale[y], rowY[y]);
+	};
+
+	// lines to render in progressive mode
+	std::vector<bool> lineEnabled;
+	if (!threadData->list.isEmpty())
+	{
+		lineEnabled.resize(height, false);
+		for (int y : threadData->list)
+			lineEnabled[y - startY] = true;
+	}
+
+	int step = threadData->progressive;
+	if (step == 0) step = 1;
+
+	const int tilesX = (width + tileSize - 1) / tileSize;
+	const int tilesY = (height + tileSize - 1) / tileSize;
+	const int maxRandom = 62831 / numberOfDirections;
+
+	for (int tile = threadData->startLine - startY; tile < tilesX * tilesY;
+			 tile += threadData->noOfThreads)
+	{
+		const int tileX1 = (tile % tilesX) * tileSize;
+		const int tileY1 = (tile / tilesX) * tileSize;
+		const int tileX2 = qMin(tileX1 + tileSize, width);
+		const int tileY2 = qMin(tileY1 + tileSize, height);
+
+		for (int py = tileY1; py < tileY2; py++)
+		{
+			if (!lineEnabled.empty() && !lineEnabled[py]) continue;
+
+			// in progressive mode every step-th pixel is calculated (counted from image edge)
+			for (int px = tileX1 + (step - tileX1 % step) % step; px < tileX2; px += step)
+			{
+				const int x = px + startX;
+				const int y = py + startY;
+				const float z = image->GetPixelZBuffer(x, y);
+				const float opacity = image->GetPixelOpacity(x, y) / 65535.0f;
+				float totalAmbient = 0.0f;
+
+				if (z < 1e19f)
+				{
+					const CVector2<float> plane = ViewPlane(px, py);
+					const CVector2<float> position = plane * z;
+
+					// random mode rotates all directions and scales all steps of the pixel
+					float rRandom = 1.0f;
+					float rotationCos = 1.0f;
+					float rotationSin = 0.0f;
+					if (params->SSAO_random_mode)
+					{
+						rRandom = 0.5f + Random(65536) / 65536.0f;
+						const float angle = Random(maxRandom) / 10000.0f;
+						rotationCos = cosf(angle);
+						rotationSin = sinf(angle);
+					}
+
+					float ambient = 0.0f;
+					int rayCount = 0;
+					for (int d = 0; d < numberOfDirections; d++)
+					{
+						const float ca = cosine[d] * rotationCos - sine[d] * rotationSin;
+						const float sa = sine[d] * rotationCos + cosine[d] * rotationSin;
+
+						float maxDiff = -1e30f;
+						bool wasRay = false;
+						for (const cSSAODepthPyramid::sStep &s : steps)
+						{
+							const float xx = px + 0.5f + s.radius * rRandom * ca;
+							const float yy = py + 0.5f + s.radius * rRandom * sa;
+
+							// steps are sorted by radius, so next ones are outside the image too
+							if (xx < 0.0f || xx >= width || yy < 0.0f || yy >= height) break;
+							const int ix = int(xx);
+							const int iy = int(yy);
+							if (ix == px && iy == py) continue;
+
+							const CVector2<float> samplePlane = ViewPlane(ix, iy);
+							const float planeDistance = float((samplePlane - plane).Length()) * z;
+
+							// cells which contain depth discontinuities are checked on finer levels
+							int level = s.level;
+							float zMin, zMax;
+							pyramid->GetMinMax(level, ix, iy, &zMin, &zMax);
+							while (level > 0
+										 && zMax - zMin > cSSAODepthPyramid::maxDepthRangeRatio * planeDistance)
+							{
+								level--;
+								pyramid->GetMinMax(level, ix, iy, &zMin, &zMax);
+							}
+
+							wasRay = true;
+
+							const CVector2<float> delta = samplePlane * zMin - position;
+							const float diff = (z - zMin) / float(delta.Length());
+							if (diff > maxDiff) maxDiff = diff;
+						}
+
+						if (wasRay)
+						{
+							ambient += -atanf(maxDiff) / float(M_PI) + 0.5f;
+							rayCount++;
+						}
+					}
+
+					if (rayCount > 0) totalAmbient = qMax(ambient / rayCount, 0.0f);
+				}
+
+				ShadePixels(x, y, step, totalAmbient, opacity);
+			}
+		}
+
+		threadData->done++;
+
+		if (threadData->stopRequest) break;
+	}
+}
+
+void cSSAOWorker::ShadePixels(int x, int y, int step, float totalAmbient, float opacity)
+{
+	const float intensity = params->ambientOcclusion;
+	const sRGBFloat aoColor = threadData->color;
+	const int endX = threadData->region.x2;
+
+	for (int xx = 0; xx < step; xx++)
+	{
+		if (x + xx >= endX - 1) break;
+		sRGB8 colour = image->GetPixelColor(x + xx, y);
+		sRGBFloat pixel = image->GetPixelPostImage(x + xx, y);
+		float shadeFactor = 1.0f / 256.0f * totalAmbient * intensity * (1.0f - opacity);
+		pixel.R = pixel.R + colour.R * shadeFactor * aoColor.R;
+		pixel.G = pixel.G + colour.G * shadeFactor * aoColor.G;
+		pixel.B = pixel.B + colour.B * shadeFactor * aoColor.B;
+		image->PutPixelPostImage(x + xx, y, pixel);
+	}
+}
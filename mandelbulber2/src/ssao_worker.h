@@ -34,6 +34,7 @@
  * SSAO shades inner edges and corners. For each pixel the surrounding
  * z-buffer (depth from camera) is scanned and based on the angle of the surface
  * each pixel will be shaded. This class gets used in render_ssao.cpp as multiple threads.
+ * Hierarchical mode traces horizons on min-max depth pyramid and processes image in tiles.
  */
 
 #ifndef MANDELBULBER2_SRC_SSAO_WORKER_H_
@@ -52,6 +53,7 @@
 struct sParamRender;
 struct sRenderData;
 class cImage;
+class cSSAODepthPyramid;
 
 class cSSAOWorker : public QObject
 {
@@ -68,8 +70,12 @@ public:
 		bool stopRequest;
 		QList<int> list;
 		cRegion<int> region;
+		const cSSAODepthPyramid *depthPyramid; // nullptr for standard SSAO
 	};
 
+	// size of tiles used in hierarchical mode
+	static const int tileSize = 32;
+
 	cSSAOWorker(const sParamRender *_params, sThreadData *_threadData, const sRenderData *_data,
 		std::shared_ptr<cImage> _image);
 	~cSSAOWorker() override;
@@ -82,6 +88,10 @@ public:
 	sThreadData *threadData;
 	std::shared_ptr<cImage> image;
 
+private:
+	void DoWorkHierarchical();
+	void ShadePixels(int x, int y, int step, float totalAmbient, float opacity);
+
 public slots:
 	void doWork();
 
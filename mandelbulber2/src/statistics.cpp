@@ -41,6 +41,14 @@ cStatistics::cStatistics()
 	numberOfRaymarchings = 0;
 	numberOfRenderedPixels = 0;
 	totalNumberOfDOFRepeats = 0;
+	numberOfReprojectedRays = 0;
+	numberOfConeMarchingSteps = 0;
+	numberOfConeSkippedSteps = 0;
+	numberOfConeMarchedPixels = 0;
+	numberOfPrimaryRays = 0;
+	numberOfBackgroundRays = 0;
+	numberOfReshadedPixels = 0;
+	numberOfDistanceEvaluations = 0;
 	totalNoise = 0;
 	time = 0.0;
 }
@@ -54,7 +62,16 @@ void cStatistics::Reset()
 	numberOfRaymarchings = 0;
 	numberOfRenderedPixels = 0;
 	totalNumberOfDOFRepeats = 0;
+	numberOfReprojectedRays = 0;
+	numberOfConeMarchingSteps = 0;
+	numberOfConeSkippedSteps = 0;
+	numberOfConeMarchedPixels = 0;
+	numberOfPrimaryRays = 0;
+	numberOfBackgroundRays = 0;
+	numberOfReshadedPixels = 0;
+	numberOfDistanceEvaluations = 0;
 	time = 0.0;
+	openClDevicesThroughput.clear();
 	histogramIterations.Clear();
 	histogramStepCount.Clear();
 }
@@ -36,6 +36,7 @@
 #define MANDELBULBER2_SRC_STATISTICS_H_
 
 #include <QString>
+#include <QVector>
 
 #include "histogram.hpp"
 
@@ -51,9 +52,18 @@ public:
 	int numberOfRaymarchings;
 	size_t numberOfRenderedPixels;
 	long long totalNumberOfDOFRepeats;
+	long long numberOfReprojectedRays;
+	long long numberOfConeMarchingSteps;
+	long long numberOfConeSkippedSteps;
+	size_t numberOfConeMarchedPixels;
+	long long numberOfPrimaryRays;
+	long long numberOfBackgroundRays; // rays skipped by coverage mask of cone pre-pass
+	size_t numberOfReshadedPixels;
+	long long numberOfDistanceEvaluations;
 	double totalNoise;
 	double time;
 	QString usedDEType;
+	QVector<double> openClDevicesThroughput; // [pixels / s] for each OpenCL device
 
 	double GetTotalNumberOfIterations() const { return totalNumberOfIterations; }
 	double GetNumberOfIterationsPerPixel() const
@@ -68,6 +78,27 @@ public:
 		return double(totalNumberOfDOFRepeats) / numberOfRenderedPixels;
 	}
 	double GetAverageDOFNoise() const { return totalNoise / numberOfRenderedPixels; }
+	double GetReprojectedRaysPercentage() const
+	{
+		if (numberOfPrimaryRays == 0) return 0.0;
+		return double(numberOfReprojectedRays) / numberOfPrimaryRays * 100.0;
+	}
+	double GetConeMarchingSavedStepsPerPixel() const
+	{
+		if (numberOfConeMarchedPixels == 0) return 0.0;
+		return double(numberOfConeSkippedSteps - numberOfConeMarchingSteps)
+					 / numberOfConeMarchedPixels;
+	}
+	double GetBackgroundRaysPercentage() const
+	{
+		if (numberOfPrimaryRays == 0) return 0.0;
+		return double(numberOfBackgroundRays) / numberOfPrimaryRays * 100.0;
+	}
+	double GetDistanceEvaluationsPerRay() const
+	{
+		if (numberOfRaymarchings == 0) return 0.0;
+		return double(numberOfDistanceEvaluations) / numberOfRaymarchings;
+	}
 	void Reset();
 };
 
@@ -68,6 +68,7 @@ struct sSystemDirectories
 	QString GetOpenCLTempFolder() const { return dataDirectoryHidden + "openclTemp"; }
 	QString GetOpenCLCustomFormulasFolder() const { return dataDirectoryHidden + "customFormulas"; }
 	QString GetUndoFolder() const { return dataDirectoryHidden + "undo"; }
+	QString GetCheckpointsFolder() const { return dataDirectoryHidden + "checkpoints"; }
 
 	QString homeDir;
 	QString sharedDir;
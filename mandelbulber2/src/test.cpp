@@ -36,22 +36,34 @@
 
 #include <memory>
 
+#include <QBuffer>
+#include <QImage>
+
 #include "animation_flight.hpp"
 #include "animation_frames.hpp"
 #include "animation_keyframes.hpp"
 #include "cimage.hpp"
 #include "files.h"
+#include "fractparams.hpp"
 #include "headless.h"
 #include "initparameters.hpp"
 #include "interface.hpp"
 #include "keyframes.hpp"
+#include "light.h"
+#include "lights.hpp"
 #include "netrender.hpp"
+#include "nine_fractals.hpp"
 #include "opencl_global.h"
 #include "opencl_hardware.h"
+#include "render_data.hpp"
 #include "render_job.hpp"
+#include "render_worker.hpp"
 #include "rendering_configuration.hpp"
+#include "reprojection_cache.hpp"
+#include "scheduler.hpp"
 #include "settings.hpp"
 #include "system_directories.hpp"
+#include "texture.hpp"
 #include "write_log.hpp"
 
 QString Test::testFolder()
@@ -131,6 +143,8 @@ void Test::renderExamples() const
 		testPar->Set<int>("opencl_platform", gPar->Get<int>("opencl_platform"));
 		testPar->Set<int>("opencl_device_type", gPar->Get<int>("opencl_device_type"));
 		testPar->Set<QString>("opencl_device_list", gPar->Get<QString>("opencl_device_list"));
+		testPar->Set<bool>("opencl_cpu_co_rendering", gPar->Get<bool>("opencl_cpu_co_rendering"));
+		testPar->Set<bool>("opencl_adaptive_tiles", gPar->Get<bool>("opencl_adaptive_tiles"));
 
 		// log the opencl params
 		WriteLogCout(
@@ -316,6 +330,301 @@ void Test::testFlight() const
 		QVERIFY2(flightAnimation->slotRenderFlight(), "flight render failed.");
 }
 
+void Test::testReprojectionCacheWrapper() const
+{
+	if (IsBenchmarking()) return; // correctness test only
+	testReprojectionCache();
+}
+
+void Test::testReprojectionCache() const
+{
+	// renders the same flight frame with and without depth reprojected from the previous frame
+	// and compares the Z-buffers
+	const QString exampleFlightFile =
+		QDir::toNativeSeparators(systemDirectories.sharedDir + QDir::separator() + "examples"
+														 + QDir::separator() + "flight_anim_menger sponge_3.fract");
+
+	std::shared_ptr<cParameterContainer> testPar(new cParameterContainer());
+	std::shared_ptr<cFractalContainer> testParFractal(new cFractalContainer());
+	std::shared_ptr<cAnimationFrames> testAnimFrames(new cAnimationFrames());
+	std::shared_ptr<cKeyframes> testKeyframes(new cKeyframes());
+
+	testPar->SetContainerName("main");
+	InitParams(testPar);
+	/****************** TEMPORARY CODE FOR MATERIALS *******************/
+
+	InitMaterialParams(1, testPar);
+
+	/*******************************************************************/
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		testParFractal->at(i)->SetContainerName(QString("fractal") + QString::number(i));
+		InitFractalParams(testParFractal->at(i));
+	}
+	bool stopRequest = false;
+	cRenderingConfiguration config;
+	config.DisableRefresh();
+	config.DisableProgressiveRender();
+
+	cSettings parSettings(cSettings::formatFullText);
+	parSettings.BeQuiet(true);
+	parSettings.LoadFromFile(exampleFlightFile);
+	parSettings.Decode(testPar, testParFractal, testAnimFrames, testKeyframes);
+
+	const int size = 64;
+	testPar->Set("image_width", size);
+	testPar->Set("image_height", size);
+
+	// effects integrated along the whole ray disable the cache
+	testPar->Set("basic_fog_enabled", false);
+	testPar->Set("glow_enabled", false);
+	testPar->Set("volumetric_fog_enabled", false);
+	testPar->Set("iteration_fog_enable", false);
+	testPar->Set("clouds_enable", false);
+	testPar->Set("fake_lights_enabled", false);
+	testPar->Set("DOF_monte_carlo", false);
+	testPar->Set("stereo_enabled", false);
+	for (int lightId : cLights::GetListOfLights(testPar))
+		testPar->Set(cLight::Name("volumetric", lightId), false);
+
+	const int previousFrame = 50;
+	const int testedFrame = 51;
+
+	// reference frame
+	std::shared_ptr<cImage> imageReference(new cImage(size, size));
+	testAnimFrames->GetFrameAndConsolidate(testedFrame, testPar, testParFractal);
+	std::unique_ptr<cRenderJob> referenceJob(
+		new cRenderJob(testPar, testParFractal, imageReference, &stopRequest));
+	referenceJob->Init(cRenderJob::flightAnim, config);
+	QVERIFY2(referenceJob->Execute(), "reference render failed.");
+
+	// previous and tested frame with reprojection cache
+	std::shared_ptr<cImage> image(new cImage(size, size));
+	std::shared_ptr<cReprojectionCache> cache(new cReprojectionCache());
+	testAnimFrames->GetFrameAndConsolidate(previousFrame, testPar, testParFractal);
+	std::unique_ptr<cRenderJob> renderJob(
+		new cRenderJob(testPar, testParFractal, image, &stopRequest));
+	renderJob->SetReprojectionCache(cache);
+	renderJob->Init(cRenderJob::flightAnim, config);
+	QVERIFY2(renderJob->Execute(), "render of previous frame failed.");
+
+	testAnimFrames->GetFrameAndConsolidate(testedFrame, testPar, testParFractal);
+	renderJob->UpdateParameters(testPar, testParFractal);
+	QVERIFY2(renderJob->Execute(), "render with reprojection cache failed.");
+	QVERIFY2(cache->IsReady(), "reprojection cache was not used.");
+	QVERIFY2(renderJob->GetStatistics().numberOfReprojectedRays > 0, "no ray used reprojection.");
+
+	// ray-marching is jittered, so depths are compared with a tolerance
+	int differentPixels = 0;
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			float depthReference = imageReference->GetPixelZBuffer(x, y);
+			float depth = image->GetPixelZBuffer(x, y);
+			bool foundReference = depthReference < 1e19f;
+			bool found = depth < 1e19f;
+			if (found != foundReference
+					|| (found && fabs(depth - depthReference) > 0.05f * depthReference))
+				differentPixels++;
+		}
+	}
+	QVERIFY2(differentPixels <= size * size / 100,
+		QString("too many pixels differ with reprojection cache: %1").arg(differentPixels)
+			.toStdString()
+			.c_str());
+}
+
+void Test::testCompactTextureWrapper() const
+{
+	if (IsBenchmarking()) return; // correctness test only
+	testCompactTexture();
+}
+
+void Test::testCompactTexture() const
+{
+	// 8-bit texture in compact storage has to give the same filtered colours as float storage
+	// size is not a multiple of the tile size, so padding of tiles is also tested
+	const int width = 70;
+	const int height = 45;
+	QImage qImage(width, height, QImage::Format_RGB888);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			qImage.setPixel(x, y, qRgb((x * 37 + y * 11) % 256, (x * y) % 256, (x * 255) / width));
+		}
+	}
+	QByteArray encodedImage;
+	QBuffer buffer(&encodedImage);
+	buffer.open(QIODevice::WriteOnly);
+	QVERIFY2(qImage.save(&buffer, "PNG"), "can't encode test image.");
+
+	cTexture texture;
+	texture.FromQByteArray(&encodedImage, cTexture::useMipmaps);
+	QVERIFY2(texture.IsLoaded(), "test texture was not loaded.");
+	QVERIFY2(texture.GetStorage() == cTexture::storage8bit, "compact storage was not used.");
+
+	cTexture reference(texture);
+	reference.ConvertToFloatStorage();
+	QVERIFY2(reference.GetStorage() == cTexture::storageFloat, "conversion to float failed.");
+
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			const sRGBFloat pixel = texture.FastPixel(x, y);
+			const sRGBFloat pixelReference = reference.FastPixel(x, y);
+			QVERIFY2(pixel.R == pixelReference.R && pixel.G == pixelReference.G
+								 && pixel.B == pixelReference.B,
+				QString("texel %1 x %2 differs").arg(x).arg(y).toStdString().c_str());
+		}
+	}
+
+	// mipmaps of compact storage are quantized separately, so small differences are allowed
+	const float tolerance = 2.0f / 256.0f;
+	const float pixelSizes[] = {0.0f, 2.0f, 10.0f, 50.0f};
+	for (float pixelSize : pixelSizes)
+	{
+		for (int i = 0; i < 1000; i++)
+		{
+			const CVector2<float> point(i * 0.0173f, i * 0.0291f - 3.0f);
+			const sRGBFloat color = texture.Pixel(point, pixelSize);
+			const sRGBFloat colorReference = reference.Pixel(point, pixelSize);
+			const float difference = qMax(fabsf(color.R - colorReference.R),
+				qMax(fabsf(color.G - colorReference.G), fabsf(color.B - colorReference.B)));
+			QVERIFY2(difference <= tolerance,
+				QString("filtered colour differs by %1 (pixel size %2)")
+					.arg(difference)
+					.arg(pixelSize)
+					.toStdString()
+					.c_str());
+		}
+	}
+}
+
+void Test::testTiledRenderWrapper() const
+{
+	if (IsBenchmarking()) return; // correctness test only
+	testTiledRender();
+}
+
+void Test::testTiledRender() const
+{
+	// renders an image with rotated camera in one piece and in tiles with one reused render worker
+	// (as CPU threads of CPU + OpenCL co-rendering do) and compares the Z-buffers
+	const QString simpleExampleFileName =
+		QDir::toNativeSeparators(systemDirectories.sharedDir + QDir::separator() + "examples"
+														 + QDir::separator() + "mandelbox001.fract");
+
+	std::shared_ptr<cParameterContainer> testPar(new cParameterContainer());
+	std::shared_ptr<cFractalContainer> testParFractal(new cFractalContainer());
+	std::shared_ptr<cAnimationFrames> testAnimFrames(new cAnimationFrames());
+	std::shared_ptr<cKeyframes> testKeyframes(new cKeyframes());
+
+	testPar->SetContainerName("main");
+	InitParams(testPar);
+	/****************** TEMPORARY CODE FOR MATERIALS *******************/
+
+	InitMaterialParams(1, testPar);
+
+	/*******************************************************************/
+	for (int i = 0; i < NUMBER_OF_FRACTALS; i++)
+	{
+		testParFractal->at(i)->SetContainerName(QString("fractal") + QString::number(i));
+		InitFractalParams(testParFractal->at(i));
+	}
+	bool stopRequest = false;
+
+	cSettings parSettings(cSettings::formatFullText);
+	parSettings.BeQuiet(true);
+	parSettings.LoadFromFile(simpleExampleFileName);
+	parSettings.Decode(testPar, testParFractal, testAnimFrames, testKeyframes);
+
+	const int size = 64;
+	const int tileSize = size / 4;
+	testPar->Set("image_width", size);
+	testPar->Set("image_height", size);
+	testPar->Set("camera", CVector3(3.0, -4.0, 2.0));
+	testPar->Set("target", CVector3(0.0, 0.0, 0.0));
+	testPar->Set("camera_top", CVector3(0.3, 0.2, 0.9)); // roll
+	testPar->Set("DOF_monte_carlo", false);
+	testPar->Set("stereo_enabled", false);
+
+	// render data prepared the same way as in cRenderJob, without textures
+	std::shared_ptr<sRenderData> renderData(new sRenderData);
+	renderData->stopRequest = &stopRequest;
+	renderData->imageRegion.Set(-0.5, 0.5, 0.5, -0.5);
+	renderData->screenRegion.Set(0, 0, size, size);
+	CreateMaterialsMap(testPar, &renderData->materials, false, true, false);
+	renderData->lights.Set(testPar, testParFractal, false, true, false);
+	renderData->objectData.resize(NUMBER_OF_FRACTALS);
+
+	std::shared_ptr<sParamRender> params(new sParamRender(testPar, &renderData->objectData));
+	std::shared_ptr<cNineFractals> fractals(new cNineFractals(testParFractal, testPar));
+	renderData->ValidateObjects();
+	params->resolution = 1.0 / size;
+	renderData->statistics.histogramIterations.Resize(testPar->Get<int>("N"));
+	renderData->statistics.histogramStepCount.Resize(1000);
+	renderData->statistics.Reset();
+
+	// whole image
+	std::shared_ptr<cImage> imageReference(new cImage(size, size));
+	{
+		std::shared_ptr<cRenderWorker::sThreadData> threadData(new cRenderWorker::sThreadData);
+		threadData->id = 1;
+		threadData->startLine = 0;
+		threadData->scheduler.reset(new cScheduler(renderData->screenRegion, 1));
+		cRenderWorker worker(params, fractals, threadData, renderData, imageReference);
+		worker.doWork();
+	}
+
+	// tiles rendered by one worker
+	std::shared_ptr<cImage> image(new cImage(size, size));
+	{
+		std::shared_ptr<cRenderWorker::sThreadData> threadData(new cRenderWorker::sThreadData);
+		threadData->id = 1;
+		threadData->ownRegion = true;
+		cRenderWorker worker(params, fractals, threadData, renderData, image);
+		for (int tileY = 0; tileY < size; tileY += tileSize)
+		{
+			for (int tileX = 0; tileX < size; tileX += tileSize)
+			{
+				cRegion<int> tileRegion(tileX, tileY, tileX + tileSize, tileY + tileSize);
+				CVector2<double> corner1 = renderData->screenRegion.transpose(
+					renderData->imageRegion, CVector2<int>(tileRegion.x1, tileRegion.y1));
+				CVector2<double> corner2 = renderData->screenRegion.transpose(
+					renderData->imageRegion, CVector2<int>(tileRegion.x2, tileRegion.y2));
+				threadData->screenRegion = tileRegion;
+				threadData->imageRegion.Set(corner1.x, corner1.y, corner2.x, corner2.y);
+				threadData->startLine = tileRegion.y1;
+				threadData->scheduler.reset(new cScheduler(tileRegion, 1));
+				worker.doWork();
+			}
+		}
+	}
+
+	// ray-marching is jittered, so depths are compared with a tolerance
+	int differentPixels = 0;
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			float depthReference = imageReference->GetPixelZBuffer(x, y);
+			float depth = image->GetPixelZBuffer(x, y);
+			bool foundReference = depthReference < 1e19f;
+			bool found = depth < 1e19f;
+			if (found != foundReference
+					|| (found && fabs(depth - depthReference) > 0.05f * depthReference))
+				differentPixels++;
+		}
+	}
+	QVERIFY2(differentPixels <= size * size / 100,
+		QString("too many pixels differ in tiled render: %1").arg(differentPixels)
+			.toStdString()
+			.c_str());
+}
+
 void Test::testKeyframeWrapper() const
 {
 	if (IsBenchmarking())
@@ -67,6 +67,9 @@ private:
 	void renderExamples() const;
 	void testFlight() const;
 	void testKeyframe() const;
+	void testReprojectionCache() const;
+	void testCompactTexture() const;
+	void testTiledRender() const;
 	void renderSimple() const;
 	void renderImageSave() const;
 
@@ -77,6 +80,9 @@ private slots:
 	void netrender();
 	void testFlightWrapper() const;
 	void testKeyframeWrapper() const;
+	void testReprojectionCacheWrapper() const;
+	void testCompactTextureWrapper() const;
+	void testTiledRenderWrapper() const;
 	void renderSimpleWrapper() const;
 	void testImageSaveWrapper() const;
 };
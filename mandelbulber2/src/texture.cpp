@@ -42,12 +42,16 @@
 
 #include <memory>
 
+#include <QDateTime>
+#include <QFileInfo>
+
 #include "common_math.h"
 #include "error_message.hpp"
 #include "files.h"
 #include "netrender.hpp"
 #include "qimage.h"
 #include "radiance_hdr.h"
+#include "render_trace.hpp"
 #include "resource_http_provider.hpp"
 #include "write_log.hpp"
 
@@ -55,7 +59,9 @@
 cTexture::cTexture(
 	QString filename, enumUseMipmaps mode, int frameNo, bool beQuiet, bool useNetRender)
 {
+	cTraceSpan traceSpan("cTexture::Load", "texture");
 	WriteLogString("Loading texture", filename, 2);
+	storage = storageFloat;
 
 	if (gNetRender->IsClient() && useNetRender)
 	{
@@ -74,11 +80,33 @@ cTexture::cTexture(
 		if (httpProvider.IsUrl()) filename = httpProvider.cacheAndGetFilename();
 	}
 
+	// the same file (with the same modification time) can be already decoded
+	QString cacheKey;
+	if (cacheEnabled)
+	{
+		cacheKey = QString("%1|%2|%3")
+								 .arg(filename)
+								 .arg(int(mode))
+								 .arg(QFileInfo(filename).lastModified().toMSecsSinceEpoch());
+		QMutexLocker lock(&cacheMutex);
+		auto cached = cache.constFind(cacheKey);
+		if (cached != cache.constEnd())
+		{
+			*this = cached.value();
+			WriteLogString("Loading texture - taken from cache", filename, 3);
+			return;
+		}
+	}
+
+	// bits per channel of source image (0 for floating point images)
+	int bitsPerChannel = 0;
+
 	// try to load image if it's PNG format (this one supports 16-bit depth images)
 	WriteLogString("Loading texture - LoadPNG()", filename, 3);
 	std::vector<sRGBA16> bitmap16 = LoadPNG(filename, width, height);
 	if (!bitmap16.empty())
 	{
+		bitsPerChannel = 16;
 		bitmap.resize(bitmap16.size());
 		for (quint64 i = 0; i < bitmap16.size(); i++)
 		{
@@ -93,6 +121,7 @@ cTexture::cTexture(
 	if (radiance->Init(filename, &width, &height))
 	{
 		radiance->Load(&bitmap);
+		bitsPerChannel = 0;
 		loaded = true;
 	}
 
@@ -107,6 +136,7 @@ cTexture::cTexture(
 		{
 			width = qImage.width();
 			height = qImage.height();
+			bitsPerChannel = 8;
 			bitmap.resize(width * height);
 			for (int y = 0; y < height; y++)
 			{
@@ -124,11 +154,8 @@ cTexture::cTexture(
 	{
 		loaded = true;
 		originalFileName = filename;
-		if (mode == useMipmaps)
-		{
-			WriteLogString("Loading texture - CreateMipMaps()", filename, 3);
-			CreateMipMaps();
-		}
+		WriteLogString("Loading texture - PrepareStorage()", filename, 3);
+		PrepareStorage(mode, bitsPerChannel);
 	}
 	else
 	{
@@ -142,6 +169,13 @@ cTexture::cTexture(
 		std::fill(bitmap.begin(), bitmap.end(), sRGBFloat(1.0, 1.0, 1.0));
 	}
 
+	if (cacheEnabled && loaded)
+	{
+		QMutexLocker lock(&cacheMutex);
+		if (cache.size() >= maxCacheSize) cache.clear();
+		cache.insert(cacheKey, *this);
+	}
+
 	WriteLogString("Loading texture - finished", filename, 3);
 }
 
@@ -155,6 +189,8 @@ cTexture::cTexture(const cTexture &tex)
 	originalFileName = tex.originalFileName;
 	mipmaps = tex.mipmaps;
 	mipmapSizes = tex.mipmapSizes;
+	compactTexture = tex.compactTexture;
+	storage = tex.storage;
 }
 
 // move cotructor
@@ -167,6 +203,8 @@ cTexture::cTexture(cTexture &&other)
 	originalFileName = std::move(other.originalFileName);
 	mipmaps = std::move(other.mipmaps);
 	mipmapSizes = std::move(other.mipmapSizes);
+	compactTexture = std::move(other.compactTexture);
+	storage = other.storage;
 }
 
 cTexture &cTexture::operator=(const cTexture &tex)
@@ -178,6 +216,8 @@ cTexture &cTexture::operator=(const cTexture &tex)
 	originalFileName = tex.originalFileName;
 	mipmaps = tex.mipmaps;
 	mipmapSizes = tex.mipmapSizes;
+	compactTexture = tex.compactTexture;
+	storage = tex.storage;
 
 	return *this;
 }
@@ -191,6 +231,8 @@ cTexture &cTexture::operator=(cTexture &&other)
 	originalFileName = std::move(other.originalFileName);
 	mipmaps = std::move(other.mipmaps);
 	mipmapSizes = std::move(other.mipmapSizes);
+	compactTexture = std::move(other.compactTexture);
+	storage = other.storage;
 
 	return *this;
 }
@@ -218,10 +260,7 @@ void cTexture::FromQByteArray(QByteArray *buffer, enumUseMipmaps mode)
 
 		loaded = true;
 
-		if (mode == useMipmaps)
-		{
-			CreateMipMaps();
-		}
+		PrepareStorage(mode, 8);
 	}
 	else
 	{
@@ -230,6 +269,8 @@ void cTexture::FromQByteArray(QByteArray *buffer, enumUseMipmaps mode)
 		width = defaultSize;
 		height = defaultSize;
 		loaded = false;
+		compactTexture.Clear();
+		storage = storageFloat;
 		bitmap.resize(defaultSize * defaultSize);
 		std::fill(bitmap.begin(), bitmap.end(), sRGBFloat(1.0, 1.0, 1.0));
 	}
@@ -240,6 +281,7 @@ cTexture::cTexture()
 	width = defaultSize;
 	height = defaultSize;
 	loaded = false;
+	storage = storageFloat;
 	bitmap.resize(defaultSize * defaultSize);
 	std::fill(bitmap.begin(), bitmap.end(), sRGBFloat(1.0, 1.0, 1.0));
 }
@@ -276,6 +318,8 @@ sRGBFloat cTexture::Pixel(CVector2<float> point, float pixelSize) const
 
 sRGBFloat cTexture::LinearInterpolation(float x, float y) const
 {
+	if (storage != storageFloat) return compactTexture.Bilinear(0, x, y);
+
 	sRGBFloat color;
 	const int ix = int(x);
 	const int iy = int(y);
@@ -303,15 +347,19 @@ sRGBFloat cTexture::BicubicInterpolation(float x, float y, const sRGBFloat *bitm
 
 	float R[4][4], G[4][4], B[4][4];
 
+	// wrapped coordinates are calculated once per axis
+	int xs[4], rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		xs[i] = (ix + i - 1 + w) % w;
+		rows[i] = ((iy + i - 1 + h) % h) * w;
+	}
+
 	for (int yy = 0; yy < 4; yy++)
 	{
 		for (int xx = 0; xx < 4; xx++)
 		{
-			int ixx = ix + xx - 1;
-			int iyy = iy + yy - 1;
-			ixx = (ixx + w) % w;
-			iyy = (iyy + h) % h;
-			const int address2 = ixx + iyy * w;
+			const int address2 = xs[xx] + rows[yy];
 			const sRGBFloat pixel = bitm[address2];
 			R[xx][yy] = pixel.R;
 			G[xx][yy] = pixel.G;
@@ -334,6 +382,7 @@ sRGBFloat cTexture::BicubicInterpolation(float x, float y, const sRGBFloat *bitm
 
 sRGBFloat cTexture::FastPixel(int x, int y) const
 {
+	if (storage != storageFloat) return compactTexture.Texel(0, x, y);
 	return bitmap[x + y * width];
 }
 
@@ -381,15 +430,33 @@ CVector3 cTexture::NormalMap(
 	return normal;
 }
 
+int cTexture::NumberOfLevels() const
+{
+	if (storage != storageFloat) return compactTexture.GetNumberOfLevels();
+	return mipmaps.size() + 1;
+}
+
+// bicubic interpolation on selected mipmap level (0 is the original bitmap)
+sRGBFloat cTexture::LevelBicubic(int level, float x, float y) const
+{
+	if (storage != storageFloat) return compactTexture.Bicubic(level, x, y);
+
+	if (level == 0) return BicubicInterpolation(x, y, bitmap.data(), width, height);
+
+	const CVector2<int> &size = mipmapSizes[level - 1];
+	return BicubicInterpolation(x, y, mipmaps[level - 1].data(), size.x, size.y);
+}
+
 sRGBFloat cTexture::MipMap(float x, float y, float pixelSize) const
 {
 	pixelSize /= float(max(width, height));
-	if (mipmaps.size() > 0 && pixelSize > 0)
+	const int numberOfMipmaps = NumberOfLevels() - 1;
+	if (numberOfMipmaps > 0 && pixelSize > 0)
 	{
 		if (pixelSize < 1e-20f) pixelSize = 1e-20f;
 		float dMipLayer = -log(pixelSize) / log(2.0f);
 		if (dMipLayer < 0) dMipLayer = 0;
-		if (dMipLayer + 1 >= mipmaps.size() - 1) dMipLayer = mipmaps.size() - 1;
+		if (dMipLayer + 1 >= numberOfMipmaps - 1) dMipLayer = numberOfMipmaps - 1;
 
 		const int layerBig = int(dMipLayer);
 		const int layerSmall = int(dMipLayer + 1);
@@ -398,30 +465,13 @@ sRGBFloat cTexture::MipMap(float x, float y, float pixelSize) const
 		const float trans = dMipLayer - layerBig;
 		const float transN = 1.0f - trans;
 
-		const sRGBFloat *bigBitmap, *smallBitmap;
-		CVector2<int> bigBitmapSize, smallBitmapSize;
-		if (layerBig >= 0 && layerBig <= mipmaps.length() && layerSmall >= 0
-				&& layerSmall <= mipmaps.length())
+		if (layerBig >= 0 && layerBig <= numberOfMipmaps && layerSmall >= 0
+				&& layerSmall <= numberOfMipmaps)
 		{
-			if (layerBig == 0)
-			{
-				bigBitmap = bitmap.data();
-				smallBitmap = mipmaps[layerSmall - 1].data();
-				bigBitmapSize.x = width;
-				bigBitmapSize.y = height;
-				smallBitmapSize = mipmapSizes[layerSmall - 1];
-			}
-			else
-			{
-				bigBitmap = mipmaps[layerBig - 1].data();
-				smallBitmap = mipmaps[layerSmall - 1].data();
-				bigBitmapSize = mipmapSizes[layerBig - 1];
-				smallBitmapSize = mipmapSizes[layerSmall - 1];
-			}
-			const sRGBFloat pixelFromBig = BicubicInterpolation(
-				x / sizeMultipleBig, y / sizeMultipleBig, bigBitmap, bigBitmapSize.x, bigBitmapSize.y);
-			const sRGBFloat pixelFromSmall = BicubicInterpolation(x / sizeMultipleSmall,
-				y / sizeMultipleSmall, smallBitmap, smallBitmapSize.x, smallBitmapSize.y);
+			const sRGBFloat pixelFromBig =
+				LevelBicubic(layerBig, x / sizeMultipleBig, y / sizeMultipleBig);
+			const sRGBFloat pixelFromSmall =
+				LevelBicubic(layerSmall, x / sizeMultipleSmall, y / sizeMultipleSmall);
 
 			sRGBFloat pixel;
 			pixel.R = float(pixelFromSmall.R * trans + pixelFromBig.R * transN);
@@ -436,7 +486,7 @@ sRGBFloat cTexture::MipMap(float x, float y, float pixelSize) const
 	}
 	else
 	{
-		return BicubicInterpolation(x, y, bitmap.data(), width, height);
+		return LevelBicubic(0, x, y);
 	}
 }
 
@@ -477,3 +527,54 @@ void cTexture::CreateMipMaps()
 		prevBitmap = mipmaps.last().data();
 	}
 }
+
+// 8-bit and 16-bit images are kept in compact storage, which uses 4 or 2 times less memory
+void cTexture::PrepareStorage(enumUseMipmaps mode, int bitsPerChannel)
+{
+	mipmaps.clear();
+	mipmapSizes.clear();
+	compactTexture.Clear();
+
+	if (bitsPerChannel == 0)
+	{
+		storage = storageFloat;
+		if (mode == useMipmaps) CreateMipMaps();
+	}
+	else
+	{
+		compactTexture.Create(bitmap, width, height, bitsPerChannel, mode == useMipmaps);
+		storage = (bitsPerChannel > 8) ? storage16bit : storage8bit;
+		bitmap.clear();
+		bitmap.shrink_to_fit();
+	}
+}
+
+void cTexture::ConvertToFloatStorage()
+{
+	if (storage == storageFloat) return;
+
+	bitmap.resize(quint64(width) * height);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			bitmap[x + quint64(y) * width] = compactTexture.Texel(0, x, y);
+		}
+	}
+
+	const bool hasMipmaps = compactTexture.GetNumberOfLevels() > 1;
+	compactTexture.Clear();
+	storage = storageFloat;
+	if (hasMipmaps) CreateMipMaps();
+}
+
+void cTexture::EnableCache(bool enable)
+{
+	QMutexLocker lock(&cacheMutex);
+	cacheEnabled = enable;
+	if (!enable) cache.clear();
+}
+
+bool cTexture::cacheEnabled = false;
+QMutex cTexture::cacheMutex;
+QHash<QString, cTexture> cTexture::cache;
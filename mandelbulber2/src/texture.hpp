@@ -36,13 +36,17 @@
  * Pixel(...) gets the pixel at a given point. The image data is MipMap-ped and
  * bicubic interpolated to give a "smooth" result.
  * more information on Mipmaps:  https://en.wikipedia.org/wiki/Mipmap
+ * 8-bit and 16-bit images are kept in cCompactTexture (integer channels, tiled layout),
+ * HDR images are kept as float bitmap.
  */
 
 #ifndef MANDELBULBER2_SRC_TEXTURE_HPP_
 #define MANDELBULBER2_SRC_TEXTURE_HPP_
 
 #include <QByteArray>
+#include <QHash>
 #include <QList>
+#include <QMutex>
 #include <QString>
 #include <QVector>
 
@@ -50,6 +54,7 @@
 
 #include "algebra.hpp"
 #include "color_structures.hpp"
+#include "texture_compact.hpp"
 
 class cTexture
 {
@@ -60,6 +65,13 @@ public:
 		useMipmaps
 	};
 
+	enum enumStorage
+	{
+		storageFloat,
+		storage8bit,
+		storage16bit
+	};
+
 	cTexture(QString filename, enumUseMipmaps mode, int frameNo, bool beQuiet, bool useNetRender);
 	cTexture();
 	cTexture(const cTexture &tex);
@@ -74,17 +86,26 @@ public:
 	sRGBFloat Pixel(CVector2<float> point, float pixelSize = 0.0) const;
 	sRGBFloat FastPixel(int x, int y) const;
 	bool IsLoaded() const { return loaded; }
+	enumStorage GetStorage() const { return storage; }
+	// decodes compact storage to float bitmap (with mipmaps if they were used)
+	void ConvertToFloatStorage();
 	QString GetFileName() const { return originalFileName; }
 	void FromQByteArray(QByteArray *buffer, enumUseMipmaps mode);
 	CVector3 NormalMapFromBumpMap(CVector2<float> point, float bump, float pixelSize = 0.0) const;
 	CVector3 NormalMap(
 		CVector2<float> point, float bump, bool invertGreen, float pixelSize = 0.0) const;
 
+	// cache of decoded textures used by long running processes (render daemon)
+	static void EnableCache(bool enable);
+
 private:
 	sRGBFloat LinearInterpolation(float x, float y) const;
 	static sRGBFloat BicubicInterpolation(float x, float y, const sRGBFloat *_bitmap, int w, int h);
 	sRGBFloat MipMap(float x, float y, float pixelSize) const;
+	sRGBFloat LevelBicubic(int level, float x, float y) const;
+	int NumberOfLevels() const;
 	void CreateMipMaps();
+	void PrepareStorage(enumUseMipmaps mode, int bitsPerChannel);
 	static int WrapInt(int a, int size) { return (a + size) % size; }
 	std::vector<sRGBFloat> bitmap;
 	int width;
@@ -93,8 +114,15 @@ private:
 	QString originalFileName;
 	QList<QVector<sRGBFloat>> mipmaps;
 	QList<CVector2<int>> mipmapSizes;
+	cCompactTexture compactTexture;
+	enumStorage storage;
 
 	static const int defaultSize = 5;
+
+	static bool cacheEnabled;
+	static QMutex cacheMutex;
+	static QHash<QString, cTexture> cache;
+	static const int maxCacheSize = 64;
 };
 
 #endif /* MANDELBULBER2_SRC_TEXTURE_HPP_ */
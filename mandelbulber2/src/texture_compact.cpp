@@ -0,0 +1,253 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cCompactTexture - texture storage with 8 or 16 bits per channel
+ */
+
+#include "texture_compact.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+cCompactTexture::cCompactTexture()
+{
+	bitsPerChannel = 0;
+	scale = 0.0f;
+}
+
+cCompactTexture::~cCompactTexture()
+{
+	// nothing to delete
+}
+
+void cCompactTexture::Clear()
+{
+	data8.clear();
+	data8.shrink_to_fit();
+	data16.clear();
+	data16.shrink_to_fit();
+	levels.clear();
+	bitsPerChannel = 0;
+	scale = 0.0f;
+}
+
+void cCompactTexture::Create(const std::vector<sRGBFloat> &bitmap, int width, int height,
+	int _bitsPerChannel, bool createMipmaps)
+{
+	Clear();
+	bitsPerChannel = (_bitsPerChannel > 8) ? 16 : 8;
+	scale = 1.0f / float(1 << bitsPerChannel);
+
+	// layout of all mipmap levels. Levels are padded to whole tiles
+	quint64 numberOfTexels = 0;
+	int w = width;
+	int h = height;
+	while (w > 0 && h > 0)
+	{
+		sLevel level;
+		level.width = w;
+		level.height = h;
+		level.tilesX = (w + tileSize - 1) / tileSize;
+		level.offset = numberOfTexels;
+		const int tilesY = (h + tileSize - 1) / tileSize;
+		numberOfTexels += quint64(level.tilesX) * tilesY * tileSize * tileSize;
+		levels.push_back(level);
+
+		if (!createMipmaps) break;
+		w /= 2;
+		h /= 2;
+	}
+
+	if (bitsPerChannel == 8)
+		data8.resize(numberOfTexels * channels, 0);
+	else
+		data16.resize(numberOfTexels * channels, 0);
+
+	// mipmaps are calculated the same way as in cTexture::CreateMipMaps()
+	std::vector<sRGBFloat> actualLevel = bitmap;
+	std::vector<sRGBFloat> nextLevel;
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		if (bitsPerChannel == 8)
+			Store(&data8, actualLevel, levels[l]);
+		else
+			Store(&data16, actualLevel, levels[l]);
+
+		if (l + 1 == levels.size()) break;
+
+		const int prevW = levels[l].width;
+		const int prevH = levels[l].height;
+		const int nextW = levels[l + 1].width;
+		const int nextH = levels[l + 1].height;
+		nextLevel.resize(quint64(nextW) * nextH);
+		for (int y = 0; y < nextH; y++)
+		{
+			const int y1 = ((y * 2) % prevH) * prevW;
+			const int y2 = ((y * 2 + 1) % prevH) * prevW;
+			for (int x = 0; x < nextW; x++)
+			{
+				const int x1 = (x * 2) % prevW;
+				const int x2 = (x * 2 + 1) % prevW;
+				const sRGBFloat p1 = actualLevel[x1 + y1];
+				const sRGBFloat p2 = actualLevel[x2 + y1];
+				const sRGBFloat p3 = actualLevel[x1 + y2];
+				const sRGBFloat p4 = actualLevel[x2 + y2];
+				sRGBFloat newPixel;
+				newPixel.R = (p1.R + p2.R + p3.R + p4.R) / 4.0f;
+				newPixel.G = (p1.G + p2.G + p3.G + p4.G) / 4.0f;
+				newPixel.B = (p1.B + p2.B + p3.B + p4.B) / 4.0f;
+				nextLevel[x + y * nextW] = newPixel;
+			}
+		}
+		actualLevel.swap(nextLevel);
+	}
+}
+
+template <typename T>
+void cCompactTexture::Store(
+	std::vector<T> *data, const std::vector<sRGBFloat> &bitmap, const sLevel &level)
+{
+	const float multiplier = float(1 << bitsPerChannel);
+	const float maxValue = float((1 << bitsPerChannel) - 1);
+	for (int y = 0; y < level.height; y++)
+	{
+		for (int x = 0; x < level.width; x++)
+		{
+			const sRGBFloat pixel = bitmap[x + quint64(y) * level.width];
+			T *texel = &(*data)[TexelIndex(level, x, y) * channels];
+			texel[0] = T(std::min(std::max(std::round(pixel.R * multiplier), 0.0f), maxValue));
+			texel[1] = T(std::min(std::max(std::round(pixel.G * multiplier), 0.0f), maxValue));
+			texel[2] = T(std::min(std::max(std::round(pixel.B * multiplier), 0.0f), maxValue));
+		}
+	}
+}
+
+quint64 cCompactTexture::GetMemorySize() const
+{
+	return data8.size() * sizeof(quint8) + data16.size() * sizeof(quint16);
+}
+
+sRGBFloat cCompactTexture::Texel(int levelIndex, int x, int y) const
+{
+	const sLevel &level = levels[levelIndex];
+	const quint64 index = TexelIndex(level, x, y) * channels;
+	if (bitsPerChannel == 8)
+		return sRGBFloat(data8[index] * scale, data8[index + 1] * scale, data8[index + 2] * scale);
+	else
+		return sRGBFloat(data16[index] * scale, data16[index + 1] * scale, data16[index + 2] * scale);
+}
+
+// weighted sum of taps x taps texels. Loops over channels have constant length, so they can be
+// vectorized by the compiler
+template <typename T>
+void cCompactTexture::Gather(const T *data, const sLevel &level, const int *xs, const int *ys,
+	const float *weightsX, const float *weightsY, int taps, float *result) const
+{
+	for (int c = 0; c < channels; c++)
+		result[c] = 0.0f;
+
+	for (int j = 0; j < taps; j++)
+	{
+		float row[channels] = {0.0f, 0.0f, 0.0f};
+		for (int i = 0; i < taps; i++)
+		{
+			const T *texel = &data[TexelIndex(level, xs[i], ys[j]) * channels];
+			for (int c = 0; c < channels; c++)
+				row[c] += weightsX[i] * float(texel[c]);
+		}
+		for (int c = 0; c < channels; c++)
+			result[c] += weightsY[j] * row[c];
+	}
+}
+
+sRGBFloat cCompactTexture::Bilinear(int levelIndex, float x, float y) const
+{
+	const sLevel &level = levels[levelIndex];
+	const int ix = int(floorf(x));
+	const int iy = int(floorf(y));
+	const float rx = x - ix;
+	const float ry = y - iy;
+
+	int xs[2], ys[2];
+	for (int i = 0; i < 2; i++)
+	{
+		xs[i] = ((ix + i) % level.width + level.width) % level.width;
+		ys[i] = ((iy + i) % level.height + level.height) % level.height;
+	}
+	const float weightsX[2] = {1.0f - rx, rx};
+	const float weightsY[2] = {1.0f - ry, ry};
+
+	float result[channels];
+	if (bitsPerChannel == 8)
+		Gather(data8.data(), level, xs, ys, weightsX, weightsY, 2, result);
+	else
+		Gather(data16.data(), level, xs, ys, weightsX, weightsY, 2, result);
+
+	return sRGBFloat(result[0] * scale, result[1] * scale, result[2] * scale);
+}
+
+sRGBFloat cCompactTexture::Bicubic(int levelIndex, float x, float y) const
+{
+	const sLevel &level = levels[levelIndex];
+	const int ix = int(x);
+	const int iy = int(y);
+	const float rx = x - ix;
+	const float ry = y - iy;
+
+	// wrapped coordinates are calculated once per axis
+	int xs[4], ys[4];
+	for (int i = 0; i < 4; i++)
+	{
+		xs[i] = ((ix + i - 1) % level.width + level.width) % level.width;
+		ys[i] = ((iy + i - 1) % level.height + level.height) % level.height;
+	}
+
+	// Catmull-Rom weights - the same spline as bicubicInterpolate()
+	const float rx2 = rx * rx;
+	const float rx3 = rx2 * rx;
+	const float ry2 = ry * ry;
+	const float ry3 = ry2 * ry;
+	const float weightsX[4] = {0.5f * (-rx + 2.0f * rx2 - rx3),
+		0.5f * (2.0f - 5.0f * rx2 + 3.0f * rx3), 0.5f * (rx + 4.0f * rx2 - 3.0f * rx3),
+		0.5f * (rx3 - rx2)};
+	const float weightsY[4] = {0.5f * (-ry + 2.0f * ry2 - ry3),
+		0.5f * (2.0f - 5.0f * ry2 + 3.0f * ry3), 0.5f * (ry + 4.0f * ry2 - 3.0f * ry3),
+		0.5f * (ry3 - ry2)};
+
+	float result[channels];
+	if (bitsPerChannel == 8)
+		Gather(data8.data(), level, xs, ys, weightsX, weightsY, 4, result);
+	else
+		Gather(data16.data(), level, xs, ys, weightsX, weightsY, 4, result);
+
+	return sRGBFloat(std::max(result[0] * scale, 0.0f), std::max(result[1] * scale, 0.0f),
+		std::max(result[2] * scale, 0.0f));
+}
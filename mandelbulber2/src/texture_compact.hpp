@@ -0,0 +1,104 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cCompactTexture - texture storage with 8 or 16 bits per channel
+ *
+ * Texels are stored as 3 channels (RGB) in tiles of 8x8 texels. Inside a tile the
+ * texels are ordered along Morton (Z-order) curve, so neighbouring texels used by bilinear and
+ * bicubic filters are close in memory. All mipmap levels are kept in one contiguous buffer.
+ */
+
+#ifndef MANDELBULBER2_SRC_TEXTURE_COMPACT_HPP_
+#define MANDELBULBER2_SRC_TEXTURE_COMPACT_HPP_
+
+#include <vector>
+
+#include <QtGlobal>
+
+#include "color_structures.hpp"
+
+class cCompactTexture
+{
+public:
+	cCompactTexture();
+	~cCompactTexture();
+
+	// quantizes the bitmap. Values have to be in range 0..1. Mipmaps are averaged from not
+	// quantized levels, so quantization errors don't accumulate
+	void Create(const std::vector<sRGBFloat> &bitmap, int width, int height, int bitsPerChannel,
+		bool createMipmaps);
+	void Clear();
+
+	int GetNumberOfLevels() const { return int(levels.size()); }
+	int GetLevelWidth(int level) const { return levels[level].width; }
+	int GetLevelHeight(int level) const { return levels[level].height; }
+	quint64 GetMemorySize() const;
+
+	sRGBFloat Texel(int level, int x, int y) const;
+	sRGBFloat Bilinear(int level, float x, float y) const;
+	sRGBFloat Bicubic(int level, float x, float y) const;
+
+private:
+	struct sLevel
+	{
+		int width;
+		int height;
+		int tilesX;
+		quint64 offset; // index of the first texel
+	};
+
+	static const int tileShift = 3;
+	static const int tileSize = 1 << tileShift;
+	static const int channels = 3;
+
+	quint64 TexelIndex(const sLevel &level, int x, int y) const
+	{
+		// bits of x and y coordinates inside the tile are interleaved
+		static const int spread[tileSize] = {0, 1, 4, 5, 16, 17, 20, 21};
+		const quint64 tile = quint64(y >> tileShift) * level.tilesX + quint64(x >> tileShift);
+		return level.offset + (tile << (2 * tileShift)) + quint64(spread[x & (tileSize - 1)])
+					 + (quint64(spread[y & (tileSize - 1)]) << 1);
+	}
+
+	template <typename T>
+	void Gather(const T *data, const sLevel &level, const int *xs, const int *ys,
+		const float *weightsX, const float *weightsY, int taps, float *result) const;
+	template <typename T>
+	void Store(std::vector<T> *data, const std::vector<sRGBFloat> &bitmap, const sLevel &level);
+
+	std::vector<quint8> data8;
+	std::vector<quint16> data16;
+	std::vector<sLevel> levels;
+	int bitsPerChannel;
+	float scale; // multiplier from stored integer to colour value
+};
+
+#endif /* MANDELBULBER2_SRC_TEXTURE_COMPACT_HPP_ */
@@ -0,0 +1,242 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cThumbnailRenderService - one queue for rendering of all thumbnail widgets
+ */
+
+#include "thumbnail_render_service.hpp"
+
+#include <QTimer>
+
+#include "render_job.hpp"
+#include "system_data.hpp"
+
+#include "qt/thumbnail_widget.h"
+
+cThumbnailRenderService *gThumbnailRenderService = nullptr;
+
+cThumbnailRenderService::cThumbnailRenderService(QObject *parent) : QObject(parent)
+{
+	requestCounter = 0;
+	dispatchTimer = new QTimer(this);
+	dispatchTimer->setInterval(100);
+	connect(dispatchTimer, &QTimer::timeout, this, &cThumbnailRenderService::slotDispatch);
+}
+
+cThumbnailRenderService::~cThumbnailRenderService()
+{
+	// nothing to delete
+}
+
+void cThumbnailRenderService::Request(cThumbnailWidget *widget, bool cancellable)
+{
+	// previous request of the widget is replaced (its job was already stopped by the widget)
+	Cancel(widget);
+
+	sRequest request;
+	request.widget = widget;
+	// results are shared only between widgets which accept thumbnails from the cache
+	if (!widget->IsThumbnailCacheDisabled()) request.hash = widget->GetHash();
+	request.openClProgramKey = widget->GetOpenClProgramKey();
+	request.cancellable = cancellable;
+	request.allCores = false;
+	request.jobId = -1;
+	request.order = requestCounter++;
+	pending.append(request);
+
+	connect(widget, &cThumbnailWidget::renderJobFinished, this,
+		&cThumbnailRenderService::slotJobFinished, Qt::UniqueConnection);
+
+	if (!dispatchTimer->isActive()) dispatchTimer->start();
+	slotDispatch();
+}
+
+void cThumbnailRenderService::Cancel(cThumbnailWidget *widget)
+{
+	for (int i = pending.size() - 1; i >= 0; i--)
+	{
+		if (pending[i].widget == widget) pending.removeAt(i);
+	}
+	for (int i = running.size() - 1; i >= 0; i--)
+	{
+		if (running[i].widget == widget) running.removeAt(i);
+	}
+}
+
+int cThumbnailRenderService::RequestPriority(const sRequest &request) const
+{
+	if (request.widget->IsVisibleOnScreen()) return 0;
+	if (!request.cancellable) return 1; // somebody waits for the result
+	return 2;
+}
+
+bool cThumbnailRenderService::IsHashRunning(const QString &hash) const
+{
+	if (hash.isEmpty()) return false;
+
+	for (const sRequest &request : running)
+	{
+		if (request.hash == hash) return true;
+	}
+	return false;
+}
+
+int cThumbnailRenderService::FindBestPendingRequest() const
+{
+	bool openClBusy = false;
+	for (const sRequest &request : running)
+	{
+		if (!request.openClProgramKey.isEmpty()) openClBusy = true;
+	}
+
+	int bestIndex = -1;
+	int bestPriority = 0;
+	bool bestSameProgram = false;
+	for (int i = 0; i < pending.size(); i++)
+	{
+		const sRequest &request = pending[i];
+		if (!request.widget) continue;
+
+		// the same settings are already rendered, result will be copied
+		if (IsHashRunning(request.hash)) continue;
+
+		// OpenCL engine is shared, so OpenCL thumbnails are rendered one by one
+		bool openCl = !request.openClProgramKey.isEmpty();
+		if (openCl && openClBusy) continue;
+
+		int priority = RequestPriority(request);
+		bool sameProgram = openCl && request.openClProgramKey == lastOpenClProgramKey;
+
+		// lower priority value wins, then the same OpenCL program, then the oldest request
+		if (bestIndex < 0 || priority < bestPriority
+				|| (priority == bestPriority && sameProgram && !bestSameProgram))
+		{
+			bestIndex = i;
+			bestPriority = priority;
+			bestSameProgram = sameProgram;
+		}
+	}
+	return bestIndex;
+}
+
+void cThumbnailRenderService::CancelHiddenJobs()
+{
+	bool visibleWaiting = false;
+	for (const sRequest &request : pending)
+	{
+		if (request.widget && RequestPriority(request) == 0 && !IsHashRunning(request.hash))
+			visibleWaiting = true;
+	}
+	if (!visibleWaiting) return;
+
+	for (const sRequest &request : running)
+	{
+		if (request.cancellable && request.widget && !request.widget->IsVisibleOnScreen())
+		{
+			request.widget->CancelRender();
+		}
+	}
+}
+
+void cThumbnailRenderService::slotDispatch()
+{
+	// requests of deleted widgets
+	for (int i = pending.size() - 1; i >= 0; i--)
+	{
+		if (!pending[i].widget) pending.removeAt(i);
+	}
+	for (int i = running.size() - 1; i >= 0; i--)
+	{
+		if (!running[i].widget) running.removeAt(i);
+	}
+
+	CancelHiddenJobs();
+
+	// when other render is running (e.g. main image), only one thumbnail is rendered at a time
+	bool otherJobsRunning = cRenderJob::GetRunningJobCount() > running.size();
+	int maxRunningJobs = otherJobsRunning ? 1 : qMax(1, systemData.numberOfThreads);
+
+	while (running.size() < maxRunningJobs)
+	{
+		bool allCoresUsed = false;
+		for (const sRequest &request : running)
+		{
+			if (request.allCores) allCoresUsed = true;
+		}
+		if (allCoresUsed) break;
+
+		int index = FindBestPendingRequest();
+		if (index < 0) break;
+		if (otherJobsRunning && RequestPriority(pending[index]) > 0) break;
+
+		sRequest request = pending.takeAt(index);
+
+		// single request gets all CPU cores, many requests are rendered in parallel on single cores
+		request.allCores = pending.isEmpty() && running.isEmpty() && !otherJobsRunning;
+		request.jobId = request.widget->StartRenderJob(!request.allCores);
+		if (request.jobId < 0) continue; // nothing to render anymore
+
+		if (!request.openClProgramKey.isEmpty()) lastOpenClProgramKey = request.openClProgramKey;
+		running.append(request);
+	}
+
+	if (pending.isEmpty() && running.isEmpty()) dispatchTimer->stop();
+}
+
+void cThumbnailRenderService::slotJobFinished(int jobId)
+{
+	cThumbnailWidget *widget = qobject_cast<cThumbnailWidget *>(sender());
+	if (!widget) return;
+
+	int index = -1;
+	for (int i = 0; i < running.size(); i++)
+	{
+		if (running[i].widget == widget && running[i].jobId == jobId) index = i;
+	}
+	if (index < 0) return; // job was cancelled and replaced by newer request
+
+	sRequest request = running.takeAt(index);
+
+	// other widgets which requested the same settings get copy of the result
+	if (widget->IsRendered() && !request.hash.isEmpty())
+	{
+		for (int i = pending.size() - 1; i >= 0; i--)
+		{
+			if (pending[i].widget && pending[i].hash == request.hash)
+			{
+				sRequest duplicate = pending.takeAt(i);
+				duplicate.widget->CopyRenderedThumbnail(widget);
+			}
+		}
+	}
+
+	slotDispatch();
+}
@@ -0,0 +1,97 @@
+/**
+ * Mandelbulber v2, a 3D fractal generator       ,=#MKNmMMKmmßMNWy,
+ *                                             ,B" ]L,,p%%%,,,§;, "K
+ * Copyright (C) 2020 Mandelbulber Team        §R-==%w["'~5]m%=L.=~5N
+ *                                        ,=mm=§M ]=4 yJKA"/-Nsaj  "Bw,==,,
+ * This file is part of Mandelbulber.    §R.r= jw",M  Km .mM  FW ",§=ß., ,TN
+ *                                     ,4R =%["w[N=7]J '"5=],""]]M,w,-; T=]M
+ * Mandelbulber is free software:     §R.ß~-Q/M=,=5"v"]=Qf,'§"M= =,M.§ Rz]M"Kw
+ * you can redistribute it and/or     §w "xDY.J ' -"m=====WeC=\ ""%""y=%"]"" §
+ * modify it under the terms of the    "§M=M =D=4"N #"%==A%p M§ M6  R' #"=~.4M
+ * GNU General Public License as        §W =, ][T"]C  §  § '§ e===~ U  !§[Z ]N
+ * published by the                    4M",,Jm=,"=e~  §  §  j]]""N  BmM"py=ßM
+ * Free Software Foundation,          ]§ T,M=& 'YmMMpM9MMM%=w=,,=MT]M m§;'§,
+ * either version 3 of the License,    TWw [.j"5=~N[=§%=%W,T ]R,"=="Y[LFT ]N
+ * or (at your option)                   TW=,-#"%=;[  =Q:["V""  ],,M.m == ]N
+ * any later version.                      J§"mr"] ,=,," =="""J]= M"M"]==ß"
+ *                                          §= "=C=4 §"eM "=B:m|4"]#F,§~
+ * Mandelbulber is distributed in            "9w=,,]w em%wJ '"~" ,=,,ß"
+ * the hope that it will be useful,                 . "K=  ,=RMMMßM"""
+ * but WITHOUT ANY WARRANTY;                            .'''
+ * without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with Mandelbulber. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ###########################################################################
+ *
+ * Authors: Mandelbulber Team
+ *
+ * cThumbnailRenderService - one queue for rendering of all thumbnail widgets
+ *
+ * Thumbnail widgets don't start render jobs by themselves but send requests to the service.
+ * Requests of widgets visible on the screen are rendered first. Running jobs of widgets which
+ * were scrolled out of view are cancelled when visible widgets wait. Requests with the same
+ * settings hash are rendered only once and the result is copied to all waiting widgets.
+ * OpenCL thumbnails are rendered one by one and requests with the same OpenCL program are
+ * grouped, so the compiled program stays warm in the shared OpenCL engine.
+ */
+
+#ifndef MANDELBULBER2_SRC_THUMBNAIL_RENDER_SERVICE_HPP_
+#define MANDELBULBER2_SRC_THUMBNAIL_RENDER_SERVICE_HPP_
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+// forward declarations
+class cThumbnailWidget;
+class QTimer;
+
+class cThumbnailRenderService : public QObject
+{
+	Q_OBJECT
+public:
+	explicit cThumbnailRenderService(QObject *parent = nullptr);
+	~cThumbnailRenderService() override;
+
+	// cancellable requests are stopped when the widget is not visible and visible widgets wait
+	void Request(cThumbnailWidget *widget, bool cancellable);
+	void Cancel(cThumbnailWidget *widget);
+	int GetNumberOfPendingRequests() const { return pending.size(); }
+	int GetNumberOfRunningJobs() const { return running.size(); }
+
+private:
+	struct sRequest
+	{
+		QPointer<cThumbnailWidget> widget;
+		QString hash;
+		QString openClProgramKey; // empty if rendered on CPU
+		bool cancellable;
+		bool allCores; // job uses all CPU cores
+		int jobId;
+		qint64 order;
+	};
+
+	int RequestPriority(const sRequest &request) const;
+	int FindBestPendingRequest() const;
+	bool IsHashRunning(const QString &hash) const;
+	void CancelHiddenJobs();
+
+	QList<sRequest> pending;
+	QList<sRequest> running;
+	QTimer *dispatchTimer;
+	QString lastOpenClProgramKey;
+	qint64 requestCounter;
+
+private slots:
+	void slotDispatch();
+	void slotJobFinished(int jobId);
+};
+
+extern cThumbnailRenderService *gThumbnailRenderService;
+
+#endif /* MANDELBULBER2_SRC_THUMBNAIL_RENDER_SERVICE_HPP_ */
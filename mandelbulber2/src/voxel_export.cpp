@@ -46,6 +46,7 @@
 #include "calculate_distance.hpp"
 #include "common_math.h"
 #include "file_image.hpp"
+#include "file_sparse_volume.hpp"
 #include "fractal_container.hpp"
 #include "fractparams.hpp"
 #include "initparameters.hpp"
@@ -58,7 +59,7 @@
 #include "write_log.hpp"
 
 cVoxelExport::cVoxelExport(int w, int h, int l, CVector3 limitMin, CVector3 limitMax, QDir folder,
-	int maxIter, bool greyscale)
+	int maxIter, bool greyscale, enumVoxelFormat voxelFormat)
 		: QObject()
 {
 	this->w = w;
@@ -69,6 +70,7 @@ cVoxelExport::cVoxelExport(int w, int h, int l, CVector3 limitMin, CVector3 limi
 	this->folder = folder;
 	this->maxIter = maxIter;
 	this->greyscale = greyscale;
+	this->voxelFormat = voxelFormat;
 	voxelLayer.resize(w * h);
 	stop = false;
 }
@@ -106,9 +108,29 @@ void cVoxelExport::ProcessVolume()
 	progressText.ResetTimer();
 
 	bool openClEnabled = false;
+	bool failed = false;
 	std::vector<double> voxelDistances;
 	std::vector<int> voxelIterations;
 
+	const bool sparseVolume = voxelFormat == voxelFormatSparseVolume;
+	std::unique_ptr<cSparseVolumeFileSave> volumeFile;
+	if (sparseVolume)
+	{
+		const QString filename = folder.absolutePath() + QDir::separator() + "volume."
+														 + cSparseVolumeFileSave::FileExtension();
+		volumeFile.reset(
+			new cSparseVolumeFileSave(filename, w, h, l, limitMin, limitMax, dist_thresh, maxIter));
+		if (!volumeFile->Open())
+		{
+			emit updateProgressAndStatus(
+				tr("Voxel Export - Cannot write to file %1").arg(filename), "", 1.0);
+			emit finished();
+			return;
+		}
+		voxelDistances.resize(w * h);
+		voxelIterations.resize(w * h);
+	}
+
 #ifdef USE_OPENCL
 	openClEnabled =
 		gPar->Get<bool>("opencl_enabled")
@@ -141,10 +163,7 @@ void cVoxelExport::ProcessVolume()
 		}
 		else
 		{
-			emit finished();
-			gOpenCl->openClEngineRenderFractal->ReleaseMemory();
-			gOpenCl->openClEngineRenderFractal->Unlock();
-			return;
+			failed = true;
 		}
 
 		voxelDistances.resize(w * h);
@@ -153,7 +172,7 @@ void cVoxelExport::ProcessVolume()
 
 #endif // USE_OPENCL
 
-	for (long long z = 0; z < l; z++)
+	for (long long z = 0; z < l && !failed; z++)
 	{
 		const QString statusText =
 			" - " + tr("Processing layer %1 of %2").arg(QString::number(z + 1), QString::number(l));
@@ -169,12 +188,12 @@ void cVoxelExport::ProcessVolume()
 
 			if (!result)
 			{
-				gOpenCl->openClEngineRenderFractal->ReleaseMemory();
-				gOpenCl->openClEngineRenderFractal->Unlock();
-				return;
+				failed = true;
+				break;
 			}
 
-			for (long long x = 0; x < w; x++)
+			// sparse volume stores the slicer output (distances and iterations) directly
+			for (long long x = 0; x < w && !sparseVolume; x++)
 			{
 				for (long long y = 0; y < h; y++)
 				{
@@ -214,7 +233,12 @@ void cVoxelExport::ProcessVolume()
 
 					const double dist = CalculateDistance(*params, *fractals, distanceIn, &distanceOut);
 
-					if (greyscale)
+					if (sparseVolume)
+					{
+						voxelDistances[x + y * w] = dist;
+						voxelIterations[x + y * w] = distanceOut.iters;
+					}
+					else if (greyscale)
 					{
 						voxelLayer[x + y * w] =
 							static_cast<unsigned char>((distanceOut.iters - 1) * 255 / maxIter);
@@ -227,8 +251,13 @@ void cVoxelExport::ProcessVolume()
 			}		// for x
 		}			// if not openClEnabled
 
-		if (stop || !StoreLayer(z))
+		if (stop) break;
+
+		const bool stored =
+			sparseVolume ? volumeFile->AppendLayer(voxelDistances, voxelIterations) : StoreLayer(z);
+		if (!stored)
 		{
+			failed = true;
 			break;
 		}
 	}
@@ -241,9 +270,24 @@ void cVoxelExport::ProcessVolume()
 	}
 #endif // USE_OPENCL
 
+	if (sparseVolume)
+	{
+		// incomplete volume is not saved under the final file name
+		if (stop || failed)
+			volumeFile->Abort();
+		else if (!volumeFile->Finish())
+			failed = true;
+		WriteLog(QString("Sparse volume: stored %1 bricks, skipped %2 empty bricks")
+							 .arg(volumeFile->GetStoredBricksCount())
+							 .arg(volumeFile->GetSkippedBricksCount()),
+			2);
+	}
+
 	QString statusText;
 	if (stop)
 		statusText = tr("Voxel Export finished - Cancelled export");
+	else if (failed)
+		statusText = tr("Voxel Export finished - Export failed");
 	else
 		statusText = tr("Voxel Export finished - Processed %1 layers").arg(QString::number(l));
 	emit updateProgressAndStatus(statusText, progressText.getText(1.0), 1.0);
@@ -34,7 +34,8 @@
  * This class calculates the volume in between the limitMin and limitMax points
  * with a resolution of w * h * l. for each voxel ProcessVolume() determines if the point
  * is inside the fractal, or not. The result is saved in layers of X-Y planes in StoreLayer
- * to the output folder as a black-and-white PNG file.
+ * to the output folder as a black-and-white PNG file, or (voxelFormatSparseVolume) streamed
+ * with distance and iteration channels to a single sparse volume file (cSparseVolumeFileSave).
  */
 
 #ifndef MANDELBULBER2_SRC_VOXEL_EXPORT_HPP_
@@ -45,13 +46,21 @@
 
 #include "algebra.hpp"
 
+class cSparseVolumeFileSave;
+
 class cVoxelExport : public QObject
 {
 	Q_OBJECT
 
 public:
+	enum enumVoxelFormat
+	{
+		voxelFormatSlice,
+		voxelFormatSparseVolume
+	};
+
 	cVoxelExport(int w, int h, int l, CVector3 limitMin, CVector3 limitMax, QDir folder, int maxIter,
-		bool greyscale);
+		bool greyscale, enumVoxelFormat voxelFormat = voxelFormatSlice);
 	~cVoxelExport() override;
 
 signals:
@@ -72,6 +81,7 @@ private:
 	QDir folder;
 	int maxIter;
 	bool greyscale;
+	enumVoxelFormat voxelFormat;
 	bool stop;
 };
 